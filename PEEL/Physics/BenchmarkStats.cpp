@@ -0,0 +1,195 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "BenchmarkStats.h"
+#include "Simulation.h"
+#include "TestScenes.h"
+
+#define NB_BOOTSTRAP_RESAMPLES	2000
+
+// One median frame time per repetition, for each engine
+static Container	gRepetitionMedians[MAX_NB_ENGINES];
+static udword		gNbRepetitions = 0;
+
+void ResetBenchmark()
+{
+	for(udword i=0;i<MAX_NB_ENGINES;i++)
+		gRepetitionMedians[i].Reset();
+	gNbRepetitions = 0;
+}
+
+udword GetNbBenchmarkRepetitions()
+{
+	return gNbRepetitions;
+}
+
+static inline_ bool IsEngineBenchmarked(udword i)
+{
+	return gEngines[i].mEnabled && gEngines[i].mSupportsCurrentTest && (gEngines[i].mEngine->GetFlags() & PINT_IS_ACTIVE);
+}
+
+void RecordBenchmarkRepetition()
+{
+	for(udword i=0;i<gNbEngines;i++)
+	{
+		ASSERT(gEngines[i].mEngine);
+		const PintHistogram& H = gEngines[i].mTiming.mHistogram;
+		if(IsEngineBenchmarked(i) && H.GetNbValues())
+			gRepetitionMedians[i].Add(H.GetPercentile(50.0f));
+	}
+	gNbRepetitions++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Sets are small (one value per repetition), insertion sort is enough
+static void SortValues(float* values, udword nb)
+{
+	for(udword i=1;i<nb;i++)
+	{
+		const float Value = values[i];
+		udword j = i;
+		while(j && values[j-1]>Value)
+		{
+			values[j] = values[j-1];
+			j--;
+		}
+		values[j] = Value;
+	}
+}
+
+static float GetSortedMedian(const float* values, udword nb)
+{
+	ASSERT(nb);
+	if(nb&1)
+		return values[nb/2];
+	return (values[nb/2-1] + values[nb/2])*0.5f;
+}
+
+static float GetMedian(const Container& values, float* buffer)
+{
+	const udword Nb = values.GetNbEntries();
+	for(udword i=0;i<Nb;i++)
+		buffer[i] = float(values.GetEntry(i));
+	SortValues(buffer, Nb);
+	return GetSortedMedian(buffer, Nb);
+}
+
+static float GetResampledMedian(const Container& values, float* buffer, BasicRandom& rnd)
+{
+	const udword Nb = values.GetNbEntries();
+	for(udword i=0;i<Nb;i++)
+		buffer[i] = float(values.GetEntry((rnd.Randomize()>>16) % Nb));
+	SortValues(buffer, Nb);
+	return GetSortedMedian(buffer, Nb);
+}
+
+// Percentile bootstrap interval from NB_BOOTSTRAP_RESAMPLES sorted estimates
+static void GetInterval(float* estimates, float confidence, float& low, float& high)
+{
+	SortValues(estimates, NB_BOOTSTRAP_RESAMPLES);
+	const float Alpha = (1.0f - confidence*0.01f)*0.5f;
+	low = estimates[udword(Alpha*float(NB_BOOTSTRAP_RESAMPLES-1))];
+	high = estimates[udword((1.0f-Alpha)*float(NB_BOOTSTRAP_RESAMPLES-1))];
+}
+
+static FILE* OpenBenchmarkFile()
+{
+	return fopen(GetTestCSVFilename("_Repetitions"), "w");
+}
+
+// Writes to both the console and the file
+static void Output(FILE* fp, const char* text)
+{
+	printf("%s", text);
+	if(fp)
+		fprintf_s(fp, "%s", text);
+}
+
+bool ExportBenchmarkResults(float confidence)
+{
+	if(!gRunningTest || !gNbRepetitions)
+		return false;
+
+	if(confidence<=0.0f || confidence>=100.0f)
+		confidence = DEFAULT_BENCHMARK_CONFIDENCE;
+
+	FILE* fp = OpenBenchmarkFile();
+
+	const char* Sep = gCommaSeparator ? ", " : "; ";
+	const char* Units = GetProfilingTimer(gProfilingUnits).mUnits;
+
+	Output(fp, _F("%s: %d repetitions, median frame time (%s), %.1f%% bootstrap confidence intervals\n\n", gRunningTest->GetName(), gNbRepetitions, Units, confidence));
+	Output(fp, _F("Engine%sRepetitions%sMedian%sCI low%sCI high\n", Sep, Sep, Sep, Sep));
+
+	float* Buffer = (float*)ICE_ALLOC(sizeof(float)*gNbRepetitions);
+	float* Estimates = (float*)ICE_ALLOC(sizeof(float)*NB_BOOTSTRAP_RESAMPLES);
+
+	// Fixed seed so that reports are reproducible, and so that we don't disturb the tests' random sequences
+	BasicRandom Rnd(42);
+
+	float Medians[MAX_NB_ENGINES];
+	for(udword i=0;i<gNbEngines;i++)
+	{
+		const Container& Values = gRepetitionMedians[i];
+		if(!Values.GetNbEntries())
+			continue;
+
+		Medians[i] = GetMedian(Values, Buffer);
+		for(udword j=0;j<NB_BOOTSTRAP_RESAMPLES;j++)
+			Estimates[j] = GetResampledMedian(Values, Buffer, Rnd);
+
+		float Low, High;
+		GetInterval(Estimates, confidence, Low, High);
+
+		Output(fp, _F("%s%s%d%s%.2f%s%.2f%s%.2f\n", gEngines[i].mEngine->GetName(), Sep, Values.GetNbEntries(), Sep, Medians[i], Sep, Low, Sep, High));
+	}
+
+	// Pairwise comparisons: bootstrap the relative difference between the two medians. If its interval contains zero,
+	// the difference can't be told apart from run-to-run noise.
+	Output(fp, _F("\nComparison%sDifference (%%)%sCI low (%%)%sCI high (%%)%sSignificant\n", Sep, Sep, Sep, Sep));
+	for(udword a=0;a<gNbEngines;a++)
+	{
+		const Container& ValuesA = gRepetitionMedians[a];
+		if(!ValuesA.GetNbEntries())
+			continue;
+
+		for(udword b=a+1;b<gNbEngines;b++)
+		{
+			const Container& ValuesB = gRepetitionMedians[b];
+			if(!ValuesB.GetNbEntries() || Medians[b]==0.0f)
+				continue;
+
+			for(udword j=0;j<NB_BOOTSTRAP_RESAMPLES;j++)
+			{
+				const float MedianA = GetResampledMedian(ValuesA, Buffer, Rnd);
+				const float MedianB = GetResampledMedian(ValuesB, Buffer, Rnd);
+				Estimates[j] = MedianB!=0.0f ? (MedianA - MedianB)*100.0f/MedianB : 0.0f;
+			}
+
+			float Low, High;
+			GetInterval(Estimates, confidence, Low, High);
+			const bool Significant = Low>0.0f || High<0.0f;
+			const float Difference = (Medians[a] - Medians[b])*100.0f/Medians[b];
+
+			Output(fp, _F("%s vs %s%s%+.2f%s%+.2f%s%+.2f%s%s\n", gEngines[a].mEngine->GetName(), gEngines[b].mEngine->GetName(), Sep, Difference, Sep, Low, Sep, High, Sep, Significant ? "yes" : "NO (within noise)"));
+		}
+	}
+
+	if(gNbRepetitions<5)
+		Output(fp, "\n(Less than 5 repetitions: confidence intervals are not reliable.)\n");
+
+	ICE_FREE(Estimates);
+	ICE_FREE(Buffer);
+
+	if(!fp)
+		return false;
+	fclose(fp);
+	return true;
+}
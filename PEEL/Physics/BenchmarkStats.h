@@ -0,0 +1,25 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef BENCHMARK_STATS_H
+#define BENCHMARK_STATS_H
+
+	// Statistics over repeated runs of the same test. Each repetition contributes one value per engine: the median frame
+	// time of that run. The report gives the median of these values with a bootstrap confidence interval, and flags
+	// engine-vs-engine differences whose confidence interval contains zero as not significant.
+
+	#define DEFAULT_BENCHMARK_CONFIDENCE	95.0f
+
+	void	ResetBenchmark();
+	// Call at the end of each repetition, before the engines are closed.
+	void	RecordBenchmarkRepetition();
+	udword	GetNbBenchmarkRepetitions();
+	// Prints the report & saves it to "<Test>_Repetitions.csv". Confidence is a percentage (e.g. 95.0f). Returns false if no file was written.
+	bool	ExportBenchmarkResults(float confidence);
+
+#endif
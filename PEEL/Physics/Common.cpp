@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "Common.h"
+
+Quat ShortestRotation(const Point& v0, const Point& v1)
+{
+	const float d = v0|v1;
+	const Point cross = v0^v1;
+
+	Quat q = d>-1.0f ? Quat(1.0f + d, cross.x, cross.y, cross.z)
+//					: fabsf(v0.x)<0.1f ? Quat(0.0f, 0.0f, v0.z, -v0.y) : Quat(0.0f, v0.y, -v0.x, 0.0f);
+					: fabsf(v0.x)<0.1f ? Quat(0.0f, 0.0f, v0.z, -v0.y) : Quat(0.0f, v0.y, -v0.x, 0.0f);
+//	PxQuat q = d > -1 ? PxQuat(cross.x, cross.y, cross.z, 1 + d) : PxAbs(v0.x) < 0.1f ? PxQuat(0.0f, v0.z, -v0.y, 0.0f)
+//	                                                                                  : PxQuat(v0.y, -v0.x, 0.0f, 0.0f);
+
+	q.Normalize();
+
+	return q;
+}
+
+static char gBuildFolder[MAX_PATH] = {0};
+static char gCurrentFile[MAX_PATH];
+
+void SetPEELBuildFolder(const char* exe_filename)
+{
+	strcpy(gBuildFolder, exe_filename);
+	char* Build = strstr(gBuildFolder, "Build");
+	if(Build)
+	{
+		Build[6]=0;
+	}
+	else
+	{
+		gBuildFolder[0] = 0;
+	}
+}
+
+const char* FindPEELFile(const char* filename)
+{
+	{
+		const char* F0 = _F("../build/%s", filename);
+		strcpy(gCurrentFile, F0);
+		if(FileExists(gCurrentFile))
+			return gCurrentFile;
+	}
+
+	{
+		const char* F1 = _F("../build/Customers/%s", filename);
+		strcpy(gCurrentFile, F1);
+		if(FileExists(gCurrentFile))
+			return gCurrentFile;
+	}
+
+	{
+		const char* F1 = _F("./%s", filename);
+		strcpy(gCurrentFile, F1);
+		if(FileExists(gCurrentFile))
+			return gCurrentFile;
+	}
+
+	{
+		const char* F1 = _F("./Customers/%s", filename);
+		strcpy(gCurrentFile, F1);
+		if(FileExists(gCurrentFile))
+			return gCurrentFile;
+	}
+
+	{
+		const char* F2 = _F("%s%s", gBuildFolder, filename);
+		strcpy(gCurrentFile, F2);
+		if(FileExists(gCurrentFile))
+			return gCurrentFile;
+	}
+	return null;
+}
+
+void ThreadSetup()
+{
+	_clearfp();
+
+   udword x86_cw;
+   udword sse2_cw;
+	#define _MCW_ALL _MCW_DN | _MCW_EM | _MCW_IC | _MCW_RC | _MCW_PC
+	__control87_2(_CW_DEFAULT | _DN_FLUSH, _MCW_ALL, &x86_cw, &sse2_cw);
+
+	_clearfp();
+}
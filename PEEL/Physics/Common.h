@@ -19,5 +19,9 @@
 	Quat ShortestRotation(const Point& v0, const Point& v1);
 
 	const char* FindPEELFile(const char* filename);
+	void		SetPEELBuildFolder(const char* exe_filename);
+
+	// Sets up the FPU/SSE control words. Must be called by each thread running physics code.
+	void		ThreadSetup();
 
 #endif
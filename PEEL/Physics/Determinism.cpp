@@ -0,0 +1,478 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "Determinism.h"
+#include "Simulation.h"
+#include "TestScenes.h"
+
+bool	gDeterminismCheck = false;
+
+namespace
+{
+	// Poses & per-frame hashes of one engine, for one run of a test
+	class DeterminismRun
+	{
+		public:
+						DeterminismRun();
+						~DeterminismRun()	{ Release();	}
+
+			void		Release();
+			void		Start(const char* engine_name);
+			// Reads back the poses of all objects & records their hash
+			void		Record(const ObjectsManager& objects);
+			void		Swap(DeterminismRun& run);
+
+			char		mEngineName[64];
+			uqword*		mHashes;			// One per frame, for the first MAX_NB_RECORDED_FRAMES frames
+			float*		mMaxDrift;			// Cross-engine drift per frame, vs the first engine
+			float*		mAvgDrift;
+			PR*			mPoses;				// Poses after the last recorded frame
+			udword		mNbFrames;			// Total number of recorded frames, can exceed MAX_NB_RECORDED_FRAMES
+			udword		mNbObjects;
+			udword		mMaxNbObjects;		// Capacity of mPoses
+			udword		mNbThreads;			// gNbWorkerThreads during the run
+			udword		mFirstDivergentFrame;	// Cross-engine, INVALID_ID if none
+	};
+}
+
+DeterminismRun::DeterminismRun() :
+	mHashes				(null),
+	mMaxDrift			(null),
+	mAvgDrift			(null),
+	mPoses				(null),
+	mNbFrames			(0),
+	mNbObjects			(0),
+	mMaxNbObjects		(0),
+	mNbThreads			(INVALID_ID),
+	mFirstDivergentFrame(INVALID_ID)
+{
+	mEngineName[0] = 0;
+}
+
+void DeterminismRun::Release()
+{
+	ICE_FREE(mPoses);
+	ICE_FREE(mAvgDrift);
+	ICE_FREE(mMaxDrift);
+	ICE_FREE(mHashes);
+	mEngineName[0] = 0;
+	mNbFrames = 0;
+	mNbObjects = 0;
+	mMaxNbObjects = 0;
+	mNbThreads = INVALID_ID;
+	mFirstDivergentFrame = INVALID_ID;
+}
+
+void DeterminismRun::Start(const char* engine_name)
+{
+	Release();
+	strncpy(mEngineName, engine_name, sizeof(mEngineName)-1);
+	mEngineName[sizeof(mEngineName)-1] = 0;
+	mNbThreads = gNbWorkerThreads;
+	mHashes = (uqword*)ICE_ALLOC(sizeof(uqword)*MAX_NB_RECORDED_FRAMES);
+}
+
+void DeterminismRun::Swap(DeterminismRun& run)
+{
+	char Tmp[sizeof(mEngineName)];
+	strcpy(Tmp, mEngineName);
+	strcpy(mEngineName, run.mEngineName);
+	strcpy(run.mEngineName, Tmp);
+	TSwap(mHashes, run.mHashes);
+	TSwap(mMaxDrift, run.mMaxDrift);
+	TSwap(mAvgDrift, run.mAvgDrift);
+	TSwap(mPoses, run.mPoses);
+	TSwap(mNbFrames, run.mNbFrames);
+	TSwap(mNbObjects, run.mNbObjects);
+	TSwap(mMaxNbObjects, run.mMaxNbObjects);
+	TSwap(mNbThreads, run.mNbThreads);
+	TSwap(mFirstDivergentFrame, run.mFirstDivergentFrame);
+}
+
+// 64-bit FNV-1a on the raw bits: any difference, even in the last bit of a float, changes the hash
+static uqword HashPoses(udword nb, const PR* poses)
+{
+	uqword Hash = 0xcbf29ce484222325ULL;
+	const ubyte* Data = (const ubyte*)poses;
+	const udword Size = nb*sizeof(PR);
+	for(udword i=0;i<Size;i++)
+	{
+		Hash ^= Data[i];
+		Hash *= 0x100000001b3ULL;
+	}
+	return Hash;
+}
+
+void DeterminismRun::Record(const ObjectsManager& objects)
+{
+	// Tests can create objects at runtime
+	const udword NbObjects = objects.GetNbObjects();
+	if(NbObjects>mMaxNbObjects)
+	{
+		ICE_FREE(mPoses);
+		mPoses = (PR*)ICE_ALLOC(sizeof(PR)*NbObjects);
+		mMaxNbObjects = NbObjects;
+	}
+	mNbObjects = NbObjects;
+	if(NbObjects)
+		objects.GetWorldTransforms(mPoses);
+
+	if(mNbFrames<MAX_NB_RECORDED_FRAMES)
+		mHashes[mNbFrames] = HashPoses(NbObjects, mPoses);
+	mNbFrames++;
+}
+
+static DeterminismRun	gCurrentRuns[MAX_NB_ENGINES];
+static DeterminismRun	gReferenceRuns[MAX_NB_ENGINES];
+static char				gReferenceTest[1024] = {0};	// CSV filename of the reference runs' test, which identifies it
+static udword			gRunIndex = 0;				// Index of the current run, 0 for the reference run
+
+void ResetDeterminismReference()
+{
+	for(udword i=0;i<MAX_NB_ENGINES;i++)
+		gReferenceRuns[i].Release();
+	gReferenceTest[0] = 0;
+	gRunIndex = 0;
+}
+
+static inline_ bool IsTracked(udword i)
+{
+	return gEngines[i].mEnabled && gEngines[i].mSupportsCurrentTest && gEngines[i].mEngine;
+}
+
+void StartDeterminismRun()
+{
+	if(!gDeterminismCheck || !gRunningTest)
+		return;
+
+	// A different test starts over with a new reference
+	const char* TestName = GetTestCSVFilename(null);
+	if(strcmp(TestName, gReferenceTest)!=0)
+	{
+		ResetDeterminismReference();
+		strncpy(gReferenceTest, TestName, sizeof(gReferenceTest)-1);
+		gReferenceTest[sizeof(gReferenceTest)-1] = 0;
+	}
+
+	for(udword i=0;i<gNbEngines;i++)
+	{
+		if(IsTracked(i))
+			gCurrentRuns[i].Start(gEngines[i].mEngine->GetName());
+		else
+			gCurrentRuns[i].Release();
+	}
+}
+
+static float GetRotationDrift(const Quat& q0, const Quat& q1)
+{
+	// Angle of the rotation from q0 to q1, in degrees. Identical rotations don't go through acosf, which could report
+	// a tiny drift for them.
+	if(memcmp(&q0, &q1, sizeof(Quat))==0)
+		return 0.0f;
+	const float d = fabsf(q0.p.Dot(q1.p) + q0.w*q1.w);
+	return 2.0f * acosf(d<1.0f ? d : 1.0f) * RADTODEG;
+}
+
+void RecordDeterminismFrame()
+{
+	if(!gDeterminismCheck || !gRunningTest)
+		return;
+
+	udword Reference = INVALID_ID;
+	for(udword i=0;i<gNbEngines;i++)
+	{
+		if(!IsTracked(i) || !gCurrentRuns[i].mHashes)
+			continue;
+
+		gCurrentRuns[i].Record(gEngines[i].mOMHelper);
+		if(Reference==INVALID_ID)
+			Reference = i;
+	}
+	if(Reference==INVALID_ID)
+		return;
+
+	// Cross-engine drift, vs the first engine
+	const DeterminismRun& Ref = gCurrentRuns[Reference];
+	const udword Frame = Ref.mNbFrames-1;
+	for(udword i=Reference+1;i<gNbEngines;i++)
+	{
+		DeterminismRun& Run = gCurrentRuns[i];
+		if(!IsTracked(i) || !Run.mHashes || Run.mNbObjects!=Ref.mNbObjects)
+			continue;
+
+		if(Run.mFirstDivergentFrame==INVALID_ID && HashPoses(Run.mNbObjects, Run.mPoses)!=HashPoses(Ref.mNbObjects, Ref.mPoses))
+			Run.mFirstDivergentFrame = Frame;
+
+		if(Frame>=MAX_NB_RECORDED_FRAMES)
+			continue;
+
+		if(!Run.mMaxDrift)
+		{
+			Run.mMaxDrift = (float*)ICE_ALLOC(sizeof(float)*MAX_NB_RECORDED_FRAMES);
+			Run.mAvgDrift = (float*)ICE_ALLOC(sizeof(float)*MAX_NB_RECORDED_FRAMES);
+			ZeroMemory(Run.mMaxDrift, sizeof(float)*MAX_NB_RECORDED_FRAMES);
+			ZeroMemory(Run.mAvgDrift, sizeof(float)*MAX_NB_RECORDED_FRAMES);
+		}
+
+		float MaxDrift = 0.0f;
+		float SumDrift = 0.0f;
+		for(udword j=0;j<Run.mNbObjects;j++)
+		{
+			const float Drift = Run.mPoses[j].mPos.Distance(Ref.mPoses[j].mPos);
+			SumDrift += Drift;
+			if(Drift>MaxDrift)
+				MaxDrift = Drift;
+		}
+		Run.mMaxDrift[Frame] = MaxDrift;
+		Run.mAvgDrift[Frame] = Run.mNbObjects ? SumDrift/float(Run.mNbObjects) : 0.0f;
+	}
+}
+
+static const char* GetNbThreadsString(udword nb_threads, char buffer[16])
+{
+	if(nb_threads==INVALID_ID)
+		return "plugin settings";
+	sprintf(buffer, "%d", nb_threads);
+	return buffer;
+}
+
+// Compares a run to the reference run of the same engine, prints the result & writes the per-body drift to the CSV file
+static void CompareToReference(FILE* fp, const char* sep, const DeterminismRun& run, const DeterminismRun& ref)
+{
+	const udword NbFrames = TMin(TMin(run.mNbFrames, ref.mNbFrames), udword(MAX_NB_RECORDED_FRAMES));
+	udword FirstDivergentFrame = INVALID_ID;
+	for(udword f=0;f<NbFrames;f++)
+	{
+		if(run.mHashes[f]!=ref.mHashes[f])
+		{
+			FirstDivergentFrame = f;
+			break;
+		}
+	}
+
+	const bool SameNbObjects = run.mNbObjects==ref.mNbObjects;
+	float MaxPosDrift = 0.0f;
+	float SumPosDrift = 0.0f;
+	float MaxRotDrift = 0.0f;
+	udword WorstBody = INVALID_ID;
+	if(SameNbObjects)
+	{
+		for(udword j=0;j<run.mNbObjects;j++)
+		{
+			const float PosDrift = run.mPoses[j].mPos.Distance(ref.mPoses[j].mPos);
+			const float RotDrift = GetRotationDrift(run.mPoses[j].mRot, ref.mPoses[j].mRot);
+			SumPosDrift += PosDrift;
+			if(PosDrift>MaxPosDrift)
+			{
+				MaxPosDrift = PosDrift;
+				WorstBody = j;
+			}
+			if(RotDrift>MaxRotDrift)
+				MaxRotDrift = RotDrift;
+		}
+	}
+	const float AvgPosDrift = run.mNbObjects ? SumPosDrift/float(run.mNbObjects) : 0.0f;
+
+	// Frames past MAX_NB_RECORDED_FRAMES only have their final poses compared
+	const bool Diverged = FirstDivergentFrame!=INVALID_ID || !SameNbObjects || MaxPosDrift!=0.0f || MaxRotDrift!=0.0f || run.mNbFrames!=ref.mNbFrames;
+
+	char RunThreads[16], RefThreads[16];
+	const char* RunThreadsString = GetNbThreadsString(run.mNbThreads, RunThreads);
+	const char* RefThreadsString = GetNbThreadsString(ref.mNbThreads, RefThreads);
+
+	printf("  %s (threads: %s vs %s): ", run.mEngineName, RunThreadsString, RefThreadsString);
+	if(!Diverged)
+		printf("deterministic over %d frames (%d objects)\n", run.mNbFrames, run.mNbObjects);
+	else if(!SameNbObjects)
+		printf("DIVERGED, %d objects vs %d in the reference run\n", run.mNbObjects, ref.mNbObjects);
+	else
+	{
+		if(FirstDivergentFrame!=INVALID_ID)
+			printf("DIVERGED at frame %d", FirstDivergentFrame);
+		else
+			printf("DIVERGED after frame %d", NbFrames);
+		printf(", final drift: max %f (body %d), avg %f, max rotation %.4f deg\n", MaxPosDrift, WorstBody, AvgPosDrift, MaxRotDrift);
+	}
+
+	if(!fp)
+		return;
+
+	fprintf_s(fp, "%s%s%s%s%s%s%d%s%d%s", run.mEngineName, sep, RefThreadsString, sep, RunThreadsString, sep, run.mNbFrames, sep, run.mNbObjects, sep);
+	if(FirstDivergentFrame!=INVALID_ID)
+		fprintf_s(fp, "%d", FirstDivergentFrame);
+	else
+		fprintf_s(fp, "%s", Diverged ? "-" : "none");
+	fprintf_s(fp, "%s%f%s%f%s%f\n", sep, MaxPosDrift, sep, AvgPosDrift, sep, MaxRotDrift);
+}
+
+static void ReportRunToRun()
+{
+	bool HasReference = false;
+	for(udword i=0;i<gNbEngines;i++)
+	{
+		if(gCurrentRuns[i].mHashes && gReferenceRuns[i].mHashes && strcmp(gCurrentRuns[i].mEngineName, gReferenceRuns[i].mEngineName)==0)
+			HasReference = true;
+	}
+
+	if(!HasReference)
+	{
+		// First run of this test: it becomes the reference
+		for(udword i=0;i<gNbEngines;i++)
+			gReferenceRuns[i].Swap(gCurrentRuns[i]);
+		char Threads[16];
+		printf("Determinism: reference run recorded for %s (threads: %s).\n", gRunningTest->GetName(), GetNbThreadsString(gNbWorkerThreads, Threads));
+		return;
+	}
+
+	gRunIndex++;
+	printf("Determinism of %s, run %d vs reference run:\n", gRunningTest->GetName(), gRunIndex);
+
+	FILE* fp = fopen(GetTestCSVFilename(_F("_Determinism_Run%d", gRunIndex)), "w");
+	const char* Sep = gCommaSeparator ? ", " : "; ";
+	if(fp)
+	{
+		fprintf_s(fp, "%s - Determinism, run %d vs reference run\n\n", gRunningTest->GetName(), gRunIndex);
+		fprintf_s(fp, "Engine%sReference threads%sThreads%sFrames%sObjects%sFirst divergent frame%sMax drift%sAvg drift%sMax rotation drift (deg)\n", Sep, Sep, Sep, Sep, Sep, Sep, Sep, Sep);
+	}
+
+	udword Compared[MAX_NB_ENGINES];
+	udword NbCompared = 0;
+	for(udword i=0;i<gNbEngines;i++)
+	{
+		const DeterminismRun& Run = gCurrentRuns[i];
+		const DeterminismRun& Ref = gReferenceRuns[i];
+		if(!Run.mHashes || !Ref.mHashes || strcmp(Run.mEngineName, Ref.mEngineName)!=0)
+			continue;
+
+		CompareToReference(fp, Sep, Run, Ref);
+		if(Run.mNbObjects==Ref.mNbObjects)
+			Compared[NbCompared++] = i;
+	}
+
+	// Per-body drift of the final poses
+	if(fp && NbCompared)
+	{
+		fprintf_s(fp, "\nBody");
+		for(udword c=0;c<NbCompared;c++)
+			fprintf_s(fp, "%s%s", Sep, gCurrentRuns[Compared[c]].mEngineName);
+		fprintf_s(fp, "\n");
+
+		udword NbBodies = 0;
+		for(udword c=0;c<NbCompared;c++)
+			NbBodies = TMax(NbBodies, gCurrentRuns[Compared[c]].mNbObjects);
+
+		for(udword j=0;j<NbBodies;j++)
+		{
+			fprintf_s(fp, "%d", j);
+			for(udword c=0;c<NbCompared;c++)
+			{
+				const DeterminismRun& Run = gCurrentRuns[Compared[c]];
+				if(j<Run.mNbObjects)
+					fprintf_s(fp, "%s%f", Sep, Run.mPoses[j].mPos.Distance(gReferenceRuns[Compared[c]].mPoses[j].mPos));
+				else
+					fprintf_s(fp, "%s", Sep);
+			}
+			fprintf_s(fp, "\n");
+		}
+	}
+
+	if(fp)
+		fclose(fp);
+}
+
+static void ReportCrossEngine()
+{
+	udword Reference = INVALID_ID;
+	bool HasResults = false;
+	for(udword i=0;i<gNbEngines;i++)
+	{
+		if(!gCurrentRuns[i].mHashes)
+			continue;
+		if(Reference==INVALID_ID)
+			Reference = i;
+		else if(gCurrentRuns[i].mMaxDrift)
+			HasResults = true;
+	}
+	if(!HasResults)
+		return;
+
+	const DeterminismRun& Ref = gCurrentRuns[Reference];
+	printf("Divergence of %s vs %s:\n", gRunningTest->GetName(), Ref.mEngineName);
+
+	udword NbFrames = 0;
+	for(udword i=Reference+1;i<gNbEngines;i++)
+	{
+		const DeterminismRun& Run = gCurrentRuns[i];
+		if(!Run.mMaxDrift)
+			continue;
+
+		const udword NbRecorded = TMin(Run.mNbFrames, udword(MAX_NB_RECORDED_FRAMES));
+		NbFrames = TMax(NbFrames, NbRecorded);
+		const float FinalDrift = NbRecorded ? Run.mMaxDrift[NbRecorded-1] : 0.0f;
+		if(Run.mFirstDivergentFrame==INVALID_ID)
+			printf("  %s: identical over %d frames\n", Run.mEngineName, Run.mNbFrames);
+		else
+			printf("  %s: first divergent frame: %d, max drift at frame %d: %f\n", Run.mEngineName, Run.mFirstDivergentFrame, NbRecorded-1, FinalDrift);
+	}
+
+	FILE* fp = fopen(GetTestCSVFilename("_Divergence"), "w");
+	if(!fp)
+		return;
+
+	const char* Sep = gCommaSeparator ? ", " : "; ";
+	fprintf_s(fp, "%s - Position drift vs %s (max, avg)\n\n", gRunningTest->GetName(), Ref.mEngineName);
+	fprintf_s(fp, "First divergent frame");
+	for(udword i=Reference+1;i<gNbEngines;i++)
+	{
+		const DeterminismRun& Run = gCurrentRuns[i];
+		if(!Run.mMaxDrift)
+			continue;
+		if(Run.mFirstDivergentFrame==INVALID_ID)
+			fprintf_s(fp, "%snone%s", Sep, Sep);
+		else
+			fprintf_s(fp, "%s%d%s", Sep, Run.mFirstDivergentFrame, Sep);
+	}
+	fprintf_s(fp, "\nFrame");
+	for(udword i=Reference+1;i<gNbEngines;i++)
+	{
+		if(gCurrentRuns[i].mMaxDrift)
+			fprintf_s(fp, "%s%s (max)%s%s (avg)", Sep, gCurrentRuns[i].mEngineName, Sep, gCurrentRuns[i].mEngineName);
+	}
+	fprintf_s(fp, "\n");
+
+	for(udword f=0;f<NbFrames;f++)
+	{
+		fprintf_s(fp, "%d", f);
+		for(udword i=Reference+1;i<gNbEngines;i++)
+		{
+			const DeterminismRun& Run = gCurrentRuns[i];
+			if(!Run.mMaxDrift)
+				continue;
+			if(f<Run.mNbFrames)
+				fprintf_s(fp, "%s%f%s%f", Sep, Run.mMaxDrift[f], Sep, Run.mAvgDrift[f]);
+			else
+				fprintf_s(fp, "%s%s", Sep, Sep);
+		}
+		fprintf_s(fp, "\n");
+	}
+	fclose(fp);
+}
+
+void ReportDeterminism()
+{
+	if(!gDeterminismCheck || !gRunningTest)
+		return;
+
+	// Before the run-to-run report, which can move the current runs to the reference
+	ReportCrossEngine();
+	ReportRunToRun();
+
+	for(udword i=0;i<MAX_NB_ENGINES;i++)
+		gCurrentRuns[i].Release();
+}
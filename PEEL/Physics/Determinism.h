@@ -0,0 +1,38 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef DETERMINISM_H
+#define DETERMINISM_H
+
+	// Determinism & divergence tracking. With gDeterminismCheck, the poses of all objects in each engine's ObjectsManager
+	// are read back after each frame (after the test's update, outside of the timed sections) and hashed bit-for-bit.
+	// When the test is closed, two reports are made:
+	//
+	// - Run-to-run: the first run of a test is kept as the reference run of each engine. The next runs of the same test,
+	// e.g. with a different gNbWorkerThreads, are compared to it: the first frame whose hash differs, and the drift of each
+	// body between the final poses. A bit-deterministic engine reports no divergence. Results go to Test_Determinism.csv.
+	//
+	// - Cross-engine: each engine is compared to the first simulated engine, frame by frame, if they have the same number
+	// of objects (i.e. the test created the same scene for both). This gives the first frame whose hash differs (useful to
+	// compare two versions of an engine) and the max & average position drift per frame, saved to Test_Divergence.csv.
+	//
+	// Hashes & drifts are only recorded for the first MAX_NB_RECORDED_FRAMES frames, final poses are compared in any case.
+
+	extern	bool	gDeterminismCheck;
+
+	// Called when a test starts, after the engines have been setup
+	void	StartDeterminismRun();
+	// Called at the end of each frame
+	void	RecordDeterminismFrame();
+	// Called when the running test is closed, before the engines release their objects. The first run of a test becomes
+	// the reference run, later runs are compared to it.
+	void	ReportDeterminism();
+	// Discards the reference runs, so that the next run of a test becomes the new reference
+	void	ResetDeterminismReference();
+
+#endif
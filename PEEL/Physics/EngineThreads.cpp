@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "EngineThreads.h"
+#include "Simulation.h"
+#include "RunConfig.h"
+
+namespace
+{
+	struct EngineWorker
+	{
+		IceThread*	mThread;
+		IceSem*		mStart;
+		udword		mIndex;
+	};
+}
+
+static EngineWorker	gWorkers[MAX_NB_ENGINES];
+static udword		gNbWorkers = 0;
+static IceSem*		gWorkersDone = null;
+
+// Current job. Written by the main thread before the workers are woken up, the semaphores take care of visibility.
+static EngineTask	gTask = null;
+static void*		gTaskUserData = null;
+
+void ThreadSetup();
+
+static int gEngineWorkerThread(void* user_data)
+{
+	ThreadSetup();
+
+	const EngineWorker* Worker = (const EngineWorker*)user_data;
+	while(1)
+	{
+		SemWait(Worker->mStart);
+
+		// A null task is the exit signal
+		const EngineTask Task = gTask;
+		if(!Task)
+			break;
+
+		(Task)(Worker->mIndex, gTaskUserData);
+
+		SemPost(gWorkersDone);
+	}
+	return 0;
+}
+
+static udword GetNbCores()
+{
+	SYSTEM_INFO Info;
+	GetSystemInfo(&Info);
+	return Info.dwNumberOfProcessors;
+}
+
+static void CreateEngineThreads(udword nb)
+{
+	ASSERT(!gNbWorkers);
+	ASSERT(nb<=MAX_NB_ENGINES);
+
+	gWorkersDone = CreateSemaphore(0);
+
+	const udword NbCores = GetNbCores();
+	const udword MaxNbCores = sizeof(DWORD_PTR)*8;
+
+	for(udword i=0;i<nb;i++)
+	{
+		EngineWorker& Worker = gWorkers[i];
+		Worker.mIndex	= i;
+		Worker.mStart	= CreateSemaphore(0);
+		Worker.mThread	= CreateThread(gEngineWorkerThread, &Worker);
+
+		// Use the simulation cores from the run config if any, else leave core 0 to the main thread, unless there is only one
+		udword Core;
+		if(!GetEngineThreadCore(i, Core))
+			Core = NbCores>1 ? 1 + (i % (NbCores-1)) : 0;
+		if(Core>=MaxNbCores)
+			Core %= MaxNbCores;
+		if(Worker.mThread)
+			SetThreadAffinityMask(Worker.mThread->handle, DWORD_PTR(1)<<Core);
+	}
+	gNbWorkers = nb;
+
+	if(nb>=NbCores)
+		printf("WARNING: %d engine threads for %d cores, some engines share a core.\n", nb, NbCores);
+}
+
+void ReleaseEngineThreads()
+{
+	if(!gNbWorkers)
+		return;
+
+	gTask = null;
+	gTaskUserData = null;
+	for(udword i=0;i<gNbWorkers;i++)
+		SemPost(gWorkers[i].mStart);
+
+	for(udword i=0;i<gNbWorkers;i++)
+	{
+		WaitThread(gWorkers[i].mThread, null);
+		DestroySemaphore(gWorkers[i].mStart);
+		gWorkers[i].mThread = null;
+		gWorkers[i].mStart = null;
+	}
+	DestroySemaphore(gWorkersDone);
+	gWorkersDone = null;
+	gNbWorkers = 0;
+}
+
+udword GetNbEngineThreads()
+{
+	return gNbWorkers;
+}
+
+void RunEngineTasks(udword nb_engines, EngineTask task, void* user_data)
+{
+	ASSERT(task);
+	if(!nb_engines)
+		return;
+
+	if(gNbWorkers<nb_engines)
+	{
+		ReleaseEngineThreads();
+		CreateEngineThreads(nb_engines);
+	}
+
+	gTask = task;
+	gTaskUserData = user_data;
+	for(udword i=0;i<nb_engines;i++)
+		SemPost(gWorkers[i].mStart);
+
+	for(udword i=0;i<nb_engines;i++)
+		SemWait(gWorkersDone);
+}
@@ -0,0 +1,28 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef ENGINE_THREADS_H
+#define ENGINE_THREADS_H
+
+	// One worker thread per engine, each pinned to its own core (core 0 is left to the main thread when possible,
+	// or the simulation cores are used, see RunConfig.h).
+	// Workers sleep between calls, so engines can still be used from the main thread (rendering, picking, etc)
+	// as long as RunEngineTasks() is not running.
+
+	typedef void	(*EngineTask)	(udword engine_index, void* user_data);
+
+	// Runs task(i, user_data) on worker i, for i in [0, nb_engines[, and waits for all of them to complete.
+	// Workers are (re)created when needed.
+	void	RunEngineTasks(udword nb_engines, EngineTask task, void* user_data);
+
+	// Stops and releases all workers.
+	void	ReleaseEngineThreads();
+
+	udword	GetNbEngineThreads();
+
+#endif
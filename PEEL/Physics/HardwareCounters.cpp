@@ -0,0 +1,197 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "HardwareCounters.h"
+
+#ifdef __linux__
+	#include <linux/perf_event.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+	#include <string.h>
+#endif
+
+const char* GetHardwareCounterName(HardwareCounter counter)
+{
+	switch(counter)
+	{
+		case HW_COUNTER_CYCLES:			return "Cycles";
+		case HW_COUNTER_INSTRUCTIONS:	return "Instructions";
+		case HW_COUNTER_L1D_MISSES:		return "L1D misses";
+		case HW_COUNTER_LLC_MISSES:		return "LLC misses";
+		case HW_COUNTER_BRANCH_MISSES:	return "Branch misses";
+		case HW_COUNTER_DTLB_MISSES:	return "dTLB misses";
+	};
+	return null;
+}
+
+void GetHardwareCountersDelta(HardwareCounterValues& delta, const HardwareCounterValues& start, const HardwareCounterValues& end)
+{
+	for(udword i=0;i<HW_COUNTER_COUNT;i++)
+		delta.mValues[i] = end.mValues[i]>start.mValues[i] ? end.mValues[i] - start.mValues[i] : 0;
+}
+
+#ifdef __linux__
+
+static int gCounterFDs[HW_COUNTER_COUNT] = { -1, -1, -1, -1, -1, -1 };
+
+static int OpenCounter(udword type, uqword config)
+{
+	perf_event_attr Attr;
+	memset(&Attr, 0, sizeof(Attr));
+	Attr.size			= sizeof(Attr);
+	Attr.type			= type;
+	Attr.config			= config;
+	Attr.inherit		= 1;
+	Attr.exclude_kernel	= 1;
+	Attr.exclude_hv		= 1;
+	// Counters are not grouped (groups can't be inherited), so the kernel may multiplex them. Reads are scaled accordingly.
+	Attr.read_format	= PERF_FORMAT_TOTAL_TIME_ENABLED|PERF_FORMAT_TOTAL_TIME_RUNNING;
+	return int(syscall(__NR_perf_event_open, &Attr, 0, -1, -1, 0));
+}
+
+static inline_ uqword CacheConfig(uqword cache, uqword op, uqword result)
+{
+	return cache | (op<<8) | (result<<16);
+}
+
+bool InitHardwareCounters()
+{
+	if(gCounterFDs[HW_COUNTER_CYCLES]!=-1)
+		return true;
+
+	gCounterFDs[HW_COUNTER_CYCLES]			= OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+	gCounterFDs[HW_COUNTER_INSTRUCTIONS]	= OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+	gCounterFDs[HW_COUNTER_L1D_MISSES]		= OpenCounter(PERF_TYPE_HW_CACHE, CacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS));
+	gCounterFDs[HW_COUNTER_LLC_MISSES]		= OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+	gCounterFDs[HW_COUNTER_BRANCH_MISSES]	= OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+	gCounterFDs[HW_COUNTER_DTLB_MISSES]		= OpenCounter(PERF_TYPE_HW_CACHE, CacheConfig(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS));
+
+	if(gCounterFDs[HW_COUNTER_CYCLES]==-1)
+	{
+		printf("WARNING: hardware counters unavailable (check /proc/sys/kernel/perf_event_paranoid).\n");
+		CloseHardwareCounters();
+		return false;
+	}
+
+	for(udword i=0;i<HW_COUNTER_COUNT;i++)
+	{
+		if(gCounterFDs[i]==-1)
+			printf("WARNING: hardware counter '%s' unavailable, reported as 0.\n", GetHardwareCounterName(HardwareCounter(i)));
+	}
+	return true;
+}
+
+void CloseHardwareCounters()
+{
+	for(udword i=0;i<HW_COUNTER_COUNT;i++)
+	{
+		if(gCounterFDs[i]!=-1)
+		{
+			close(gCounterFDs[i]);
+			gCounterFDs[i] = -1;
+		}
+	}
+}
+
+bool IsHardwareCounterAvailable(HardwareCounter counter)
+{
+	return gCounterFDs[counter]!=-1;
+}
+
+void ReadHardwareCounters(HardwareCounterValues& values)
+{
+	for(udword i=0;i<HW_COUNTER_COUNT;i++)
+	{
+		values.mValues[i] = 0;
+		if(gCounterFDs[i]==-1)
+			continue;
+
+		uqword Data[3];	// Value, time enabled, time running
+		if(read(gCounterFDs[i], Data, sizeof(Data))!=sizeof(Data))
+			continue;
+
+		if(Data[2] && Data[2]<Data[1])
+			values.mValues[i] = uqword(double(Data[0])*double(Data[1])/double(Data[2]));
+		else
+			values.mValues[i] = Data[0];
+	}
+}
+
+#elif defined(_WIN32)
+
+// Windows doesn't give user-mode access to the PMU, so only cycles are available there, through QueryProcessCycleTime.
+// It covers all the threads of the process, including worker threads created before the counters were initialized, but
+// also kernel-mode time. The function is loaded dynamically since it doesn't exist before Vista.
+typedef BOOL (WINAPI *QueryProcessCycleTimeFunc)(HANDLE, PULONG64);
+static QueryProcessCycleTimeFunc gQueryProcessCycleTime = null;
+
+bool InitHardwareCounters()
+{
+	if(gQueryProcessCycleTime)
+		return true;
+
+	gQueryProcessCycleTime = (QueryProcessCycleTimeFunc)GetProcAddress(GetModuleHandleA("kernel32.dll"), "QueryProcessCycleTime");
+	if(!gQueryProcessCycleTime)
+	{
+		printf("WARNING: hardware counters unavailable (QueryProcessCycleTime needs Windows Vista or later).\n");
+		return false;
+	}
+
+	for(udword i=0;i<HW_COUNTER_COUNT;i++)
+	{
+		if(i!=HW_COUNTER_CYCLES)
+			printf("WARNING: hardware counter '%s' unavailable on Windows, reported as 0.\n", GetHardwareCounterName(HardwareCounter(i)));
+	}
+	return true;
+}
+
+void CloseHardwareCounters()
+{
+	gQueryProcessCycleTime = null;
+}
+
+bool IsHardwareCounterAvailable(HardwareCounter counter)
+{
+	return counter==HW_COUNTER_CYCLES && gQueryProcessCycleTime;
+}
+
+void ReadHardwareCounters(HardwareCounterValues& values)
+{
+	for(udword i=0;i<HW_COUNTER_COUNT;i++)
+		values.mValues[i] = 0;
+
+	ULONG64 Cycles;
+	if(gQueryProcessCycleTime && gQueryProcessCycleTime(GetCurrentProcess(), &Cycles))
+		values.mValues[HW_COUNTER_CYCLES] = Cycles;
+}
+
+#else
+
+bool InitHardwareCounters()
+{
+	printf("WARNING: hardware counters are not supported on this platform.\n");
+	return false;
+}
+
+void CloseHardwareCounters()
+{
+}
+
+bool IsHardwareCounterAvailable(HardwareCounter)
+{
+	return false;
+}
+
+void ReadHardwareCounters(HardwareCounterValues& values)
+{
+	for(udword i=0;i<HW_COUNTER_COUNT;i++)
+		values.mValues[i] = 0;
+}
+
+#endif
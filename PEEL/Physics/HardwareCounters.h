@@ -0,0 +1,45 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef HARDWARE_COUNTERS_H
+#define HARDWARE_COUNTERS_H
+
+	enum HardwareCounter
+	{
+		HW_COUNTER_CYCLES,
+		HW_COUNTER_INSTRUCTIONS,
+		HW_COUNTER_L1D_MISSES,
+		HW_COUNTER_LLC_MISSES,
+		HW_COUNTER_BRANCH_MISSES,
+		HW_COUNTER_DTLB_MISSES,
+
+		HW_COUNTER_COUNT
+	};
+
+	struct HardwareCounterValues
+	{
+		uqword	mValues[HW_COUNTER_COUNT];
+
+		inline_	float	GetIPC()	const	{ return mValues[HW_COUNTER_CYCLES] ? float(double(mValues[HW_COUNTER_INSTRUCTIONS])/double(mValues[HW_COUNTER_CYCLES])) : 0.0f;	}
+	};
+
+	// Optional CPU performance counters. On Linux they are based on perf_event_open: counters are opened for the calling
+	// thread and inherited by threads created afterwards, so they must be initialized before the plugins create their
+	// worker threads (i.e. before a test starts) to include multithreaded work. On Windows only process-wide cycles are
+	// available (QueryProcessCycleTime). Counters that the CPU or the OS doesn't expose are reported as 0, see
+	// IsHardwareCounterAvailable(). InitHardwareCounters() returns false when nothing is available.
+	bool		InitHardwareCounters();
+	void		CloseHardwareCounters();
+	bool		IsHardwareCounterAvailable(HardwareCounter counter);
+	const char*	GetHardwareCounterName(HardwareCounter counter);
+
+	// Usage: ReadHardwareCounters(start); ...profiled code...; ReadHardwareCounters(end); delta = end - start.
+	void		ReadHardwareCounters(HardwareCounterValues& values);
+	void		GetHardwareCountersDelta(HardwareCounterValues& delta, const HardwareCounterValues& start, const HardwareCounterValues& end);
+
+#endif
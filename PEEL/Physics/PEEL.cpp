@@ -27,6 +27,14 @@
 #include "Script.h"
 #include "RepX_Tools.h"
 #include "TestSelector.h"
+#include "Simulation.h"
+#include "BenchmarkStats.h"
+#include "ResultsWriter.h"
+#include "RegressionGate.h"
+#include "RunConfig.h"
+#include "SQThreads.h"
+#include "PintCapture.h"
+#include "Determinism.h"
 #include "CustomICEAllocator.h"
 #include "GUI_Helpers.h"
 
@@ -48,18 +56,13 @@ static	int					gMouseY = 0;
 static	bool				gWireframe = false;
 static	bool				gWireframeOverlay = true;
 static	bool				gAutoCameraMove = false;
-static	bool				gPaused = false;
 static	bool				gOneFrame = false;
 static	bool				gRender = true;
 static	bool				gMenuIsVisible = true;
 static	bool				gHelpIsVisible = false;
 static	int					gCurrentTest = 0;
-static	PhysicsTest*		gRunningTest = null;
 static	PhysicsTest*		gCandidateTest = null;
-static	bool				gRandomizeOrder = false;
-static	bool				gTrashCache = false;
 static	bool				gEnableVSync = true;
-static	bool				gCommaSeparator = false;
 static	bool				gDisplayMessage = false;
 static	float				gDisplayMessageDelay = 0.0f;
 static	udword				gDisplayMessageType = 0;
@@ -78,22 +81,6 @@ static	float				gBoxVelocity = 100.0f;
 static	PintObjectHandle	gTrackedObject = null;
 static	Pint*				gTrackedEngine = null;
 
-enum ProfilingUnits
-{
-	PROFILING_UNITS_RDTSC,
-	PROFILING_UNITS_TIME_GET_TIME,
-	PROFILING_UNITS_QPC,
-};
-static	ProfilingUnits	gProfilingUnits = PROFILING_UNITS_RDTSC;
-
-enum SQProfilingMode
-{
-	SQ_PROFILING_SIM,
-	SQ_PROFILING_UPDATE,
-	SQ_PROFILING_COMBINED,
-};
-static	SQProfilingMode	gSQProfilingMode = SQ_PROFILING_UPDATE;
-
 enum SQRaycastMode
 {
 	SQ_RAYCAST_CLOSEST,
@@ -135,9 +122,6 @@ static GLFontRenderer			gTexter;
 /*static*/ udword				gScreenHeight	= INITIAL_SCREEN_HEIGHT;
 static FPS						gFPS;
 
-#define MAX_NB_ENGINES			32
-static udword					gFrameNb = 0;
-
 class GUIHelper : public PintGUIHelper
 {
 	public:
@@ -165,83 +149,19 @@ struct CursorKeysState
 
 static CursorKeysState gState;
 
-static void TestCSVExport();
+static void ExportResults();
 static void PEEL_InitGUI();
 static void PEEL_CloseGUI();
 static void gPEEL_GetOptionsFromGUI();
 static void gPEEL_PollRadioButtons();
 
-struct EngineData
-{
-	EngineData() :
-		mEngine					(null),
-		mEnabled				(true),
-		mSupportsCurrentTest	(true)
-	{
-		mDragPoint.Zero();
-		mLocalPoint.Zero();
-	}
-
-	Pint*					mEngine;
-	PintSQ					mSQHelper;
-	ObjectsManager			mOMHelper;
-	PintTiming				mTiming;
-	PintRaycastHit			mPickingData;
-	Point					mDragPoint;
-	Point					mLocalPoint;
-	bool					mEnabled;
-	bool					mSupportsCurrentTest;
-};
-static EngineData			gEngines[MAX_NB_ENGINES];
-static udword				gNbEngines = 0;
-static udword				gNbSimulateCallsPerFrame = 1;
-static float				gTimestep = 1.0f/60.0f;
-
 class RaytracingWindow;
-static PintPlugin*			gPlugIns[MAX_NB_ENGINES];
 static RaytracingWindow*	gRaytracingWindows[MAX_NB_ENGINES] = {0};
-static udword				gNbPlugIns = 0;
 
 /*static*/ String*				gRoot = null;
 
 static CameraData			gCamera;
 
-typedef PintPlugin* (*GetPintPlugin)	();
-
-static PintPlugin* LoadPlugIn(const char* filename)
-{
-/*	LIBRARY LibHandle;
-	if(!IceCore::LoadLibrary(filename, LibHandle, true))
-		return null;
-
-	GetPintPlugin func = (GetPintPlugin)BindSymbol(LibHandle, "GetPintPlugin");
-	if(!func)
-	{
-		UnloadLibrary(LibHandle);
-		return null;
-	}
-	return (func)();*/
-
-	udword FPUEnv[256];
-	FillMemory(FPUEnv, 256*4, 0xff);
-	__asm fstenv FPUEnv
-		HMODULE handle = ::LoadLibraryA(filename);
-	__asm fldenv FPUEnv
-	if(!handle)
-	{
-		printf("WARNING: plugin %s failed to load.\n", filename);
-		return null;
-	}
-	GetPintPlugin func = (GetPintPlugin)GetProcAddress(handle, "GetPintPlugin");
-	if(!func)
-	{
-		printf("WARNING: plugin %s is invalid.\n", filename);
-		FreeLibrary(handle);
-		return null;
-	}
-	return (func)();
-}
-
 static void InitAll(PhysicsTest* test)
 {
 	PINT_WORLD_CREATE Desc;
@@ -268,14 +188,7 @@ static void InitAll(PhysicsTest* test)
 		}
 
 		// We must get the scene params after initializing the UI
-		test->GetSceneParams(Desc);
-
-		class Access : public PINT_WORLD_CREATE
-		{
-			public:
-			void SetName(const char* name)	{ mTestName = name; }
-		};
-		static_cast<Access&>(Desc).SetName(test->GetName());
+		GetTestSceneParams(test, Desc);
 
 		//### crude test - autodetect changes in camera data & reset camera if we found any
 		if(!MustResetCamera)
@@ -298,70 +211,20 @@ static void InitAll(PhysicsTest* test)
 		//Desc.mGravity	= Point(0.0f, 0.0f, 0.0f);
 	}
 
-	for(udword i=0;i<gNbPlugIns;i++)
-		gPlugIns[i]->Init(Desc);
-
-	gNbSimulateCallsPerFrame = Desc.mNbSimulateCallsPerFrame;
-	gTimestep = Desc.mTimestep;
+	InitEngines(Desc);
 
-	gNbEngines = 0;
-	for(udword i=0;i<gNbPlugIns;i++)
-	{
-		ASSERT(gNbEngines!=MAX_NB_ENGINES);
-		Pint* Engine = gPlugIns[i]->GetPint();
-		ASSERT(Engine);
-		gEngines[gNbEngines].mOMHelper.Init(Engine);
-		gEngines[gNbEngines].mSQHelper.Init(Engine);
-		gEngines[gNbEngines++].mEngine = Engine;
-	}
 	gPEEL_GetOptionsFromGUI();
 }
 
-static void CloseRunningTest()
+static void CloseAll()
 {
-	if(gRunningTest)
-	{
-		for(udword i=0;i<gNbEngines;i++)
-		{
-			ASSERT(gEngines[i].mEngine);
-			gRunningTest->Close(*gEngines[i].mEngine);
-		}
-		gRunningTest->CommonRelease();
-	}
+	CloseEngines();
+
 	gTrackedObject = null;
 	gTrackedEngine = null;
 	gState.Reset();
 }
 
-static void ResetSQHelpersHitData()
-{
-	for(udword i=0;i<gNbEngines;i++)
-		gEngines[i].mSQHelper.ResetHitData();
-}
-
-static void CloseAll()
-{
-	CloseRunningTest();
-
-	for(udword i=0;i<gNbEngines;i++)
-	{
-		gEngines[i].mOMHelper.Reset();
-		gEngines[i].mSQHelper.Reset();
-	}
-
-	for(udword i=0;i<gNbPlugIns;i++)
-		gPlugIns[i]->Close();
-
-	ReleaseAllShapeRenderers();
-}
-
-static void ResetTimers()
-{
-	gFrameNb = 0;
-	for(udword i=0;i<gNbEngines;i++)
-		gEngines[i].mTiming.ResetTimings();
-}
-
 static void ActivateTest(PhysicsTest* test=null)
 {
 	if(test)
@@ -381,14 +244,7 @@ static void ActivateTest(PhysicsTest* test=null)
 			CloseAll();
 			InitAll(gCandidateTest);
 
-			gRunningTest = gCandidateTest;
-			ResetTimers();
-			gRunningTest->CommonSetup();
-			for(udword i=0;i<gNbEngines;i++)
-			{
-				ASSERT(gEngines[i].mEngine);
-				gEngines[i].mSupportsCurrentTest = gRunningTest->Init(*gEngines[i].mEngine);
-			}
+			StartTest(gCandidateTest);
 
 			gMenuIsVisible = false;
 		}
@@ -500,7 +356,7 @@ static void KeyboardCallback(unsigned char key, int x, int y)
 			break;
 		case 's':
 		case 'S':
-			TestCSVExport();
+			ExportResults();
 			break;
 		case 'w':
 		case 'W':
@@ -786,292 +642,6 @@ static void MotionCallback(int x, int y)
 	}
 }
 
-#include "QPCTime.h"
-static QPCTime	mQPCTimer;
-
-	static inline_ void	StartProfile_RDTSC(udword& val)
-	{
-		__asm{
-			cpuid
-			rdtsc
-			mov		ebx, val
-			mov		[ebx], eax
-		}
-//		val = __rdtsc();
-	}
-
-	static inline_ void	EndProfile_RDTSC(udword& val)
-	{
-		__asm{
-			cpuid
-			rdtsc
-			mov		ebx, val
-			sub		eax, [ebx]
-			mov		[ebx], eax
-		}
-//		val = __rdtsc() - val;
-	}
-
-	static inline_ void	StartProfile_TimeGetTime(udword& val)
-	{
-		val = timeGetTime();
-	}
-
-	static inline_ void	EndProfile_TimeGetTime(udword& val)
-	{
-		val = timeGetTime() - val;
-	}
-
-	static inline_ void	StartProfile_QPC()
-	{
-		mQPCTimer.getElapsedSeconds();
-	}
-
-	static inline_ void	EndProfile_QPC(QPCTime::Second& val)
-	{
-		val = mQPCTimer.getElapsedSeconds();
-	}
-
-static udword ProfileUpdate_RDTSC(EngineData& engine, float dt)
-{
-	udword val, CurrentMemory;
-	{
-		::StartProfile_RDTSC(val);
-			CurrentMemory = engine.mEngine->Update(dt);
-		::EndProfile_RDTSC(val);
-	}
-	const udword Time = val/1024;
-	engine.mTiming.RecordTimeAndMemory(Time, CurrentMemory, gFrameNb);
-	return Time;
-}
-
-static udword ProfileUpdate_TimeGetTime(EngineData& engine, float dt)
-{
-	udword val, CurrentMemory;
-	{
-		::StartProfile_TimeGetTime(val);
-			CurrentMemory = engine.mEngine->Update(dt);
-		::EndProfile_TimeGetTime(val);
-	}
-	const udword Time = val;
-	engine.mTiming.RecordTimeAndMemory(Time, CurrentMemory, gFrameNb);
-	return Time;
-}
-
-static udword ProfileUpdate_QPC(EngineData& engine, float dt)
-{
-	udword val, CurrentMemory;
-	{
-		QPCTime::Second s;
-		::StartProfile_QPC();
-			CurrentMemory = engine.mEngine->Update(dt);
-		::EndProfile_QPC(s);
-		val = udword(s*1000000.0);
-	}
-	const udword Time = val;
-	engine.mTiming.RecordTimeAndMemory(Time, CurrentMemory, gFrameNb);
-	return Time;
-}
-
-static void NoProfileUpdate(EngineData& engine, float dt)
-{
-	engine.mEngine->Update(dt);
-}
-
-static udword ProfileTestUpdate_RDTSC(PhysicsTest* test, EngineData& engine, float dt)
-{
-	udword val, TestResult;
-	{
-		::StartProfile_RDTSC(val);
-			TestResult = gRunningTest->Update(*engine.mEngine, dt);
-		::EndProfile_RDTSC(val);
-	}
-	const udword Time = val/1024;
-	engine.mTiming.RecordTimeAndMemory(Time, 0, gFrameNb);
-	engine.mTiming.mCurrentTestResult = TestResult;
-	return Time;
-}
-
-static udword ProfileTestUpdate_TimeGetTime(PhysicsTest* test, EngineData& engine, float dt)
-{
-	udword val, TestResult;
-	{
-		::StartProfile_TimeGetTime(val);
-			TestResult = gRunningTest->Update(*engine.mEngine, dt);
-		::EndProfile_TimeGetTime(val);
-	}
-	const udword Time = val;
-	engine.mTiming.RecordTimeAndMemory(Time, 0, gFrameNb);
-	engine.mTiming.mCurrentTestResult = TestResult;
-	return Time;
-}
-
-static udword ProfileTestUpdate_QPC(PhysicsTest* test, EngineData& engine, float dt)
-{
-	udword val, TestResult;
-	{
-		QPCTime::Second s;
-		::StartProfile_QPC();
-			TestResult = gRunningTest->Update(*engine.mEngine, dt);
-		::EndProfile_QPC(s);
-		val = udword(s*1000000.0);
-	}
-	const udword Time = val;
-	engine.mTiming.RecordTimeAndMemory(Time, 0, gFrameNb);
-	engine.mTiming.mCurrentTestResult = TestResult;
-	return Time;
-}
-
-static udword ProfileTestUpdate_RDTSC_Combined(PhysicsTest* test, EngineData& engine, float dt)
-{
-	udword val, TestResult;
-	{
-		::StartProfile_RDTSC(val);
-			TestResult = gRunningTest->Update(*engine.mEngine, dt);
-		::EndProfile_RDTSC(val);
-	}
-	const udword Time = val/1024;
-	engine.mTiming.UpdateRecordedTime(Time, gFrameNb);
-	engine.mTiming.mCurrentTestResult = TestResult;
-	return Time;
-}
-
-static udword ProfileTestUpdate_TimeGetTime_Combined(PhysicsTest* test, EngineData& engine, float dt)
-{
-	udword val, TestResult;
-	{
-		::StartProfile_TimeGetTime(val);
-			TestResult = gRunningTest->Update(*engine.mEngine, dt);
-		::EndProfile_TimeGetTime(val);
-	}
-	const udword Time = val;
-	engine.mTiming.UpdateRecordedTime(Time, gFrameNb);
-	engine.mTiming.mCurrentTestResult = TestResult;
-	return Time;
-}
-
-static udword ProfileTestUpdate_QPC_Combined(PhysicsTest* test, EngineData& engine, float dt)
-{
-	udword val, TestResult;
-	{
-		QPCTime::Second s;
-		::StartProfile_QPC();
-			TestResult = gRunningTest->Update(*engine.mEngine, dt);
-		::EndProfile_QPC(s);
-		val = udword(s*1000000.0);
-	}
-	const udword Time = val;
-	engine.mTiming.UpdateRecordedTime(Time, gFrameNb);
-	engine.mTiming.mCurrentTestResult = TestResult;
-	return Time;
-}
-
-static void Simulate()
-{
-	if(0 && gTrashCache)
-	{
-		gRender = true;
-		static udword Count=0;
-		Count++;
-		if(Count!=16)
-			return;
-		Count=0;
-	}
-
-	if(gPaused)
-		return;
-
-	const float dt = gTimestep;
-
-	Permutation P;
-	P.Init(gNbEngines);
-	if(gRandomizeOrder)
-		P.Random(gNbEngines*2);
-	else
-		P.Identity();
-
-	const bool MustProfileTestUpdate = gRunningTest ? gRunningTest->ProfileUpdate() : false;
-
-	udword CurrentTime;
-	for(udword ii=0;ii<gNbEngines;ii++)
-	{
-		const udword i = P[ii];
-		if(!gEngines[i].mEnabled || !gEngines[i].mSupportsCurrentTest)
-			continue;
-
-		ASSERT(gEngines[i].mEngine);
-		if(		MustProfileTestUpdate
-			&&	gSQProfilingMode==SQ_PROFILING_UPDATE)
-		{
-			NoProfileUpdate(gEngines[i], dt);
-		}
-		else
-		{
-			if(gProfilingUnits==PROFILING_UNITS_RDTSC)
-				CurrentTime = ProfileUpdate_RDTSC(gEngines[i], dt);
-			else if(gProfilingUnits==PROFILING_UNITS_TIME_GET_TIME)
-				CurrentTime = ProfileUpdate_TimeGetTime(gEngines[i], dt);
-			else if(gProfilingUnits==PROFILING_UNITS_QPC)
-				CurrentTime = ProfileUpdate_QPC(gEngines[i], dt);
-			else ASSERT(0);
-		}
-//		printf(_F("%s: %d (Avg: %d)(Worst: %d)\n", gEngines[i].mEngine->GetName(), CurrentTime, gEngines[i].mTiming.GetAvgTime(), gEngines[i].mTiming.mWorstTime));
-
-		gEngines[i].mEngine->UpdateNonProfiled(dt);
-
-		if(gTrashCache)
-			trashCache();
-//			trashIcacheAndBranchPredictors();
-	}
-
-	if(gRunningTest)
-	{
-		gRunningTest->CommonUpdate(dt);
-		for(udword ii=0;ii<gNbEngines;ii++)
-		{
-			const udword i = P[ii];
-			if(!gEngines[i].mEnabled || !gEngines[i].mSupportsCurrentTest)
-				continue;
-
-			ASSERT(gEngines[i].mEngine);
-			if(MustProfileTestUpdate)
-			{
-				if(gSQProfilingMode==SQ_PROFILING_SIM)
-				{
-					gRunningTest->Update(*gEngines[i].mEngine, dt);
-				}
-				else if(gSQProfilingMode==SQ_PROFILING_UPDATE)
-				{
-					if(gProfilingUnits==PROFILING_UNITS_RDTSC)
-						CurrentTime = ProfileTestUpdate_RDTSC(gRunningTest, gEngines[i], dt);
-					else if(gProfilingUnits==PROFILING_UNITS_TIME_GET_TIME)
-						CurrentTime = ProfileTestUpdate_TimeGetTime(gRunningTest, gEngines[i], dt);
-					else if(gProfilingUnits==PROFILING_UNITS_QPC)
-						CurrentTime = ProfileTestUpdate_QPC(gRunningTest, gEngines[i], dt);
-					else ASSERT(0);
-				}
-				else
-				{
-					if(gProfilingUnits==PROFILING_UNITS_RDTSC)
-						CurrentTime = ProfileTestUpdate_RDTSC_Combined(gRunningTest, gEngines[i], dt);
-					else if(gProfilingUnits==PROFILING_UNITS_TIME_GET_TIME)
-						CurrentTime = ProfileTestUpdate_TimeGetTime_Combined(gRunningTest, gEngines[i], dt);
-					else if(gProfilingUnits==PROFILING_UNITS_QPC)
-						CurrentTime = ProfileTestUpdate_QPC_Combined(gRunningTest, gEngines[i], dt);
-					else ASSERT(0);
-				}
-			}
-			else
-			{
-				// Normal update without profiling
-				gRunningTest->Update(*gEngines[i].mEngine, dt);
-			}
-		}
-	}
-
-	gFrameNb++;
-}
-
 static void PrintTimings()
 {
 //	const float TextScale = 0.02f * float(INITIAL_SCREEN_HEIGHT) / float(gScreenHeight);
@@ -1100,13 +670,25 @@ static void PrintTimings()
 			if(gEngines[i].mSupportsCurrentTest)
 			{
 				const PintTiming& Timing = gEngines[i].mTiming;
+				const PintHistogram& H = Timing.mHistogram;
 				if(MustProfileTestUpdate)
 //					gTexter.print(0.0f, y, TextScale, _F("%s: %d (Avg: %d)(Worst: %d)(%d Kb)(Test value: %d)\n",
-					gTexter.print(0.0f, y, TextScale, _F("%s: %d (Avg: %d)(Worst: %d)(Nb hits: %d)\n",
-						Engine->GetName(), Timing.mCurrentTime, Timing.GetAvgTime(), Timing.mWorstTime, Timing.mCurrentTestResult));
+					gTexter.print(0.0f, y, TextScale, _F("%s: %d (Avg: %d)(p50/p99/p99.9: %d/%d/%d)(Worst: %d)(Nb hits: %d)\n",
+						Engine->GetName(), Timing.mCurrentTime, Timing.GetAvgTime(), H.GetPercentile(50.0f), H.GetPercentile(99.0f), H.GetPercentile(99.9f), Timing.GetWorstTime(), Timing.mCurrentTestResult));
 				else
-					gTexter.print(0.0f, y, TextScale, _F("%s: %d (Avg: %d)(Worst: %d)(%d Kb)\n",
-						Engine->GetName(), Timing.mCurrentTime, Timing.GetAvgTime(), Timing.mWorstTime, Timing.mCurrentMemory/1024));
+					gTexter.print(0.0f, y, TextScale, _F("%s: %d (Avg: %d)(p50/p99/p99.9: %d/%d/%d)(Worst: %d)(%d Kb)\n",
+						Engine->GetName(), Timing.mCurrentTime, Timing.GetAvgTime(), H.GetPercentile(50.0f), H.GetPercentile(99.0f), H.GetPercentile(99.9f), Timing.GetWorstTime(), udword(Timing.mCurrentMemory/1024)));
+
+				if(gHardwareCounters && Timing.HasCounters())
+				{
+					const HardwareCounterValues& C = Timing.mCurrentCounters;
+					y -= TextScale;
+					if(IsHardwareCounterAvailable(HW_COUNTER_INSTRUCTIONS))
+						gTexter.print(0.0f, y, TextScale, _F("    IPC: %.2f (L1D misses: %d)(LLC misses: %d)(Branch misses: %d)(dTLB misses: %d)\n",
+							C.GetIPC(), udword(C.mValues[HW_COUNTER_L1D_MISSES]), udword(C.mValues[HW_COUNTER_LLC_MISSES]), udword(C.mValues[HW_COUNTER_BRANCH_MISSES]), udword(C.mValues[HW_COUNTER_DTLB_MISSES])));
+					else	// e.g. Windows, cycles only
+						gTexter.print(0.0f, y, TextScale, _F("    Cycles: %d K\n", udword(C.mValues[HW_COUNTER_CYCLES]/1024)));
+				}
 			}
 			else
 			{
@@ -1121,7 +703,10 @@ static void PrintTimings()
 	if(gPaused)
 		gTexter.print(0.0f, y, TextScale, "(Paused)");
 	y -= TextScale;
-	gTexter.print(0.0f, y, TextScale, _F("Frame: %d", gFrameNb));
+	if(gWarmingUp)
+		gTexter.print(0.0f, y, TextScale, _F("Frame: %d (warmup)", gFrameNb));
+	else
+		gTexter.print(0.0f, y, TextScale, _F("Frame: %d", gFrameNb));
 	y -= TextScale;
 	gTexter.print(0.0f, y, TextScale, _F("FPS: %.02f", gFPS.GetFPS()));
 
@@ -1676,15 +1261,37 @@ static void RenderCallback()
 	{
 		AutomatedTest* CurrentTest = AutoTests->GetCurrentTest();
 		const udword Limit = MAX(CurrentTest->mNbFrames, AutoTests->mDefaultNbFrames);
-		if(gFrameNb>Limit)
+		if(gFrameNb>Limit && !gWarmingUp)
 		{
-			TestCSVExport();
+			if(AutoTests->mNbRepetitions>1)
+				RecordBenchmarkRepetition();
+			// Before the exports, which include the merged repetitions
+			RecordTestRepetition();
 
-			AutomatedTest* NextTest = AutoTests->SelectNextTest();
-			if(NextTest)
-				ActivateTest(NextTest->mTest);
+			// Each repetition is a fresh CloseAll()/InitAll()
+			if(AutoTests->SelectNextRepetition())
+			{
+				ActivateTest(CurrentTest->mTest);
+			}
 			else
-				exit(0);
+			{
+				ExportResults();
+				CheckAgainstBaseline();
+				ResetTestRepetitions();
+				if(AutoTests->mNbRepetitions>1)
+				{
+					ExportBenchmarkResults(AutoTests->mConfidence);
+					ResetBenchmark();
+				}
+
+				AutomatedTest* NextTest = AutoTests->SelectNextTest();
+				if(NextTest)
+					ActivateTest(NextTest->mTest);
+				else if(IsBaselineLoaded())
+					exit(ReportRegressions() ? 2 : 0);
+				else
+					exit(0);
+			}
 		}
 	}
 	gPEEL_PollRadioButtons();
@@ -1722,6 +1329,9 @@ static void gCleanup()
 	if(gRunningTest)
 		gRunningTest->CloseUI();
 	CloseAll();
+	CloseHardwareCounters();
+	ReleaseBaseline();
+	RestoreRunConfig();
 
 	DELETESINGLE(gRoot);
 
@@ -1740,15 +1350,6 @@ static void gCleanup()
 	DELETESINGLE(gIceAllocator);
 }
 
-static void RegisterPlugIn(const char* filename)
-{
-	PintPlugin* pp = LoadPlugIn(filename);
-	if(pp)
-	{
-		printf(_F("Plugin found: %s\n", filename));
-		gPlugIns[gNbPlugIns++] = pp;
-	}
-}
 
 
 
@@ -1766,63 +1367,10 @@ static void RegisterPlugIn(const char* filename)
 							}
 	};
 
-static char gBuildFolder[MAX_PATH];
-static char gCurrentFile[MAX_PATH];
-
-const char* FindPEELFile(const char* filename)
-{
-	{
-		const char* F0 = _F("../build/%s", filename);
-		strcpy(gCurrentFile, F0);
-		if(FileExists(gCurrentFile))
-			return gCurrentFile;
-	}
-
-	{
-		const char* F1 = _F("../build/Customers/%s", filename);
-		strcpy(gCurrentFile, F1);
-		if(FileExists(gCurrentFile))
-			return gCurrentFile;
-	}
-
-	{
-		const char* F1 = _F("./%s", filename);
-		strcpy(gCurrentFile, F1);
-		if(FileExists(gCurrentFile))
-			return gCurrentFile;
-	}
-
-	{
-		const char* F1 = _F("./Customers/%s", filename);
-		strcpy(gCurrentFile, F1);
-		if(FileExists(gCurrentFile))
-			return gCurrentFile;
-	}
-
-	{
-		const char* F2 = _F("%s%s", gBuildFolder, filename);
-		strcpy(gCurrentFile, F2);
-		if(FileExists(gCurrentFile))
-			return gCurrentFile;
-	}
-	return null;
-}
-
 static udword AnalyzeCommandLine(int argc, char** argv)
 {
 	if(argc && argv)
-	{
-		strcpy(gBuildFolder, *argv);
-		char* Build = strstr(gBuildFolder, "Build");
-		if(Build)
-		{
-			Build[6]=0;
-		}
-		else
-		{
-			gBuildFolder[0] = 0;
-		}
-	}
+		SetPEELBuildFolder(*argv);
 
 	if(argc<=1)
 		return 0;
@@ -1877,18 +1425,6 @@ static udword AnalyzeCommandLine(int argc, char** argv)
 	return NbPlugins;
 }
 
-void ThreadSetup()
-{
-	_clearfp();
-
-   udword x86_cw;
-   udword sse2_cw;
-	#define _MCW_ALL _MCW_DN | _MCW_EM | _MCW_IC | _MCW_RC | _MCW_PC
-	__control87_2(_CW_DEFAULT | _DN_FLUSH, _MCW_ALL, &x86_cw, &sse2_cw);
-
-	_clearfp();
-}
-
 ///////////////////////////////////////////////////////////////////////////////
 
 //void TestSpy();
@@ -1904,6 +1440,7 @@ int main(int argc, char** argv)
 	}
 
 	ThreadSetup();
+	InitProfilingTimers();
 	SRand(42);
 
 	gIceAllocator = new CustomIceAllocator;
@@ -1918,6 +1455,9 @@ int main(int argc, char** argv)
 	InitIceImageWork();
 	InitIceGUI();
 
+	// Default run config, only records the machine's state until a script changes it
+	ApplyRunConfig();
+
 /*	if(0)
 	{
 		TestSpy();
@@ -2225,6 +1765,8 @@ IceEditBox* GUIHelper::CreateEditBox(IceWidget* parent, udword id, sdword x, sdw
 static Container*	gMainGUI = null;
 static IceEditBox*	gEditBox_CameraSpeed = null;
 static IceEditBox*	gEditBox_RaytracingDistance = null;
+static IceEditBox*	gEditBox_SQThreads = null;
+static IceEditBox*	gEditBox_AsyncUpdateWork = null;
 static IceComboBox*	gComboBox_CurrentTool = null;
 static IceComboBox*	gComboBox_ProfilingUnits = null;
 static IceComboBox*	gComboBox_SQProfilingMode = null;
@@ -2255,6 +1797,12 @@ enum MainGUIElement
 	MAIN_GUI_TRASH_CACHE,
 	MAIN_GUI_ENABLE_VSYNC,
 	MAIN_GUI_COMMA_SEPARATOR,
+	MAIN_GUI_HARDWARE_COUNTERS,
+	MAIN_GUI_ALLOC_TRACKING,
+	MAIN_GUI_PARALLEL_ENGINES,
+	MAIN_GUI_ASYNC_UPDATES,
+	MAIN_GUI_CAPTURE,
+	MAIN_GUI_DETERMINISM,
 //	MAIN_GUI_PAUSED,
 	//
 	MAIN_GUI_CAMERA_SPEED,
@@ -2268,6 +1816,8 @@ enum MainGUIElement
 	MAIN_GUI_CURRENT_TOOL,
 	MAIN_GUI_PROFILING_UNITS,
 	MAIN_GUI_SQ_PROFILING_MODE,
+	MAIN_GUI_SQ_THREADS,
+	MAIN_GUI_ASYNC_UPDATE_WORK,
 	MAIN_GUI_SQ_RAYCAST_MODE,
 	MAIN_GUI_RAYTRACING_RESOLUTION,
 	//
@@ -2326,6 +1876,26 @@ static void gCheckBoxCallback(const IceCheckBox& check_box, bool checked, void*
 		case MAIN_GUI_COMMA_SEPARATOR:
 			gCommaSeparator = checked;
 			break;
+		case MAIN_GUI_HARDWARE_COUNTERS:
+			EnableHardwareCounters(checked);
+			break;
+		case MAIN_GUI_ALLOC_TRACKING:
+			gAllocTracking = checked;
+			break;
+		case MAIN_GUI_PARALLEL_ENGINES:
+			gParallelEngines = checked;
+			break;
+		case MAIN_GUI_ASYNC_UPDATES:
+			gAsyncUpdates = checked;
+			break;
+		case MAIN_GUI_CAPTURE:
+			gCaptureFilename = checked ? DEFAULT_CAPTURE_FILENAME : null;
+			break;
+		case MAIN_GUI_DETERMINISM:
+			gDeterminismCheck = checked;
+			if(!checked)
+				ResetDeterminismReference();
+			break;
 	}
 }
 
@@ -2343,6 +1913,14 @@ static const char* gTooltip_RandomizeOrder		= "Randomize order in which physics
 static const char* gTooltip_TrashCache			= "Trash cache after each simulation";
 static const char* gTooltip_VSYNC				= "Enable/disable v-sync";
 static const char* gTooltip_CommaSeparator		= "Use ',' or ';' as separator character in saved Excel files";
+static const char* gTooltip_HardwareCounters	= "Record CPU performance counters (IPC, cache/branch/TLB misses) for each physics engine. Windows only exposes process-wide cycles. Takes effect for worker threads created by the next test.";
+static const char* gTooltip_AllocTracking		= "Record allocation stats (counts, bytes, size classes) for each physics engine. The tracking runs within the timed updates and slows them down, leave it off when comparing timings. Takes effect for the next test.";
+static const char* gTooltip_ParallelEngines	= "Simulate each physics engine on its own thread & core. Faster for large sweeps, but engines compete for shared caches & memory bandwidth.";
+static const char* gTooltip_AsyncUpdates		= "Start the simulation of all physics engines, run the main thread work, then collect the results (engines supporting asynchronous updates only). Records the time the main thread is blocked, and the critical path.";
+static const char* gTooltip_Determinism		= "Hash the poses of all objects after each frame. The first run of a test is the reference, the next runs (e.g. after changing the number of threads) report the first divergent frame & the drift of each body. Engines are also compared to the first one. Results are saved to Test_Determinism_RunN.csv & Test_Divergence.csv.";
+static const char* gTooltip_Capture			= "Capture the calls made to the first physics engine to " DEFAULT_CAPTURE_FILENAME ", starting with the next test. The file can be replayed with PEEL_Headless -h, for all engines.";
+static const char* gTooltip_AsyncUpdateWork		= "Main thread work (busy loop) while the engines simulate in asynchronous mode, in microseconds. Stands for the rest of a game frame.";
+static const char* gTooltip_SQThreads			= "Number of threads for batched scene queries in SQ tests (engines supporting concurrent queries only). With more than one, the queries/second from 1 to N threads are reported when the test is closed.";
 static const char* gTooltip_RaycastMode			= "Desired mode for SQ raycast tests. 'Closest' returns one closest hit, 'Any' returns the first hit and early exits, 'All' collects all hits touched by the ray.";
 
 static void gPEEL_PollRadioButtons()
@@ -2364,6 +1942,12 @@ static void gPEEL_GetOptionsFromGUI()
 	gPickingForce = GetFromEditBox(gPickingForce, gEditBox_PickingForce, 0.0f, MAX_FLOAT);
 	gCameraSpeed = GetFromEditBox(gCameraSpeed, gEditBox_CameraSpeed, 0.0f, MAX_FLOAT);
 	gRTDistance = GetFromEditBox(gRTDistance, gEditBox_RaytracingDistance, 0.0f, MAX_FLOAT);
+	gNbSQThreads = GetFromEditBox(gNbSQThreads, gEditBox_SQThreads);
+	gAsyncUpdateWork = GetFromEditBox(gAsyncUpdateWork, gEditBox_AsyncUpdateWork);
+	if(!gNbSQThreads)
+		gNbSQThreads = 1;
+	else if(gNbSQThreads>MAX_NB_SQ_THREADS)
+		gNbSQThreads = MAX_NB_SQ_THREADS;
 
 	if(gComboBox_CurrentTool)
 	{
@@ -2533,6 +2117,31 @@ static void gButtonCallback(IceButton& button, void* user_data)
 			gRender = AutoTests->mRendering;
 			gRandomizeOrder = AutoTests->mRandomizeOrder;
 			gTrashCache = AutoTests->mTrashCache;
+			gParallelEngines = AutoTests->mParallelEngines;
+			gWarmupFrames = AutoTests->mWarmupFrames;
+			gSimulationCores = AutoTests->mSimulationCores;
+			gWorkerCores = AutoTests->mWorkerCores;
+			gRunPriority = AutoTests->mRunPriority;
+			gLockGovernor = AutoTests->mLockGovernor;
+			gAllocatorType = AutoTests->mAllocatorType;
+			gAllocTracking = AutoTests->mAllocTracking;
+			gNbSQThreads = AutoTests->mNbSQThreads;
+			if(gEditBox_SQThreads)
+				gEditBox_SQThreads->SetText(_F("%d", gNbSQThreads));
+			gAsyncUpdates = AutoTests->mAsyncUpdates;
+			gAsyncUpdateWork = AutoTests->mAsyncUpdateWork;
+			if(gEditBox_AsyncUpdateWork)
+				gEditBox_AsyncUpdateWork->SetText(_F("%d", gAsyncUpdateWork));
+			ApplyRunConfig();
+			if(AutoTests->mResultsFilename.IsValid())
+				SetResultsFilename(AutoTests->mResultsFilename);
+			if(AutoTests->mBaselineFilename.IsValid())
+			{
+				SetRegressionThresholds(AutoTests->mMaxMedianRegression, AutoTests->mMaxP99Regression, AutoTests->mMaxMemoryRegression);
+				LoadBaseline(AutoTests->mBaselineFilename);
+			}
+			ResetBenchmark();
+			ResetTestRepetitions();
 
 			AutomatedTest* Test = AutoTests->GetCurrentTest();
 			ActivateTest(Test->mTest);
@@ -2623,6 +2232,24 @@ static void PEEL_InitGUI()
 
 				gGUIHelper.CreateCheckBox(MainOptions, MAIN_GUI_COMMA_SEPARATOR, 4, y, 200, 20, "Use comma separator", gMainGUI, gCommaSeparator, gCheckBoxCallback, gTooltip_CommaSeparator);
 				y += YStep;
+
+				gGUIHelper.CreateCheckBox(MainOptions, MAIN_GUI_HARDWARE_COUNTERS, 4, y, 200, 20, "Hardware counters", gMainGUI, gHardwareCounters, gCheckBoxCallback, gTooltip_HardwareCounters);
+				y += YStep;
+
+				gGUIHelper.CreateCheckBox(MainOptions, MAIN_GUI_ALLOC_TRACKING, 4, y, 200, 20, "Allocation stats", gMainGUI, gAllocTracking, gCheckBoxCallback, gTooltip_AllocTracking);
+				y += YStep;
+
+				gGUIHelper.CreateCheckBox(MainOptions, MAIN_GUI_PARALLEL_ENGINES, 4, y, 200, 20, "Parallel engines", gMainGUI, gParallelEngines, gCheckBoxCallback, gTooltip_ParallelEngines);
+				y += YStep;
+
+				gGUIHelper.CreateCheckBox(MainOptions, MAIN_GUI_ASYNC_UPDATES, 4, y, 200, 20, "Async updates", gMainGUI, gAsyncUpdates, gCheckBoxCallback, gTooltip_AsyncUpdates);
+				y += YStep;
+
+				gGUIHelper.CreateCheckBox(MainOptions, MAIN_GUI_CAPTURE, 4, y, 200, 20, "Capture engine calls", gMainGUI, gCaptureFilename!=null, gCheckBoxCallback, gTooltip_Capture);
+				y += YStep;
+
+				gGUIHelper.CreateCheckBox(MainOptions, MAIN_GUI_DETERMINISM, 4, y, 200, 20, "Determinism check", gMainGUI, gDeterminismCheck, gCheckBoxCallback, gTooltip_Determinism);
+				y += YStep;
 			}
 
 			const sdword OffsetX = 90;
@@ -2646,9 +2273,8 @@ static void PEEL_InitGUI()
 				CBBD.mLabel		= "Profiling units";
 				gComboBox_ProfilingUnits = ICE_NEW(IceComboBox)(CBBD);
 				gMainGUI->Add(udword(gComboBox_ProfilingUnits));
-				gComboBox_ProfilingUnits->Add("K-Cycles (RDTSC)");
-				gComboBox_ProfilingUnits->Add("ms (timeGetTime)");
-				gComboBox_ProfilingUnits->Add("us (QPC)");
+				for(udword i=0;i<PROFILING_UNITS_COUNT;i++)
+					gComboBox_ProfilingUnits->Add(GetProfilingTimer(ProfilingUnits(i)).mName);
 				gComboBox_ProfilingUnits->Select(gProfilingUnits);
 				gComboBox_ProfilingUnits->SetVisible(true);
 				y += YStep;
@@ -2668,10 +2294,21 @@ static void PEEL_InitGUI()
 				gComboBox_SQProfilingMode->Add("Simulation");
 				gComboBox_SQProfilingMode->Add("SQ queries");
 				gComboBox_SQProfilingMode->Add("Combined");
+				gComboBox_SQProfilingMode->Add("Overlap");
 				gComboBox_SQProfilingMode->Select(gSQProfilingMode);
 				gComboBox_SQProfilingMode->SetVisible(true);
 				y += YStep;
 			}
+			{
+				gGUIHelper.CreateLabel(MainOptions, 4, y+LabelOffsetY, 90, 20, "SQ threads:", gMainGUI);
+				gEditBox_SQThreads = gGUIHelper.CreateEditBox(MainOptions, MAIN_GUI_SQ_THREADS, 4+OffsetX, y, EditBoxWidth, 20, _F("%d", gNbSQThreads), gMainGUI, EDITBOX_INTEGER_POSITIVE, gEBCallback, gTooltip_SQThreads);
+				y += YStep;
+			}
+			{
+				gGUIHelper.CreateLabel(MainOptions, 4, y+LabelOffsetY, 90, 20, "Async work (us):", gMainGUI);
+				gEditBox_AsyncUpdateWork = gGUIHelper.CreateEditBox(MainOptions, MAIN_GUI_ASYNC_UPDATE_WORK, 4+OffsetX, y, EditBoxWidth, 20, _F("%d", gAsyncUpdateWork), gMainGUI, EDITBOX_INTEGER_POSITIVE, gEBCallback, gTooltip_AsyncUpdateWork);
+				y += YStep;
+			}
 			{
 				gGUIHelper.CreateLabel(MainOptions, 4, y+LabelOffsetY, 90, 20, "Raycast mode:", gMainGUI);
 				ComboBoxDesc CBBD;
@@ -2965,6 +2602,8 @@ static void PEEL_CloseGUI()
 
 	gEditBox_CameraSpeed = null;
 	gEditBox_RaytracingDistance = null;
+	gEditBox_SQThreads = null;
+	gEditBox_AsyncUpdateWork = null;
 	gComboBox_CurrentTool = null;
 	gComboBox_ProfilingUnits = null;
 	gComboBox_SQProfilingMode = null;
@@ -2975,94 +2614,12 @@ static void PEEL_CloseGUI()
 	gRadioButton_RT_MT = null;
 }
 
-Quat ShortestRotation(const Point& v0, const Point& v1)
+static void ExportResults()
 {
-	const float d = v0|v1;
-	const Point cross = v0^v1;
-
-	Quat q = d>-1.0f ? Quat(1.0f + d, cross.x, cross.y, cross.z)
-//					: fabsf(v0.x)<0.1f ? Quat(0.0f, 0.0f, v0.z, -v0.y) : Quat(0.0f, v0.y, -v0.x, 0.0f);
-					: fabsf(v0.x)<0.1f ? Quat(0.0f, 0.0f, v0.z, -v0.y) : Quat(0.0f, v0.y, -v0.x, 0.0f);
-//	PxQuat q = d > -1 ? PxQuat(cross.x, cross.y, cross.z, 1 + d) : PxAbs(v0.x) < 0.1f ? PxQuat(0.0f, v0.z, -v0.y, 0.0f)
-//	                                                                                  : PxQuat(v0.y, -v0.x, 0.0f, 0.0f);
-
-	q.Normalize();
-
-	return q;
-}
-
-static void TestCSVExport()
-{
-	if(!gRunningTest)
-		return;
-
-	const char* Filename;
-	const char* SubName = gRunningTest->GetSubName();
-	if(SubName)
-		Filename = _F(".\\%s_%s.csv", gRunningTest->GetName(), SubName);
-	else
-		Filename = _F(".\\%s.csv", gRunningTest->GetName());
-
-	FILE* globalFile = fopen(Filename, "w");
-	if(!globalFile)
-		return;
-
-	if(gProfilingUnits==PROFILING_UNITS_RDTSC)
-		fprintf_s(globalFile, "%s (K-Cycles)\n\n", gRunningTest->GetName());
-	else if(gProfilingUnits==PROFILING_UNITS_TIME_GET_TIME)
-		fprintf_s(globalFile, "%s (ms)\n\n", gRunningTest->GetName());
-	else if(gProfilingUnits==PROFILING_UNITS_QPC)
-		fprintf_s(globalFile, "%s (us)\n\n", gRunningTest->GetName());
-	else ASSERT(0);
-
-	const udword NbFrames = gFrameNb<=MAX_NB_RECORDED_FRAMES ? gFrameNb : MAX_NB_RECORDED_FRAMES;
-
-	for(udword b=0;b<gNbEngines;b++)
+	TestJSONExport();
+	if(TestCSVExport())
 	{
-		if(!gEngines[b].mEnabled || !gEngines[b].mSupportsCurrentTest || !(gEngines[b].mEngine->GetFlags() & PINT_IS_ACTIVE))
-			continue;
-
-		if(gCommaSeparator)
-			fprintf_s(globalFile, "%s, ", gEngines[b].mEngine->GetName());
-		else
-			fprintf_s(globalFile, "%s; ", gEngines[b].mEngine->GetName());
-
-		for(udword i=0;i<NbFrames;i++)
-		{
-			if(gCommaSeparator)
-				fprintf_s(globalFile, "%d, ", gEngines[b].mTiming.mRecorded[i].mTime);
-			else
-				fprintf_s(globalFile, "%d; ", gEngines[b].mTiming.mRecorded[i].mTime);
-		}
-		fprintf_s(globalFile, "\n");
+		gDisplayMessage = true;
+		gDisplayMessageType = 0;
 	}
-
-	fprintf_s(globalFile, "\n\n");
-
-	fprintf_s(globalFile, "Memory usage (Kb):\n\n");
-
-	for(udword b=0;b<gNbEngines;b++)
-	{
-		if(!gEngines[b].mEnabled || !gEngines[b].mSupportsCurrentTest || !(gEngines[b].mEngine->GetFlags() & PINT_IS_ACTIVE))
-			continue;
-
-		if(gCommaSeparator)
-			fprintf_s(globalFile, "%s, ", gEngines[b].mEngine->GetName());
-		else
-			fprintf_s(globalFile, "%s; ", gEngines[b].mEngine->GetName());
-
-		for(udword i=0;i<NbFrames;i++)
-		{
-			if(gCommaSeparator)
-				fprintf_s(globalFile, "%d, ", gEngines[b].mTiming.mRecorded[i].mUsedMemory/1024);
-			else
-				fprintf_s(globalFile, "%d; ", gEngines[b].mTiming.mRecorded[i].mUsedMemory/1024);
-		}
-		fprintf_s(globalFile, "\n");
-	}
-
-	fclose(globalFile);
-	gDisplayMessage = true;
-	gDisplayMessageType = 0;
 }
-
@@ -0,0 +1,913 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+// Headless version of PEEL, for running benchmarks on machines without a display. There is no window, no GUI
+// and no rendering: tests are run back-to-back through the same Simulate() loop as the regular app, and results
+// are saved to CSV files as usual.
+//
+// Usage: PEEL_Headless.exe -p plugin.dll [-p plugin.dll ...] (-t test [-t test ...] | -s script.txt | -h capture.pcf) [-f nb_frames] [-w warmup] [-r repetitions] [-l confidence] [-j results.jsonl] [-b baseline.jsonl [-x median,p99,memory]] [-i [-o timeout]] [-c] [-e] [-m] [-T] [-O] [-a cores] [-k cores] [-z priority] [-g] [-n allocator] [-v capture.pcf] [-D threads]
+//
+// With -i each plugin runs each test in its own worker process (this same executable, started with a single -p and -t).
+// Engines don't share the heap, the FPU state or the caches anymore, and a crash or a hang only loses that engine's
+// results for that test: the failure is recorded in the results file and the sweep goes on. Workers run one after
+// the other and append their own results to the JSON lines file; CSV files get the plugin name as a suffix.
+//
+// With -v the calls made to the first plugin's engine are captured to a file (see PintCapture.h), and -h replays such a file
+// with each plugin instead of running tests. Replays only time Pint::Update & the queries, results go to "capture.pcf.csv".
+//
+// With -D each test runs at least twice, with the engines' worker threads cycling through the given counts, e.g. "-D 0,4".
+// The first run is the reference, the poses of later runs are compared to it (see Determinism.h).
+//
+// Exit code: 0 if everything ran fine, 1 for invalid options, 2 if the baseline check failed, 3 if a worker crashed or timed out.
+//
+// Limitation: tests' UI is never created, so configurable tests run with their default settings.
+
+#include "stdafx.h"
+#include "Simulation.h"
+#include "BenchmarkStats.h"
+#include "ResultsWriter.h"
+#include "RegressionGate.h"
+#include "TestScenes.h"
+#include "Script.h"
+#include "RunConfig.h"
+#include "SQThreads.h"
+#include "PintCapture.h"
+#include "Determinism.h"
+#include "CustomICEAllocator.h"
+
+#define	DEFAULT_NB_FRAMES			1024
+#define	DEFAULT_WORKER_TIMEOUT		3600	// Seconds
+#define	MAX_NB_THREAD_COUNTS		16
+
+#define	EXIT_CODE_REGRESSION		2
+#define	EXIT_CODE_WORKER_FAILED		3
+
+// Globals normally defined by the GUI app, still referenced by camera & test code.
+udword		gScreenWidth	= 768;
+udword		gScreenHeight	= 768;
+float		gCameraSpeed	= 0.2f;
+String*		gRoot			= null;
+
+static CustomIceAllocator*	gIceAllocator = null;
+
+// Determinism check (-D)
+static const char*	gThreadCountsParam = null;
+static udword		gThreadCounts[MAX_NB_THREAD_COUNTS];	// INVALID_ID = plugins' settings
+static udword		gNbThreadCounts = 0;
+
+// "0,4" or "default,4"
+static bool ParseThreadCounts(const char* text)
+{
+	gNbThreadCounts = 0;
+	while(*text)
+	{
+		if(gNbThreadCounts==MAX_NB_THREAD_COUNTS)
+			return false;
+
+		if(_strnicmp(text, "default", 7)==0)
+		{
+			gThreadCounts[gNbThreadCounts++] = INVALID_ID;
+			text += 7;
+		}
+		else
+		{
+			if(*text<'0' || *text>'9')
+				return false;
+			gThreadCounts[gNbThreadCounts++] = atoi(text);
+			while(*text>='0' && *text<='9')
+				text++;
+		}
+
+		if(*text==',')
+			text++;
+		else if(*text)
+			return false;
+	}
+	return gNbThreadCounts!=0;
+}
+
+// Process isolation (-i)
+namespace
+{
+	struct WorkerParams
+	{
+		WorkerParams() :
+			mTimeout				(DEFAULT_WORKER_TIMEOUT),
+			mBaselineFilename		(null),
+			mMaxMedianRegression	(DEFAULT_MAX_MEDIAN_REGRESSION),
+			mMaxP99Regression		(DEFAULT_MAX_P99_REGRESSION),
+			mMaxMemoryRegression	(DEFAULT_MAX_MEMORY_REGRESSION),
+			mNbFailedRuns			(0),
+			mNbRegressedRuns		(0)
+		{
+		}
+
+		Container	mPlugIns;		// Plugin filenames
+		udword		mTimeout;
+		const char*	mBaselineFilename;
+		float		mMaxMedianRegression;
+		float		mMaxP99Regression;
+		float		mMaxMemoryRegression;
+		udword		mNbFailedRuns;
+		udword		mNbRegressedRuns;
+	};
+}
+
+static void PrintUsage()
+{
+	printf("Usage: PEEL_Headless.exe -p plugin.dll [-p plugin.dll ...] (-t test [-t test ...] | -s script.txt) [-f nb_frames] [-w warmup] [-r repetitions] [-l confidence] [-j results.jsonl] [-b baseline.jsonl [-x median,p99,memory]] [-i [-o timeout]] [-c] [-e] [-m] [-T] [-O] [-a cores] [-k cores] [-z priority] [-g] [-n allocator] [-q sq_threads] [-y sq_mode] [-d work_us] [-v capture.pcf] [-h capture.pcf] [-D threads]\n");
+	printf("  -p: load a plugin (can be used multiple times)\n");
+	printf("  -t: run a test (can be used multiple times)\n");
+	printf("  -s: run all tests from a script file\n");
+	printf("  -f: number of frames for tests selected with -t (default: %d)\n", DEFAULT_NB_FRAMES);
+	printf("  -w: number of warmup frames, not included in timings (default: 0)\n");
+	printf("  -r: number of runs of each test, with a statistical report when more than 1 (default: 1)\n");
+	printf("  -l: confidence level (%%) of the statistical report (default: %d)\n", int(DEFAULT_BENCHMARK_CONFIDENCE));
+	printf("  -j: JSON lines file results are appended to (default: %s)\n", DEFAULT_RESULTS_FILENAME);
+	printf("  -b: compare results against a baseline results file, exit code is 2 if a threshold is exceeded\n");
+	printf("  -x: maximum regressions in percents for median, p99 & peak memory, negative disables (default: %g,%g,%g)\n", DEFAULT_MAX_MEDIAN_REGRESSION, DEFAULT_MAX_P99_REGRESSION, DEFAULT_MAX_MEMORY_REGRESSION);
+	printf("  -i: run each plugin & test in its own worker process, crashes & timeouts don't stop the sweep\n");
+	printf("  -o: worker timeout in seconds, 0 for none (default: %d)\n", DEFAULT_WORKER_TIMEOUT);
+	printf("  -u: (internal) worker mode, used by -i\n");
+	printf("  -c: use commas instead of semicolons in CSV files\n");
+	printf("  -e: record hardware performance counters (cycles only on Windows)\n");
+	printf("  -m: simulate engines in parallel, one thread & core per engine\n");
+	printf("  -T: trash the CPU caches before each engine's update\n");
+	printf("  -O: randomize the order in which engines are updated each frame\n");
+	printf("  -a: simulation cores, e.g. 2-5,8: the main thread runs on the first one, parallel engines on the others\n");
+	printf("  -k: cores for the engines' own worker threads (0-31), e.g. 6-7\n");
+	printf("  -z: process priority: normal, high or realtime (default: normal)\n");
+	printf("  -g: switch to the performance CPU governor/power scheme during the run\n");
+	printf("  -n: allocator backend for the engines: system, arena or pool (default: system)\n");
+	printf("  -M: record allocation stats (counts, bytes, size classes), at some cost in the recorded times\n");
+	printf("  -q: number of threads for batched scene queries, with a scaling report from 1 to N threads (default: 1, max: %d)\n", MAX_NB_SQ_THREADS);
+	printf("  -y: what is profiled in SQ tests: sim, update, combined or overlap (queries during the simulation) (default: update)\n");
+	printf("  -d: asynchronous updates, with this many microseconds of main thread work while the engines simulate (blocking & critical path times)\n");
+	printf("  -v: capture the calls made to the first plugin's engine to a file, overwritten by each test (not with -i)\n");
+	printf("  -h: replay a capture with each plugin instead of running tests, timings are saved to <capture>.csv\n");
+	printf("  -D: determinism check: runs each test at least twice, cycling through these engine worker thread counts (e.g. 0,4 or default,4),\n");
+	printf("      and reports the first divergent frame & per-body drift vs the first run. No repetition statistics, cannot be used with -b.\n");
+}
+
+static PhysicsTest* FindTest(const char* name)
+{
+	const udword NbTests = GetNbTests();
+	for(udword i=0;i<NbTests;i++)
+	{
+		PhysicsTest* Test = GetTest(i);
+		if(strcmp(Test->GetName(), name)==0)
+			return Test;
+	}
+	return null;
+}
+
+static void PrintResults()
+{
+	const bool MustProfileTestUpdate = gRunningTest->ProfileUpdate();
+
+	for(udword i=0;i<gNbEngines;i++)
+	{
+		ASSERT(gEngines[i].mEngine);
+		Pint* Engine = gEngines[i].mEngine;
+		if(!(Engine->GetFlags() & PINT_IS_ACTIVE))
+			continue;
+
+		if(!gEngines[i].mSupportsCurrentTest)
+		{
+			printf("  %s: (unsupported/not exposed)\n", Engine->GetName());
+			continue;
+		}
+
+		const PintTiming& Timing = gEngines[i].mTiming;
+		const PintHistogram& H = Timing.mHistogram;
+		printf("  %s: Avg: %d, StdDev: %.2f, p50: %d, p90: %d, p99: %d, p99.9: %d, Worst: %d",
+			Engine->GetName(), Timing.GetAvgTime(), H.GetStdDev(), H.GetPercentile(50.0f), H.GetPercentile(90.0f), H.GetPercentile(99.0f), H.GetPercentile(99.9f), Timing.GetWorstTime());
+		if(MustProfileTestUpdate)
+			printf(", Nb hits: %d\n", Timing.mCurrentTestResult);
+		else
+			printf(", %d Kb\n", udword(Timing.mCurrentMemory/1024));
+
+		// Async updates: the total above is the blocking time
+		const PintHistogram& CriticalPath = Timing.mPhaseHistograms[PINT_TIMING_CRITICAL_PATH];
+		if(CriticalPath.GetNbValues())
+			printf("    Critical path: Avg: %d, p50: %d, p99: %d, Worst: %d\n", udword(CriticalPath.GetMean()), CriticalPath.GetPercentile(50.0f), CriticalPath.GetPercentile(99.0f), CriticalPath.GetMax());
+
+		if(Timing.HasCounters())
+		{
+			HardwareCounterValues Avg;
+			Timing.GetAverageCounters(Avg);
+			// Only the available counters, e.g. cycles only on Windows
+			printf("   ");
+			if(IsHardwareCounterAvailable(HW_COUNTER_INSTRUCTIONS))
+				printf(" IPC: %.2f,", Avg.GetIPC());
+			printf(" per frame (%s):", GetHardwareCountersScope());
+			const char* Separator = "";
+			for(udword j=0;j<HW_COUNTER_COUNT;j++)
+			{
+				if(!IsHardwareCounterAvailable(HardwareCounter(j)))
+					continue;
+				printf("%s %s: %llu", Separator, GetHardwareCounterName(HardwareCounter(j)), Avg.mValues[j]);
+				Separator = ",";
+			}
+			printf("\n");
+		}
+
+		if(Timing.HasAllocations())
+		{
+			const PintHistogram& A = Timing.mAllocsHistogram;
+			const PintAllocStats& Totals = Timing.mTotalAllocs;
+			printf("    Allocs per frame: Avg: %.1f, p50: %d, p99: %d, Max: %d, %llu Kb allocated, %llu Kb freed, peak: %llu Kb\n",
+				A.GetMean(), A.GetPercentile(50.0f), A.GetPercentile(99.0f), A.GetMax(), Totals.mAllocatedBytes/1024, Totals.mFreedBytes/1024, Totals.mPeakBytes/1024);
+		}
+	}
+}
+
+static bool RunTest(PhysicsTest* test, udword nb_frames, udword nb_repetitions, float confidence)
+{
+	ASSERT(test);
+
+#ifdef PEEL_PUBLIC_BUILD
+	if(test->IsPrivate())
+	{
+		printf("Skipping %s: this private test is disabled in public builds.\n", test->GetName());
+		return false;
+	}
+#endif
+
+	// Each test is checked against its own first run
+	if(gDeterminismCheck)
+	{
+		ResetDeterminismReference();
+		nb_repetitions = TMax(nb_repetitions, TMax(gNbThreadCounts, udword(2)));
+	}
+
+	ResetBenchmark();
+	ResetTestRepetitions();
+	for(udword r=0;r<nb_repetitions;r++)
+	{
+		if(gDeterminismCheck)
+		{
+			gNbWorkerThreads = gThreadCounts[r % gNbThreadCounts];
+			if(gNbWorkerThreads!=INVALID_ID)
+				printf("Engine worker threads: %d\n", gNbWorkerThreads);
+		}
+
+		if(nb_repetitions>1)
+			printf("Running %s (%d frames, repetition %d/%d)...\n", test->GetName(), nb_frames, r+1, nb_repetitions);
+		else
+			printf("Running %s (%d frames)...\n", test->GetName(), nb_frames);
+
+		PINT_WORLD_CREATE Desc;
+		GetTestSceneParams(test, Desc);
+		InitEngines(Desc);
+		StartTest(test);
+
+		// Same exit condition as automated tests in the GUI app, which run gNbSimulateCallsPerFrame simulation steps per rendered frame.
+		// gFrameNb restarts from 0 after the warmup frames.
+		while(gFrameNb<=nb_frames || gWarmingUp)
+		{
+			for(udword i=0;i<gNbSimulateCallsPerFrame;i++)
+				Simulate();
+		}
+
+		PrintResults();
+
+		// Determinism passes are not repetitions of the same run (the thread counts differ), they stay out of the statistics
+		const bool LastRepetition = r==nb_repetitions-1;
+		if(nb_repetitions>1 && !gDeterminismCheck)
+		{
+			RecordBenchmarkRepetition();
+			if(LastRepetition && !ExportBenchmarkResults(confidence))
+				printf("WARNING: failed to save repetitions report for %s.\n", test->GetName());
+		}
+
+		// Before the exports, which include the merged repetitions
+		if(!gDeterminismCheck)
+			RecordTestRepetition();
+
+		if(LastRepetition)
+		{
+			if(!TestCSVExport())
+				printf("WARNING: failed to save results for %s.\n", test->GetName());
+			if(GetResultsFilename() && !TestJSONExport())
+				printf("WARNING: failed to append results for %s to %s.\n", test->GetName(), GetResultsFilename());
+			if(!gDeterminismCheck)
+				CheckAgainstBaseline();
+			ResetTestRepetitions();
+		}
+
+		CloseEngines();
+		gRunningTest = null;
+	}
+	gNbWorkerThreads = INVALID_ID;
+	return true;
+}
+
+// "C:\\Path\\PINT_Engine.dll" => "PINT_Engine"
+static void GetPlugInName(char* dst, udword size, const char* filename)
+{
+	const char* Name = filename;
+	for(const char* c=filename;*c;c++)
+	{
+		if(*c=='\\' || *c=='/' || *c==':')
+			Name = c+1;
+	}
+	strncpy(dst, Name, size-1);
+	dst[size-1] = 0;
+
+	char* Ext = strrchr(dst, '.');
+	if(Ext)
+		*Ext = 0;
+}
+
+static bool AppendToCommandLine(char* command_line, udword size, const char* text)
+{
+	if(strlen(command_line) + strlen(text) + 1 > size)
+		return false;
+	strcat(command_line, text);
+	return true;
+}
+
+static bool RunWorkerProcess(char* command_line, udword timeout, udword& exit_code, bool& timed_out)
+{
+	STARTUPINFOA SI;
+	ZeroMemory(&SI, sizeof(SI));
+	SI.cb = sizeof(SI);
+
+	PROCESS_INFORMATION PI;
+	if(!CreateProcessA(null, command_line, null, null, FALSE, 0, null, null, &SI, &PI))
+		return false;
+
+	timed_out = WaitForSingleObject(PI.hProcess, timeout ? timeout*1000 : INFINITE)==WAIT_TIMEOUT;
+	if(timed_out)
+	{
+		TerminateProcess(PI.hProcess, EXIT_CODE_WORKER_FAILED);
+		WaitForSingleObject(PI.hProcess, INFINITE);
+	}
+
+	DWORD ExitCode = 0;
+	GetExitCodeProcess(PI.hProcess, &ExitCode);
+	exit_code = ExitCode;
+
+	CloseHandle(PI.hThread);
+	CloseHandle(PI.hProcess);
+	return true;
+}
+
+// Runs the test once per plugin, each time in a new worker process.
+static void RunIsolatedTest(const char* exe_filename, PhysicsTest* test, udword nb_frames, udword nb_repetitions, float confidence, WorkerParams& params)
+{
+	ASSERT(test);
+
+	const udword NbPlugIns = params.mPlugIns.GetNbEntries();
+	for(udword i=0;i<NbPlugIns;i++)
+	{
+		const char* PlugIn = (const char*)params.mPlugIns.GetEntry(i);
+
+		char PlugInName[256];
+		GetPlugInName(PlugInName, sizeof(PlugInName), PlugIn);
+
+		char CommandLine[4096];
+		CommandLine[0] = 0;
+		bool Status = AppendToCommandLine(CommandLine, sizeof(CommandLine), _F("\"%s\" -u \"%s\" -p \"%s\" -t %s", exe_filename, PlugInName, PlugIn, test->GetName()));
+		Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), _F(" -f %d -w %d -r %d -l %f", nb_frames, gWarmupFrames, nb_repetitions, confidence));
+		if(GetResultsFilename())
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), _F(" -j \"%s\"", GetResultsFilename()));
+		if(params.mBaselineFilename)
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), _F(" -b \"%s\" -x %f,%f,%f", params.mBaselineFilename, params.mMaxMedianRegression, params.mMaxP99Regression, params.mMaxMemoryRegression));
+		if(gCommaSeparator)
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), " -c");
+		if(gHardwareCounters)
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), " -e");
+		// Same update conditions as in-process runs, even with a single engine per worker
+		if(gParallelEngines)
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), " -m");
+		if(gTrashCache)
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), " -T");
+		if(gRandomizeOrder)
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), " -O");
+		// The governor is locked (or not) by the main process, for the whole sweep
+		char Cores[256];
+		if(gSimulationCores)
+		{
+			GetCoreSetString(gSimulationCores, Cores, sizeof(Cores));
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), _F(" -a %s", Cores));
+		}
+		if(gWorkerCores)
+		{
+			GetCoreSetString(gWorkerCores, Cores, sizeof(Cores));
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), _F(" -k %s", Cores));
+		}
+		if(gRunPriority!=RUN_PRIORITY_NORMAL)
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), _F(" -z %s", GetRunPriorityName(gRunPriority)));
+		if(gAllocatorType!=PINT_ALLOCATOR_SYSTEM)
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), _F(" -n %s", GetAllocatorTypeName(gAllocatorType)));
+		if(gAllocTracking)
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), " -M");
+		if(gNbSQThreads>1)
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), _F(" -q %d", gNbSQThreads));
+		if(gSQProfilingMode!=SQ_PROFILING_UPDATE)
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), _F(" -y %s", GetSQProfilingModeName(gSQProfilingMode)));
+		if(gAsyncUpdates)
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), _F(" -d %d", gAsyncUpdateWork));
+		if(gDeterminismCheck)
+			Status &= AppendToCommandLine(CommandLine, sizeof(CommandLine), _F(" -D %s", gThreadCountsParam));
+
+		if(!Status)
+		{
+			printf("WARNING: command line too long, skipping %s for %s.\n", PlugInName, test->GetName());
+			params.mNbFailedRuns++;
+			continue;
+		}
+
+		printf("Running %s in worker process (%s)...\n", test->GetName(), PlugInName);
+
+		udword ExitCode;
+		bool TimedOut;
+		const char* Failure = null;
+		if(!RunWorkerProcess(CommandLine, params.mTimeout, ExitCode, TimedOut))
+		{
+			ExitCode = GetLastError();
+			Failure = "launch_failed";
+		}
+		else if(TimedOut)
+			Failure = "timeout";
+		else if(ExitCode==1)
+			Failure = "failed";		// E.g. the plugin didn't load
+		else if(ExitCode==EXIT_CODE_REGRESSION)
+			params.mNbRegressedRuns++;
+		else if(ExitCode)
+			Failure = "crashed";
+
+		if(Failure)
+		{
+			printf("WARNING: %s %s for %s (exit code 0x%x).\n", PlugInName, Failure, test->GetName(), ExitCode);
+			AppendFailedRunRecord(test->GetName(), PlugInName, Failure, ExitCode);
+			params.mNbFailedRuns++;
+		}
+	}
+}
+
+static void Cleanup()
+{
+	ReleaseAutomatedTests();
+	CloseHardwareCounters();
+	ReleaseBaseline();
+	RestoreRunConfig();
+	DELETESINGLE(gRoot);
+
+	CloseIceImageWork();
+	CloseMeshmerizer();
+	CloseIceMaths();
+	CloseIceCore();
+
+	DELETESINGLE(gIceAllocator);
+}
+
+int main(int argc, char** argv)
+{
+	ThreadSetup();
+	InitProfilingTimers();
+	SRand(42);
+
+	gIceAllocator = new CustomIceAllocator;
+	ASSERT(gIceAllocator);
+	IceCore::SetAllocator(*gIceAllocator);
+
+	ICECORECREATE icc;
+	icc.mLogFile = false;
+	InitIceCore(&icc);
+	InitIceMaths();
+	InitMeshmerizer();
+	InitIceImageWork();
+
+	InitTests();
+
+	ASSERT(argc && argv);
+	const String ExeFilename = *argv;
+
+	char ExePath[MAX_PATH];
+	if(!GetModuleFileNameA(null, ExePath, sizeof(ExePath)))
+		strcpy(ExePath, ExeFilename);
+
+	gRoot = ICE_NEW(String);
+	GetPath(ExeFilename, *gRoot);
+
+	SetPEELBuildFolder(*argv);
+
+	// Results are always written in headless runs, -j only changes the file
+	SetResultsFilename(DEFAULT_RESULTS_FILENAME);
+
+	Container Tests;
+	const char* ScriptFilename = null;
+	const char* ReplayFilename = null;
+	udword NbFrames = DEFAULT_NB_FRAMES;
+	udword NbRepetitions = 1;
+	float Confidence = DEFAULT_BENCHMARK_CONFIDENCE;
+	const char* BaselineFilename = null;
+	float MaxMedianRegression = DEFAULT_MAX_MEDIAN_REGRESSION;
+	float MaxP99Regression = DEFAULT_MAX_P99_REGRESSION;
+	float MaxMemoryRegression = DEFAULT_MAX_MEMORY_REGRESSION;
+	bool Isolated = false;
+	bool WarmupSet = false;	// -w given, even with 0 frames
+	WorkerParams Workers;
+
+	argc--;
+	argv++;
+	while(argc)
+	{
+		argc--;
+		const char* Command = *argv++;
+
+		if(Command[0]!='-' || !Command[1] || Command[2])
+		{
+			printf("Unknown option: %s\n", Command);
+			PrintUsage();
+			Cleanup();
+			return 1;
+		}
+
+		if(Command[1]=='c')
+		{
+			gCommaSeparator = true;
+			continue;
+		}
+
+		if(Command[1]=='e')
+		{
+			EnableHardwareCounters(true);
+			continue;
+		}
+
+		if(Command[1]=='m')
+		{
+			gParallelEngines = true;
+			continue;
+		}
+
+		if(Command[1]=='T')
+		{
+			gTrashCache = true;
+			continue;
+		}
+
+		if(Command[1]=='O')
+		{
+			gRandomizeOrder = true;
+			continue;
+		}
+
+		if(Command[1]=='M')
+		{
+			gAllocTracking = true;
+			continue;
+		}
+
+		if(Command[1]=='i')
+		{
+			Isolated = true;
+			continue;
+		}
+
+		if(Command[1]=='g')
+		{
+			gLockGovernor = true;
+			continue;
+		}
+
+		if(!argc)
+		{
+			printf("Missing argument for option %s\n", Command);
+			PrintUsage();
+			Cleanup();
+			return 1;
+		}
+		argc--;
+		const char* Param = *argv++;
+
+		if(Command[1]=='p')
+		{
+			// Loaded after all options are parsed, since isolated runs don't load plugins in this process
+			Workers.mPlugIns.Add(udword(Param));
+		}
+		else if(Command[1]=='t')
+		{
+			PhysicsTest* Test = FindTest(Param);
+			if(Test)
+				Tests.Add(udword(Test));
+			else
+				printf("WARNING: test %s not found.\n", Param);
+		}
+		else if(Command[1]=='s')
+		{
+			ScriptFilename = Param;
+		}
+		else if(Command[1]=='f')
+		{
+			NbFrames = atoi(Param);
+		}
+		else if(Command[1]=='w')
+		{
+			const int NbWarmupFrames = atoi(Param);
+			gWarmupFrames = NbWarmupFrames>0 ? NbWarmupFrames : 0;
+			WarmupSet = true;
+		}
+		else if(Command[1]=='r')
+		{
+			const int Nb = atoi(Param);
+			NbRepetitions = Nb>1 ? Nb : 1;
+		}
+		else if(Command[1]=='l')
+		{
+			Confidence = float(atof(Param));
+		}
+		else if(Command[1]=='j')
+		{
+			SetResultsFilename(Param);
+		}
+		else if(Command[1]=='o')
+		{
+			const int Timeout = atoi(Param);
+			Workers.mTimeout = Timeout>0 ? Timeout : 0;
+		}
+		else if(Command[1]=='u')
+		{
+			// We're a worker: the main process is responsible for reporting our crashes, don't block on error dialogs
+			SetErrorMode(SEM_FAILCRITICALERRORS|SEM_NOGPFAULTERRORBOX|SEM_NOOPENFILEERRORBOX);
+			gResultsSuffix = Param;
+		}
+		else if(Command[1]=='b')
+		{
+			BaselineFilename = Param;
+		}
+		else if(Command[1]=='a' || Command[1]=='k')
+		{
+			if(!ParseCoreSet(Param, Command[1]=='a' ? gSimulationCores : gWorkerCores, Command[1]=='a' ? MAX_NB_CORES : MAX_NB_WORKER_CORES))
+			{
+				printf("Invalid core set: %s\n", Param);
+				PrintUsage();
+				Cleanup();
+				return 1;
+			}
+		}
+		else if(Command[1]=='z')
+		{
+			if(!ParseRunPriority(Param, gRunPriority))
+			{
+				printf("Invalid priority: %s\n", Param);
+				PrintUsage();
+				Cleanup();
+				return 1;
+			}
+		}
+		else if(Command[1]=='n')
+		{
+			if(!ParseAllocatorType(Param, gAllocatorType))
+			{
+				printf("Invalid allocator: %s\n", Param);
+				PrintUsage();
+				Cleanup();
+				return 1;
+			}
+		}
+		else if(Command[1]=='q')
+		{
+			const int NbThreads = atoi(Param);
+			if(NbThreads<1 || NbThreads>MAX_NB_SQ_THREADS)
+			{
+				printf("Invalid number of SQ threads: %s\n", Param);
+				PrintUsage();
+				Cleanup();
+				return 1;
+			}
+			gNbSQThreads = NbThreads;
+		}
+		else if(Command[1]=='d')
+		{
+			const int Work = atoi(Param);
+			if(Work<0)
+			{
+				printf("Invalid async updates work: %s\n", Param);
+				PrintUsage();
+				Cleanup();
+				return 1;
+			}
+			gAsyncUpdates = true;
+			gAsyncUpdateWork = Work;
+		}
+		else if(Command[1]=='v')
+		{
+			gCaptureFilename = Param;
+		}
+		else if(Command[1]=='h')
+		{
+			ReplayFilename = Param;
+		}
+		else if(Command[1]=='D')
+		{
+			if(!ParseThreadCounts(Param))
+			{
+				printf("Invalid thread counts: %s\n", Param);
+				PrintUsage();
+				Cleanup();
+				return 1;
+			}
+			gThreadCountsParam = Param;
+			gDeterminismCheck = true;
+		}
+		else if(Command[1]=='y')
+		{
+			if(!ParseSQProfilingMode(Param, gSQProfilingMode))
+			{
+				printf("Invalid SQ profiling mode: %s\n", Param);
+				PrintUsage();
+				Cleanup();
+				return 1;
+			}
+		}
+		else if(Command[1]=='x')
+		{
+			if(sscanf(Param, "%f,%f,%f", &MaxMedianRegression, &MaxP99Regression, &MaxMemoryRegression)!=3)
+			{
+				printf("Invalid thresholds: %s\n", Param);
+				PrintUsage();
+				Cleanup();
+				return 1;
+			}
+		}
+		else
+		{
+			printf("Unknown option: %s\n", Command);
+			PrintUsage();
+			Cleanup();
+			return 1;
+		}
+	}
+
+	if(!Isolated)
+	{
+		const udword NbPlugIns = Workers.mPlugIns.GetNbEntries();
+		for(udword i=0;i<NbPlugIns;i++)
+			RegisterPlugIn((const char*)Workers.mPlugIns.GetEntry(i));
+	}
+
+	if(!(Isolated ? Workers.mPlugIns.GetNbEntries() : gNbPlugIns) || (!Tests.GetNbEntries() && !ScriptFilename && !ReplayFilename))
+	{
+		PrintUsage();
+		Cleanup();
+		return 1;
+	}
+
+	// Determinism passes run with different thread counts, their timings can't be compared to a baseline
+	if(gDeterminismCheck && BaselineFilename)
+	{
+		printf("-D cannot be combined with -b.\n");
+		PrintUsage();
+		Cleanup();
+		return 1;
+	}
+
+	if(Isolated && (gCaptureFilename || ReplayFilename))
+	{
+		printf("Captures cannot be recorded or replayed with -i.\n");
+		PrintUsage();
+		Cleanup();
+		return 1;
+	}
+
+	ApplyRunConfig();
+
+	if(ReplayFilename)
+	{
+		const bool Status = ReplayCapture(ReplayFilename);
+		Cleanup();
+		return Status ? 0 : 1;
+	}
+
+	// A baseline given on the command line (with its thresholds) takes precedence over the script's
+	if(Isolated)
+	{
+		// Workers do the comparison, each for its own engine
+		Workers.mBaselineFilename = BaselineFilename;
+		Workers.mMaxMedianRegression = MaxMedianRegression;
+		Workers.mMaxP99Regression = MaxP99Regression;
+		Workers.mMaxMemoryRegression = MaxMemoryRegression;
+	}
+	else if(BaselineFilename)
+	{
+		SetRegressionThresholds(MaxMedianRegression, MaxP99Regression, MaxMemoryRegression);
+		if(!LoadBaseline(BaselineFilename))
+		{
+			Cleanup();
+			return 1;
+		}
+	}
+
+	const udword NbTests = Tests.GetNbEntries();
+	for(udword i=0;i<NbTests;i++)
+	{
+		if(Isolated)
+			RunIsolatedTest(ExePath, (PhysicsTest*)Tests.GetEntry(i), NbFrames, NbRepetitions, Confidence, Workers);
+		else
+			RunTest((PhysicsTest*)Tests.GetEntry(i), NbFrames, NbRepetitions, Confidence);
+	}
+
+	if(ScriptFilename)
+	{
+		ExecuteScript(ScriptFilename);
+
+		AutomatedTests* AutoTests = GetAutomatedTests();
+		if(!AutoTests || !AutoTests->IsValid())
+		{
+			printf("Invalid script: %s\n", ScriptFilename);
+			Cleanup();
+			return 1;
+		}
+
+		// The script's "Rendering" setting is ignored, there is nothing to render here.
+		if(AutoTests->mRandomizeOrder)
+			gRandomizeOrder = true;
+		if(AutoTests->mTrashCache)
+			gTrashCache = true;
+		if(AutoTests->mParallelEngines)
+			gParallelEngines = true;
+		if(!WarmupSet)
+			gWarmupFrames = AutoTests->mWarmupFrames;
+		if(AutoTests->mResultsFilename.IsValid())
+			SetResultsFilename(AutoTests->mResultsFilename);
+		// Same for the run config, the script's settings only apply when not given on the command line
+		if(AutoTests->mSimulationCores && !gSimulationCores)
+			gSimulationCores = AutoTests->mSimulationCores;
+		if(AutoTests->mWorkerCores && !gWorkerCores)
+			gWorkerCores = AutoTests->mWorkerCores;
+		if(AutoTests->mRunPriority!=RUN_PRIORITY_NORMAL && gRunPriority==RUN_PRIORITY_NORMAL)
+			gRunPriority = AutoTests->mRunPriority;
+		if(AutoTests->mLockGovernor)
+			gLockGovernor = true;
+		if(AutoTests->mAllocatorType!=PINT_ALLOCATOR_SYSTEM && gAllocatorType==PINT_ALLOCATOR_SYSTEM)
+			gAllocatorType = AutoTests->mAllocatorType;
+		if(AutoTests->mAllocTracking)
+			gAllocTracking = true;
+		if(AutoTests->mNbSQThreads>1 && gNbSQThreads==1)
+			gNbSQThreads = AutoTests->mNbSQThreads;
+		if(AutoTests->mAsyncUpdates && !gAsyncUpdates)
+		{
+			gAsyncUpdates = true;
+			gAsyncUpdateWork = AutoTests->mAsyncUpdateWork;
+		}
+		ApplyRunConfig();
+		if(gDeterminismCheck && !BaselineFilename && AutoTests->mBaselineFilename.IsValid())
+		{
+			printf("-D cannot be combined with the script's baseline.\n");
+			Cleanup();
+			return 1;
+		}
+		if(Isolated && !BaselineFilename && AutoTests->mBaselineFilename.IsValid())
+		{
+			Workers.mBaselineFilename = AutoTests->mBaselineFilename;
+			Workers.mMaxMedianRegression = AutoTests->mMaxMedianRegression;
+			Workers.mMaxP99Regression = AutoTests->mMaxP99Regression;
+			Workers.mMaxMemoryRegression = AutoTests->mMaxMemoryRegression;
+		}
+		else if(!BaselineFilename && AutoTests->mBaselineFilename.IsValid())
+		{
+			SetRegressionThresholds(AutoTests->mMaxMedianRegression, AutoTests->mMaxP99Regression, AutoTests->mMaxMemoryRegression);
+			if(!LoadBaseline(AutoTests->mBaselineFilename))
+			{
+				Cleanup();
+				return 1;
+			}
+		}
+
+		AutomatedTest* CurrentTest = AutoTests->GetCurrentTest();
+		while(CurrentTest)
+		{
+			const udword NbTestFrames = MAX(CurrentTest->mNbFrames, AutoTests->mDefaultNbFrames);
+			if(Isolated)
+				RunIsolatedTest(ExePath, CurrentTest->mTest, NbTestFrames, AutoTests->mNbRepetitions, AutoTests->mConfidence, Workers);
+			else
+				RunTest(CurrentTest->mTest, NbTestFrames, AutoTests->mNbRepetitions, AutoTests->mConfidence);
+			CurrentTest = AutoTests->SelectNextTest();
+		}
+	}
+
+	int ExitCode = 0;
+	if(Isolated)
+	{
+		printf("\n%d failed worker runs, %d with regressions.\n", Workers.mNbFailedRuns, Workers.mNbRegressedRuns);
+		if(Workers.mNbFailedRuns)
+			ExitCode = EXIT_CODE_WORKER_FAILED;
+		else if(Workers.mNbRegressedRuns)
+			ExitCode = EXIT_CODE_REGRESSION;
+	}
+	else if(IsBaselineLoaded() && ReportRegressions())
+		ExitCode = EXIT_CODE_REGRESSION;
+
+	Cleanup();
+	return ExitCode;
+}
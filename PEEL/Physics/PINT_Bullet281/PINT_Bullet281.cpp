@@ -9,6 +9,7 @@
 #include "stdafx.h"
 
 #include "..\PINT_Common\PINT_Common.h"
+#include "..\PINT_Common\PINT_CommonAllocator.h"
 #include "..\PINT_Common\PINT_CommonBullet.h"
 
 // For Bullet 2.81 I recompiled the Bullet Release libraries using "better" optimization settings (/SSE2, etc).
@@ -80,6 +81,7 @@ static			int	gDebugVizMask[NB_DEBUG_VIZ_PARAMS] =
 
 static udword	gNbAllocs = 0;
 static udword	gCurrentMemory = 0;
+static PintAllocTracker	gAllocTracker;
 
 	struct Header
 	{
@@ -89,12 +91,13 @@ static udword	gCurrentMemory = 0;
 
 static void* __btAlignedAllocFunc(size_t size, int alignment)
 {
-	char* memory = (char*)_aligned_malloc(size+16, 16);
+	char* memory = (char*)Common_Alloc(size+16);
 	Header* H = (Header*)memory;
 	H->mMagic = 0x12345678;
 	H->mSize = size;
 	gNbAllocs++;
 	gCurrentMemory+=size;
+	gAllocTracker.OnAlloc(size);
 	return memory + 16;
 }
 
@@ -106,19 +109,21 @@ static void __btAlignedFreeFunc(void* ptr)
 	Header* H = (Header*)(bptr - 16);
 	ASSERT(H->mMagic==0x12345678);
 	const udword Size = H->mSize;
-	_aligned_free(H);
+	Common_Free(H);
 	gNbAllocs--;
 	gCurrentMemory-=Size;
+	gAllocTracker.OnFree(Size);
 }
 
 static void* __btAllocFunc(size_t size)
 {
-	char* memory = (char*)_aligned_malloc(size+16, 16);
+	char* memory = (char*)Common_Alloc(size+16);
 	Header* H = (Header*)memory;
 	H->mMagic = 0x12345678;
 	H->mSize = size;
 	gNbAllocs++;
 	gCurrentMemory+=size;
+	gAllocTracker.OnAlloc(size);
 	return memory + 16;
 }
 
@@ -130,9 +135,10 @@ static void __btFreeFunc(void* ptr)
 	Header* H = (Header*)(bptr - 16);
 	ASSERT(H->mMagic==0x12345678);
 	const udword Size = H->mSize;
-	_aligned_free(H);
+	Common_Free(H);
 	gNbAllocs--;
 	gCurrentMemory-=Size;
+	gAllocTracker.OnFree(Size);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -284,6 +290,8 @@ void Bullet::Init(const PINT_WORLD_CREATE& desc)
 
 	gNbAllocs = 0;
 	gCurrentMemory = 0;
+	Common_SetAllocator(desc.GetAllocatorType(), desc.GetAllocTracking());
+	gAllocTracker.Reset();
 	if(gUseCustomMemoryAllocator)
 	{
 		btAlignedAllocSetCustomAligned(__btAlignedAllocFunc, __btAlignedFreeFunc);
@@ -419,6 +427,7 @@ void Bullet::Close()
 
 	if(gNbAllocs)
 		printf("Bullet 2.81: %d leaks found (%d bytes)\n", gNbAllocs, gCurrentMemory);
+	Common_ReleaseAllocator();
 }
 
 udword Bullet::Update(float dt)
@@ -430,6 +439,11 @@ udword Bullet::Update(float dt)
 	return gCurrentMemory;
 }
 
+const PintAllocStats* Bullet::GetAllocStats()
+{
+	return gUseCustomMemoryAllocator ? &gAllocTracker.GetStats() : null;
+}
+
 static void DrawLeafShape(PintRender& renderer, const btCollisionShape* shape, const PR& pose)
 {
 	ASSERT(shape->getUserPointer());
@@ -819,6 +833,8 @@ bool Bullet::ReleaseObject(PintObjectHandle handle)
 	//### shapes and stuff?
 	btRigidBody* body = (btRigidBody*)handle;
 	mDynamicsWorld->removeRigidBody(body);
+	// Same as in Close()
+	delete body->getMotionState();
 	DELETESINGLE(body);
 	return true;
 }
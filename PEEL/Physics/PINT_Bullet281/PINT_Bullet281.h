@@ -25,6 +25,7 @@
 		virtual	void									SetGravity(const Point& gravity);
 		virtual	void									Close();
 		virtual	udword									Update(float dt);
+		virtual	const PintAllocStats*					GetAllocStats();
 		virtual	Point									GetMainColor();
 		virtual	void									Render(PintRender& renderer);
 
@@ -40,6 +41,8 @@
 
 		virtual	PR										GetWorldTransform(PintObjectHandle handle);
 		virtual	void									SetWorldTransform(PintObjectHandle handle, const PR& pose);
+		virtual	void									GetWorldTransforms(udword nb, const PintObjectHandle* handles, PR* poses);
+		virtual	udword									GetActiveTransforms(udword max_nb, PintObjectHandle* handles, Point* positions, Quat* rotations);
 
 //		virtual	void									ApplyActionAtPoint(PintObjectHandle handle, PintActionType action_type, const Point& action, const Point& pos);
 		virtual	void									AddWorldImpulseAtWorldPos(PintObjectHandle handle, const Point& world_impulse, const Point& world_pos);
@@ -8,6 +8,7 @@
 
 #include "stdafx.h"
 #include "PINT_Common.h"
+#include "PINT_CommonAllocator.h"
 
 void Common_GetFromEditBox(float& value, const IceEditBox* edit_box, float min_value, float max_value)
 {
@@ -145,11 +146,12 @@ void* MyIceAllocator::malloc(size_t size, MemoryType type)
 	mCurrentNbAllocs++;
 //	return ::malloc(size);
 
-	MemHeader* Header = (MemHeader*)_aligned_malloc(size+sizeof(MemHeader), 16);
+	MemHeader* Header = (MemHeader*)Common_Alloc(size+sizeof(MemHeader));
 	Header->mName		= mName;
 	Header->mCheckValue	= 0x12345678;
 	Header->mSize		= size;
 	mUsedMemory += size;
+	mTracker.OnAlloc(size);
 	return Header+1;
 }
 
@@ -159,11 +161,12 @@ void* MyIceAllocator::mallocDebug(size_t size, const char* filename, udword line
 //	return ::malloc(size);
 //	return _aligned_malloc(size, 16);
 
-	MemHeader* Header = (MemHeader*)_aligned_malloc(size+sizeof(MemHeader), 16);
+	MemHeader* Header = (MemHeader*)Common_Alloc(size+sizeof(MemHeader));
 	Header->mName		= mName;
 	Header->mCheckValue	= 0x12345678;
 	Header->mSize		= size;
 	mUsedMemory += size;
+	mTracker.OnAlloc(size);
 	return Header+1;
 }
 
@@ -194,5 +197,6 @@ void MyIceAllocator::free(void* memory, bool from_new)
 //	ASSERT(Header->mCheckValue == 0x12345678);
 	ASSERT(Header->mName==mName);
 	mUsedMemory -= Header->mSize;
-	_aligned_free(Header);
+	mTracker.OnFree(Header->mSize);
+	Common_Free(Header);
 }
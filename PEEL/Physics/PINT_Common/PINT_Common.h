@@ -9,6 +9,8 @@
 #ifndef PINT_COMMON_H
 #define PINT_COMMON_H
 
+#include "..\PintAllocTracker.h"
+
 	struct MemHeader
 	{
 		const char*	mName;
@@ -34,6 +36,7 @@
 				udword		mCurrentNbAllocs;
 				udword		mUsedMemory;
 				Allocator*	mPreviousAllocator;
+		PintAllocTracker	mTracker;
 	};
 
 	void	Common_GetFromEditBox(float& value, const IceEditBox* edit_box, float min_value, float max_value);
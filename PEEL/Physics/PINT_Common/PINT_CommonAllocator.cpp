@@ -0,0 +1,478 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "PINT_CommonAllocator.h"
+
+// Arena: blocks are bump-allocated from large chunks, frees only decrement the chunk's counter. When all the blocks
+// of the current chunk have been freed (typically the engine's per-frame temporary memory) the chunk is reset,
+// other chunks go back to a free list. Persistent blocks keep their chunk alive.
+#define ARENA_CHUNK_SIZE		(1024*1024)
+#define ARENA_MAX_BLOCK_SIZE	(ARENA_CHUNK_SIZE/4)	// Larger blocks get a dedicated chunk
+
+// Pool: one free list per size class (PINT_ALLOC_SIZE_CLASS_MIN<<i bytes, header included), blocks are carved
+// from slabs. Each thread has its own cache of free blocks and only locks to exchange batches with the shared lists.
+#define POOL_NB_SIZE_CLASSES	9										// Up to 4 Kb, larger blocks use the system allocator
+#define POOL_SLAB_SIZE			(64*1024)
+#define POOL_CACHE_SIZE			64										// Max number of free blocks per size class in a thread cache
+#define POOL_MAX_BLOCK_SIZE		(PINT_ALLOC_SIZE_CLASS_MIN<<(POOL_NB_SIZE_CLASSES-1))
+
+namespace
+{
+	struct BlockHeader
+	{
+		udword	mType;			// PintAllocatorType the block comes from
+		udword	mSizeClass;		// Pool blocks only
+		void*	mOwner;			// Arena blocks only: the chunk
+#ifndef _WIN64
+		udword	mPad;
+#endif
+	};
+
+	class Lock
+	{
+		public:
+				Lock()		{ InitializeCriticalSection(&mCS);	}
+				~Lock()		{ DeleteCriticalSection(&mCS);		}
+
+		void	Enter()		{ EnterCriticalSection(&mCS);		}
+		void	Leave()		{ LeaveCriticalSection(&mCS);		}
+
+		CRITICAL_SECTION	mCS;
+	};
+
+	class ScopedLock
+	{
+		public:
+				ScopedLock(Lock& lock) : mLock(lock)	{ mLock.Enter();	}
+				~ScopedLock()							{ mLock.Leave();	}
+		Lock&	mLock;
+		private:
+		ScopedLock& operator=(const ScopedLock&);
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	struct ArenaChunk
+	{
+		ArenaChunk*		mNext;			// Next chunk in the list of all chunks
+		ArenaChunk*		mNextFree;		// Next chunk in the free list
+		size_t			mSize;
+		size_t			mOffset;
+		volatile LONG	mNbLiveBlocks;
+		bool			mDedicated;		// Single large block, not recycled
+		bool			mInFreeList;
+
+		inline_	char*	GetData()	{ return ((char*)this) + 64;	}
+	};
+
+	class FrameArena
+	{
+		public:
+						FrameArena() : mChunks(null), mFreeChunks(null), mCurrent(null), mNbLiveBlocks(0)	{}
+
+		BlockHeader*	Alloc(size_t size);
+		void			Free(BlockHeader* header);
+		void			Release();
+
+		private:
+		Lock			mLock;
+		ArenaChunk*		mChunks;
+		ArenaChunk*		mFreeChunks;
+		ArenaChunk*		mCurrent;
+		volatile LONG	mNbLiveBlocks;
+
+		ArenaChunk*		CreateChunk(size_t size);
+		void			RecycleChunk(ArenaChunk* chunk);
+	};
+
+	///////////////////////////////////////////////////////////////////////////////
+
+	struct PoolBlock
+	{
+		PoolBlock*	mNext;
+	};
+
+	struct ThreadCache
+	{
+		PoolBlock*		mBlocks[POOL_NB_SIZE_CLASSES];
+		udword			mNbBlocks[POOL_NB_SIZE_CLASSES];
+		ThreadCache*	mNext;
+	};
+
+	class SizeClassPool
+	{
+		public:
+						SizeClassPool();
+						~SizeClassPool();
+
+		BlockHeader*	Alloc(udword size_class);
+		void			Free(BlockHeader* header);
+		void			Release();
+
+		private:
+		Lock			mLock;
+		DWORD			mTlsIndex;
+		PoolBlock*		mBlocks[POOL_NB_SIZE_CLASSES];	// Shared free lists
+		void*			mSlabs;
+		ThreadCache*	mCaches;
+		volatile LONG	mNbLiveBlocks;
+
+		ThreadCache*	GetThreadCache();
+		void			Refill(ThreadCache* cache, udword size_class);
+	};
+}
+
+ICE_COMPILE_TIME_ASSERT(sizeof(BlockHeader)==16);
+ICE_COMPILE_TIME_ASSERT(sizeof(ArenaChunk)<=64);
+
+static PintAllocatorType	gAllocatorType = PINT_ALLOCATOR_SYSTEM;
+static FrameArena			gArena;
+static SizeClassPool		gPool;
+
+///////////////////////////////////////////////////////////////////////////////
+
+ArenaChunk* FrameArena::CreateChunk(size_t size)
+{
+	ArenaChunk* Chunk = (ArenaChunk*)_aligned_malloc(size+64, 16);
+	if(!Chunk)
+		return null;
+	Chunk->mNext			= mChunks;
+	Chunk->mNextFree		= null;
+	Chunk->mSize			= size;
+	Chunk->mOffset			= 0;
+	Chunk->mNbLiveBlocks	= 0;
+	Chunk->mDedicated		= false;
+	Chunk->mInFreeList		= false;
+	mChunks = Chunk;
+	return Chunk;
+}
+
+// Called with the lock held
+void FrameArena::RecycleChunk(ArenaChunk* chunk)
+{
+	ASSERT(!chunk->mNbLiveBlocks);
+	if(chunk==mCurrent)
+	{
+		chunk->mOffset = 0;
+	}
+	else if(chunk->mDedicated)
+	{
+		ArenaChunk** Link = &mChunks;
+		while(*Link!=chunk)
+			Link = &(*Link)->mNext;
+		*Link = chunk->mNext;
+		_aligned_free(chunk);
+	}
+	else if(!chunk->mInFreeList)
+	{
+		chunk->mOffset		= 0;
+		chunk->mInFreeList	= true;
+		chunk->mNextFree	= mFreeChunks;
+		mFreeChunks = chunk;
+	}
+}
+
+BlockHeader* FrameArena::Alloc(size_t size)
+{
+	size = (size+15)&~size_t(15);
+
+	ScopedLock _(mLock);
+
+	ArenaChunk* Chunk;
+	if(size>ARENA_MAX_BLOCK_SIZE)
+	{
+		Chunk = CreateChunk(size);
+		if(!Chunk)
+			return null;
+		Chunk->mDedicated = true;
+	}
+	else
+	{
+		if(!mCurrent || mCurrent->mOffset+size>mCurrent->mSize)
+		{
+			ArenaChunk* Previous = mCurrent;
+			if(mFreeChunks)
+			{
+				mCurrent = mFreeChunks;
+				mFreeChunks = mCurrent->mNextFree;
+				mCurrent->mInFreeList = false;
+			}
+			else
+			{
+				mCurrent = CreateChunk(ARENA_CHUNK_SIZE);
+				if(!mCurrent)
+					return null;
+			}
+			// A retired chunk whose blocks are all gone can be reused right away
+			if(Previous && !Previous->mNbLiveBlocks)
+				RecycleChunk(Previous);
+		}
+		Chunk = mCurrent;
+	}
+
+	BlockHeader* Header = (BlockHeader*)(Chunk->GetData() + Chunk->mOffset);
+	Chunk->mOffset += size;
+	InterlockedIncrement(&Chunk->mNbLiveBlocks);
+	InterlockedIncrement(&mNbLiveBlocks);
+	Header->mOwner = Chunk;
+	return Header;
+}
+
+void FrameArena::Free(BlockHeader* header)
+{
+	ArenaChunk* Chunk = (ArenaChunk*)header->mOwner;
+	InterlockedDecrement(&mNbLiveBlocks);
+	if(InterlockedDecrement(&Chunk->mNbLiveBlocks))
+		return;
+
+	ScopedLock _(mLock);
+	// Blocks may have been allocated from the chunk in the meantime
+	if(!Chunk->mNbLiveBlocks)
+		RecycleChunk(Chunk);
+}
+
+void FrameArena::Release()
+{
+	ScopedLock _(mLock);
+	if(mNbLiveBlocks)
+		return;
+
+	ArenaChunk* Chunk = mChunks;
+	while(Chunk)
+	{
+		ArenaChunk* Next = Chunk->mNext;
+		_aligned_free(Chunk);
+		Chunk = Next;
+	}
+	mChunks = null;
+	mFreeChunks = null;
+	mCurrent = null;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+SizeClassPool::SizeClassPool() : mSlabs(null), mCaches(null), mNbLiveBlocks(0)
+{
+	mTlsIndex = TlsAlloc();
+	for(udword i=0;i<POOL_NB_SIZE_CLASSES;i++)
+		mBlocks[i] = null;
+}
+
+SizeClassPool::~SizeClassPool()
+{
+	// Thread caches only reference slab memory, they can go even if blocks are still in use
+	ThreadCache* Cache = mCaches;
+	while(Cache)
+	{
+		ThreadCache* Next = Cache->mNext;
+		::free(Cache);
+		Cache = Next;
+	}
+	if(mTlsIndex!=TLS_OUT_OF_INDEXES)
+		TlsFree(mTlsIndex);
+}
+
+ThreadCache* SizeClassPool::GetThreadCache()
+{
+	ThreadCache* Cache = (ThreadCache*)TlsGetValue(mTlsIndex);
+	if(!Cache)
+	{
+		Cache = (ThreadCache*)::malloc(sizeof(ThreadCache));
+		if(!Cache)
+			return null;
+		ZeroMemory(Cache, sizeof(ThreadCache));
+		{
+			ScopedLock _(mLock);
+			Cache->mNext = mCaches;
+			mCaches = Cache;
+		}
+		TlsSetValue(mTlsIndex, Cache);
+	}
+	return Cache;
+}
+
+void SizeClassPool::Refill(ThreadCache* cache, udword size_class)
+{
+	ScopedLock _(mLock);
+
+	// Take half a cache worth of blocks from the shared list...
+	udword NbBlocks = 0;
+	while(mBlocks[size_class] && NbBlocks<POOL_CACHE_SIZE/2)
+	{
+		PoolBlock* Block = mBlocks[size_class];
+		mBlocks[size_class] = Block->mNext;
+		Block->mNext = cache->mBlocks[size_class];
+		cache->mBlocks[size_class] = Block;
+		NbBlocks++;
+	}
+	cache->mNbBlocks[size_class] += NbBlocks;
+	if(NbBlocks)
+		return;
+
+	// ...or carve a new slab. The first 16 bytes link the slabs together.
+	char* Slab = (char*)_aligned_malloc(POOL_SLAB_SIZE, 16);
+	if(!Slab)
+		return;
+	*(void**)Slab = mSlabs;
+	mSlabs = Slab;
+
+	const udword BlockSize = PINT_ALLOC_SIZE_CLASS_MIN<<size_class;
+	NbBlocks = (POOL_SLAB_SIZE-16)/BlockSize;
+	char* Memory = Slab + 16;
+	for(udword i=0;i<NbBlocks;i++)
+	{
+		PoolBlock* Block = (PoolBlock*)Memory;
+		Block->mNext = cache->mBlocks[size_class];
+		cache->mBlocks[size_class] = Block;
+		Memory += BlockSize;
+	}
+	cache->mNbBlocks[size_class] += NbBlocks;
+}
+
+BlockHeader* SizeClassPool::Alloc(udword size_class)
+{
+	ASSERT(size_class<POOL_NB_SIZE_CLASSES);
+	ThreadCache* Cache = GetThreadCache();
+	if(!Cache)
+		return null;
+
+	if(!Cache->mBlocks[size_class])
+	{
+		Refill(Cache, size_class);
+		if(!Cache->mBlocks[size_class])
+			return null;
+	}
+
+	PoolBlock* Block = Cache->mBlocks[size_class];
+	Cache->mBlocks[size_class] = Block->mNext;
+	Cache->mNbBlocks[size_class]--;
+	InterlockedIncrement(&mNbLiveBlocks);
+
+	BlockHeader* Header = (BlockHeader*)Block;
+	Header->mSizeClass = size_class;
+	return Header;
+}
+
+void SizeClassPool::Free(BlockHeader* header)
+{
+	const udword SizeClass = header->mSizeClass;
+	ASSERT(SizeClass<POOL_NB_SIZE_CLASSES);
+	InterlockedDecrement(&mNbLiveBlocks);
+
+	// Blocks go to the freeing thread's cache, not necessarily the one they came from
+	PoolBlock* Block = (PoolBlock*)header;
+	ThreadCache* Cache = GetThreadCache();
+	if(!Cache)
+	{
+		ScopedLock _(mLock);
+		Block->mNext = mBlocks[SizeClass];
+		mBlocks[SizeClass] = Block;
+		return;
+	}
+
+	Block->mNext = Cache->mBlocks[SizeClass];
+	Cache->mBlocks[SizeClass] = Block;
+	if(++Cache->mNbBlocks[SizeClass]<=POOL_CACHE_SIZE)
+		return;
+
+	// Cache is full, give half of it back to the shared list
+	ScopedLock _(mLock);
+	for(udword i=0;i<POOL_CACHE_SIZE/2;i++)
+	{
+		Block = Cache->mBlocks[SizeClass];
+		Cache->mBlocks[SizeClass] = Block->mNext;
+		Block->mNext = mBlocks[SizeClass];
+		mBlocks[SizeClass] = Block;
+	}
+	Cache->mNbBlocks[SizeClass] -= POOL_CACHE_SIZE/2;
+}
+
+// Must not run while other threads use the pool (engine threads are idle when plugins are closed)
+void SizeClassPool::Release()
+{
+	ScopedLock _(mLock);
+	if(mNbLiveBlocks)
+		return;
+
+	for(ThreadCache* Cache=mCaches;Cache;Cache=Cache->mNext)
+	{
+		for(udword i=0;i<POOL_NB_SIZE_CLASSES;i++)
+		{
+			Cache->mBlocks[i] = null;
+			Cache->mNbBlocks[i] = 0;
+		}
+	}
+
+	for(udword i=0;i<POOL_NB_SIZE_CLASSES;i++)
+		mBlocks[i] = null;
+
+	while(mSlabs)
+	{
+		void* Next = *(void**)mSlabs;
+		_aligned_free(mSlabs);
+		mSlabs = Next;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Common_SetAllocator(PintAllocatorType type, bool alloc_tracking)
+{
+	gAllocatorType = type;
+	PintAllocTracking() = alloc_tracking;
+}
+
+PintAllocatorType Common_GetAllocator()
+{
+	return gAllocatorType;
+}
+
+void Common_ReleaseAllocator()
+{
+	gArena.Release();
+	gPool.Release();
+}
+
+void* Common_Alloc(size_t size)
+{
+	const size_t Size = size + sizeof(BlockHeader);
+
+	BlockHeader* Header = null;
+	PintAllocatorType Type = gAllocatorType;
+	if(Type==PINT_ALLOCATOR_ARENA)
+		Header = gArena.Alloc(Size);
+	else if(Type==PINT_ALLOCATOR_POOL && Size<=POOL_MAX_BLOCK_SIZE)
+		Header = gPool.Alloc(GetPintAllocSizeClass(Size));
+
+	// System allocator, also used for large pool blocks and as a fallback
+	if(!Header)
+	{
+		Type = PINT_ALLOCATOR_SYSTEM;
+		Header = (BlockHeader*)_aligned_malloc(Size, 16);
+		if(!Header)
+			return null;
+	}
+
+	Header->mType = Type;
+	return Header+1;
+}
+
+void Common_Free(void* memory)
+{
+	if(!memory)
+		return;
+
+	BlockHeader* Header = ((BlockHeader*)memory)-1;
+	switch(Header->mType)
+	{
+		case PINT_ALLOCATOR_ARENA:	gArena.Free(Header);		break;
+		case PINT_ALLOCATOR_POOL:	gPool.Free(Header);			break;
+		default:					_aligned_free(Header);		break;
+	};
+}
@@ -0,0 +1,29 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef PINT_COMMON_ALLOCATOR_H
+#define PINT_COMMON_ALLOCATOR_H
+
+#include "..\PintAllocTracker.h"
+
+	// Allocator backends under the plugins' allocator hooks. The hooks call Common_Alloc/Common_Free instead of
+	// _aligned_malloc/_aligned_free, and Init() selects the backend with Common_SetAllocator(desc.GetAllocatorType(),
+	// desc.GetAllocTracking()). The second parameter enables the plugin's PintAllocTracker (off by default).
+	//
+	// Each block remembers the backend it comes from, so blocks allocated before a switch (e.g. by static objects)
+	// can still be freed afterwards. Returned memory is 16-byte aligned.
+
+	void				Common_SetAllocator(PintAllocatorType type, bool alloc_tracking);
+	PintAllocatorType	Common_GetAllocator();
+	// Gives the arena & pool memory back to the system, if all their blocks have been freed. Call it from Close().
+	void				Common_ReleaseAllocator();
+
+	void*				Common_Alloc(size_t size);
+	void				Common_Free(void* memory);
+
+#endif
@@ -296,6 +296,43 @@ PR Bullet::GetWorldTransform(PintObjectHandle handle)
 	return ToPR(trans);
 }
 
+void Bullet::GetWorldTransforms(udword nb, const PintObjectHandle* handles, PR* poses)
+{
+	btTransform trans;
+	while(nb--)
+	{
+		const btRigidBody* body = (const btRigidBody*)*handles++;
+		body->getMotionState()->getWorldTransform(trans);
+		*poses++ = ToPR(trans);
+	}
+}
+
+udword Bullet::GetActiveTransforms(udword max_nb, PintObjectHandle* handles, Point* positions, Quat* rotations)
+{
+	ASSERT(mDynamicsWorld);
+
+	// Bullet doesn't keep a list of moving bodies, so we filter out static & sleeping ones from the objects array.
+	const btCollisionObjectArray& Objects = mDynamicsWorld->getCollisionObjectArray();
+	const int NbObjects = Objects.size();
+
+	udword NbActive = 0;
+	btTransform trans;
+	for(int i=0;i<NbObjects && NbActive<max_nb;i++)
+	{
+		const btRigidBody* body = btRigidBody::upcast(Objects[i]);
+		if(!body || body->isStaticObject() || !body->isActive() || !body->getMotionState())
+			continue;
+
+		body->getMotionState()->getWorldTransform(trans);
+		if(handles)
+			handles[NbActive] = PintObjectHandle(body);
+		positions[NbActive] = ToPoint(trans.getOrigin());
+		rotations[NbActive] = ToQuat(trans.getRotation());
+		NbActive++;
+	}
+	return NbActive;
+}
+
 void Bullet::SetWorldTransform(PintObjectHandle handle, const PR& pose)
 {
 	btRigidBody* body = (btRigidBody*)handle;
@@ -568,6 +568,55 @@ udword Havok_GetAllocatedMemory()
 	}*/
 }
 
+namespace
+{
+	class TrackingAllocator : public hkMemoryAllocator
+	{
+		public:
+						TrackingAllocator() : mAllocator(null)	{}
+
+		virtual void*	blockAlloc(int nbytes)
+						{
+							void* p = mAllocator->blockAlloc(nbytes);
+							if(p)
+								mTracker.OnAlloc(nbytes);
+							return p;
+						}
+
+		virtual void	blockFree(void* p, int nbytes)
+						{
+							if(p)
+								mTracker.OnFree(nbytes);
+							mAllocator->blockFree(p, nbytes);
+						}
+
+		// These are const or not depending on the Havok version, both are defined so that one of them overrides
+		virtual void	getMemoryStatistics(MemoryStatistics& u)		{ mAllocator->getMemoryStatistics(u);				}
+		virtual void	getMemoryStatistics(MemoryStatistics& u) const	{ mAllocator->getMemoryStatistics(u);				}
+		virtual int		getAllocatedSize(const void* obj, int nbytes)		{ return mAllocator->getAllocatedSize(obj, nbytes);	}
+		virtual int		getAllocatedSize(const void* obj, int nbytes) const	{ return mAllocator->getAllocatedSize(obj, nbytes);	}
+
+		hkMemoryAllocator*	mAllocator;
+		PintAllocTracker	mTracker;
+	};
+}
+
+static TrackingAllocator gTrackingAllocator;
+
+hkMemoryAllocator* Havok_InitTrackingAllocator(hkMemoryAllocator* allocator, bool alloc_tracking)
+{
+	ASSERT(allocator);
+	PintAllocTracking() = alloc_tracking;
+	gTrackingAllocator.mAllocator = allocator;
+	gTrackingAllocator.mTracker.Reset();
+	return &gTrackingAllocator;
+}
+
+const PintAllocStats* Havok_GetAllocStats()
+{
+	return gTrackingAllocator.mAllocator ? &gTrackingAllocator.mTracker.GetStats() : null;
+}
+
 static hkpShape* CreateMeshShape(const PINT_MESH_CREATE& create, HavokMeshFormat format)
 {
 	// ### share meshes?
@@ -1840,6 +1889,25 @@ void Havok_::GetOptionsFromGUI()
 	Common_GetFromEditBox(gParams.mGlobalBoxSize, gHavokUI->mEditBox_GlobalBoxSize, 0.0f, FLT_MAX);
 }
 
+static udword gNbThreadsSetting = INVALID_ID;	// Plugin's own setting, while overridden
+
+void Havok_::GetOptionsFromDesc(const PINT_WORLD_CREATE& desc)
+{
+	// Without UI nothing else restores the setting after an override
+	if(gNbThreadsSetting!=INVALID_ID)
+	{
+		if(!gHavokUI || !gHavokUI->mComboBox_NbThreads)
+			gParams.mNbThreads = gNbThreadsSetting;
+		gNbThreadsSetting = INVALID_ID;
+	}
+
+	if(desc.GetNbWorkerThreads()!=INVALID_ID)
+	{
+		gNbThreadsSetting = gParams.mNbThreads;
+		gParams.mNbThreads = desc.GetNbWorkerThreads();
+	}
+}
+
 static void gCheckBoxCallback(const IceCheckBox& check_box, bool checked, void* user_data)
 {
 	switch(check_box.GetID())
@@ -114,6 +114,12 @@
 
 	udword Havok_GetAllocatedMemory();
 
+	// Wraps the base allocator given to the Havok memory system, to feed PEEL's allocation telemetry. Havok's own free
+	// lists sit on top of it, so this records the blocks Havok requests from the system, not each engine allocation.
+	// Tracking is enabled if 'alloc_tracking' is set, see PINT_WORLD_CREATE::GetAllocTracking().
+	hkMemoryAllocator*		Havok_InitTrackingAllocator(hkMemoryAllocator* allocator, bool alloc_tracking);
+	const PintAllocStats*	Havok_GetAllocStats();
+
 	struct EditableParams
 	{
 												EditableParams();
@@ -149,6 +155,8 @@
 		IceWindow*				InitSharedGUI(IceWidget* parent, PintGUIHelper& helper, UICallback& callback);
 		const EditableParams&	GetEditableParams();
 		void					GetOptionsFromGUI();
+		// Applies the system overrides (e.g. number of threads) on top of the UI options
+		void					GetOptionsFromDesc(const PINT_WORLD_CREATE& desc);
 		void					CloseSharedGUI();
 	}
 
@@ -11,6 +11,7 @@
 #include "stdafx.h"
 #include "..\Pint.h"
 #include "PINT_Common.h"
+#include "PINT_CommonAllocator.h"
 #include "PINT_CommonPhysX3.h"
 
 #ifdef PHYSX_SUPPORT_RAYCAST_CCD
@@ -143,7 +144,7 @@ static int atomicAdd(volatile int* val, int delta)
 PX_COMPILE_TIME_ASSERT(sizeof(PEEL_PhysX3_AllocatorCallback::Header)<=32);
 void* PEEL_PhysX3_AllocatorCallback::allocate(size_t size, const char* typeName, const char* filename, int line)
 {
-	char* memory = (char*)_aligned_malloc(size+32, 16);
+	char* memory = (char*)Common_Alloc(size+32);
 	Header* H = (Header*)memory;
 	H->mMagic		= 0x12345678;
 	H->mSize		= size;
@@ -160,6 +161,8 @@ void* PEEL_PhysX3_AllocatorCallback::allocate(size_t size, const char* typeName,
 	atomicAdd((int*)&mCurrentMemory, size);
 //	mCurrentMemory+=size;
 
+	mTracker.OnAlloc(size);
+
 	return memory + 32;
 }
 
@@ -172,13 +175,15 @@ void PEEL_PhysX3_AllocatorCallback::deallocate(void* ptr)
 	Header* H = (Header*)(bptr - 32);
 	ASSERT(H->mMagic==0x12345678);
 	const udword Size = H->mSize;
-	_aligned_free(H);
+	Common_Free(H);
 
 	atomicDecrement((int*)&mNbAllocs);
 //	mNbAllocs--;
 
 	atomicAdd((int*)&mCurrentMemory, -(int)Size);
 //	mCurrentMemory-=Size;
+
+	mTracker.OnFree(Size);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1023,42 +1028,61 @@ extern PxU32 gNbLocalVectors;
 extern PxVec3 gLocalVectors[256];
 #endif
 
-void SharedPhysX::UpdateCommon(float dt)
+void SharedPhysX::FetchResultsCommon()
+{
+	// Queries from other threads can run until the simulation is over, fetchResults() then waits for them
+	mScene->checkResults(true);
+
+	PHYSX_SCENE_WRITE_LOCK;
+	mScene->fetchResults(true);
+}
+
+// Runs all substeps but the last one, which is only started. EndUpdateCommon() must be called before anything else.
+void SharedPhysX::BeginUpdateCommon(float dt)
 {
 #ifdef CAPTURE_VECTORS
 	SaveAsSource("D://tmp//LocalVectors.cpp", "LocalVectors", gLocalVectors, gNbLocalVectors*sizeof(PxVec3), gNbLocalVectors*sizeof(PxVec3), PACK_NONE);
 #endif
 
-	if(mScene)
+	if(!mScene)
+		return;
+
+	const udword NbSubsteps = mParams.mNbSubsteps;
+	const float sdt = dt/float(NbSubsteps);
+	for(udword i=0;i<NbSubsteps;i++)
 	{
-		if(1)
+		if(i)
+			FetchResultsCommon();
+
+		if(NbSubsteps>1)
 		{
-			const udword NbSubsteps = mParams.mNbSubsteps;
-			const float sdt = dt/float(NbSubsteps);
-			for(udword i=0;i<NbSubsteps;i++)
+			const udword Size = mLocalTorques.size();
+			for(udword j=0;j<Size;j++)
 			{
-				if(NbSubsteps>1)
-				{
-					const udword Size = mLocalTorques.size();
-					for(udword j=0;j<Size;j++)
-					{
-						const LocalTorque& Current = mLocalTorques[j];
+				const LocalTorque& Current = mLocalTorques[j];
 
-						PxRigidBody* RigidBody = GetRigidBody(Current.mHandle);
-						if(RigidBody)
-						{
-							const PxVec3 GlobalTorque = RigidBody->getGlobalPose().rotate(ToPxVec3(Current.mLocalTorque));
-					//		RigidBody->addTorque(GlobalTorque, PxForceMode::eFORCE, true);
-							RigidBody->addTorque(GlobalTorque, PxForceMode::eACCELERATION, true);
-						}
-					}
+				PxRigidBody* RigidBody = GetRigidBody(Current.mHandle);
+				if(RigidBody)
+				{
+					const PxVec3 GlobalTorque = RigidBody->getGlobalPose().rotate(ToPxVec3(Current.mLocalTorque));
+			//		RigidBody->addTorque(GlobalTorque, PxForceMode::eFORCE, true);
+					RigidBody->addTorque(GlobalTorque, PxForceMode::eACCELERATION, true);
 				}
-				mScene->simulate(sdt, null, GetScratchPad(), GetScratchPadSize());
-				mScene->fetchResults(true);
 			}
-			mLocalTorques.clear();
 		}
 
+		PHYSX_SCENE_WRITE_LOCK;
+		mScene->simulate(sdt, null, GetScratchPad(), GetScratchPadSize());
+	}
+}
+
+void SharedPhysX::EndUpdateCommon()
+{
+	if(mScene)
+	{
+		FetchResultsCommon();
+		mLocalTorques.clear();
+
 /*		mScene->setFlag(PxSceneFlag::eENABLE_MANUAL_QUERY_UPDATE, gSQManualFlushUpdates);
 		if(gSQManualFlushUpdates)
 			mScene->flushQueryUpdates();*/
@@ -1107,6 +1131,12 @@ void SharedPhysX::UpdateCommon(float dt)
 #endif
 }
 
+void SharedPhysX::UpdateCommon(float dt)
+{
+	BeginUpdateCommon(dt);
+	EndUpdateCommon();
+}
+
 void SharedPhysX::SetDisabledGroups(udword nb_groups, const PintDisabledGroups* groups)
 {
 	for(udword i=0;i<nb_groups;i++)
@@ -1157,6 +1187,77 @@ PintObjectHandle SharedPhysX::CreateObject(const PINT_OBJECT_CREATE& desc)
 	return CreateHandle(actor);
 }
 
+udword SharedPhysX::CreateObjects(udword nb, const PINT_OBJECT_CREATE* descs, PintObjectHandle* handles)
+{
+#ifdef PHYSX_SUPPORT_ADD_ACTORS
+	ASSERT(mPhysics);
+	ASSERT(mScene);
+
+	// Create all actors out of the scene first, then insert them in one go
+	mBatchRigidActors.clear();
+	udword NbCreated = 0;
+	for(udword i=0;i<nb;i++)
+	{
+		const PINT_OBJECT_CREATE& Desc = descs[i];
+		if(Desc.mAddToWorld)
+		{
+			PINT_OBJECT_CREATE OutOfScene = Desc;
+			OutOfScene.mAddToWorld = false;
+			handles[i] = CreateObject(OutOfScene);
+
+			PxRigidActor* Actor = GetActorFromHandle(handles[i]);
+			if(Actor)
+				mBatchRigidActors.push_back(Actor);
+		}
+		else
+			handles[i] = CreateObject(Desc);
+
+		if(handles[i])
+			NbCreated++;
+	}
+
+	const PxU32 NbActors = PxU32(mBatchRigidActors.size());
+	if(NbActors)
+	{
+#ifdef PHYSX_SUPPORT_PRUNING_STRUCTURE
+		// The scene-query trees are pre-built here, and merged into the scene's pruners by addActors().
+		PxPruningStructure* PS = mPhysics->createPruningStructure(&mBatchRigidActors[0], NbActors);
+		if(PS)
+		{
+			mScene->addActors(*PS);
+			PS->release();
+		}
+		else
+		{
+			// Pruning structures can't be built e.g. for actors without scene-query shapes
+			for(PxU32 i=0;i<NbActors;i++)
+				mScene->addActor(*mBatchRigidActors[i]);
+		}
+#else
+		mBatchActors.assign(mBatchRigidActors.begin(), mBatchRigidActors.end());
+		mScene->addActors(&mBatchActors[0], NbActors);
+		mBatchActors.clear();
+#endif
+		mBatchRigidActors.clear();
+
+		// Same as in CreateObject(), this needs the actors to be in the scene
+		for(udword i=0;i<nb;i++)
+		{
+			const PINT_OBJECT_CREATE& Desc = descs[i];
+			if(Desc.mAddToWorld && Desc.mMass!=0.0f && !Desc.mKinematic)
+			{
+				PxRigidActor* Actor = GetActorFromHandle(handles[i]);
+				if(Actor)
+					SetupSleeping(static_cast<PxRigidDynamic*>(Actor), mParams.mEnableSleeping);
+			}
+		}
+	}
+	return NbCreated;
+#else
+	return Pint::CreateObjects(nb, descs, handles);
+#endif
+}
+
 bool SharedPhysX::ReleaseObject(PintObjectHandle handle)
 {
 	PxRigidActor* RigidActor = GetActorFromHandle(handle);
@@ -1181,6 +1282,47 @@ bool SharedPhysX::ReleaseObject(PintObjectHandle handle)
 	return false;
 }
 
+udword SharedPhysX::ReleaseObjects(udword nb, const PintObjectHandle* handles)
+{
+#ifdef PHYSX_SUPPORT_REMOVE_ACTORS
+	ASSERT(mScene);
+
+	// Remove all actors from the scene in one call, then release them
+	mBatchActors.clear();
+	udword NbReleased = 0;
+	for(udword i=0;i<nb;i++)
+	{
+		PxRigidActor* RigidActor = GetActorFromHandle(handles[i]);
+		if(!RigidActor)
+		{
+			PxShape* Shape = GetShapeFromHandle(handles[i]);
+			if(Shape)
+				RigidActor = Shape->getActor();
+		}
+		if(!RigidActor)
+			continue;
+
+		if(RigidActor->getScene())
+			mBatchActors.push_back(RigidActor);
+		else
+			RigidActor->release();
+		NbReleased++;
+	}
+
+	const PxU32 NbActors = PxU32(mBatchActors.size());
+	if(NbActors)
+	{
+		mScene->removeActors(&mBatchActors[0], NbActors, false);
+		for(PxU32 i=0;i<NbActors;i++)
+			mBatchActors[i]->release();
+		mBatchActors.clear();
+	}
+	return NbReleased;
+#else
+	return Pint::ReleaseObjects(nb, handles);
+#endif
+}
+
 static	const	bool	gEnableCollisionBetweenJointed	= false;
 PintJointHandle SharedPhysX::CreateJoint(const PINT_JOINT_CREATE& desc)
 {
@@ -1212,6 +1354,47 @@ PR SharedPhysX::GetWorldTransform(PintObjectHandle handle)
 	return PR(ToPoint(Pose.p), ToQuat(Pose.q));
 }
 
+void SharedPhysX::GetWorldTransforms(udword nb, const PintObjectHandle* handles, PR* poses)
+{
+	while(nb--)
+	{
+		const PintObjectHandle Handle = *handles++;
+		PxRigidActor* RigidActor = GetActorFromHandle(Handle);
+		if(RigidActor)
+		{
+			const PxTransform Pose = RigidActor->getGlobalPose();
+			poses->mPos = ToPoint(Pose.p);
+			poses->mRot = ToQuat(Pose.q);
+		}
+		else
+			*poses = SharedPhysX::GetWorldTransform(Handle);
+		poses++;
+	}
+}
+
+udword SharedPhysX::GetActiveTransforms(udword max_nb, PintObjectHandle* handles, Point* positions, Quat* rotations)
+{
+	ASSERT(mScene);
+	// Without this flag the SDK doesn't track moving actors, and the caller must read all poses instead.
+	if(!(mScene->getFlags() & PxSceneFlag::eENABLE_ACTIVETRANSFORMS))
+		return INVALID_ID;
+
+	PxU32 NbActiveTransforms = 0;
+	const PxActiveTransform* ActiveTransforms = mScene->getActiveTransforms(NbActiveTransforms);
+	if(NbActiveTransforms>max_nb)
+		NbActiveTransforms = max_nb;
+
+	for(PxU32 i=0;i<NbActiveTransforms;i++)
+	{
+		const PxActiveTransform& Current = ActiveTransforms[i];
+		if(handles)
+			handles[i] = PintObjectHandle(Current.actor);
+		positions[i] = ToPoint(Current.actor2World.p);
+		rotations[i] = ToQuat(Current.actor2World.q);
+	}
+	return NbActiveTransforms;
+}
+
 void SharedPhysX::SetWorldTransform(PintObjectHandle handle, const PR& pose)
 {
 	const PxTransform Pose(ToPxVec3(pose.mPos), ToPxQuat(pose.mRot));
@@ -1773,6 +1956,7 @@ PintObjectHandle SharedPhysX::CreateArticulationLink(PxArticulation* articulatio
 udword SharedPhysX::BatchRaycastAny(PintSQThreadContext context, udword nb, PintBooleanHit* dest, const PintRaycastData* raycasts)
 {
 	ASSERT(mScene);
+	PHYSX_SQ_READ_LOCK;
 
 	const PxQueryFilterData PF = GetSQFilterData();
 
@@ -1792,6 +1976,7 @@ udword SharedPhysX::BatchRaycastAny(PintSQThreadContext context, udword nb, Pint
 udword SharedPhysX::BatchSphereOverlapAny(PintSQThreadContext context, udword nb, PintBooleanHit* dest, const PintSphereOverlapData* overlaps)
 {
 	ASSERT(mScene);
+	PHYSX_SQ_READ_LOCK;
 
 	const PxQueryFilterData PF = GetSQFilterData();
 
@@ -1823,6 +2008,7 @@ udword SharedPhysX::BatchSphereOverlapAny(PintSQThreadContext context, udword nb
 udword SharedPhysX::BatchSphereOverlapObjects(PintSQThreadContext context, udword nb, PintOverlapObjectHit* dest, const PintSphereOverlapData* overlaps)
 {
 	ASSERT(mScene);
+	PHYSX_SQ_READ_LOCK;
 
 	const PxQueryFilterData PF = GetSQFilterData();
 
@@ -1849,6 +2035,7 @@ udword SharedPhysX::BatchSphereOverlapObjects(PintSQThreadContext context, udwor
 udword SharedPhysX::BatchBoxOverlapAny(PintSQThreadContext context, udword nb, PintBooleanHit* dest, const PintBoxOverlapData* overlaps)
 {
 	ASSERT(mScene);
+	PHYSX_SQ_READ_LOCK;
 
 	const PxQueryFilterData PF = GetSQFilterData();
 
@@ -1878,6 +2065,7 @@ udword SharedPhysX::BatchBoxOverlapAny(PintSQThreadContext context, udword nb, P
 udword SharedPhysX::BatchBoxOverlapObjects(PintSQThreadContext context, udword nb, PintOverlapObjectHit* dest, const PintBoxOverlapData* overlaps)
 {
 	ASSERT(mScene);
+	PHYSX_SQ_READ_LOCK;
 
 	const PxQueryFilterData PF = GetSQFilterData();
 
@@ -1902,6 +2090,7 @@ udword SharedPhysX::BatchBoxOverlapObjects(PintSQThreadContext context, udword n
 udword SharedPhysX::BatchCapsuleOverlapAny(PintSQThreadContext context, udword nb, PintBooleanHit* dest, const PintCapsuleOverlapData* overlaps)
 {
 	ASSERT(mScene);
+	PHYSX_SQ_READ_LOCK;
 
 	const PxQueryFilterData PF = GetSQFilterData();
 
@@ -2609,6 +2798,61 @@ const EditableParams& PhysX3::GetEditableParams()
 	return gParams;
 }
 
+static const char* GetPrunerName(PxPruningStructureType::Enum pruner)
+{
+	switch(pruner)
+	{
+		case PxPruningStructureType::eNONE:					return "eNONE";
+		case PxPruningStructureType::eDYNAMIC_AABB_TREE:	return "eDYNAMIC_AABB_TREE";
+		case PxPruningStructureType::eSTATIC_AABB_TREE:		return "eSTATIC_AABB_TREE";
+	};
+	return "Unknown";
+}
+
+static inline_ const char* GetBoolString(bool b)
+{
+	return b ? "true" : "false";
+}
+
+void PhysX3::GetSettings(PintSettingsCallback& callback)
+{
+	callback.ReportSetting("NbThreads",					_F("%d", gParams.mNbThreads));
+	callback.ReportSetting("StaticPruner",				GetPrunerName(gParams.mStaticPruner));
+	callback.ReportSetting("DynamicPruner",				GetPrunerName(gParams.mDynamicPruner));
+	callback.ReportSetting("SQDynamicRebuildRateHint",	_F("%d", gParams.mSQDynamicRebuildRateHint));
+#ifdef PHYSX_SUPPORT_SCRATCH_BUFFER
+	callback.ReportSetting("ScratchSize",				_F("%d", gParams.mScratchSize));
+#endif
+#ifdef PHYSX_SUPPORT_PX_BROADPHASE_TYPE
+	callback.ReportSetting("BroadPhase",				gParams.mBroadPhaseType==PxBroadPhaseType::eSAP ? "eSAP" : "eMBP");
+	callback.ReportSetting("MBPSubdivLevel",			_F("%d", gParams.mMBPSubdivLevel));
+	callback.ReportSetting("MBPRange",					_F("%f", gParams.mMBPRange));
+#endif
+#ifdef PHYSX_SUPPORT_PX_MESH_MIDPHASE
+	callback.ReportSetting("MidPhase",					gParams.mMidPhaseType==PxMeshMidPhase::eBVH33 ? "eBVH33" : "eBVH34");
+#endif
+	callback.ReportSetting("PCM",						GetBoolString(gParams.mPCM));
+#ifdef PHYSX_SUPPORT_SSE_FLAG
+	callback.ReportSetting("EnableSSE",					GetBoolString(gParams.mEnableSSE));
+#endif
+	callback.ReportSetting("UseCCD",					GetBoolString(gParams.mUseCCD));
+	callback.ReportSetting("ShareMeshData",				GetBoolString(gParams.mShareMeshData));
+	callback.ReportSetting("ShareShapes",				GetBoolString(gParams.mShareShapes));
+	callback.ReportSetting("EnableSleeping",			GetBoolString(gParams.mEnableSleeping));
+	callback.ReportSetting("EnableActiveTransforms",	GetBoolString(gParams.mEnableActiveTransforms));
+	callback.ReportSetting("EnableContactCache",		GetBoolString(gParams.mEnableContactCache));
+	callback.ReportSetting("SolverIterationCountPos",	_F("%d", gParams.mSolverIterationCountPos));
+	callback.ReportSetting("SolverIterationCountVel",	_F("%d", gParams.mSolverIterationCountVel));
+	callback.ReportSetting("ContactOffset",				_F("%f", gParams.mContactOffset));
+	callback.ReportSetting("RestOffset",				_F("%f", gParams.mRestOffset));
+#ifdef PHYSX_SUPPORT_SUBSTEPS
+	callback.ReportSetting("NbSubsteps",				_F("%d", gParams.mNbSubsteps));
+#endif
+#ifdef PHYSX_SUPPORT_GPU
+	callback.ReportSetting("UseGPU",					GetBoolString(gParams.mUseGPU));
+#endif
+}
+
 #define MAX_NB_DEBUG_VIZ_PARAMS	32
 
 	struct PhysXUI : public Allocateable
@@ -2878,6 +3122,25 @@ void PhysX3::GetOptionsFromGUI(const char* test_name)
 
 }
 
+static udword gNbThreadsSetting = INVALID_ID;	// Plugin's own setting, while overridden
+
+void PhysX3::GetOptionsFromDesc(const PINT_WORLD_CREATE& desc)
+{
+	// Without UI nothing else restores the setting after an override
+	if(gNbThreadsSetting!=INVALID_ID)
+	{
+		if(!gPhysXUI || !gPhysXUI->mComboBox_NbThreads)
+			gParams.mNbThreads = gNbThreadsSetting;
+		gNbThreadsSetting = INVALID_ID;
+	}
+
+	if(desc.GetNbWorkerThreads()!=INVALID_ID)
+	{
+		gNbThreadsSetting = gParams.mNbThreads;
+		gParams.mNbThreads = desc.GetNbWorkerThreads();
+	}
+}
+
 #ifdef PHYSX_SUPPORT_PX_BROADPHASE_TYPE
 	// ### would be easier to use a callback here
 	class BPComboBox : public IceComboBox
@@ -13,6 +13,33 @@
 
 	#define SAFE_RELEASE(x)	if(x) { x->release(); x = null; }
 
+#ifdef PHYSX_SUPPORT_CONCURRENT_SQ
+	// Scene queries can be called from several threads at the same time (PINT_CONCURRENT_SQ). Only defined for versions
+	// documented as such, i.e. 3.3.0 and later. Older versions get a single SQ thread.
+	#define PHYSX_CONCURRENT_SQ_FLAG	PINT_CONCURRENT_SQ
+#else
+	#define PHYSX_CONCURRENT_SQ_FLAG	0
+#endif
+
+#ifdef PHYSX_SUPPORT_SCENE_RW_LOCK
+	// Queries can run while the scene is simulated (PINT_SQ_DURING_UPDATE). Batches of queries take the scene's read
+	// lock, UpdateCommon() takes the write lock around simulate() & fetchResults() only, not while the simulation runs.
+	#define PHYSX_SQ_READ_LOCK		PxSceneReadLock SQReadLock(*mScene)
+	#define PHYSX_SCENE_WRITE_LOCK	PxSceneWriteLock SceneWriteLock(*mScene)
+	#define PHYSX_SQ_FLAGS			(PHYSX_CONCURRENT_SQ_FLAG|PINT_SQ_DURING_UPDATE)
+#else
+	#define PHYSX_SQ_READ_LOCK
+	#define PHYSX_SCENE_WRITE_LOCK
+	#define PHYSX_SQ_FLAGS			PHYSX_CONCURRENT_SQ_FLAG
+#endif
+
+#ifdef PHYSX_SUPPORT_ASYNC_UPDATE
+	// The plugin implements BeginUpdate() & EndUpdate() with BeginUpdateCommon() & EndUpdateCommon()
+	#define PHYSX_UPDATE_FLAGS		PINT_ASYNC_UPDATE
+#else
+	#define PHYSX_UPDATE_FLAGS		0
+#endif
+
 	inline_ Point	ToPoint(const PxVec3& p)	{ return Point(p.x, p.y, p.z);				}
 	inline_ Quat	ToQuat(const PxQuat& q)		{ return Quat(q.w, q.x, q.y, q.z);			}
 	inline_ PxVec3	ToPxVec3(const Point& p)	{ return PxVec3(p.x, p.y, p.z);				}
@@ -75,6 +102,7 @@
 				udword	mNbAllocs;
 				udword	mCurrentMemory;
 				bool	mLog;
+				PintAllocTracker	mTracker;
 	};
 
 	class MemoryOutputStream : public PxOutputStream
@@ -265,15 +293,20 @@
 											SharedPhysX(const EditableParams& params);
 		virtual								~SharedPhysX();
 
+		virtual	udword						GetFlags()			const	{ return PINT_DEFAULT|PHYSX_SQ_FLAGS|PHYSX_UPDATE_FLAGS;	}
 		virtual	void						SetGravity(const Point& gravity);
 
 		virtual	void						SetDisabledGroups(udword nb_groups, const PintDisabledGroups* groups);
 		virtual	PintObjectHandle			CreateObject(const PINT_OBJECT_CREATE& desc);
+		virtual	udword						CreateObjects(udword nb, const PINT_OBJECT_CREATE* descs, PintObjectHandle* handles);
 		virtual	bool						ReleaseObject(PintObjectHandle handle);
+		virtual	udword						ReleaseObjects(udword nb, const PintObjectHandle* handles);
 		virtual	PintJointHandle				CreateJoint(const PINT_JOINT_CREATE& desc);
 
 		virtual	PR							GetWorldTransform(PintObjectHandle handle);
 		virtual	void						SetWorldTransform(PintObjectHandle handle, const PR& pose);
+		virtual	void						GetWorldTransforms(udword nb, const PintObjectHandle* handles, PR* poses);
+		virtual	udword						GetActiveTransforms(udword max_nb, PintObjectHandle* handles, Point* positions, Quat* rotations);
 
 //		virtual	void						ApplyActionAtPoint(PintObjectHandle handle, PintActionType action_type, const Point& action, const Point& pos);
 		virtual	void						AddWorldImpulseAtWorldPos(PintObjectHandle handle, const Point& world_impulse, const Point& world_pos);
@@ -349,12 +382,16 @@
 				void						InitCommon();
 				void						CloseCommon();
 				void						UpdateCommon(float dt);
+				// Split version of UpdateCommon(), for PINT_ASYNC_UPDATE
+				void						BeginUpdateCommon(float dt);
+				void						EndUpdateCommon();
 
 		inline_	PxQueryFilterData			GetSQFilterData()
 											{
 												return PxQueryFilterData(PxFilterData(!mParams.mSQFilterOutAllShapes, mParams.mSQFilterOutAllShapes, 0, 0), PxQueryFlag::eDYNAMIC | PxQueryFlag::eSTATIC);
 											}
 		private:
+				void						FetchResultsCommon();
 #ifdef PHYSX_SUPPORT_SCRATCH_BUFFER
 				void*						mScratchPad;
 				udword						mScratchPadSize;
@@ -396,6 +433,11 @@
 					Point					mLocalTorque;
 				};
 				std::vector<LocalTorque>	mLocalTorques;
+#if defined(PHYSX_SUPPORT_ADD_ACTORS) || defined(PHYSX_SUPPORT_REMOVE_ACTORS)
+				// Scratch arrays for batched creation & removal
+				std::vector<PxRigidActor*>	mBatchRigidActors;
+				std::vector<PxActor*>		mBatchActors;
+#endif
 	};
 
 	template<class T>
@@ -430,6 +472,9 @@
 		IceWindow*				InitSharedGUI(IceWidget* parent, PintGUIHelper& helper, UICallback& callback, udword nb_debug_viz_params, bool* debug_viz_params, const char** debug_viz_names);
 		const EditableParams&	GetEditableParams();
 		void					GetOptionsFromGUI(const char* test_name);
+		// Applies the system overrides (e.g. number of threads) on top of the UI options
+		void					GetOptionsFromDesc(const PINT_WORLD_CREATE& desc);
+		void					GetSettings(PintSettingsCallback& callback);
 		void					CloseSharedGUI();
 	}
 
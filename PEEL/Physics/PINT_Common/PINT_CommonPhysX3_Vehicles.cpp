@@ -1551,7 +1551,10 @@ void SharedPhysX_Vehicles::CloseVehicles()
 void SharedPhysX_Vehicles::UpdateVehicles()
 {
 	if(gVehicleTest)
+	{
+		PHYSX_SCENE_WRITE_LOCK;
 		gVehicleTest->Update(1.0f/60.0f);
+	}
 }
 
 VehicleTest::VehicleTest() : mScene(null), mVehicle(null)
@@ -31,6 +31,11 @@ udword GetIceAllocatorUsedMemory()
 	return gIceAllocator->mUsedMemory;
 }
 
+const PintAllocStats* GetIceAllocatorStats()
+{
+	return gIceAllocator ? &gIceAllocator->mTracker.GetStats() : null;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 AllocSwitch::AllocSwitch()
@@ -19,5 +19,6 @@
 	void	InitIceAllocator(const char* name);
 	void	ReleaseIceAllocator();
 	udword	GetIceAllocatorUsedMemory();
+	const PintAllocStats*	GetIceAllocatorStats();
 
 #endif
\ No newline at end of file
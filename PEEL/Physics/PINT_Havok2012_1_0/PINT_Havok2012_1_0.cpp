@@ -475,7 +475,7 @@ void Havok::Init(const PINT_WORLD_CREATE& desc)
 
 
 //	mThreadMemory = new hkThreadMemory(memoryManager);
-	mMemoryRouter = hkMemoryInitUtil::initDefault( hkMallocAllocator::m_defaultMallocAllocator, hkMemorySystem::FrameInfo(mParams.mSolverBufferSize * 1024));
+	mMemoryRouter = hkMemoryInitUtil::initDefault( Havok_InitTrackingAllocator(hkMallocAllocator::m_defaultMallocAllocator, desc.GetAllocTracking()), hkMemorySystem::FrameInfo(mParams.mSolverBufferSize * 1024));
 
 //	hkBaseSystem::init(memoryManager, mThreadMemory, errorReport);
 	hkBaseSystem::init( mMemoryRouter, errorReport );
@@ -790,6 +790,11 @@ udword Havok::Update(float timestep)
 	return Havok_GetAllocatedMemory();
 }
 
+const PintAllocStats* Havok::GetAllocStats()
+{
+	return Havok_GetAllocStats();
+}
+
 Point Havok::GetMainColor()
 {
 	return HAVOK_MAIN_COLOR;
@@ -1174,6 +1179,7 @@ void Havok_Init(const PINT_WORLD_CREATE& desc)
 {
 //	gHavok_GetOptionsFromGUI();
 	Havok_::GetOptionsFromGUI();
+	Havok_::GetOptionsFromDesc(desc);
 
 	ASSERT(!gHavok);
 	gHavok = ICE_NEW(Havok)(Havok_::GetEditableParams());
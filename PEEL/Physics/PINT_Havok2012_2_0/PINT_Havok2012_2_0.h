@@ -36,11 +36,13 @@
 
 		// Pint
 		virtual	const char*								GetName()				const	{ return "Havok 2012_2_0";	}
+		virtual	udword									GetFlags()				const	{ return PINT_DEFAULT|PINT_MAIN_THREAD_ONLY;	}
 		virtual	void									GetCaps(PintCaps& caps)	const;
 		virtual	void									Init(const PINT_WORLD_CREATE& desc);
 		virtual	void									SetGravity(const Point& gravity);
 		virtual	void									Close();
 		virtual	udword									Update(float dt);
+		virtual	const PintAllocStats*							GetAllocStats();
 		virtual	Point									GetMainColor();
 
 		virtual	void									SetDisabledGroups(udword nb_groups, const PintDisabledGroups* groups);
@@ -549,9 +549,10 @@ void Havok::Init(const PINT_WORLD_CREATE& desc)
 #ifdef USE_CUSTOM_ALLOCATOR
 //	mMemoryRouter = hkMemoryInitUtil::initDefault( &gMyMemoryAllocator, hkMemorySystem::FrameInfo( 2 * 1024 * 1024 ) );
 //	mMemoryRouter = hkMemoryInitUtil::initSimple( &gMyMemoryAllocator, hkMemorySystem::FrameInfo( 2 * 1024 * 1024 ) );
-	mMemoryRouter = hkMemoryInitUtil::initHeapAllocator( &gMyMemoryAllocator, &gMyMemoryAllocator, null, hkMemorySystem::FrameInfo(mParams.mSolverBufferSize * 1024));
+	hkMemoryAllocator* Allocator = Havok_InitTrackingAllocator(&gMyMemoryAllocator, desc.GetAllocTracking());
+	mMemoryRouter = hkMemoryInitUtil::initHeapAllocator( Allocator, Allocator, null, hkMemorySystem::FrameInfo(mParams.mSolverBufferSize * 1024));
 #else
-	mMemoryRouter = hkMemoryInitUtil::initDefault( hkMallocAllocator::m_defaultMallocAllocator, hkMemorySystem::FrameInfo(mParams.mSolverBufferSize * 1024));
+	mMemoryRouter = hkMemoryInitUtil::initDefault( Havok_InitTrackingAllocator(hkMallocAllocator::m_defaultMallocAllocator, desc.GetAllocTracking()), hkMemorySystem::FrameInfo(mParams.mSolverBufferSize * 1024));
 #endif
 
 //	hkBaseSystem::init(memoryManager, mThreadMemory, errorReport);
@@ -892,6 +893,11 @@ udword Havok::Update(float timestep)
 	return Havok_GetAllocatedMemory();
 }
 
+const PintAllocStats* Havok::GetAllocStats()
+{
+	return Havok_GetAllocStats();
+}
+
 Point Havok::GetMainColor()
 {
 	return HAVOK_MAIN_COLOR;
@@ -1295,6 +1301,7 @@ void Havok_Init(const PINT_WORLD_CREATE& desc)
 {
 //	gHavok_GetOptionsFromGUI();
 	Havok_::GetOptionsFromGUI();
+	Havok_::GetOptionsFromDesc(desc);
 
 	ASSERT(!gHavok);
 	gHavok = ICE_NEW(Havok)(Havok_::GetEditableParams());
@@ -135,6 +135,7 @@ class CustomMemory : public hkMemory
 			H->mSize = size;
 			mNbAllocs++;
 			mCurrentMemory+=size;
+			mTracker.OnAlloc(size);
 			return memory + 16;
 		}
 
@@ -150,10 +151,12 @@ class CustomMemory : public hkMemory
 			_aligned_free(H);
 			mNbAllocs--;
 			mCurrentMemory-=Size;
+			mTracker.OnFree(Size);
 		}
 
 		udword	mNbAllocs;
 		udword	mCurrentMemory;
+		PintAllocTracker	mTracker;
 
 
 			/// Allocate nblocks of nbytes. This is equivalent to nblocks calls to
@@ -393,6 +396,8 @@ static CustomMemory* gMemoryManager = null;
 
 void Havok::Init(const PINT_WORLD_CREATE& desc)
 {
+	PintAllocTracking() = desc.GetAllocTracking();
+
 	// Initialize the base system including our memory system
 	hkMemory* memoryManager = null;
 	if(gUseCustomMemory)
@@ -676,6 +681,11 @@ udword Havok::Update(float timestep)
 	return 0;
 }
 
+const PintAllocStats* Havok::GetAllocStats()
+{
+	return gMemoryManager ? &gMemoryManager->mTracker.GetStats() : null;
+}
+
 static void DrawLeafShape(PintRender& renderer, const hkpShape* shape, const PR& pose)
 {
 	ASSERT(shape->getUserData());
@@ -21,6 +21,7 @@ support SSE4.
 #include "stdafx.h"
 #include "PINT_Newton3_13_Stable.h"
 #include "..\PINT_Common\PINT_Common.h"
+#include "..\PINT_Common\PINT_CommonAllocator.h"
 
 #include "Newton.h"
 #include "CustomJoint.h"
@@ -65,7 +66,8 @@ public:
 		AllocatiorSyngleton& me = GetAllocator();
 		me.gNbAllocs++;
 		me.gCurrentMemory+=sizeInBytes;
-		return malloc (sizeInBytes);
+		me.mTracker.OnAlloc(sizeInBytes);
+		return Common_Alloc (sizeInBytes);
 	}
 
 	// this is the callback for freeing Newton Memory
@@ -74,11 +76,13 @@ public:
 		AllocatiorSyngleton& me = GetAllocator();
 		me.gNbAllocs--;
 		me.gCurrentMemory-=sizeInBytes;
-		free (ptr);
+		me.mTracker.OnFree(sizeInBytes);
+		Common_Free (ptr);
 	}
 
 	udword	gNbAllocs;
 	udword	gCurrentMemory;
+	PintAllocTracker	mTracker;
 };
 
 class CriticalSection
@@ -421,8 +425,9 @@ void NewtonPint::GetCaps(PintCaps& caps) const
 
 void NewtonPint::Init(const PINT_WORLD_CREATE& desc)
 {
+	Common_SetAllocator(desc.GetAllocatorType(), desc.GetAllocTracking());
 	// make sure the global allocation singletons is initialized
-	AllocatiorSyngleton::GetAllocator();
+	AllocatiorSyngleton::GetAllocator().mTracker.ResetPeak();
 
 	for(udword i=0; i<32; i++) {
 		mGroupMasks[i] = 0xffffffff;
@@ -484,6 +489,7 @@ void NewtonPint::Close()
 
 	// finally destroy the newton world 
 	NewtonDestroy (mWorld);
+	Common_ReleaseAllocator();
 }
 
 const char*	NewtonPint::GetName() const	
@@ -527,6 +533,11 @@ udword NewtonPint::Update(dFloat dt)
 	return AllocatiorSyngleton::GetAllocator().gCurrentMemory;
 }
 
+const PintAllocStats* NewtonPint::GetAllocStats()
+{
+	return &AllocatiorSyngleton::GetAllocator().mTracker.GetStats();
+}
+
 Point NewtonPint::GetMainColor()
 {
 	return NEWTON_MAIN_COLOR;
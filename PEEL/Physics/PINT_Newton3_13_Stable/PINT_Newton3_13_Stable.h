@@ -52,6 +52,7 @@ public:
 	virtual	void									SetGravity(const Point& gravity);
 	virtual	void									Close();
 	virtual	udword									Update(float dt);
+	virtual	const PintAllocStats*							GetAllocStats();
 	virtual	Point									GetMainColor();
 	virtual	void									Render(PintRender& renderer);
 
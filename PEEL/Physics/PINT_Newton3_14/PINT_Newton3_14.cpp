@@ -24,6 +24,7 @@ I adapted athe code as I could but there might be errors.
 #include "stdafx.h"
 #include "PINT_Newton3_14.h"
 #include "..\PINT_Common\PINT_Common.h"
+#include "..\PINT_Common\PINT_CommonAllocator.h"
 
 #include "Newton.h"
 #include "CustomJoint.h"
@@ -68,7 +69,8 @@ public:
 		AllocatiorSyngleton& me = GetAllocator();
 		me.gNbAllocs++;
 		me.gCurrentMemory+=sizeInBytes;
-		return malloc (sizeInBytes);
+		me.mTracker.OnAlloc(sizeInBytes);
+		return Common_Alloc (sizeInBytes);
 	}
 
 	// this is the callback for freeing Newton Memory
@@ -77,11 +79,13 @@ public:
 		AllocatiorSyngleton& me = GetAllocator();
 		me.gNbAllocs--;
 		me.gCurrentMemory-=sizeInBytes;
-		free (ptr);
+		me.mTracker.OnFree(sizeInBytes);
+		Common_Free (ptr);
 	}
 
 	udword	gNbAllocs;
 	udword	gCurrentMemory;
+	PintAllocTracker	mTracker;
 };
 
 class CriticalSection
@@ -424,8 +428,9 @@ void NewtonPint::GetCaps(PintCaps& caps) const
 
 void NewtonPint::Init(const PINT_WORLD_CREATE& desc)
 {
+	Common_SetAllocator(desc.GetAllocatorType(), desc.GetAllocTracking());
 	// make sure the global allocation singletons is initialized
-	AllocatiorSyngleton::GetAllocator();
+	AllocatiorSyngleton::GetAllocator().mTracker.ResetPeak();
 
 	for(udword i=0; i<32; i++) {
 		mGroupMasks[i] = 0xffffffff;
@@ -490,6 +495,7 @@ void NewtonPint::Close()
 
 	// finally destroy the newton world 
 	NewtonDestroy (mWorld);
+	Common_ReleaseAllocator();
 }
 
 const char*	NewtonPint::GetName() const	
@@ -533,6 +539,11 @@ udword NewtonPint::Update(dFloat dt)
 	return AllocatiorSyngleton::GetAllocator().gCurrentMemory;
 }
 
+const PintAllocStats* NewtonPint::GetAllocStats()
+{
+	return &AllocatiorSyngleton::GetAllocator().mTracker.GetStats();
+}
+
 Point NewtonPint::GetMainColor()
 {
 	return NEWTON_MAIN_COLOR;
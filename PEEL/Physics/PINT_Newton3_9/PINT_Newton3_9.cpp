@@ -25,6 +25,7 @@ support SSE4.
 #include "stdafx.h"
 #include "PINT_Newton3_9.h"
 #include "..\PINT_Common\PINT_Common.h"
+#include "..\PINT_Common\PINT_CommonAllocator.h"
 
 #include "Newton.h"
 #include "CustomJoint.h"
@@ -110,7 +111,8 @@ class AllocatiorSyngleton
 		AllocatiorSyngleton& me = GetAllocator();
 		me.gNbAllocs++;
 		me.gCurrentMemory+=sizeInBytes;
-		return malloc (sizeInBytes);
+		me.mTracker.OnAlloc(sizeInBytes);
+		return Common_Alloc (sizeInBytes);
 	}
 
 	// this is the callback for freeing Newton Memory
@@ -119,11 +121,13 @@ class AllocatiorSyngleton
 		AllocatiorSyngleton& me = GetAllocator();
 		me.gNbAllocs--;
 		me.gCurrentMemory-=sizeInBytes;
-		free (ptr);
+		me.mTracker.OnFree(sizeInBytes);
+		Common_Free (ptr);
 	}
 
 	udword	gNbAllocs;
 	udword	gCurrentMemory;
+	PintAllocTracker	mTracker;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -203,8 +207,9 @@ void NewtonPint::GetCaps(PintCaps& caps) const
 
 void NewtonPint::Init(const PINT_WORLD_CREATE& desc)
 {
+	Common_SetAllocator(desc.GetAllocatorType(), desc.GetAllocTracking());
 	// make sure the global allocation singletons is initialized
-	AllocatiorSyngleton::GetAllocator();
+	AllocatiorSyngleton::GetAllocator().mTracker.ResetPeak();
 
 	for(udword i=0; i<32; i++) {
 		mGroupMasks[i] = 0xffffffff;
@@ -244,6 +249,7 @@ void NewtonPint::Close()
 
 	// finally destroy the newton world 
 	NewtonDestroy (mWorld);
+	Common_ReleaseAllocator();
 }
 
 const char*	NewtonPint::GetName() const	
@@ -273,6 +279,11 @@ udword NewtonPint::Update(float dt)
 	return AllocatiorSyngleton::GetAllocator().gCurrentMemory;
 }
 
+const PintAllocStats* NewtonPint::GetAllocStats()
+{
+	return &AllocatiorSyngleton::GetAllocator().mTracker.GetStats();
+}
+
 Point NewtonPint::GetMainColor()
 {
 	return NEWTON_MAIN_COLOR;
@@ -28,6 +28,7 @@ typedef std::vector< NewtonBody * > NewtonBodyVector;
 		virtual	void				SetGravity(const Point& gravity);
 		virtual	void				Close();
 		virtual	udword				Update(float dt);
+		virtual	const PintAllocStats*		GetAllocStats();
 		virtual	Point				GetMainColor();
 		virtual	void				Render(PintRender& renderer);
 
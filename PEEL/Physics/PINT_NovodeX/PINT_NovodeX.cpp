@@ -13,6 +13,7 @@
 #include "stdafx.h"
 #include "PINT_Novodex.h"
 #include "..\PINT_Common\PINT_Common.h"
+#include "..\PINT_Common\PINT_CommonAllocator.h"
 
 #include "NxPhysics.h"
 
@@ -133,23 +134,25 @@ static inline_	NxShape*			GetShapeFromHandle(PintObjectHandle handle)
 	virtual void* mallocDEBUG(size_t size, const char* fileName, int line)
 	{
 //		return ::malloc(size);
-		char* memory = (char*)_aligned_malloc(size+16, 16);
+		char* memory = (char*)Common_Alloc(size+16);
 		Header* H = (Header*)memory;
 		H->mMagic = 0x12345678;
 		H->mSize = size;
 		mNbAllocs++;
 		mCurrentMemory+=size;
+		mTracker.OnAlloc(size);
 		return memory + 16;
 	}
 	virtual void* malloc(size_t size)
 	{
 //		return ::malloc(size);
-		char* memory = (char*)_aligned_malloc(size+16, 16);
+		char* memory = (char*)Common_Alloc(size+16);
 		Header* H = (Header*)memory;
 		H->mMagic = 0x12345678;
 		H->mSize = size;
 		mNbAllocs++;
 		mCurrentMemory+=size;
+		mTracker.OnAlloc(size);
 		return memory + 16;
 	}
 	virtual void* realloc(void* memory, size_t size)
@@ -170,12 +173,14 @@ static inline_	NxShape*			GetShapeFromHandle(PintObjectHandle handle)
 		Header* H = (Header*)(bptr - 16);
 		ASSERT(H->mMagic==0x12345678);
 		const udword Size = H->mSize;
-		_aligned_free(H);
+		Common_Free(H);
 		mNbAllocs--;
 		mCurrentMemory-=Size;
+		mTracker.OnFree(Size);
 	}
 		udword	mNbAllocs;
 		udword	mCurrentMemory;
+		PintAllocTracker	mTracker;
 	};
 
 	class MyNxUserOutputStream : public NxUserOutputStream
@@ -242,6 +247,7 @@ void NovodeX::Init(const PINT_WORLD_CREATE& desc)
 	}
 
 	ASSERT(!gMyNxUserAllocator);
+	Common_SetAllocator(desc.GetAllocatorType(), desc.GetAllocTracking());
 	gMyNxUserAllocator = new MyNxUserAllocator;
 	ASSERT(gMyNxUserAllocator);
 
@@ -323,6 +329,7 @@ void NovodeX::Close()
 	DELETESINGLE(mTouchedShapes);
 
 	DELETESINGLE(gMyNxUserAllocator);
+	Common_ReleaseAllocator();
 }
 
 void NovodeX::UpdateFromUI()
@@ -346,6 +353,11 @@ udword NovodeX::Update(float dt)
 	return gMyNxUserAllocator->mCurrentMemory;
 }
 
+const PintAllocStats* NovodeX::GetAllocStats()
+{
+	return gMyNxUserAllocator ? &gMyNxUserAllocator->mTracker.GetStats() : null;
+}
+
 Point NovodeX::GetMainColor()
 {
 	return Point(0.0f, 1.0f, 0.0f);
@@ -91,6 +91,9 @@ bool AABBCollider::Collide(AABBCache& cache, const CollisionAABB& box, const Mod
 	// Checkings
 	if(!Setup(&model))	return false;
 
+	// Wide trees aren't supported by this collider [PEEL]
+	if(model.IsWide())	return false;
+
 	// Init collision query
 	if(InitQuery(cache, box))	return true;
 
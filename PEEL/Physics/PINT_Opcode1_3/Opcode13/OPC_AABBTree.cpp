@@ -128,6 +128,159 @@ udword AABBTreeNode::Split(udword axis, AABBTreeBuilder* builder)
 	return NbPos;
 }
 
+// Number of bins per axis for SPLIT_SAH
+#define SAH_NB_BINS		16
+
+// Half the surface area of a box, enough to compare costs
+static inline_ float HalfSurfaceArea(const Point& min, const Point& max)
+{
+	const Point d = max - min;
+	return d.x*d.y + d.y*d.z + d.z*d.x;
+}
+
+// Boxes are accessed through a stride, so that they can be stored in the nodes of a tree
+static inline_ const AABB& GetSAHBox(const AABB* boxes, udword stride, udword index)
+{
+	return *(const AABB*)(((const ubyte*)boxes) + index * stride);
+}
+
+namespace
+{
+	struct SAHBin
+	{
+		inline_	void	Reset()		{ mMin.Set(MAX_FLOAT, MAX_FLOAT, MAX_FLOAT); mMax.Set(MIN_FLOAT, MIN_FLOAT, MIN_FLOAT); mCount = 0;	}
+
+		Point	mMin;
+		Point	mMax;
+		udword	mCount;
+	};
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Partitions a set of boxes using a binned surface area heuristic [PEEL].
+ *	Box centers are binned along each axis, and the split between two bins minimizing the SAH cost of both sides
+ *	(area * number of boxes, summed for both) is selected. The list of indices is reorganized so that boxes on the
+ *	lower side of the split come first.
+ *	\param		boxes		[in] box array, indexed by the entries of the list
+ *	\param		stride		[in] size in bytes between two consecutive boxes
+ *	\param		indices		[in/out] list of box indices
+ *	\param		nb			[in] number of indices
+ *	\return		the number of boxes on the lower side, or 0 if no valid split was found
+ *	\warning	this function reorganizes the list of indices
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+udword Opcode::BinnedSAHSplit(const AABB* boxes, udword stride, udword* indices, udword nb)
+{
+	// Bounds of the box centers. Bins are laid out within them.
+	Point CMin(MAX_FLOAT, MAX_FLOAT, MAX_FLOAT);
+	Point CMax(MIN_FLOAT, MIN_FLOAT, MIN_FLOAT);
+	for(udword i=0;i<nb;i++)
+	{
+		Point Center;
+		GetSAHBox(boxes, stride, indices[i]).GetCenter(Center);
+		CMin.Min(Center);
+		CMax.Max(Center);
+	}
+
+	float BestCost = MAX_FLOAT;
+	udword BestAxis = INVALID_ID;
+	udword BestBin = 0;
+	float BestScale = 0.0f;
+	for(udword Axis=0;Axis<3;Axis++)
+	{
+		const float Extent = CMax[Axis] - CMin[Axis];
+		if(Extent<=0.0f)	continue;	// All centers in the same plane, can't split along this axis
+		const float Scale = float(SAH_NB_BINS)/Extent;
+		if(Scale>=MAX_FLOAT)	continue;	// Degenerate extent
+
+		SAHBin Bins[SAH_NB_BINS];
+		for(udword b=0;b<SAH_NB_BINS;b++)
+			Bins[b].Reset();
+
+		for(udword i=0;i<nb;i++)
+		{
+			const AABB& Box = GetSAHBox(boxes, stride, indices[i]);
+			udword b = udword((Box.GetCenter(Axis) - CMin[Axis])*Scale);
+			if(b>=SAH_NB_BINS)	b = SAH_NB_BINS-1;
+
+			Point Min, Max;
+			Box.GetMin(Min);
+			Box.GetMax(Max);
+			Bins[b].mMin.Min(Min);
+			Bins[b].mMax.Max(Max);
+			Bins[b].mCount++;
+		}
+
+		// Sweep from the right: cost of bins [b, SAH_NB_BINS) for each split position b
+		float RightCosts[SAH_NB_BINS];
+		udword RightCounts[SAH_NB_BINS];
+		{
+			SAHBin Acc;	Acc.Reset();
+			for(udword b=SAH_NB_BINS-1;b>0;b--)
+			{
+				Acc.mMin.Min(Bins[b].mMin);
+				Acc.mMax.Max(Bins[b].mMax);
+				Acc.mCount += Bins[b].mCount;
+				RightCounts[b] = Acc.mCount;
+				RightCosts[b] = Acc.mCount ? HalfSurfaceArea(Acc.mMin, Acc.mMax)*float(Acc.mCount) : 0.0f;
+			}
+		}
+
+		// Sweep from the left & evaluate each split position
+		SAHBin Acc;	Acc.Reset();
+		for(udword b=1;b<SAH_NB_BINS;b++)
+		{
+			Acc.mMin.Min(Bins[b-1].mMin);
+			Acc.mMax.Max(Bins[b-1].mMax);
+			Acc.mCount += Bins[b-1].mCount;
+			if(!Acc.mCount || !RightCounts[b])	continue;
+
+			const float Cost = HalfSurfaceArea(Acc.mMin, Acc.mMax)*float(Acc.mCount) + RightCosts[b];
+			if(Cost<BestCost)
+			{
+				BestCost	= Cost;
+				BestAxis	= Axis;
+				BestBin		= b;
+				BestScale	= Scale;
+			}
+		}
+	}
+
+	if(BestAxis==INVALID_ID)	return 0;
+
+	// Reorganize the list of indices in this order: lower bins - upper bins. Bin indices are recomputed exactly as above.
+	udword NbPos = 0;
+	for(udword i=0;i<nb;i++)
+	{
+		udword b = udword((GetSAHBox(boxes, stride, indices[i]).GetCenter(BestAxis) - CMin[BestAxis])*BestScale);
+		if(b>=SAH_NB_BINS)	b = SAH_NB_BINS-1;
+		if(b<BestBin)
+		{
+			// Swap entries
+			udword Tmp = indices[i];
+			indices[i] = indices[NbPos];
+			indices[NbPos] = Tmp;
+			NbPos++;
+		}
+	}
+	return NbPos;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Splits the node using a binned surface area heuristic [PEEL]. See BinnedSAHSplit().
+ *	\param		builder		[in] the tree builder, with cached primitive boxes
+ *	\return		the number of primitives assigned to the first child, or 0 if no valid split was found
+ *	\warning	this method reorganizes the internal list of primitives
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+udword AABBTreeNode::SplitSAH(AABBTreeBuilder* builder)
+{
+	ASSERT(builder->mPrimitiveBoxes);
+	return BinnedSAHSplit(builder->mPrimitiveBoxes, sizeof(AABB), mNodePrimitives, mNbPrimitives);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Subdivides the node.
@@ -162,7 +315,15 @@ bool AABBTreeNode::Subdivide(AABBTreeBuilder* builder)
 
 	bool ValidSplit = true;	// Optimism...
 	udword NbPos;
-	if(builder->mSettings.mRules & SPLIT_LARGEST_AXIS)
+	if(builder->mSettings.mRules & SPLIT_SAH)
+	{
+		// Find the cheapest split among all axes [PEEL]
+		NbPos = SplitSAH(builder);
+
+		// Check split validity
+		if(!NbPos || NbPos==mNbPrimitives)	ValidSplit = false;
+	}
+	else if(builder->mSettings.mRules & SPLIT_LARGEST_AXIS)
 	{
 		// Find the largest axis to split along
 		Point Extents;	mBV.GetExtents(Extents);	// Box extents
@@ -435,9 +596,25 @@ bool AABBTree::Build(AABBTreeBuilder* builder)
 		builder->mNodeBase = mPool;	// ### ugly !
 	}
 
+	// SAH splits need the primitive boxes at each level, so compute them once [PEEL]
+	AABB* PrimitiveBoxes = null;
+	if(builder->mSettings.mRules & SPLIT_SAH)
+	{
+		PrimitiveBoxes = ICE_NEW(AABB)[builder->mNbPrimitives];
+		CHECKALLOC(PrimitiveBoxes);
+		for(udword i=0;i<builder->mNbPrimitives;i++)	builder->GetPrimitiveBox(i, PrimitiveBoxes[i]);
+		builder->mPrimitiveBoxes = PrimitiveBoxes;
+	}
+
 	// Build the hierarchy
 	_BuildHierarchy(builder);
 
+	if(PrimitiveBoxes)
+	{
+		builder->mPrimitiveBoxes = null;
+		DELETEARRAY(PrimitiveBoxes);
+	}
+
 	// Get back total number of nodes
 	mTotalNbNodes	= builder->GetCount();
 
@@ -493,6 +670,41 @@ udword AABBTree::Walk(WalkingCallback callback, void* user_data) const
 	return MaxDepth;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Computes the expected cost of traversing the tree with a random ray, according to the surface area heuristic [PEEL].
+ *	Each node is reached with a probability proportional to its surface area (relative to the root's). Internal nodes cost
+ *	one box test, leaves one test per primitive. Lower is better, the value is only meaningful to compare trees built
+ *	over the same primitives.
+ *	\return		expected number of box & primitive tests per ray
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+float AABBTree::ComputeSAHCost() const
+{
+	struct Local
+	{
+		static float _Cost(const AABBTreeNode* current_node)
+		{
+			Point Min, Max;
+			current_node->GetAABB()->GetMin(Min);
+			current_node->GetAABB()->GetMax(Max);
+			const float Area = HalfSurfaceArea(Min, Max);
+
+			if(current_node->IsLeaf())	return Area * float(current_node->GetNbPrimitives());
+
+			return Area + _Cost(current_node->GetPos()) + _Cost(current_node->GetNeg());
+		}
+	};
+
+	Point Min, Max;
+	GetAABB()->GetMin(Min);
+	GetAABB()->GetMax(Max);
+	const float RootArea = HalfSurfaceArea(Min, Max);
+	if(RootArea<=0.0f)	return 0.0f;
+
+	return Local::_Cost(this) / RootArea;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Refits the tree in a top-down way.
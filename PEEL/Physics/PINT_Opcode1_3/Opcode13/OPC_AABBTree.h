@@ -88,6 +88,7 @@
 				udword				mNbPrimitives;		//!< Number of primitives for this node
 		// Internal methods
 				udword				Split(udword axis, AABBTreeBuilder* builder);
+				udword				SplitSAH(AABBTreeBuilder* builder);
 				bool				Subdivide(AABBTreeBuilder* builder);
 				void				_BuildHierarchy(AABBTreeBuilder* builder);
 				void				_Refit(AABBTreeBuilder* builder);
@@ -124,6 +125,7 @@
 				udword				ComputeDepth()		const;
 				udword				GetUsedBytes()		const;
 				udword				Walk(WalkingCallback callback, void* user_data) const;
+				float				ComputeSAHCost()	const;
 
 				bool				Refit(AABBTreeBuilder* builder);
 				bool				Refit2(AABBTreeBuilder* builder);
@@ -134,4 +136,7 @@
 				udword				mTotalNbNodes;		//!< Number of nodes in the tree.
 	};
 
+	// Binned SAH partition, shared by SPLIT_SAH and the dynamic AABB tree [PEEL]
+	FUNCTION OPCODE_API udword BinnedSAHSplit(const AABB* boxes, udword stride, udword* indices, udword nb);
+
 #endif // __OPC_AABBTREE_H__
@@ -45,6 +45,7 @@ OPCODECREATE::OPCODECREATE()
 	mSettings.mLimit	= 1;	// Mandatory for complete trees
 	mNoLeaf				= true;
 	mQuantized			= true;
+	mWide				= false;
 #ifdef __MESHMERIZER_H__
 	mCollisionHull		= false;
 #endif // __MESHMERIZER_H__
@@ -57,7 +58,7 @@ OPCODECREATE::OPCODECREATE()
  *	Constructor.
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-BaseModel::BaseModel() : mIMesh(null), mModelCode(0), mSource(null), mTree(null)
+BaseModel::BaseModel() : mIMesh(null), mModelCode(0), mSource(null), mTree(null), mSAHCost(0.0f)
 {
 }
 
@@ -87,10 +88,11 @@ void BaseModel::ReleaseBase()
  *	Creates an optimized tree according to user-settings, and setups mModelCode.
  *	\param		no_leaf		[in] true for "no leaf" tree
  *	\param		quantized	[in] true for quantized tree
+ *	\param		wide		[in] true for wide tree (overrides the other flags) [PEEL]
  *	\return		true if success
  */
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-bool BaseModel::CreateTree(bool no_leaf, bool quantized)
+bool BaseModel::CreateTree(bool no_leaf, bool quantized, bool wide)
 {
 	DELETESINGLE(mTree);
 
@@ -101,8 +103,15 @@ bool BaseModel::CreateTree(bool no_leaf, bool quantized)
 	if(quantized)	mModelCode |= OPC_QUANTIZED;
 	else			mModelCode &= ~OPC_QUANTIZED;
 
+	if(wide)		mModelCode |= OPC_WIDE;
+	else			mModelCode &= ~OPC_WIDE;
+
 	// Create the correct class
-	if(mModelCode & OPC_NO_LEAF)
+	if(mModelCode & OPC_WIDE)
+	{
+		mTree = ICE_NEW(AABBWideTree);
+	}
+	else if(mModelCode & OPC_NO_LEAF)
 	{
 		if(mModelCode & OPC_QUANTIZED)	mTree = ICE_NEW(AABBQuantizedNoLeafTree);
 		else							mTree = ICE_NEW(AABBNoLeafTree);
@@ -30,6 +30,7 @@
 		BuildSettings			mSettings;		//!< Builder's settings
 		bool					mNoLeaf;		//!< true => discard leaf nodes (else use a normal tree)
 		bool					mQuantized;		//!< true => quantize the tree (else use a normal tree)
+		bool					mWide;			//!< true => use a wide SIMD tree, mNoLeaf & mQuantized are ignored [PEEL]
 #ifdef __MESHMERIZER_H__
 		bool					mCollisionHull;	//!< true => use convex hull + GJK
 #endif // __MESHMERIZER_H__
@@ -44,7 +45,8 @@
 	{
 		OPC_QUANTIZED	= (1<<0),	//!< Compressed/uncompressed tree
 		OPC_NO_LEAF		= (1<<1),	//!< Leaf/NoLeaf tree
-		OPC_SINGLE_NODE	= (1<<2)	//!< Special case for 1-node models
+		OPC_SINGLE_NODE	= (1<<2),	//!< Special case for 1-node models
+		OPC_WIDE		= (1<<3)	//!< Wide SIMD tree (AABBWideTree) [PEEL]
 	};
 
 	class OPCODE_API BaseModel : public Allocateable
@@ -138,6 +140,14 @@
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		inline_			BOOL				HasSingleNode()		const	{ return mModelCode & OPC_SINGLE_NODE;	}
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Checks whether the tree is a wide tree or not. Wide trees are only supported by the ray, sphere, OBB & LSS colliders. [PEEL]
+		 *	\return		true if the tree is an AABBWideTree
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		inline_			BOOL				IsWide()			const	{ return mModelCode & OPC_WIDE;			}
+
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		/**
 		 *	Gets the model's code.
@@ -146,6 +156,14 @@
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		inline_			udword				GetModelCode()		const	{ return mModelCode;					}
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Gets the expected traversal cost of the source tree, computed at build time (see AABBTree::ComputeSAHCost). [PEEL]
+		 *	\return		SAH cost, or 0 for single-node models
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		inline_			float				GetSAHCost()		const	{ return mSAHCost;						}
+
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 		/**
 		 *	Gets the mesh interface.
@@ -167,9 +185,10 @@
 						udword				mModelCode;		//!< Model code = combination of ModelFlag(s)
 						AABBTree*			mSource;		//!< Original source tree
 						AABBOptimizedTree*	mTree;			//!< Optimized tree owned by the model
+						float				mSAHCost;		//!< Stats: expected traversal cost of the source tree [PEEL]
 		// Internal methods
 						void				ReleaseBase();
-						bool				CreateTree(bool no_leaf, bool quantized);
+						bool				CreateTree(bool no_leaf, bool quantized, bool wide=false);
 	};
 
 #endif //__OPC_BASEMODEL_H__
\ No newline at end of file
@@ -0,0 +1,643 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ *	OPCODE - Optimized Collision Detection
+ *	Copyright (C) 2001 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/Opcode.htm
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains code for a dynamic AABB tree [PEEL].
+ *	\file		OPC_DynamicAABBTree.cpp
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains an incrementally maintained AABB tree, for scenes whose objects are added, removed or moved at runtime.
+ *
+ *	Contrary to the AABBTree, whose nodes are allocated once for a fixed set of primitives, the dynamic tree is a binary tree
+ *	of individually allocated nodes with parent links:
+ *
+ *	- insertions walk down the tree and pick the sibling giving the smallest surface area increase.
+ *	- removals replace the leaf's parent with its sibling.
+ *	- after each insertion or removal, the ancestors are refit and rebalanced with AVL rotations, so the height stays O(log N).
+ *	- moving objects are stored with fat boxes. As long as the new box is inside the fat box, nothing happens. Otherwise the
+ *	object is reinserted with a new fat box.
+ *	- since incremental insertions degrade the tree's quality over time, the tree can be rebuilt top-down when its SAH cost
+ *	has grown too much.
+ *
+ *	Leaves are never moved in memory, so leaf indices are used as object handles, even across full rebuilds.
+ *
+ *	\class		DynamicAABBTree
+ *	\version	1.0
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Precompiled Header
+#include "Stdafx.h"
+#include "Opcode.h"
+
+using namespace Opcode;
+
+// Half the surface area of a box, good enough for SAH computations
+static inline_ float HalfSurfaceArea(const AABB& box)
+{
+	const Point d = box.GetMax() - box.GetMin();
+	return d.x*d.y + d.y*d.z + d.z*d.x;
+}
+
+static inline_ void MergeBoxes(AABB& dest, const AABB& box0, const AABB& box1)
+{
+	AABB Merged = box0;
+	Merged.Add(box1);
+	dest = Merged;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Constructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+DynamicAABBTree::DynamicAABBTree() :
+	mNodes			(null),
+	mMaxNbNodes		(0),
+	mFreeNodes		(INVALID_ID),
+	mRoot			(INVALID_ID),
+	mNbObjects		(0),
+	mNbChanges		(0),
+	mNbRebuilds		(0),
+	mRebuildCost	(0.0f),
+	mFatCoeff		(0.2f),
+	mRules			(SPLIT_GEOM_CENTER)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Destructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+DynamicAABBTree::~DynamicAABBTree()
+{
+	Release();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Releases the tree.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void DynamicAABBTree::Release()
+{
+	DELETEARRAY(mNodes);
+	mMaxNbNodes		= 0;
+	mFreeNodes		= INVALID_ID;
+	mRoot			= INVALID_ID;
+	mNbObjects		= 0;
+	mNbChanges		= 0;
+	mNbRebuilds		= 0;
+	mRebuildCost	= 0.0f;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Allocates a node from the pool. The pool is resized when needed, so node pointers must not be kept across this call.
+ *	\return		node index
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+udword DynamicAABBTree::AllocateNode()
+{
+	if(mFreeNodes==INVALID_ID)
+	{
+		const udword NewMaxNbNodes = mMaxNbNodes ? mMaxNbNodes*2 : 32;
+		DynamicAABBTreeNode* NewNodes = ICE_NEW(DynamicAABBTreeNode)[NewMaxNbNodes];
+		if(mNodes)
+			CopyMemory(NewNodes, mNodes, mMaxNbNodes*sizeof(DynamicAABBTreeNode));
+		DELETEARRAY(mNodes);
+		mNodes = NewNodes;
+
+		// Link new nodes in the free list
+		for(udword i=mMaxNbNodes;i<NewMaxNbNodes;i++)
+		{
+			mNodes[i].mParent	= i+1<NewMaxNbNodes ? i+1 : INVALID_ID;
+			mNodes[i].mHeight	= -1;
+		}
+		mFreeNodes = mMaxNbNodes;
+		mMaxNbNodes = NewMaxNbNodes;
+	}
+
+	const udword Index = mFreeNodes;
+	DynamicAABBTreeNode& Node = mNodes[Index];
+	mFreeNodes = Node.mParent;
+
+	Node.mParent		= INVALID_ID;
+	Node.mChildren[0]	= INVALID_ID;
+	Node.mChildren[1]	= INVALID_ID;
+	Node.mUserData		= INVALID_ID;
+	Node.mHeight		= 0;
+	return Index;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Returns a node to the pool.
+ *	\param		index	[in] node index
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void DynamicAABBTree::FreeNode(udword index)
+{
+	mNodes[index].mParent	= mFreeNodes;
+	mNodes[index].mHeight	= -1;
+	mFreeNodes = index;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Adds an object to the tree.
+ *	\param		box			[in] object's world box
+ *	\param		user_data	[in] user-defined data
+ *	\return		object handle
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+udword DynamicAABBTree::AddObject(const AABB& box, udword user_data)
+{
+	const udword Leaf = AllocateNode();
+	mNodes[Leaf].mBox		= box;
+	mNodes[Leaf].mUserData	= user_data;
+
+	InsertLeaf(Leaf);
+	mNbObjects++;
+	mNbChanges++;
+	return Leaf;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Removes an object from the tree.
+ *	\param		handle		[in] object handle
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void DynamicAABBTree::RemoveObject(udword handle)
+{
+	ASSERT(handle<mMaxNbNodes && mNodes[handle].IsLeaf() && mNodes[handle].mHeight==0);
+
+	RemoveLeaf(handle);
+	FreeNode(handle);
+	mNbObjects--;
+	mNbChanges++;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Updates an object's box.
+ *	\param		handle		[in] object handle
+ *	\param		box			[in] object's new world box
+ *	\return		true if the object has been reinserted
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool DynamicAABBTree::UpdateObject(udword handle, const AABB& box)
+{
+	ASSERT(handle<mMaxNbNodes && mNodes[handle].IsLeaf() && mNodes[handle].mHeight==0);
+
+	// Early exit if the object is still inside its fat box
+	if(box.IsInside(mNodes[handle].mBox))
+		return false;
+
+	RemoveLeaf(handle);
+
+	const float Margin = box.GetSize() * mFatCoeff;
+	const Point Fat(Margin, Margin, Margin);
+	mNodes[handle].mBox.SetMinMax(box.GetMin() - Fat, box.GetMax() + Fat);
+
+	InsertLeaf(handle);
+	mNbChanges++;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Inserts a leaf in the tree. The sibling is found by walking down the tree, following the child whose box grows the
+ *	least, until creating a new parent here is cheaper than descending further.
+ *	\param		leaf	[in] leaf index
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void DynamicAABBTree::InsertLeaf(udword leaf)
+{
+	if(mRoot==INVALID_ID)
+	{
+		mRoot = leaf;
+		mNodes[leaf].mParent = INVALID_ID;
+		return;
+	}
+
+	const AABB LeafBox = mNodes[leaf].mBox;
+
+	// Find best sibling
+	udword Index = mRoot;
+	while(!mNodes[Index].IsLeaf())
+	{
+		const DynamicAABBTreeNode& Node = mNodes[Index];
+
+		AABB Combined;
+		MergeBoxes(Combined, Node.mBox, LeafBox);
+		const float Area = HalfSurfaceArea(Node.mBox);
+		const float CombinedArea = HalfSurfaceArea(Combined);
+
+		// Cost of creating a new parent for this node and the new leaf
+		const float Cost = 2.0f * CombinedArea;
+		// Minimum cost of pushing the leaf further down the tree
+		const float InheritanceCost = 2.0f * (CombinedArea - Area);
+
+		float ChildCosts[2];
+		for(udword j=0;j<2;j++)
+		{
+			const DynamicAABBTreeNode& Child = mNodes[Node.mChildren[j]];
+			AABB Box;
+			MergeBoxes(Box, Child.mBox, LeafBox);
+			ChildCosts[j] = HalfSurfaceArea(Box) + InheritanceCost;
+			if(!Child.IsLeaf())
+				ChildCosts[j] -= HalfSurfaceArea(Child.mBox);
+		}
+
+		if(Cost<ChildCosts[0] && Cost<ChildCosts[1])
+			break;
+
+		Index = ChildCosts[0]<ChildCosts[1] ? Node.mChildren[0] : Node.mChildren[1];
+	}
+
+	// Create a new parent. This can resize the pool so we only use indices from here.
+	const udword Sibling = Index;
+	const udword OldParent = mNodes[Sibling].mParent;
+	const udword NewParent = AllocateNode();
+
+	MergeBoxes(mNodes[NewParent].mBox, mNodes[Sibling].mBox, LeafBox);
+	mNodes[NewParent].mParent		= OldParent;
+	mNodes[NewParent].mChildren[0]	= Sibling;
+	mNodes[NewParent].mChildren[1]	= leaf;
+	mNodes[NewParent].mHeight		= mNodes[Sibling].mHeight + 1;
+	mNodes[Sibling].mParent			= NewParent;
+	mNodes[leaf].mParent			= NewParent;
+
+	if(OldParent!=INVALID_ID)
+	{
+		if(mNodes[OldParent].mChildren[0]==Sibling)	mNodes[OldParent].mChildren[0] = NewParent;
+		else										mNodes[OldParent].mChildren[1] = NewParent;
+	}
+	else mRoot = NewParent;
+
+	// Refit & rebalance ancestors
+	FixUpwards(OldParent);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Removes a leaf from the tree. The leaf's parent is freed and replaced with the leaf's sibling.
+ *	\param		leaf	[in] leaf index
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void DynamicAABBTree::RemoveLeaf(udword leaf)
+{
+	if(leaf==mRoot)
+	{
+		mRoot = INVALID_ID;
+		return;
+	}
+
+	const udword Parent = mNodes[leaf].mParent;
+	const udword GrandParent = mNodes[Parent].mParent;
+	const udword Sibling = mNodes[Parent].mChildren[0]==leaf ? mNodes[Parent].mChildren[1] : mNodes[Parent].mChildren[0];
+
+	FreeNode(Parent);
+	mNodes[Sibling].mParent = GrandParent;
+	mNodes[leaf].mParent = INVALID_ID;
+
+	if(GrandParent!=INVALID_ID)
+	{
+		if(mNodes[GrandParent].mChildren[0]==Parent)	mNodes[GrandParent].mChildren[0] = Sibling;
+		else											mNodes[GrandParent].mChildren[1] = Sibling;
+
+		FixUpwards(GrandParent);
+	}
+	else mRoot = Sibling;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Refits & rebalances a node and all its ancestors.
+ *	\param		index	[in] node index
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void DynamicAABBTree::FixUpwards(udword index)
+{
+	while(index!=INVALID_ID)
+	{
+		index = Balance(index);
+
+		DynamicAABBTreeNode& Node = mNodes[index];
+		const DynamicAABBTreeNode& Child0 = mNodes[Node.mChildren[0]];
+		const DynamicAABBTreeNode& Child1 = mNodes[Node.mChildren[1]];
+
+		Node.mHeight = 1 + MAX(Child0.mHeight, Child1.mHeight);
+		MergeBoxes(Node.mBox, Child0.mBox, Child1.mBox);
+
+		index = Node.mParent;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Performs a left or right rotation if a node is imbalanced, i.e. if its children's heights differ by more than 1.
+ *	\param		index	[in] node index
+ *	\return		index of the node now at the same position in the tree
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+udword DynamicAABBTree::Balance(udword index)
+{
+	DynamicAABBTreeNode* A = mNodes + index;
+	if(A->IsLeaf() || A->mHeight<2)
+		return index;
+
+	const udword IndexB = A->mChildren[0];
+	const udword IndexC = A->mChildren[1];
+	DynamicAABBTreeNode* B = mNodes + IndexB;
+	DynamicAABBTreeNode* C = mNodes + IndexC;
+
+	const sdword Delta = C->mHeight - B->mHeight;
+
+	// Rotate C up
+	if(Delta>1)
+	{
+		const udword IndexF = C->mChildren[0];
+		const udword IndexG = C->mChildren[1];
+		DynamicAABBTreeNode* F = mNodes + IndexF;
+		DynamicAABBTreeNode* G = mNodes + IndexG;
+
+		// Swap A and C
+		C->mChildren[0] = index;
+		C->mParent = A->mParent;
+		A->mParent = IndexC;
+
+		if(C->mParent!=INVALID_ID)
+		{
+			if(mNodes[C->mParent].mChildren[0]==index)	mNodes[C->mParent].mChildren[0] = IndexC;
+			else										mNodes[C->mParent].mChildren[1] = IndexC;
+		}
+		else mRoot = IndexC;
+
+		// Keep the highest of F and G under C
+		if(F->mHeight>G->mHeight)
+		{
+			C->mChildren[1] = IndexF;
+			A->mChildren[1] = IndexG;
+			G->mParent = index;
+			MergeBoxes(A->mBox, B->mBox, G->mBox);
+			MergeBoxes(C->mBox, A->mBox, F->mBox);
+			A->mHeight = 1 + MAX(B->mHeight, G->mHeight);
+			C->mHeight = 1 + MAX(A->mHeight, F->mHeight);
+		}
+		else
+		{
+			C->mChildren[1] = IndexG;
+			A->mChildren[1] = IndexF;
+			F->mParent = index;
+			MergeBoxes(A->mBox, B->mBox, F->mBox);
+			MergeBoxes(C->mBox, A->mBox, G->mBox);
+			A->mHeight = 1 + MAX(B->mHeight, F->mHeight);
+			C->mHeight = 1 + MAX(A->mHeight, G->mHeight);
+		}
+		return IndexC;
+	}
+
+	// Rotate B up
+	if(Delta<-1)
+	{
+		const udword IndexD = B->mChildren[0];
+		const udword IndexE = B->mChildren[1];
+		DynamicAABBTreeNode* D = mNodes + IndexD;
+		DynamicAABBTreeNode* E = mNodes + IndexE;
+
+		// Swap A and B
+		B->mChildren[0] = index;
+		B->mParent = A->mParent;
+		A->mParent = IndexB;
+
+		if(B->mParent!=INVALID_ID)
+		{
+			if(mNodes[B->mParent].mChildren[0]==index)	mNodes[B->mParent].mChildren[0] = IndexB;
+			else										mNodes[B->mParent].mChildren[1] = IndexB;
+		}
+		else mRoot = IndexB;
+
+		// Keep the highest of D and E under B
+		if(D->mHeight>E->mHeight)
+		{
+			B->mChildren[1] = IndexD;
+			A->mChildren[0] = IndexE;
+			E->mParent = index;
+			MergeBoxes(A->mBox, C->mBox, E->mBox);
+			MergeBoxes(B->mBox, A->mBox, D->mBox);
+			A->mHeight = 1 + MAX(C->mHeight, E->mHeight);
+			B->mHeight = 1 + MAX(A->mHeight, D->mHeight);
+		}
+		else
+		{
+			B->mChildren[1] = IndexE;
+			A->mChildren[0] = IndexD;
+			D->mParent = index;
+			MergeBoxes(A->mBox, C->mBox, D->mBox);
+			MergeBoxes(B->mBox, A->mBox, E->mBox);
+			A->mHeight = 1 + MAX(C->mHeight, D->mHeight);
+			B->mHeight = 1 + MAX(A->mHeight, E->mHeight);
+		}
+		return IndexB;
+	}
+	return index;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Rebuilds the tree from scratch. Internal nodes are discarded, leaves are kept in place so that handles remain valid.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void DynamicAABBTree::Rebuild()
+{
+	if(mRoot==INVALID_ID)
+		return;
+
+	udword* Leaves = ICE_NEW(udword)[mNbObjects];
+	CHECKALLOC(Leaves);
+
+	udword NbLeaves = 0;
+	for(udword i=0;i<mMaxNbNodes;i++)
+	{
+		if(mNodes[i].mHeight<0)
+			continue;	// Free node
+
+		if(mNodes[i].IsLeaf())
+			Leaves[NbLeaves++] = i;
+		else
+			FreeNode(i);
+	}
+	ASSERT(NbLeaves==mNbObjects);
+
+	mRoot = BuildTopDown(Leaves, NbLeaves);
+	mNodes[mRoot].mParent = INVALID_ID;
+
+	DELETEARRAY(Leaves);
+
+	mRebuildCost = ComputeSAHCost();
+	mNbChanges = 0;
+	mNbRebuilds++;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Builds a subtree over a set of leaves. With SPLIT_SAH in the build rules, leaves are split with the same binned SAH as
+ *	AABBTree. Otherwise they are split at the center of their centers on the longest axis.
+ *	\param		leaves	[in/out] leaf indices, reordered
+ *	\param		nb		[in] number of leaves
+ *	\return		subtree root
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+udword DynamicAABBTree::BuildTopDown(udword* leaves, udword nb)
+{
+	if(nb==1)
+		return leaves[0];
+
+	udword NbPos = 0;
+	if(mRules & SPLIT_SAH)
+	{
+		NbPos = BinnedSAHSplit(&mNodes[0].mBox, sizeof(DynamicAABBTreeNode), leaves, nb);
+	}
+	else
+	{
+		// Bounds of box centers
+		Point CMin(MAX_FLOAT, MAX_FLOAT, MAX_FLOAT);
+		Point CMax(MIN_FLOAT, MIN_FLOAT, MIN_FLOAT);
+		for(udword i=0;i<nb;i++)
+		{
+			Point Center;	mNodes[leaves[i]].mBox.GetCenter(Center);
+			CMin.Min(Center);
+			CMax.Max(Center);
+		}
+
+		// Split along the longest axis
+		const Point Extents = CMax - CMin;
+		const udword Axis = Extents.LargestAxis();
+		const float SplitValue = (CMin[Axis] + CMax[Axis])*0.5f;
+
+		for(udword i=0;i<nb;i++)
+		{
+			if(mNodes[leaves[i]].mBox.GetCenter(Axis)>SplitValue)
+			{
+				const udword Tmp = leaves[i];
+				leaves[i] = leaves[NbPos];
+				leaves[NbPos++] = Tmp;
+			}
+		}
+	}
+	// Degenerate split, e.g. all centers are the same
+	if(!NbPos || NbPos==nb)
+		NbPos = nb/2;
+
+	const udword Child0 = BuildTopDown(leaves, NbPos);
+	const udword Child1 = BuildTopDown(leaves+NbPos, nb-NbPos);
+
+	// Internal nodes have been freed before the build so this doesn't resize the pool
+	const udword Index = AllocateNode();
+	DynamicAABBTreeNode& Node = mNodes[Index];
+	Node.mChildren[0]	= Child0;
+	Node.mChildren[1]	= Child1;
+	Node.mHeight		= 1 + MAX(mNodes[Child0].mHeight, mNodes[Child1].mHeight);
+	MergeBoxes(Node.mBox, mNodes[Child0].mBox, mNodes[Child1].mBox);
+	mNodes[Child0].mParent = Index;
+	mNodes[Child1].mParent = Index;
+	return Index;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Rebuilds the tree if its quality has degraded too much since the last rebuild.
+ *	\param		max_cost_ratio	[in] max ratio between the current SAH cost & the one after the last rebuild
+ *	\return		true if the tree has been rebuilt
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool DynamicAABBTree::RebuildIfNeeded(float max_cost_ratio)
+{
+	if(mRoot==INVALID_ID)
+		return false;
+
+	// First build
+	if(!mNbRebuilds)
+	{
+		Rebuild();
+		return true;
+	}
+
+	// Only check the cost once a quarter of the objects have changed, to amortize the O(N) check
+	const udword Limit = mNbObjects/4;
+	if(mNbChanges<MAX(Limit, 1))
+		return false;
+	mNbChanges = 0;
+
+	if(ComputeSAHCost()<=mRebuildCost*max_cost_ratio)
+		return false;
+
+	Rebuild();
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Computes the SAH cost of the tree: the sum of the surface areas of all nodes, relative to the root's.
+ *	\return		SAH cost
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+float DynamicAABBTree::ComputeSAHCost() const
+{
+	if(mRoot==INVALID_ID)
+		return 0.0f;
+
+	const float RootArea = HalfSurfaceArea(mNodes[mRoot].mBox);
+	if(RootArea<=0.0f)
+		return 0.0f;
+
+	float TotalArea = 0.0f;
+	for(udword i=0;i<mMaxNbNodes;i++)
+	{
+		if(mNodes[i].mHeight>=0)
+			TotalArea += HalfSurfaceArea(mNodes[i].mBox);
+	}
+	return TotalArea / RootArea;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Collects the user data of the objects whose boxes overlap a given box.
+ *	\param		box			[in] query box
+ *	\param		user_data	[out] user data of touched objects
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void DynamicAABBTree::Overlap(const AABB& box, Container& user_data) const
+{
+	if(mRoot!=INVALID_ID)
+		_Overlap(mRoot, box, user_data);
+}
+
+void DynamicAABBTree::_Overlap(udword index, const AABB& box, Container& user_data) const
+{
+	const DynamicAABBTreeNode& Node = mNodes[index];
+	if(!Node.mBox.Intersect(box))
+		return;
+
+	if(Node.IsLeaf())
+		user_data.Add(Node.mUserData);
+	else
+	{
+		_Overlap(Node.mChildren[0], box, user_data);
+		_Overlap(Node.mChildren[1], box, user_data);
+	}
+}
@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ *	OPCODE - Optimized Collision Detection
+ *	Copyright (C) 2001 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/Opcode.htm
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains code for a dynamic AABB tree [PEEL].
+ *	\file		OPC_DynamicAABBTree.h
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Include Guard
+#ifndef __OPC_DYNAMICAABBTREE_H__
+#define __OPC_DYNAMICAABBTREE_H__
+
+	//! A node of the dynamic AABB tree. Nodes are referenced by index, and leaf indices are the object handles.
+	struct OPCODE_API DynamicAABBTreeNode
+	{
+		inline_	BOOL		IsLeaf()	const	{ return mChildren[0]==INVALID_ID;	}
+
+				AABB		mBox;			//!< Node box. For leaves, this is the (possibly fat) object box.
+				udword		mParent;		//!< Parent node, or next free node for free nodes
+				udword		mChildren[2];	//!< Children nodes, or INVALID_ID for leaves
+				udword		mUserData;		//!< Leaves: user-defined data, e.g. the object index
+				sdword		mHeight;		//!< Leaves: 0, free nodes: -1
+	};
+
+	class OPCODE_API DynamicAABBTree : public Allocateable
+	{
+		public:
+		// Constructor / Destructor
+													DynamicAABBTree();
+													~DynamicAABBTree();
+
+						void						Release();
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Adds an object to the tree. The box is inserted as-is, it only gets fattened when the object moves.
+		 *	\param		box			[in] object's world box
+		 *	\param		user_data	[in] user-defined data
+		 *	\return		object handle
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+						udword						AddObject(const AABB& box, udword user_data);
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Removes an object from the tree.
+		 *	\param		handle		[in] object handle
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+						void						RemoveObject(udword handle);
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Updates an object's box. Nothing happens while the new box is inside the object's fat box. Otherwise the object is
+		 *	reinserted with a new fat box, enlarged by the fat coeff to absorb the next moves.
+		 *	\param		handle		[in] object handle
+		 *	\param		box			[in] object's new world box
+		 *	\return		true if the object has been reinserted
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+						bool						UpdateObject(udword handle, const AABB& box);
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Rebuilds the tree from scratch, top-down. Object handles remain valid.
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+						void						Rebuild();
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Rebuilds the tree if its quality has degraded too much since the last rebuild. The quality check is O(N) so it is
+		 *	only performed once enough objects have been added, removed or reinserted.
+		 *	\param		max_cost_ratio	[in] max ratio between the current SAH cost & the one after the last rebuild
+		 *	\return		true if the tree has been rebuilt
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+						bool						RebuildIfNeeded(float max_cost_ratio=1.5f);
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Collects the user data of the objects whose boxes overlap a given box.
+		 *	\param		box			[in] query box
+		 *	\param		user_data	[out] user data of touched objects
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+						void						Overlap(const AABB& box, Container& user_data)	const;
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Computes the SAH cost of the tree, i.e. the surface areas of all nodes relative to the root's.
+		 *	\return		SAH cost
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+						float						ComputeSAHCost()	const;
+
+		// Settings
+		inline_			void						SetFatCoeff(float coeff)				{ mFatCoeff = coeff;					}
+		inline_			float						GetFatCoeff()					const	{ return mFatCoeff;						}
+		inline_			void						SetBuildRules(udword rules)				{ mRules = rules;						}	//!< SPLIT_SAH or not, used by rebuilds
+		inline_			udword						GetBuildRules()					const	{ return mRules;						}
+		// Objects
+		inline_			void						SetUserData(udword handle, udword user_data)	{ mNodes[handle].mUserData = user_data;	}
+		inline_			udword						GetUserData(udword handle)		const	{ return mNodes[handle].mUserData;		}
+		inline_			const AABB&					GetBox(udword handle)			const	{ return mNodes[handle].mBox;			}
+		// Data access
+		inline_			udword						GetRoot()						const	{ return mRoot;							}
+		inline_			const DynamicAABBTreeNode*	GetNodes()						const	{ return mNodes;						}
+		// Stats
+		inline_			udword						GetNbObjects()					const	{ return mNbObjects;					}
+		inline_			udword						GetNbRebuilds()					const	{ return mNbRebuilds;					}
+		inline_			udword						GetHeight()						const	{ return mRoot!=INVALID_ID ? mNodes[mRoot].mHeight : 0;	}
+		inline_			udword						GetUsedBytes()					const	{ return mMaxNbNodes*sizeof(DynamicAABBTreeNode);		}
+
+		private:
+						DynamicAABBTreeNode*		mNodes;				//!< Node pool
+						udword						mMaxNbNodes;		//!< Size of the node pool
+						udword						mFreeNodes;			//!< Head of the free list
+						udword						mRoot;				//!< Root node, or INVALID_ID
+						udword						mNbObjects;			//!< Number of leaves
+						udword						mNbChanges;			//!< Number of insertions, removals & reinsertions since last quality check
+						udword						mNbRebuilds;		//!< Number of full rebuilds
+						float						mRebuildCost;		//!< SAH cost after last rebuild
+						float						mFatCoeff;			//!< Fat boxes are enlarged by mFatCoeff times the box size
+						udword						mRules;				//!< Build rules for rebuilds, see SplittingRules
+		// Internal methods
+						udword						AllocateNode();
+						void						FreeNode(udword index);
+						void						InsertLeaf(udword leaf);
+						void						RemoveLeaf(udword leaf);
+						void						FixUpwards(udword index);
+						udword						Balance(udword index);
+						udword						BuildTopDown(udword* leaves, udword nb);
+						void						_Overlap(udword index, const AABB& box, Container& user_data)	const;
+	};
+
+#endif // __OPC_DYNAMICAABBTREE_H__
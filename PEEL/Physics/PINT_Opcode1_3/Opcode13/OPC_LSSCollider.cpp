@@ -96,7 +96,21 @@ bool LSSCollider::Collide(LSSCache& cache, const LSS& lss, const Model& model, c
 	// Init collision query
 	if(InitQuery(cache, lss, worldl, worldm))	return true;
 
-	if(!model.HasLeafNodes())
+	if(model.IsWide())
+	{
+		const AABBWideTree* Tree = (const AABBWideTree*)model.GetTree();
+
+		// LSS bounds in model space, for the SIMD tests
+		const float Radius = sqrtf(mRadius2);
+		mWideMin = mSeg.mP0;	mWideMin.Min(mSeg.mP1);
+		mWideMax = mSeg.mP0;	mWideMax.Max(mSeg.mP1);
+		mWideMin -= Point(Radius, Radius, Radius);
+		mWideMax += Point(Radius, Radius, Radius);
+
+		// Perform collision query. Primitive tests are skipped or not at the leaves.
+		_Collide(Tree->GetNodes());
+	}
+	else if(!model.HasLeafNodes())
 	{
 		if(model.IsQuantized())
 		{
@@ -551,6 +565,49 @@ void LSSCollider::_CollideNoPrimitiveTest(const AABBQuantizedNoLeafNode* node)
 	else					_CollideNoPrimitiveTest(node->GetNeg());
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive collision query for wide AABB trees [PEEL]. The LSS bounds are tested against all children boxes at once with
+ *	SIMD, then the exact LSS-AABB test is performed for each touched child.
+ *	\param		node	[in] current collision node
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void LSSCollider::_Collide(const AABBWideNode* node)
+{
+	// Empty slots have inverted boxes, which are always rejected
+	__m128 Separated = _mm_or_ps(_mm_cmpgt_ps(_mm_load1_ps(&mWideMin.x), _mm_loadu_ps(node->mMaxX)), _mm_cmplt_ps(_mm_load1_ps(&mWideMax.x), _mm_loadu_ps(node->mMinX)));
+	Separated = _mm_or_ps(Separated, _mm_or_ps(_mm_cmpgt_ps(_mm_load1_ps(&mWideMin.y), _mm_loadu_ps(node->mMaxY)), _mm_cmplt_ps(_mm_load1_ps(&mWideMax.y), _mm_loadu_ps(node->mMinY))));
+	Separated = _mm_or_ps(Separated, _mm_or_ps(_mm_cmpgt_ps(_mm_load1_ps(&mWideMin.z), _mm_loadu_ps(node->mMaxZ)), _mm_cmplt_ps(_mm_load1_ps(&mWideMax.z), _mm_loadu_ps(node->mMinZ))));
+	const udword Mask = ~_mm_movemask_ps(Separated) & ((1<<OPC_WIDE_NB_CHILDREN)-1);
+	if(!Mask)	return;
+
+	for(udword i=0;i<OPC_WIDE_NB_CHILDREN;i++)
+	{
+		if(!(Mask & (1<<i)))	continue;
+
+		// Perform LSS-AABB overlap test
+		Point Center, Extents;
+		node->GetCenter(i, Center);
+		node->GetExtents(i, Extents);
+		if(!LSSAABBOverlap(Center, Extents))	continue;
+
+		if(node->IsLeaf(i))
+		{
+			if(SkipPrimitiveTests())
+			{
+				SET_CONTACT(node->GetPrimitive(i), OPC_CONTACT)
+			}
+			else
+			{
+				LSS_PRIM(node->GetPrimitive(i), OPC_CONTACT)
+			}
+		}
+		else _Collide(node->GetChild(i));
+
+		if(ContactFound()) return;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Recursive collision query for vanilla AABB trees.
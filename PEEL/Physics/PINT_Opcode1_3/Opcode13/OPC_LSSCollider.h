@@ -66,11 +66,14 @@
 		// LSS in model space
 							Segment			mSeg;			//!< Segment
 							float			mRadius2;		//!< LSS radius squared
+							Point			mWideMin;		//!< LSS bounds in model space, for wide trees [PEEL]
+							Point			mWideMax;		//!< LSS bounds in model space, for wide trees [PEEL]
 		// Internal methods
 							void			_Collide(const AABBCollisionNode* node);
 							void			_Collide(const AABBNoLeafNode* node);
 							void			_Collide(const AABBQuantizedNode* node);
 							void			_Collide(const AABBQuantizedNoLeafNode* node);
+							void			_Collide(const AABBWideNode* node);
 							void			_Collide(const AABBTreeNode* node);
 							void			_CollideNoPrimitiveTest(const AABBCollisionNode* node);
 							void			_CollideNoPrimitiveTest(const AABBNoLeafNode* node);
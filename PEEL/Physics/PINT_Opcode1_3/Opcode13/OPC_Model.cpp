@@ -151,6 +151,7 @@ bool Model::Build(const OPCODECREATE& create)
 	// We continue nonetheless.... 
 
 	Release();	// Make sure previous tree has been discarded [Opcode 1.3, thanks Adam]
+	mSAHCost = 0.0f;
 
 	// 1-1) Setup mesh interface automatically [Opcode 1.3]
 	SetMeshInterface(create.mIMesh);
@@ -178,9 +179,10 @@ bool Model::Build(const OPCODECREATE& create)
 		TB.mNbPrimitives	= NbTris;
 		if(!mSource->Build(&TB))	return false;
 	}
+	mSAHCost = mSource->ComputeSAHCost();
 
 	// 3) Create an optimized tree according to user-settings
-	if(!CreateTree(create.mNoLeaf, create.mQuantized))	return false;
+	if(!CreateTree(create.mNoLeaf, create.mQuantized, create.mWide))	return false;
 
 	// 3-2) Create optimized tree
 	if(!mTree->Build(mSource))	return false;
@@ -110,7 +110,14 @@ bool OBBCollider::Collide(OBBCache& cache, const OBB& box, const Model& model, c
 	// Init collision query
 	if(InitQuery(cache, box, worldb, worldm))	return true;
 
-	if(!model.HasLeafNodes())
+	if(model.IsWide())
+	{
+		const AABBWideTree* Tree = (const AABBWideTree*)model.GetTree();
+
+		// Perform collision query. Primitive tests are skipped or not at the leaves.
+		_Collide(Tree->GetNodes());
+	}
+	else if(!model.HasLeafNodes())
 	{
 		if(model.IsQuantized())
 		{
@@ -619,6 +626,120 @@ void OBBCollider::_CollideNoPrimitiveTest(const AABBQuantizedNoLeafNode* node)
 	else					_CollideNoPrimitiveTest(node->GetNeg());
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive collision query for wide AABB trees [PEEL]. The OBB's bounds (class I axes) are tested against all children
+ *	boxes at once with SIMD, then the full OBB-AABB test is performed for each touched child.
+ *	\param		node	[in] current collision node
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void OBBCollider::_Collide(const AABBWideNode* node)
+{
+	// OBB bounds in model space. Empty slots have inverted boxes, which are always rejected.
+	const __m128 BoxMinX = _mm_set1_ps(mTBoxToModel.x - mBBx1);
+	const __m128 BoxMinY = _mm_set1_ps(mTBoxToModel.y - mBBy1);
+	const __m128 BoxMinZ = _mm_set1_ps(mTBoxToModel.z - mBBz1);
+	const __m128 BoxMaxX = _mm_set1_ps(mTBoxToModel.x + mBBx1);
+	const __m128 BoxMaxY = _mm_set1_ps(mTBoxToModel.y + mBBy1);
+	const __m128 BoxMaxZ = _mm_set1_ps(mTBoxToModel.z + mBBz1);
+
+	__m128 Separated = _mm_or_ps(_mm_cmpgt_ps(BoxMinX, _mm_loadu_ps(node->mMaxX)), _mm_cmplt_ps(BoxMaxX, _mm_loadu_ps(node->mMinX)));
+	Separated = _mm_or_ps(Separated, _mm_or_ps(_mm_cmpgt_ps(BoxMinY, _mm_loadu_ps(node->mMaxY)), _mm_cmplt_ps(BoxMaxY, _mm_loadu_ps(node->mMinY))));
+	Separated = _mm_or_ps(Separated, _mm_or_ps(_mm_cmpgt_ps(BoxMinZ, _mm_loadu_ps(node->mMaxZ)), _mm_cmplt_ps(BoxMaxZ, _mm_loadu_ps(node->mMinZ))));
+	const udword Mask = ~_mm_movemask_ps(Separated) & ((1<<OPC_WIDE_NB_CHILDREN)-1);
+	if(!Mask)	return;
+
+	for(udword i=0;i<OPC_WIDE_NB_CHILDREN;i++)
+	{
+		if(!(Mask & (1<<i)))	continue;
+
+		// Perform OBB-AABB overlap test
+		Point Center, Extents;
+		node->GetCenter(i, Center);
+		node->GetExtents(i, Extents);
+		if(!BoxBoxOverlap(Extents, Center))	continue;
+
+		if(OBBContainsBox(Center, Extents))
+		{
+			mFlags |= OPC_CONTACT;
+			if(node->IsLeaf(i))	mTouchedPrimitives->Add(node->GetPrimitive(i));
+			else				_Dump(node->GetChild(i));
+		}
+		else if(node->IsLeaf(i))
+		{
+			if(SkipPrimitiveTests())
+			{
+				SET_CONTACT(node->GetPrimitive(i), OPC_CONTACT)
+			}
+			else
+			{
+				OBB_PRIM(node->GetPrimitive(i), OPC_CONTACT)
+			}
+		}
+		else _Collide(node->GetChild(i));
+
+		if(ContactFound()) return;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Collision query for dynamic AABB trees [PEEL].
+ *	\param		cache		[in/out] a box cache
+ *	\param		box			[in] collision OBB in world space
+ *	\param		tree		[in] dynamic AABB tree
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool OBBCollider::Collide(OBBCache& cache, const OBB& box, const DynamicAABBTree* tree)
+{
+	// This is typically called for a scene tree, full of -AABBs-, not full of triangles.
+	// So we don't really have "primitives" to deal with. Hence it doesn't work with
+	// "FirstContact" + "TemporalCoherence".
+	ASSERT( !(FirstContactEnabled() && TemporalCoherenceEnabled()) );
+
+	// Checkings
+	if(!tree)	return false;
+
+	// Init collision query
+	if(InitQuery(cache, box))	return true;
+
+	// Perform collision query
+	if(tree->GetRoot()!=INVALID_ID)
+		_Collide(tree->GetNodes(), tree->GetRoot());
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive collision query for dynamic AABB trees [PEEL].
+ *	\param		nodes	[in] tree nodes
+ *	\param		index	[in] current node index
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void OBBCollider::_Collide(const DynamicAABBTreeNode* nodes, udword index)
+{
+	const DynamicAABBTreeNode& Node = nodes[index];
+
+	// Perform OBB-AABB overlap test
+	Point Center, Extents;
+	Node.mBox.GetCenter(Center);
+	Node.mBox.GetExtents(Extents);
+	if(!BoxBoxOverlap(Extents, Center))	return;
+
+	if(Node.IsLeaf())
+	{
+		mFlags |= OPC_CONTACT;
+		mTouchedPrimitives->Add(Node.mUserData);
+	}
+	else
+	{
+		_Collide(nodes, Node.mChildren[0]);
+		_Collide(nodes, Node.mChildren[1]);
+	}
+}
+
 
 
 
@@ -60,6 +60,18 @@
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 							bool			Collide(OBBCache& cache, const OBB& box, const Model& model, const Matrix4x4* worldb=null, const Matrix4x4* worldm=null);
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Collision query for dynamic AABB trees [PEEL]. The touched primitives are the user data of the touched objects.
+		 *
+		 *	\param		cache			[in/out] a box cache
+		 *	\param		box				[in] collision OBB in world space
+		 *	\param		tree			[in] dynamic AABB tree
+		 *	\return		true if success
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+							bool			Collide(OBBCache& cache, const OBB& box, const DynamicAABBTree* tree);
+
 		// Settings
 
 		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -115,6 +127,8 @@
 							void			_Collide(const AABBNoLeafNode* node);
 							void			_Collide(const AABBQuantizedNode* node);
 							void			_Collide(const AABBQuantizedNoLeafNode* node);
+							void			_Collide(const AABBWideNode* node);
+							void			_Collide(const DynamicAABBTreeNode* nodes, udword index);
 							void			_CollideNoPrimitiveTest(const AABBCollisionNode* node);
 							void			_CollideNoPrimitiveTest(const AABBNoLeafNode* node);
 							void			_CollideNoPrimitiveTest(const AABBQuantizedNode* node);
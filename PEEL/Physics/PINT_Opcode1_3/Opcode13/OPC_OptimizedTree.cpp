@@ -8,11 +8,12 @@
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
- *	Contains code for optimized trees. Implements 4 trees:
+ *	Contains code for optimized trees. Implements 5 trees:
  *	- normal
  *	- no leaf
  *	- quantized
  *	- no leaf / quantized
+ *	- wide [PEEL]
  *
  *	\file		OPC_OptimizedTree.cpp
  *	\author		Pierre Terdiman
@@ -781,3 +782,277 @@ bool AABBQuantizedNoLeafTree::Walk(GenericWalkingCallback callback, void* user_d
 	Local::_Walk(mNodes, callback, user_data);
 	return true;
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Collapses a node of the binary tree into up to OPC_WIDE_NB_CHILDREN children [PEEL]. The non-leaf child with the largest
+ *	box is opened until the wide node is full, so that the wide tree has roughly the same spatial layout as the binary one.
+ *
+ *	\relates	AABBWideNode
+ *	\fn			_CollapseNode(const AABBTreeNode* current_node, const AABBTreeNode** children)
+ *	\param		current_node	[in] non-leaf node from input tree
+ *	\param		children		[out] collapsed children
+ *	\return		number of collapsed children
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static udword _CollapseNode(const AABBTreeNode* current_node, const AABBTreeNode** children)
+{
+	ASSERT(!current_node->IsLeaf());
+	children[0] = current_node->GetPos();
+	children[1] = current_node->GetNeg();
+	udword NbChildren = 2;
+
+	while(NbChildren<OPC_WIDE_NB_CHILDREN)
+	{
+		udword Best = INVALID_ID;
+		float BestSize = -1.0f;
+		for(udword i=0;i<NbChildren;i++)
+		{
+			if(children[i]->IsLeaf())	continue;
+			Point Extents;	children[i]->GetAABB()->GetExtents(Extents);
+			const float Size = Extents.x*Extents.y + Extents.y*Extents.z + Extents.z*Extents.x;
+			if(Size>BestSize)
+			{
+				BestSize = Size;
+				Best = i;
+			}
+		}
+		if(Best==INVALID_ID)	break;	// Only leaves left
+
+		const AABBTreeNode* Opened = children[Best];
+		children[Best] = Opened->GetPos();
+		children[NbChildren++] = Opened->GetNeg();
+	}
+	return NbChildren;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Counts the wide nodes needed for a binary tree [PEEL].
+ *	\param		current_node	[in] non-leaf node from input tree
+ *	\return		number of wide nodes
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static udword _CountWideNodes(const AABBTreeNode* current_node)
+{
+	const AABBTreeNode* Children[OPC_WIDE_NB_CHILDREN];
+	const udword NbChildren = _CollapseNode(current_node, Children);
+
+	udword NbNodes = 1;
+	for(udword i=0;i<NbChildren;i++)
+	{
+		if(!Children[i]->IsLeaf())	NbNodes += _CountWideNodes(Children[i]);
+	}
+	return NbNodes;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Builds a wide tree from a standard one [PEEL].
+ *
+ *	Layout for wide trees:
+ *	Node:
+ *			- SoA min/max of up to OPC_WIDE_NB_CHILDREN children boxes
+ *			- data for each child (32-bits value)
+ *
+ *	if data's LSB = 1 =>	remaining bits are a primitive pointer
+ *	else if data != 0 =>	data is a child node pointer
+ *	else					empty slot. Its box is inverted (min > max).
+ *
+ *	\relates	AABBWideNode
+ *	\fn			_BuildWideTree(AABBWideNode* linear, const udword box_id, udword& current_id, const AABBTreeNode* current_node)
+ *	\param		linear			[in] base address of destination nodes
+ *	\param		box_id			[in] index of destination node
+ *	\param		current_id		[in] current running index
+ *	\param		current_node	[in] current non-leaf node from input tree
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void _BuildWideTree(AABBWideNode* linear, const udword box_id, udword& current_id, const AABBTreeNode* current_node)
+{
+	const AABBTreeNode* Children[OPC_WIDE_NB_CHILDREN];
+	const udword NbChildren = _CollapseNode(current_node, Children);
+
+	AABBWideNode& Node = linear[box_id];
+	for(udword i=0;i<OPC_WIDE_NB_CHILDREN;i++)
+	{
+		if(i>=NbChildren)
+		{
+			// Empty slot
+			Node.mMinX[i] = Node.mMinY[i] = Node.mMinZ[i] = MAX_FLOAT;
+			Node.mMaxX[i] = Node.mMaxY[i] = Node.mMaxZ[i] = MIN_FLOAT;
+			Node.mData[i] = 0;
+			continue;
+		}
+
+		const AABBTreeNode* Child = Children[i];
+		Point Min, Max;
+		Child->GetAABB()->GetMin(Min);
+		Child->GetAABB()->GetMax(Max);
+		Node.mMinX[i] = Min.x;	Node.mMinY[i] = Min.y;	Node.mMinZ[i] = Min.z;
+		Node.mMaxX[i] = Max.x;	Node.mMaxY[i] = Max.y;	Node.mMaxZ[i] = Max.z;
+
+		if(Child->IsLeaf())
+		{
+			// The input tree must be complete => i.e. one primitive/leaf
+			ASSERT(Child->GetNbPrimitives()==1);
+			Node.mData[i] = (Child->GetPrimitives()[0]<<1)|1;
+		}
+		else
+		{
+			const udword ChildID = current_id++;
+			Node.mData[i] = (udword)&linear[ChildID];
+			// Make sure it's not marked as leaf
+			ASSERT(!(Node.mData[i]&1));
+			_BuildWideTree(linear, ChildID, current_id, Child);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Constructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+AABBWideTree::AABBWideTree() : mNodes(null)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Destructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+AABBWideTree::~AABBWideTree()
+{
+	DELETEARRAY(mNodes);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Builds the collision tree from a generic AABB tree.
+ *	\param		tree			[in] generic AABB tree
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool AABBWideTree::Build(AABBTree* tree)
+{
+	// Checkings
+	if(!tree)	return false;
+	// Check the input tree is complete
+	udword NbTriangles	= tree->GetNbPrimitives();
+	udword NbNodes		= tree->GetNbNodes();
+	if(NbNodes!=NbTriangles*2-1)	return false;
+
+	// Get nodes. A 1-primitive tree is a single leaf, stored as a root node with a single slot.
+	NbNodes = tree->IsLeaf() ? 1 : _CountWideNodes(tree);
+	if(mNbNodes!=NbNodes)	// Same number of nodes => keep moving
+	{
+		mNbNodes = NbNodes;
+		DELETEARRAY(mNodes);
+		mNodes = ICE_NEW(AABBWideNode)[mNbNodes];
+		CHECKALLOC(mNodes);
+	}
+
+	// Build the tree
+	if(tree->IsLeaf())
+	{
+		AABBWideNode& Root = mNodes[0];
+		for(udword i=0;i<OPC_WIDE_NB_CHILDREN;i++)
+		{
+			Root.mMinX[i] = Root.mMinY[i] = Root.mMinZ[i] = MAX_FLOAT;
+			Root.mMaxX[i] = Root.mMaxY[i] = Root.mMaxZ[i] = MIN_FLOAT;
+			Root.mData[i] = 0;
+		}
+		Point Min, Max;
+		tree->GetAABB()->GetMin(Min);
+		tree->GetAABB()->GetMax(Max);
+		Root.mMinX[0] = Min.x;	Root.mMinY[0] = Min.y;	Root.mMinZ[0] = Min.z;
+		Root.mMaxX[0] = Max.x;	Root.mMaxY[0] = Max.y;	Root.mMaxZ[0] = Max.z;
+		Root.mData[0] = (tree->GetPrimitives()[0]<<1)|1;
+		return true;
+	}
+
+	udword CurID = 1;
+	_BuildWideTree(mNodes, 0, CurID, tree);
+	ASSERT(CurID==mNbNodes);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Refits the collision tree after vertices have been modified.
+ *	\param		mesh_interface	[in] mesh interface for current model
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool AABBWideTree::Refit(const MeshInterface* mesh_interface)
+{
+	// Checkings
+	if(!mesh_interface)	return false;
+
+	// Bottom-up update. Child nodes are always stored after their parent, so a reverse sweep refits them first.
+	VertexPointers VP;
+	Point Min,Max;
+	udword Index = mNbNodes;
+	while(Index--)
+	{
+		AABBWideNode& Current = mNodes[Index];
+
+		for(udword i=0;i<OPC_WIDE_NB_CHILDREN;i++)
+		{
+			if(Current.IsEmpty(i))	continue;	// Empty slots keep their inverted boxes
+
+			if(Current.IsLeaf(i))
+			{
+				mesh_interface->GetTriangle(VP, Current.GetPrimitive(i));
+				ComputeMinMax(Min, Max, VP);
+			}
+			else
+			{
+				// The child's box is the union of its own slots
+				const AABBWideNode* Child = Current.GetChild(i);
+				Min.Set(MAX_FLOAT, MAX_FLOAT, MAX_FLOAT);
+				Max.Set(MIN_FLOAT, MIN_FLOAT, MIN_FLOAT);
+				for(udword j=0;j<OPC_WIDE_NB_CHILDREN;j++)
+				{
+					if(Child->IsEmpty(j))	continue;
+					Min.Min(Point(Child->mMinX[j], Child->mMinY[j], Child->mMinZ[j]));
+					Max.Max(Point(Child->mMaxX[j], Child->mMaxY[j], Child->mMaxZ[j]));
+				}
+			}
+
+			Current.mMinX[i] = Min.x;	Current.mMinY[i] = Min.y;	Current.mMinZ[i] = Min.z;
+			Current.mMaxX[i] = Max.x;	Current.mMaxY[i] = Max.y;	Current.mMaxZ[i] = Max.z;
+		}
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Walks the tree and call the user back for each node.
+ *	\param		callback	[in] walking callback
+ *	\param		user_data	[in] callback's user data
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool AABBWideTree::Walk(GenericWalkingCallback callback, void* user_data) const
+{
+	if(!callback)	return false;
+
+	struct Local
+	{
+		static void _Walk(const AABBWideNode* current_node, GenericWalkingCallback callback, void* user_data)
+		{
+			if(!current_node || !(callback)(current_node, user_data))	return;
+
+			for(udword i=0;i<OPC_WIDE_NB_CHILDREN;i++)
+			{
+				if(!current_node->IsEmpty(i) && !current_node->IsLeaf(i))	_Walk(current_node->GetChild(i), callback, user_data);
+			}
+		}
+	};
+	Local::_Walk(mNodes, callback, user_data);
+	return true;
+}
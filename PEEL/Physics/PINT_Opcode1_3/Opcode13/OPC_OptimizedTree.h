@@ -109,6 +109,45 @@
 		IMPLEMENT_NOLEAF_NODE(AABBQuantizedNoLeafNode, QuantizedAABB)
 	};
 
+	//! Number of children in a wide node [PEEL]
+	#define OPC_WIDE_NB_CHILDREN	4
+
+	//! Wide node [PEEL]: the children boxes are stored as SoA min/max arrays, so that all of them can be tested at once with SSE.
+	//! Each child slot is either a primitive (LSB=1), a child node pointer (LSB=0), or empty (0). Empty slots come last.
+	class OPCODE_API AABBWideNode : public Allocateable
+	{
+		public:
+		inline_								AABBWideNode()			{}
+		inline_								~AABBWideNode()			{}
+		// Child slots
+		inline_			BOOL				IsEmpty(udword i)		const	{ return !mData[i];							}
+		inline_			BOOL				IsLeaf(udword i)		const	{ return mData[i]&1;						}
+		inline_			const AABBWideNode*	GetChild(udword i)		const	{ return (const AABBWideNode*)mData[i];		}
+		inline_			udword				GetPrimitive(udword i)	const	{ return (mData[i]>>1);						}
+		inline_			void				GetCenter(udword i, Point& center)	const
+											{
+												center.x = (mMaxX[i] + mMinX[i])*0.5f;
+												center.y = (mMaxY[i] + mMinY[i])*0.5f;
+												center.z = (mMaxZ[i] + mMinZ[i])*0.5f;
+											}
+		inline_			void				GetExtents(udword i, Point& extents)	const
+											{
+												extents.x = (mMaxX[i] - mMinX[i])*0.5f;
+												extents.y = (mMaxY[i] - mMinY[i])*0.5f;
+												extents.z = (mMaxZ[i] - mMinZ[i])*0.5f;
+											}
+		// Stats
+		inline_			udword				GetNodeSize()			const	{ return SIZEOFOBJECT;						}
+
+						float				mMinX[OPC_WIDE_NB_CHILDREN];
+						float				mMinY[OPC_WIDE_NB_CHILDREN];
+						float				mMinZ[OPC_WIDE_NB_CHILDREN];
+						float				mMaxX[OPC_WIDE_NB_CHILDREN];
+						float				mMaxY[OPC_WIDE_NB_CHILDREN];
+						float				mMaxZ[OPC_WIDE_NB_CHILDREN];
+						udword				mData[OPC_WIDE_NB_CHILDREN];
+	};
+
 	//! Common interface for a collision tree
 	#define IMPLEMENT_COLLISION_TREE(base_class, node)																\
 		public:																										\
@@ -203,4 +242,11 @@
 						Point				mExtentsCoeff;
 	};
 
+	//! Wide tree [PEEL]: the binary tree collapsed into OPC_WIDE_NB_CHILDREN-wide nodes. The root node holds the children of
+	//! the binary root, its own box isn't stored.
+	class OPCODE_API AABBWideTree : public AABBOptimizedTree
+	{
+		IMPLEMENT_COLLISION_TREE(AABBWideTree, AABBWideNode)
+	};
+
 #endif // __OPC_OPTIMIZEDTREE_H__
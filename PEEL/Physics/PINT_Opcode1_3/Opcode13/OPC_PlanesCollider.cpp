@@ -106,6 +106,9 @@ bool PlanesCollider::Collide(PlanesCache& cache, const Plane* planes, udword nb_
 	// Checkings
 	if(!Setup(&model))	return false;
 
+	// Wide trees aren't supported by this collider [PEEL]
+	if(model.IsWide())	return false;
+
 	// Init collision query
 	if(InitQuery(cache, planes, nb_planes, worldm))	return true;
 
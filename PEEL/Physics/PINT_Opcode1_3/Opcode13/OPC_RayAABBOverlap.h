@@ -61,3 +61,31 @@ inline_ BOOL RayCollider::RayAABBOverlap(const Point& center, const Point& exten
 
 	return TRUE;
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Computes a segment-AABB overlap test using slabs [PEEL]. The segment is [0, mMaxDist] along the cached ray, and mInvDir
+ *	must have been setup.
+ *	\param		center	[in] AABB center
+ *	\param		extents	[in] AABB extents
+ *	\param		dist	[out] entry distance along the ray, when overlapping
+ *	\return		true on overlap
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline_ BOOL RayCollider::SlabAABBOverlap(const Point& center, const Point& extents, float& dist)
+{
+	// Stats
+	mNbRayBVTests++;
+
+	const float TX0 = (center.x - extents.x - mOrigin.x) * mInvDir.x;
+	const float TX1 = (center.x + extents.x - mOrigin.x) * mInvDir.x;
+	const float TY0 = (center.y - extents.y - mOrigin.y) * mInvDir.y;
+	const float TY1 = (center.y + extents.y - mOrigin.y) * mInvDir.y;
+	const float TZ0 = (center.z - extents.z - mOrigin.z) * mInvDir.z;
+	const float TZ1 = (center.z + extents.z - mOrigin.z) * mInvDir.z;
+
+	const float TMin = MAX(MAX(MIN(TX0, TX1), MIN(TY0, TY1)), MAX(MIN(TZ0, TZ1), 0.0f));
+	const float TMax = MIN(MIN(MAX(TX0, TX1), MAX(TY0, TY1)), MIN(MAX(TZ0, TZ1), mMaxDist));
+	dist = TMin;
+	return TMin<=TMax;
+}
@@ -187,6 +187,22 @@ using namespace Opcode;
 		}																					\
 	}
 
+// [PEEL] Closest-hit version: the segment shrinks to the hit, so that farther nodes & triangles can be skipped
+#define CLOSEST_PRIM(prim_index, flag)														\
+	/* Request vertices from the app */														\
+	VertexPointers VP;	mIMesh->GetTriangle(VP, prim_index);								\
+																							\
+	/* Perform ray-tri overlap test and return */											\
+	if(RayTriOverlap(*VP.Vertex[0], *VP.Vertex[1], *VP.Vertex[2]))							\
+	{																						\
+		/* Intersection point is valid if dist < current closest distance */				\
+		if(IR(mStabbedFace.mDistance)<IR(mMaxDist))											\
+		{																					\
+			HANDLE_CONTACT(prim_index, flag)												\
+			mMaxDist = mStabbedFace.mDistance;												\
+		}																					\
+	}
+
 #define RAY_PRIM(prim_index, flag)															\
 	/* Request vertices from the app */														\
 	VertexPointers VP;	mIMesh->GetTriangle(VP, prim_index);								\
@@ -268,7 +284,31 @@ bool RayCollider::Collide(const Ray& world_ray, const Model& model, const Matrix
 	// Init collision query
 	if(InitQuery(world_ray, world, cache))	return true;
 
-	if(!model.HasLeafNodes())
+	if(model.IsWide())
+	{
+		const AABBWideTree* Tree = (const AABBWideTree*)model.GetTree();
+
+		// Precompute the inverse direction for slab tests
+		SetupInvDir();
+
+		// Perform stabbing query. Slab tests handle both rays & segments (with an infinite mMaxDist).
+		_SegmentStab(Tree->GetNodes());
+	}
+#ifndef OPC_RAYHIT_CALLBACK
+	else if(mClosestHit && !model.IsQuantized())
+	{
+		// [PEEL] Closest hit: ordered front-to-back traversal. The segment shrinks as hits are found, so we restore the
+		// user's setting afterwards. Slab tests handle both rays & segments.
+		SetupInvDir();
+		const float MaxDist = mMaxDist;
+
+		if(model.HasLeafNodes())	_ClosestHitStab(((const AABBCollisionTree*)model.GetTree())->GetNodes());
+		else						_ClosestHitStab(((const AABBNoLeafTree*)model.GetTree())->GetNodes());
+
+		mMaxDist = MaxDist;
+	}
+#endif
+	else if(!model.HasLeafNodes())
 	{
 		if(model.IsQuantized())
 		{
@@ -485,6 +525,68 @@ bool RayCollider::Collide(const Ray& world_ray, const AABBTree* tree, Container&
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Closest-hit stabbing query for vanilla AABB trees [PEEL].
+ *	\param		world_ray		[in] stabbing ray in world space
+ *	\param		tree			[in] AABB tree
+ *	\param		callback		[in] callback called for each stabbed box
+ *	\param		user_data		[in] user-defined data sent to the callback
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool RayCollider::Collide(const Ray& world_ray, const AABBTree* tree, StabbedBoxCallback callback, void* user_data)
+{
+	// This is typically called for a scene tree, full of -AABBs-, see above.
+	ASSERT( !(FirstContactEnabled() && TemporalCoherenceEnabled()) );
+
+	// Checkings
+	if(!tree || !callback)		return false;
+
+	// Init collision query
+	if(InitQuery(world_ray))	return true;
+
+	// Perform ordered stabbing query. The segment shrinks as the callback finds hits, so we restore the user's setting afterwards.
+	SetupInvDir();
+	const float MaxDist = mMaxDist;
+	_ClosestHitStab(tree, callback, user_data);
+	mMaxDist = MaxDist;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Closest-hit stabbing query for dynamic AABB trees [PEEL].
+ *	\param		world_ray		[in] stabbing ray in world space
+ *	\param		tree			[in] dynamic AABB tree
+ *	\param		callback		[in] callback called for each stabbed object
+ *	\param		user_data		[in] user-defined data sent to the callback
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool RayCollider::Collide(const Ray& world_ray, const DynamicAABBTree* tree, StabbedBoxCallback callback, void* user_data)
+{
+	ASSERT( !(FirstContactEnabled() && TemporalCoherenceEnabled()) );
+
+	// Checkings
+	if(!tree || !callback)		return false;
+
+	// Init collision query
+	if(InitQuery(world_ray))	return true;
+
+	// Empty tree
+	if(tree->GetRoot()==INVALID_ID)	return true;
+
+	// Perform ordered stabbing query
+	SetupInvDir();
+	const float MaxDist = mMaxDist;
+	_ClosestHitStab(tree->GetNodes(), tree->GetRoot(), callback, user_data);
+	mMaxDist = MaxDist;
+
+	return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Recursive stabbing query for normal AABB trees.
@@ -597,6 +699,53 @@ void RayCollider::_SegmentStab(const AABBQuantizedNoLeafNode* node)
 	else _SegmentStab(node->GetNeg());
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive stabbing query for wide AABB trees [PEEL]. All children boxes are tested at once with a SIMD slab test.
+ *	\param		node	[in] current collision node
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayCollider::_SegmentStab(const AABBWideNode* node)
+{
+	// Stats: one SIMD test for all children
+	mNbRayBVTests++;
+
+	const __m128 OX = _mm_load1_ps(&mOrigin.x);
+	const __m128 OY = _mm_load1_ps(&mOrigin.y);
+	const __m128 OZ = _mm_load1_ps(&mOrigin.z);
+	const __m128 IX = _mm_load1_ps(&mInvDir.x);
+	const __m128 IY = _mm_load1_ps(&mInvDir.y);
+	const __m128 IZ = _mm_load1_ps(&mInvDir.z);
+
+	// Distances along the ray to each slab
+	const __m128 TX0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->mMinX), OX), IX);
+	const __m128 TX1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->mMaxX), OX), IX);
+	const __m128 TY0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->mMinY), OY), IY);
+	const __m128 TY1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->mMaxY), OY), IY);
+	const __m128 TZ0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->mMinZ), OZ), IZ);
+	const __m128 TZ1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->mMaxZ), OZ), IZ);
+
+	// Intersect the slabs with the [0, mMaxDist] segment
+	const __m128 TMin = _mm_max_ps(_mm_max_ps(_mm_min_ps(TX0, TX1), _mm_min_ps(TY0, TY1)), _mm_max_ps(_mm_min_ps(TZ0, TZ1), _mm_setzero_ps()));
+	const __m128 TMax = _mm_min_ps(_mm_min_ps(_mm_max_ps(TX0, TX1), _mm_max_ps(TY0, TY1)), _mm_min_ps(_mm_max_ps(TZ0, TZ1), _mm_load1_ps(&mMaxDist)));
+	const udword Mask = _mm_movemask_ps(_mm_cmple_ps(TMin, TMax));
+	if(!Mask)	return;
+
+	for(udword i=0;i<OPC_WIDE_NB_CHILDREN;i++)
+	{
+		// Empty slots have inverted boxes, which slab tests don't reject
+		if(!(Mask & (1<<i)) || node->IsEmpty(i))	continue;
+
+		if(node->IsLeaf(i))
+		{
+			SEGMENT_PRIM(node->GetPrimitive(i), OPC_CONTACT)
+		}
+		else _SegmentStab(node->GetChild(i));
+
+		if(ContactFound()) return;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Recursive stabbing query for vanilla AABB trees.
@@ -761,3 +910,369 @@ void RayCollider::_RayStab(const AABBTreeNode* node, Container& box_indices)
 		_RayStab(node->GetNeg(), box_indices);
 	}
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Ordered closest-hit stabbing query for normal AABB trees [PEEL].
+ *	This is an iterative, stack-based traversal. Children are visited front-to-back, i.e. the child with the smallest entry
+ *	distance first, and the segment shrinks as hits are found. Nodes are culled when popped if they start beyond the closest
+ *	hit so far.
+ *	\param		node	[in] root node
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayCollider::_ClosestHitStab(const AABBCollisionNode* node)
+{
+	struct StackEntry
+	{
+		const AABBCollisionNode*	mNode;
+		float						mDist;	// Entry distance along the ray
+	};
+	StackEntry Stack[OPC_RAY_STACK_SIZE];
+	udword NbEntries = 0;
+
+	float Dist;
+	if(!SlabAABBOverlap(node->mAABB.mCenter, node->mAABB.mExtents, Dist))	return;
+
+	while(1)
+	{
+		if(node->IsLeaf())
+		{
+			CLOSEST_PRIM(node->GetPrimitive(), OPC_CONTACT)
+			node = null;
+		}
+		else
+		{
+			const AABBCollisionNode* Pos = node->GetPos();
+			const AABBCollisionNode* Neg = node->GetNeg();
+			float DistPos, DistNeg;
+			const BOOL HitPos = SlabAABBOverlap(Pos->mAABB.mCenter, Pos->mAABB.mExtents, DistPos);
+			const BOOL HitNeg = SlabAABBOverlap(Neg->mAABB.mCenter, Neg->mAABB.mExtents, DistNeg);
+			if(HitPos && HitNeg)
+			{
+				// Visit the nearest child first, keep the other one for later
+				const AABBCollisionNode* Far = Neg;
+				float FarDist = DistNeg;
+				node = Pos;
+				if(DistNeg<DistPos)
+				{
+					Far = Pos;
+					FarDist = DistPos;
+					node = Neg;
+				}
+
+				if(NbEntries==OPC_RAY_STACK_SIZE)
+				{
+					// Stack overflow, process the near child recursively. The far one will be culled if needed.
+					_ClosestHitStab(node);
+					node = Far;
+				}
+				else
+				{
+					Stack[NbEntries].mNode = Far;
+					Stack[NbEntries].mDist = FarDist;
+					NbEntries++;
+				}
+			}
+			else if(HitPos)	node = Pos;
+			else if(HitNeg)	node = Neg;
+			else			node = null;
+		}
+
+		if(!node)
+		{
+			// Pop the next node, skipping the ones beyond the closest hit
+			do
+			{
+				if(!NbEntries)	return;
+				NbEntries--;
+			}while(Stack[NbEntries].mDist>mMaxDist);
+			node = Stack[NbEntries].mNode;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Ordered closest-hit stabbing query for no-leaf AABB trees [PEEL].
+ *	\param		node	[in] root node
+ *	\see		_ClosestHitStab(const AABBCollisionNode* node)
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayCollider::_ClosestHitStab(const AABBNoLeafNode* node)
+{
+	struct StackEntry
+	{
+		const AABBNoLeafNode*	mNode;
+		float					mDist;	// Entry distance along the ray
+	};
+	StackEntry Stack[OPC_RAY_STACK_SIZE];
+	udword NbEntries = 0;
+
+	float Dist;
+	if(!SlabAABBOverlap(node->mAABB.mCenter, node->mAABB.mExtents, Dist))	return;
+
+	while(1)
+	{
+		// Leaf children have no boxes, their triangles are tested right away
+		const AABBNoLeafNode* Pos = null;
+		const AABBNoLeafNode* Neg = null;
+		float DistPos, DistNeg;
+
+		if(node->HasPosLeaf())
+		{
+			CLOSEST_PRIM(node->GetPosPrimitive(), OPC_CONTACT)
+		}
+		else if(SlabAABBOverlap(node->GetPos()->mAABB.mCenter, node->GetPos()->mAABB.mExtents, DistPos))
+			Pos = node->GetPos();
+
+		if(node->HasNegLeaf())
+		{
+			CLOSEST_PRIM(node->GetNegPrimitive(), OPC_CONTACT)
+		}
+		else if(SlabAABBOverlap(node->GetNeg()->mAABB.mCenter, node->GetNeg()->mAABB.mExtents, DistNeg))
+			Neg = node->GetNeg();
+
+		// A hit in a leaf child may have moved the closest hit before the other child
+		if(Pos && DistPos>mMaxDist)	Pos = null;
+		if(Neg && DistNeg>mMaxDist)	Neg = null;
+
+		if(Pos && Neg)
+		{
+			// Visit the nearest child first, keep the other one for later
+			const AABBNoLeafNode* Far = Neg;
+			float FarDist = DistNeg;
+			node = Pos;
+			if(DistNeg<DistPos)
+			{
+				Far = Pos;
+				FarDist = DistPos;
+				node = Neg;
+			}
+
+			if(NbEntries==OPC_RAY_STACK_SIZE)
+			{
+				// Stack overflow, process the near child recursively. The far one will be culled if needed.
+				_ClosestHitStab(node);
+				node = Far;
+			}
+			else
+			{
+				Stack[NbEntries].mNode = Far;
+				Stack[NbEntries].mDist = FarDist;
+				NbEntries++;
+			}
+		}
+		else if(Pos)	node = Pos;
+		else if(Neg)	node = Neg;
+		else
+		{
+			// Pop the next node, skipping the ones beyond the closest hit
+			do
+			{
+				if(!NbEntries)	return;
+				NbEntries--;
+			}while(Stack[NbEntries].mDist>mMaxDist);
+			node = Stack[NbEntries].mNode;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Ordered closest-hit stabbing query for vanilla AABB trees [PEEL]. Stabbed boxes are sent to the callback nearest-first,
+ *	and the segment shrinks to the distances it returns.
+ *	\param		node		[in] root node
+ *	\param		callback	[in] callback called for each stabbed box
+ *	\param		user_data	[in] user-defined data sent to the callback
+ *	\see		_ClosestHitStab(const AABBCollisionNode* node)
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayCollider::_ClosestHitStab(const AABBTreeNode* node, StabbedBoxCallback callback, void* user_data)
+{
+	struct StackEntry
+	{
+		const AABBTreeNode*	mNode;
+		float				mDist;	// Entry distance along the ray
+	};
+	StackEntry Stack[OPC_RAY_STACK_SIZE];
+	udword NbEntries = 0;
+
+	Point Center, Extents;
+	node->GetAABB()->GetCenter(Center);
+	node->GetAABB()->GetExtents(Extents);
+	float Dist;
+	if(!SlabAABBOverlap(Center, Extents, Dist))	return;
+
+	while(1)
+	{
+		if(node->IsLeaf())
+		{
+			mFlags |= OPC_CONTACT;
+
+			const udword* Prims = node->GetPrimitives();
+			const udword NbPrims = node->GetNbPrimitives();
+			for(udword i=0;i<NbPrims;i++)
+			{
+				const float NewMaxDist = (callback)(Prims[i], mMaxDist, user_data);
+				if(NewMaxDist<mMaxDist)
+					mMaxDist = NewMaxDist;
+				// A negative distance culls all remaining nodes
+				if(mMaxDist<0.0f)
+					break;
+			}
+			node = null;
+		}
+		else
+		{
+			const AABBTreeNode* Pos = node->GetPos();
+			const AABBTreeNode* Neg = node->GetNeg();
+			float DistPos, DistNeg;
+
+			Pos->GetAABB()->GetCenter(Center);
+			Pos->GetAABB()->GetExtents(Extents);
+			const BOOL HitPos = SlabAABBOverlap(Center, Extents, DistPos);
+
+			Neg->GetAABB()->GetCenter(Center);
+			Neg->GetAABB()->GetExtents(Extents);
+			const BOOL HitNeg = SlabAABBOverlap(Center, Extents, DistNeg);
+
+			if(HitPos && HitNeg)
+			{
+				// Visit the nearest child first, keep the other one for later
+				const AABBTreeNode* Far = Neg;
+				float FarDist = DistNeg;
+				node = Pos;
+				if(DistNeg<DistPos)
+				{
+					Far = Pos;
+					FarDist = DistPos;
+					node = Neg;
+				}
+
+				if(NbEntries==OPC_RAY_STACK_SIZE)
+				{
+					// Stack overflow, process the near child recursively. The far one will be culled if needed.
+					_ClosestHitStab(node, callback, user_data);
+					node = Far;
+				}
+				else
+				{
+					Stack[NbEntries].mNode = Far;
+					Stack[NbEntries].mDist = FarDist;
+					NbEntries++;
+				}
+			}
+			else if(HitPos)	node = Pos;
+			else if(HitNeg)	node = Neg;
+			else			node = null;
+		}
+
+		if(!node)
+		{
+			// Pop the next node, skipping the ones beyond the closest hit
+			do
+			{
+				if(!NbEntries)	return;
+				NbEntries--;
+			}while(Stack[NbEntries].mDist>mMaxDist);
+			node = Stack[NbEntries].mNode;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Ordered closest-hit stabbing query for dynamic AABB trees [PEEL]. Stabbed objects are sent to the callback nearest-first,
+ *	and the segment shrinks to the distances it returns.
+ *	\param		nodes		[in] tree nodes
+ *	\param		index		[in] root node index
+ *	\param		callback	[in] callback called for each stabbed object
+ *	\param		user_data	[in] user-defined data sent to the callback
+ *	\see		_ClosestHitStab(const AABBTreeNode* node, StabbedBoxCallback callback, void* user_data)
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayCollider::_ClosestHitStab(const DynamicAABBTreeNode* nodes, udword index, StabbedBoxCallback callback, void* user_data)
+{
+	struct StackEntry
+	{
+		udword	mIndex;
+		float	mDist;	// Entry distance along the ray
+	};
+	StackEntry Stack[OPC_RAY_STACK_SIZE];
+	udword NbEntries = 0;
+
+	Point Center, Extents;
+	nodes[index].mBox.GetCenter(Center);
+	nodes[index].mBox.GetExtents(Extents);
+	float Dist;
+	if(!SlabAABBOverlap(Center, Extents, Dist))	return;
+
+	while(1)
+	{
+		const DynamicAABBTreeNode& Node = nodes[index];
+		if(Node.IsLeaf())
+		{
+			mFlags |= OPC_CONTACT;
+
+			const float NewMaxDist = (callback)(Node.mUserData, mMaxDist, user_data);
+			if(NewMaxDist<mMaxDist)
+				mMaxDist = NewMaxDist;
+			index = INVALID_ID;
+		}
+		else
+		{
+			const udword Child0 = Node.mChildren[0];
+			const udword Child1 = Node.mChildren[1];
+			float Dist0, Dist1;
+
+			nodes[Child0].mBox.GetCenter(Center);
+			nodes[Child0].mBox.GetExtents(Extents);
+			const BOOL Hit0 = SlabAABBOverlap(Center, Extents, Dist0);
+
+			nodes[Child1].mBox.GetCenter(Center);
+			nodes[Child1].mBox.GetExtents(Extents);
+			const BOOL Hit1 = SlabAABBOverlap(Center, Extents, Dist1);
+
+			if(Hit0 && Hit1)
+			{
+				// Visit the nearest child first, keep the other one for later
+				udword Far = Child1;
+				float FarDist = Dist1;
+				index = Child0;
+				if(Dist1<Dist0)
+				{
+					Far = Child0;
+					FarDist = Dist0;
+					index = Child1;
+				}
+
+				if(NbEntries==OPC_RAY_STACK_SIZE)
+				{
+					// Stack overflow, process the near child recursively. The far one will be culled if needed.
+					_ClosestHitStab(nodes, index, callback, user_data);
+					index = Far;
+				}
+				else
+				{
+					Stack[NbEntries].mIndex = Far;
+					Stack[NbEntries].mDist = FarDist;
+					NbEntries++;
+				}
+			}
+			else if(Hit0)	index = Child0;
+			else if(Hit1)	index = Child1;
+			else			index = INVALID_ID;
+		}
+
+		if(index==INVALID_ID)
+		{
+			// Pop the next node, skipping the ones beyond the closest hit
+			do
+			{
+				if(!NbEntries)	return;
+				NbEntries--;
+			}while(Stack[NbEntries].mDist>mMaxDist);
+			index = Stack[NbEntries].mIndex;
+		}
+	}
+}
@@ -61,6 +61,22 @@
 	typedef void	(*HitCallback)	(const CollisionFace& hit, void* user_data);
 #endif
 
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	/**
+	 *	User-callback, called by OPCODE for each stabbed box during a closest-hit scene query [PEEL]. Boxes are reported
+	 *	nearest-first, and the query stops as soon as the next box is farther than the returned distance. Return a negative
+	 *	distance to stop the query immediately, e.g. for any-hit queries.
+	 *	\param		box_index	[in] index of stabbed box
+	 *	\param		max_dist	[in] current max distance along the ray
+	 *	\param		user_data	[in] user-defined data
+	 *	\return		new max distance, i.e. the distance to the closest hit found in the box, or max_dist
+	 */
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	typedef float	(*StabbedBoxCallback)	(udword box_index, float max_dist, void* user_data);
+
+	//! Size of the stack used by ordered traversals. Deeper trees are handled with recursive calls. [PEEL]
+	#define OPC_RAY_STACK_SIZE	64
+
 	class OPCODE_API RayCollider : public Collider
 	{
 		public:
@@ -85,6 +101,35 @@
 							bool			Collide(const Ray& world_ray, const Model& model, const Matrix4x4* world=null, udword* cache=null);
 		//
 							bool			Collide(const Ray& world_ray, const AABBTree* tree, Container& box_indices);
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Closest-hit stabbing query for vanilla AABB trees [PEEL]. Boxes are visited front-to-back and sent to the callback,
+		 *	which typically performs the closest-hit query against the object in the box. The segment shrinks to the returned
+		 *	distances, and the traversal stops when the remaining boxes are farther than the closest hit.
+		 *
+		 *	\param		world_ray		[in] stabbing ray in world space
+		 *	\param		tree			[in] AABB tree
+		 *	\param		callback		[in] callback called for each stabbed box
+		 *	\param		user_data		[in] user-defined data sent to the callback
+		 *	\return		true if success
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+							bool			Collide(const Ray& world_ray, const AABBTree* tree, StabbedBoxCallback callback, void* user_data);
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Closest-hit stabbing query for dynamic AABB trees [PEEL]. Same as above, except the callback receives the user data
+		 *	of the stabbed objects instead of box indices.
+		 *
+		 *	\param		world_ray		[in] stabbing ray in world space
+		 *	\param		tree			[in] dynamic AABB tree
+		 *	\param		callback		[in] callback called for each stabbed object
+		 *	\param		user_data		[in] user-defined data sent to the callback
+		 *	\return		true if success
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+							bool			Collide(const Ray& world_ray, const DynamicAABBTree* tree, StabbedBoxCallback callback, void* user_data);
 		// Settings
 
 #ifndef OPC_RAYHIT_CALLBACK
@@ -182,6 +227,7 @@
 							Point			mDir;				//!< Ray direction (normalized)
 							Point			mFDir;				//!< fabsf(mDir)
 							Point			mData, mData2;
+							Point			mInvDir;			//!< 1/mDir, for slab tests [PEEL]
 		// Stabbed faces
 							CollisionFace	mStabbedFace;		//!< Current stabbed face
 #ifdef OPC_RAYHIT_CALLBACK
@@ -209,18 +255,31 @@
 							void			_SegmentStab(const AABBNoLeafNode* node);
 							void			_SegmentStab(const AABBQuantizedNode* node);
 							void			_SegmentStab(const AABBQuantizedNoLeafNode* node);
+							void			_SegmentStab(const AABBWideNode* node);
 							void			_SegmentStab(const AABBTreeNode* node, Container& box_indices);
 							void			_RayStab(const AABBCollisionNode* node);
 							void			_RayStab(const AABBNoLeafNode* node);
 							void			_RayStab(const AABBQuantizedNode* node);
 							void			_RayStab(const AABBQuantizedNoLeafNode* node);
 							void			_RayStab(const AABBTreeNode* node, Container& box_indices);
+							void			_ClosestHitStab(const AABBCollisionNode* node);
+							void			_ClosestHitStab(const AABBNoLeafNode* node);
+							void			_ClosestHitStab(const AABBTreeNode* node, StabbedBoxCallback callback, void* user_data);
+							void			_ClosestHitStab(const DynamicAABBTreeNode* nodes, udword index, StabbedBoxCallback callback, void* user_data);
 			// Overlap tests
 		inline_				BOOL			RayAABBOverlap(const Point& center, const Point& extents);
 		inline_				BOOL			SegmentAABBOverlap(const Point& center, const Point& extents);
 		inline_				BOOL			RayTriOverlap(const Point& vert0, const Point& vert1, const Point& vert2);
+		inline_				BOOL			SlabAABBOverlap(const Point& center, const Point& extents, float& dist);
 			// Init methods
 							BOOL			InitQuery(const Ray& world_ray, const Matrix4x4* world=null, udword* face_id=null);
+		inline_				void			SetupInvDir()
+											{
+												// Null components are replaced with tiny ones, to avoid 0*inf NaNs
+												mInvDir.x = 1.0f / (fabsf(mDir.x)>1e-20f ? mDir.x : 1e-20f);
+												mInvDir.y = 1.0f / (fabsf(mDir.y)>1e-20f ? mDir.y : 1e-20f);
+												mInvDir.z = 1.0f / (fabsf(mDir.z)>1e-20f ? mDir.z : 1e-20f);
+											}
 	};
 
 #endif // __OPC_RAYCOLLIDER_H__
@@ -0,0 +1,629 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ *	OPCODE - Optimized Collision Detection
+ *	Copyright (C) 2001 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/Opcode.htm
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains code for a ray-packet collider [PEEL].
+ *	\file		OPC_RayPacketCollider.cpp
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains a packet-vs-tree collider.
+ *	This class performs closest-hit stabbing queries for up to OPC_MAX_PACKET_SIZE rays at the same time. Coherent rays
+ *	(e.g. camera rays) mostly visit the same nodes, so a node is fetched once for the whole packet:
+ *
+ *	- the packet is first tested against the node's box with interval arithmetic, i.e. with conservative bounds of the slab
+ *	distances computed from the bounds of the origins & inverse directions. This culls the node for all rays at once. It is
+ *	only valid when all rays have the same direction signs.
+ *	- the remaining rays are tested 4 at a time with SSE slab tests, giving the mask of rays which actually touch the node.
+ *	- when a single ray is left in the mask, the packet has diverged and we switch to a single-ray traversal.
+ *
+ *	Each ray keeps its own max distance, which shrinks as hits are found.
+ *
+ *	\class		RayPacketCollider
+ *	\version	1.0
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Precompiled Header
+#include "Stdafx.h"
+#include "Opcode.h"
+
+using namespace Opcode;
+
+#include "OPC_RayTriOverlap.h"
+
+// Inverse of a direction component. Null components are replaced with tiny ones with the same sign, to avoid 0*inf NaNs.
+static inline_ float InvDirComponent(float d)
+{
+	if(fabsf(d)>1e-20f)
+		return 1.0f / d;
+	return IS_NEGATIVE_FLOAT(d) ? -1e20f : 1e20f;
+}
+
+// Lower bound of the product of intervals [a0, a1] and [b0, b1]
+static inline_ float IntervalMulMin(float a0, float a1, float b0, float b1)
+{
+	return MIN(MIN(a0*b0, a0*b1), MIN(a1*b0, a1*b1));
+}
+
+// Upper bound of the product of intervals [a0, a1] and [b0, b1]
+static inline_ float IntervalMulMax(float a0, float a1, float b0, float b1)
+{
+	return MAX(MAX(a0*b0, a0*b1), MAX(a1*b0, a1*b1));
+}
+
+// Index of the only bit set in a mask
+static inline_ udword GetRayIndex(udword mask)
+{
+	udword i = 0;
+	while(!(mask & (1<<i)))
+		i++;
+	return i;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Constructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+RayPacketCollider::RayPacketCollider() :
+	mUseIA				(FALSE),
+	mHits				(null),
+	mHitMask			(0),
+	mNbPacketBVTests	(0),
+	mNbCulledNodes		(0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Destructor.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+RayPacketCollider::~RayPacketCollider()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Packet stabbing query for vanilla AABB trees.
+ *	\param		packet			[in] rays in world space
+ *	\param		max_dists		[in] one max distance per ray
+ *	\param		active_mask		[in] bit i set if ray i must be processed
+ *	\param		tree			[in] AABB tree
+ *	\param		box_indices		[out] (box index, ray mask) pairs
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool RayPacketCollider::Collide(const RayPacket& packet, const float* max_dists, udword active_mask, const AABBTree* tree, Container& box_indices)
+{
+	// Checkings
+	if(!tree || !max_dists)	return false;
+	ASSERT(packet.mNbRays<=OPC_MAX_PACKET_SIZE);
+
+	// Init collision query
+	Collider::InitQuery();
+	mNbRayBVTests		= 0;
+	mNbRayPrimTests		= 0;
+	mNbIntersections	= 0;
+	mNbPacketBVTests	= 0;
+	mNbCulledNodes		= 0;
+
+	SetupPacket(packet, active_mask, null);
+	for(udword i=0;i<packet.mNbRays;i++)
+		mTMax[i] = max_dists[i];
+
+	// Perform stabbing query
+	if(active_mask)
+		_Stab(tree, active_mask, box_indices);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Packet stabbing query for dynamic AABB trees.
+ *	\param		packet			[in] rays in world space
+ *	\param		max_dists		[in] one max distance per ray
+ *	\param		active_mask		[in] bit i set if ray i must be processed
+ *	\param		tree			[in] dynamic AABB tree
+ *	\param		user_data		[out] (user data, ray mask) pairs
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool RayPacketCollider::Collide(const RayPacket& packet, const float* max_dists, udword active_mask, const DynamicAABBTree* tree, Container& user_data)
+{
+	// Checkings
+	if(!tree || !max_dists)	return false;
+	ASSERT(packet.mNbRays<=OPC_MAX_PACKET_SIZE);
+
+	// Init collision query
+	Collider::InitQuery();
+	mNbRayBVTests		= 0;
+	mNbRayPrimTests		= 0;
+	mNbIntersections	= 0;
+	mNbPacketBVTests	= 0;
+	mNbCulledNodes		= 0;
+
+	SetupPacket(packet, active_mask, null);
+	for(udword i=0;i<packet.mNbRays;i++)
+		mTMax[i] = max_dists[i];
+
+	// Perform stabbing query
+	if(active_mask && tree->GetRoot()!=INVALID_ID)
+		_Stab(tree->GetNodes(), tree->GetRoot(), active_mask, user_data);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Closest-hit packet stabbing query for generic OPCODE models.
+ *	\param		packet			[in] rays in world space
+ *	\param		active_mask		[in] bit i set if ray i must be processed
+ *	\param		model			[in] Opcode model to collide with
+ *	\param		world			[in] model's world matrix, or null
+ *	\param		hits			[in/out] one closest hit per ray. Input distances are used as max distances.
+ *	\return		mask of rays whose closest hit has been updated
+ *	\warning	SCALE NOT SUPPORTED. The matrices must contain rotation & translation parts only.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+udword RayPacketCollider::Collide(const RayPacket& packet, udword active_mask, const Model& model, const Matrix4x4* world, CollisionFace* hits)
+{
+	// Checkings
+	if(!hits || !Setup(&model))	return 0;
+	ASSERT(packet.mNbRays<=OPC_MAX_PACKET_SIZE);
+
+	mHits		= hits;
+	mHitMask	= 0;
+
+	if(model.IsWide() || model.IsQuantized() || model.HasSingleNode())
+	{
+#ifndef OPC_RAYHIT_CALLBACK
+		// Packet traversal is only implemented for normal & no-leaf trees. Fallback to one closest-hit query per ray.
+		CollisionFace Memory;
+		CollisionFaces CF;
+		CF.InitSharedBuffers(sizeof(CollisionFace)/sizeof(udword), (udword*)&Memory);
+
+		CollisionFaces* SavedDestination = mStabbedFaces;
+		const bool SavedClosestHit = mClosestHit;
+		mStabbedFaces	= &CF;
+		mClosestHit		= true;
+
+		for(udword i=0;i<packet.mNbRays;i++)
+		{
+			if(!(active_mask & (1<<i)))
+				continue;
+
+			mMaxDist = hits[i].mDistance;
+			Memory.mDistance = MAX_FLOAT;
+			if(RayCollider::Collide(Ray(packet.mOrigin[i], packet.mDir[i]), model, world) && Memory.mDistance<hits[i].mDistance)
+			{
+				hits[i] = Memory;
+				mHitMask |= 1<<i;
+			}
+		}
+
+		mStabbedFaces	= SavedDestination;
+		mClosestHit		= SavedClosestHit;
+		mMaxDist		= MAX_FLOAT;
+#else
+		ASSERT(!"RayPacketCollider: per-ray fallback not supported with OPC_RAYHIT_CALLBACK");
+#endif
+		return mHitMask;
+	}
+
+	// Init collision query
+	Collider::InitQuery();
+	mNbRayBVTests		= 0;
+	mNbRayPrimTests		= 0;
+	mNbIntersections	= 0;
+	mNbPacketBVTests	= 0;
+	mNbCulledNodes		= 0;
+
+	SetupPacket(packet, active_mask, world);
+	for(udword i=0;i<packet.mNbRays;i++)
+		mTMax[i] = hits[i].mDistance;
+
+	if(!active_mask)
+		return 0;
+
+	// Perform stabbing query
+	if(!model.HasLeafNodes())
+	{
+		const AABBNoLeafTree* Tree = (const AABBNoLeafTree*)model.GetTree();
+		_Stab(Tree->GetNodes(), active_mask);
+	}
+	else
+	{
+		const AABBCollisionTree* Tree = (const AABBCollisionTree*)model.GetTree();
+		_Stab(Tree->GetNodes(), active_mask);
+	}
+	return mHitMask;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Initializes a packet query: computes the rays in local space, and the packet bounds used for interval arithmetic.
+ *	\param		packet			[in] rays in world space
+ *	\param		active_mask		[in] bit i set if ray i must be processed
+ *	\param		world			[in] object's world matrix, or null
+ *	\warning	SCALE NOT SUPPORTED. The matrix must contain rotation & translation parts only.
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayPacketCollider::SetupPacket(const RayPacket& packet, udword active_mask, const Matrix4x4* world)
+{
+	const udword NbRays = packet.mNbRays;
+
+	// Compute rays in local space
+	if(world)
+	{
+		const Matrix3x3 InvWorld = *world;
+
+		Matrix4x4 World;
+		InvertPRMatrix(World, *world);
+
+		for(udword i=0;i<NbRays;i++)
+		{
+			mLocalDir[i]	= InvWorld * packet.mDir[i];
+			mLocalOrigin[i]	= packet.mOrigin[i] * World;
+		}
+	}
+	else
+	{
+		for(udword i=0;i<NbRays;i++)
+		{
+			mLocalDir[i]	= packet.mDir[i];
+			mLocalOrigin[i]	= packet.mOrigin[i];
+		}
+	}
+
+	// Fill the SoA arrays. Unused slots get harmless values, they're never part of the masks anyway.
+	for(udword i=0;i<OPC_MAX_PACKET_SIZE;i++)
+	{
+		if(i<NbRays)
+		{
+			mOX[i] = mLocalOrigin[i].x;
+			mOY[i] = mLocalOrigin[i].y;
+			mOZ[i] = mLocalOrigin[i].z;
+			mIX[i] = InvDirComponent(mLocalDir[i].x);
+			mIY[i] = InvDirComponent(mLocalDir[i].y);
+			mIZ[i] = InvDirComponent(mLocalDir[i].z);
+		}
+		else
+		{
+			mOX[i] = mOY[i] = mOZ[i] = 0.0f;
+			mIX[i] = mIY[i] = mIZ[i] = 0.0f;
+			mTMax[i] = -1.0f;
+		}
+	}
+
+	// Compute the packet bounds for interval arithmetic
+	mUseIA = FALSE;
+	if(CountBits(active_mask)<2)
+		return;
+
+	mOriginMin.Set(MAX_FLOAT, MAX_FLOAT, MAX_FLOAT);
+	mOriginMax.Set(MIN_FLOAT, MIN_FLOAT, MIN_FLOAT);
+	mInvDirMin.Set(MAX_FLOAT, MAX_FLOAT, MAX_FLOAT);
+	mInvDirMax.Set(MIN_FLOAT, MIN_FLOAT, MIN_FLOAT);
+	for(udword i=0;i<NbRays;i++)
+	{
+		if(!(active_mask & (1<<i)))
+			continue;
+
+		mOriginMin.Min(mLocalOrigin[i]);
+		mOriginMax.Max(mLocalOrigin[i]);
+
+		const Point InvDir(mIX[i], mIY[i], mIZ[i]);
+		mInvDirMin.Min(InvDir);
+		mInvDirMax.Max(InvDir);
+	}
+
+	// Interval arithmetic is only used when all rays have the same direction signs, i.e. the same near & far planes
+	mUseIA =	(mInvDirMin.x>0.0f || mInvDirMax.x<0.0f)
+			&&	(mInvDirMin.y>0.0f || mInvDirMax.y<0.0f)
+			&&	(mInvDirMin.z>0.0f || mInvDirMax.z<0.0f);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Tests a packet against an AABB.
+ *	\param		min		[in] box min
+ *	\param		max		[in] box max
+ *	\param		mask	[in] rays to test
+ *	\return		mask of rays overlapping the box
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+udword RayPacketCollider::PacketAABBOverlap(const Point& min, const Point& max, udword mask)
+{
+	// Stats
+	mNbPacketBVTests++;
+
+	if(mUseIA)
+	{
+		// Conservative bounds of the slab distances for all rays at once. Tnear is also clamped to the ray start.
+		float NearLo = 0.0f;
+		float FarHi = MAX_FLOAT;
+		for(udword j=0;j<3;j++)
+		{
+			const float NearPlane	= mInvDirMin[j]>0.0f ? min[j] : max[j];
+			const float FarPlane	= mInvDirMin[j]>0.0f ? max[j] : min[j];
+
+			const float NearDist = IntervalMulMin(NearPlane - mOriginMax[j], NearPlane - mOriginMin[j], mInvDirMin[j], mInvDirMax[j]);
+			const float FarDist = IntervalMulMax(FarPlane - mOriginMax[j], FarPlane - mOriginMin[j], mInvDirMin[j], mInvDirMax[j]);
+			if(NearDist>NearLo)	NearLo = NearDist;
+			if(FarDist<FarHi)	FarHi = FarDist;
+		}
+
+		// Every ray enters the box after NearLo and leaves it before FarHi
+		if(NearLo>FarHi)
+		{
+			mNbCulledNodes++;
+			return 0;
+		}
+	}
+
+	const __m128 MinX = _mm_load1_ps(&min.x);
+	const __m128 MinY = _mm_load1_ps(&min.y);
+	const __m128 MinZ = _mm_load1_ps(&min.z);
+	const __m128 MaxX = _mm_load1_ps(&max.x);
+	const __m128 MaxY = _mm_load1_ps(&max.y);
+	const __m128 MaxZ = _mm_load1_ps(&max.z);
+
+	udword Result = 0;
+	for(udword g=0;g<OPC_MAX_PACKET_SIZE;g+=4)
+	{
+		if(!((mask>>g)&15))
+			continue;
+
+		// Stats: one SIMD test for 4 rays
+		mNbRayBVTests++;
+
+		const __m128 OX = _mm_loadu_ps(mOX+g);
+		const __m128 OY = _mm_loadu_ps(mOY+g);
+		const __m128 OZ = _mm_loadu_ps(mOZ+g);
+		const __m128 IX = _mm_loadu_ps(mIX+g);
+		const __m128 IY = _mm_loadu_ps(mIY+g);
+		const __m128 IZ = _mm_loadu_ps(mIZ+g);
+
+		// Distances along the rays to each slab
+		const __m128 TX0 = _mm_mul_ps(_mm_sub_ps(MinX, OX), IX);
+		const __m128 TX1 = _mm_mul_ps(_mm_sub_ps(MaxX, OX), IX);
+		const __m128 TY0 = _mm_mul_ps(_mm_sub_ps(MinY, OY), IY);
+		const __m128 TY1 = _mm_mul_ps(_mm_sub_ps(MaxY, OY), IY);
+		const __m128 TZ0 = _mm_mul_ps(_mm_sub_ps(MinZ, OZ), IZ);
+		const __m128 TZ1 = _mm_mul_ps(_mm_sub_ps(MaxZ, OZ), IZ);
+
+		// Intersect the slabs with the [0, tmax] segments
+		const __m128 TMin = _mm_max_ps(_mm_max_ps(_mm_min_ps(TX0, TX1), _mm_min_ps(TY0, TY1)), _mm_max_ps(_mm_min_ps(TZ0, TZ1), _mm_setzero_ps()));
+		const __m128 TMax = _mm_min_ps(_mm_min_ps(_mm_max_ps(TX0, TX1), _mm_max_ps(TY0, TY1)), _mm_min_ps(_mm_max_ps(TZ0, TZ1), _mm_loadu_ps(mTMax+g)));
+		Result |= udword(_mm_movemask_ps(_mm_cmple_ps(TMin, TMax)))<<g;
+	}
+	return Result & mask;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Tests a single ray of the packet against an AABB.
+ *	\param		min		[in] box min
+ *	\param		max		[in] box max
+ *	\param		i		[in] ray index
+ *	\return		true if the ray overlaps the box
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+inline_ BOOL RayPacketCollider::SingleRayAABBOverlap(const Point& min, const Point& max, udword i) const
+{
+	const float TX0 = (min.x - mOX[i]) * mIX[i];
+	const float TX1 = (max.x - mOX[i]) * mIX[i];
+	const float TY0 = (min.y - mOY[i]) * mIY[i];
+	const float TY1 = (max.y - mOY[i]) * mIY[i];
+	const float TZ0 = (min.z - mOZ[i]) * mIZ[i];
+	const float TZ1 = (max.z - mOZ[i]) * mIZ[i];
+
+	const float TMin = MAX(MAX(MIN(TX0, TX1), MIN(TY0, TY1)), MAX(MIN(TZ0, TZ1), 0.0f));
+	const float TMax = MIN(MIN(MAX(TX0, TX1), MAX(TY0, TY1)), MIN(MAX(TZ0, TZ1), mTMax[i]));
+	return TMin<=TMax;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Tests the rays of a packet against a triangle, and records the closest hits.
+ *	\param		prim_index	[in] triangle index
+ *	\param		mask		[in] rays to test
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayPacketCollider::_RayTri(udword prim_index, udword mask)
+{
+	// Request vertices from the app, once for all rays
+	VertexPointers VP;	mIMesh->GetTriangle(VP, prim_index);
+
+	for(udword i=0;mask;i++)
+	{
+		if(!(mask & (1<<i)))
+			continue;
+		mask &= ~(1<<i);
+
+		// Perform ray-tri overlap test. The regular code uses mOrigin & mDir.
+		mOrigin	= mLocalOrigin[i];
+		mDir	= mLocalDir[i];
+		if(RayTriOverlap(*VP.Vertex[0], *VP.Vertex[1], *VP.Vertex[2]) && mStabbedFace.mDistance<mTMax[i])
+		{
+			mNbIntersections++;
+			mFlags |= OPC_CONTACT;
+			mStabbedFace.mFaceID = prim_index;
+
+			// Keep the closest hit, and shrink the ray accordingly
+			mHits[i]	= mStabbedFace;
+			mTMax[i]	= mStabbedFace.mDistance;
+			mHitMask	|= 1<<i;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive packet stabbing query for normal AABB trees.
+ *	\param		node	[in] current collision node
+ *	\param		mask	[in] active rays
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayPacketCollider::_Stab(const AABBCollisionNode* node, udword mask)
+{
+	// A single ray left: the packet has diverged
+	if(!(mask & (mask-1)))
+	{
+		_StabSingle(node, GetRayIndex(mask));
+		return;
+	}
+
+	mask = PacketAABBOverlap(node->mAABB.mCenter - node->mAABB.mExtents, node->mAABB.mCenter + node->mAABB.mExtents, mask);
+	if(!mask)	return;
+
+	if(node->IsLeaf())
+	{
+		_RayTri(node->GetPrimitive(), mask);
+	}
+	else
+	{
+		_Stab(node->GetPos(), mask);
+		_Stab(node->GetNeg(), mask);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive packet stabbing query for no-leaf AABB trees.
+ *	\param		node	[in] current collision node
+ *	\param		mask	[in] active rays
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayPacketCollider::_Stab(const AABBNoLeafNode* node, udword mask)
+{
+	// A single ray left: the packet has diverged
+	if(!(mask & (mask-1)))
+	{
+		_StabSingle(node, GetRayIndex(mask));
+		return;
+	}
+
+	mask = PacketAABBOverlap(node->mAABB.mCenter - node->mAABB.mExtents, node->mAABB.mCenter + node->mAABB.mExtents, mask);
+	if(!mask)	return;
+
+	if(node->HasPosLeaf())	_RayTri(node->GetPosPrimitive(), mask);
+	else					_Stab(node->GetPos(), mask);
+
+	if(node->HasNegLeaf())	_RayTri(node->GetNegPrimitive(), mask);
+	else					_Stab(node->GetNeg(), mask);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive packet stabbing query for vanilla AABB trees.
+ *	\param		node		[in] current collision node
+ *	\param		mask		[in] active rays
+ *	\param		box_indices	[out] (box index, ray mask) pairs
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayPacketCollider::_Stab(const AABBTreeNode* node, udword mask, Container& box_indices)
+{
+	mask = PacketAABBOverlap(node->GetAABB()->GetMin(), node->GetAABB()->GetMax(), mask);
+	if(!mask)	return;
+
+	if(node->IsLeaf())
+	{
+		mFlags |= OPC_CONTACT;
+
+		const udword* Prims = node->GetPrimitives();
+		const udword NbPrims = node->GetNbPrimitives();
+		for(udword i=0;i<NbPrims;i++)
+			box_indices.Add(Prims[i]).Add(mask);
+	}
+	else
+	{
+		_Stab(node->GetPos(), mask, box_indices);
+		_Stab(node->GetNeg(), mask, box_indices);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive packet stabbing query for dynamic AABB trees.
+ *	\param		nodes		[in] tree nodes
+ *	\param		index		[in] current node index
+ *	\param		mask		[in] active rays
+ *	\param		user_data	[out] (user data, ray mask) pairs
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayPacketCollider::_Stab(const DynamicAABBTreeNode* nodes, udword index, udword mask, Container& user_data)
+{
+	const DynamicAABBTreeNode& Node = nodes[index];
+	mask = PacketAABBOverlap(Node.mBox.GetMin(), Node.mBox.GetMax(), mask);
+	if(!mask)	return;
+
+	if(Node.IsLeaf())
+	{
+		mFlags |= OPC_CONTACT;
+		user_data.Add(Node.mUserData).Add(mask);
+	}
+	else
+	{
+		_Stab(nodes, Node.mChildren[0], mask, user_data);
+		_Stab(nodes, Node.mChildren[1], mask, user_data);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive single-ray stabbing query for normal AABB trees, used once the packet has diverged.
+ *	\param		node	[in] current collision node
+ *	\param		i		[in] ray index
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayPacketCollider::_StabSingle(const AABBCollisionNode* node, udword i)
+{
+	// Stats
+	mNbRayBVTests++;
+
+	if(!SingleRayAABBOverlap(node->mAABB.mCenter - node->mAABB.mExtents, node->mAABB.mCenter + node->mAABB.mExtents, i))	return;
+
+	if(node->IsLeaf())
+	{
+		_RayTri(node->GetPrimitive(), 1<<i);
+	}
+	else
+	{
+		_StabSingle(node->GetPos(), i);
+		_StabSingle(node->GetNeg(), i);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive single-ray stabbing query for no-leaf AABB trees, used once the packet has diverged.
+ *	\param		node	[in] current collision node
+ *	\param		i		[in] ray index
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void RayPacketCollider::_StabSingle(const AABBNoLeafNode* node, udword i)
+{
+	// Stats
+	mNbRayBVTests++;
+
+	if(!SingleRayAABBOverlap(node->mAABB.mCenter - node->mAABB.mExtents, node->mAABB.mCenter + node->mAABB.mExtents, i))	return;
+
+	if(node->HasPosLeaf())	_RayTri(node->GetPosPrimitive(), 1<<i);
+	else					_StabSingle(node->GetPos(), i);
+
+	if(node->HasNegLeaf())	_RayTri(node->GetNegPrimitive(), 1<<i);
+	else					_StabSingle(node->GetNeg(), i);
+}
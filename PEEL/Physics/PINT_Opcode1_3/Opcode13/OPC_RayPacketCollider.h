@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/*
+ *	OPCODE - Optimized Collision Detection
+ *	Copyright (C) 2001 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/Opcode.htm
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Contains code for a ray-packet collider [PEEL].
+ *	\file		OPC_RayPacketCollider.h
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Include Guard
+#ifndef __OPC_RAYPACKETCOLLIDER_H__
+#define __OPC_RAYPACKETCOLLIDER_H__
+
+	//! Max number of rays in a packet
+	#define OPC_MAX_PACKET_SIZE	16
+
+	//! A packet of rays, processed together by the RayPacketCollider
+	struct OPCODE_API RayPacket
+	{
+				udword		mNbRays;							//!< Number of rays in the packet, up to OPC_MAX_PACKET_SIZE
+				Point		mOrigin[OPC_MAX_PACKET_SIZE];		//!< Ray origins
+				Point		mDir[OPC_MAX_PACKET_SIZE];			//!< Ray directions (normalized)
+	};
+
+	class OPCODE_API RayPacketCollider : public RayCollider
+	{
+		public:
+		// Constructor / Destructor
+											RayPacketCollider();
+		virtual								~RayPacketCollider();
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Packet stabbing query for vanilla AABB trees, typically a scene tree full of mesh boxes. Touched boxes are reported
+		 *	as (box index, ray mask) pairs, where the ray mask tells which rays of the packet touched the box.
+		 *
+		 *	\param		packet			[in] rays in world space
+		 *	\param		max_dists		[in] one max distance per ray
+		 *	\param		active_mask		[in] bit i set if ray i must be processed
+		 *	\param		tree			[in] AABB tree
+		 *	\param		box_indices		[out] (box index, ray mask) pairs
+		 *	\return		true if success
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+							bool			Collide(const RayPacket& packet, const float* max_dists, udword active_mask, const AABBTree* tree, Container& box_indices);
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Packet stabbing query for dynamic AABB trees. Same as above, except touched objects are reported as (user data, ray
+		 *	mask) pairs.
+		 *
+		 *	\param		packet			[in] rays in world space
+		 *	\param		max_dists		[in] one max distance per ray
+		 *	\param		active_mask		[in] bit i set if ray i must be processed
+		 *	\param		tree			[in] dynamic AABB tree
+		 *	\param		user_data		[out] (user data, ray mask) pairs
+		 *	\return		true if success
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+							bool			Collide(const RayPacket& packet, const float* max_dists, udword active_mask, const DynamicAABBTree* tree, Container& user_data);
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Closest-hit packet stabbing query for generic OPCODE models. Normal and no-leaf trees are traversed with the whole
+		 *	packet, other trees fall back to one RayCollider query per ray.
+		 *
+		 *	\param		packet			[in] rays in world space
+		 *	\param		active_mask		[in] bit i set if ray i must be processed
+		 *	\param		model			[in] Opcode model to collide with
+		 *	\param		world			[in] model's world matrix, or null
+		 *	\param		hits			[in/out] one closest hit per ray. Input distances are used as max distances.
+		 *	\return		mask of rays whose closest hit has been updated
+		 *	\warning	SCALE NOT SUPPORTED. The matrices must contain rotation & translation parts only.
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+							udword			Collide(const RayPacket& packet, udword active_mask, const Model& model, const Matrix4x4* world, CollisionFace* hits);
+
+		// Stats
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Stats: gets the number of packet-BV tests after a collision query.
+		 *	\return		the number of packet-BV tests performed during last query
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		inline_				udword			GetNbPacketBVTests()			const	{ return mNbPacketBVTests;	}
+
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Stats: gets the number of nodes culled for the whole packet by a single interval arithmetic test.
+		 *	\return		the number of culled nodes during last query
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		inline_				udword			GetNbCulledNodes()				const	{ return mNbCulledNodes;	}
+
+		protected:
+		// Rays in local space, as SoA arrays for SIMD slab tests
+							float			mOX[OPC_MAX_PACKET_SIZE], mOY[OPC_MAX_PACKET_SIZE], mOZ[OPC_MAX_PACKET_SIZE];
+							float			mIX[OPC_MAX_PACKET_SIZE], mIY[OPC_MAX_PACKET_SIZE], mIZ[OPC_MAX_PACKET_SIZE];
+							float			mTMax[OPC_MAX_PACKET_SIZE];		//!< Current max distance of each ray
+							Point			mLocalOrigin[OPC_MAX_PACKET_SIZE];
+							Point			mLocalDir[OPC_MAX_PACKET_SIZE];
+		// Packet bounds, for interval arithmetic
+							Point			mOriginMin, mOriginMax;			//!< Bounds of active ray origins
+							Point			mInvDirMin, mInvDirMax;			//!< Bounds of active inverse directions
+							BOOL			mUseIA;							//!< All active rays have the same direction signs
+		// Closest hits
+							CollisionFace*	mHits;
+							udword			mHitMask;
+		// Stats
+							udword			mNbPacketBVTests;
+							udword			mNbCulledNodes;
+		// Internal methods
+							void			_Stab(const AABBCollisionNode* node, udword mask);
+							void			_Stab(const AABBNoLeafNode* node, udword mask);
+							void			_Stab(const AABBTreeNode* node, udword mask, Container& box_indices);
+							void			_Stab(const DynamicAABBTreeNode* nodes, udword index, udword mask, Container& user_data);
+							void			_StabSingle(const AABBCollisionNode* node, udword i);
+							void			_StabSingle(const AABBNoLeafNode* node, udword i);
+							void			_RayTri(udword prim_index, udword mask);
+			// Overlap tests
+							udword			PacketAABBOverlap(const Point& min, const Point& max, udword mask);
+		inline_				BOOL			SingleRayAABBOverlap(const Point& min, const Point& max, udword i)	const;
+			// Init methods
+							void			SetupPacket(const RayPacket& packet, udword active_mask, const Matrix4x4* world);
+	};
+
+#endif // __OPC_RAYPACKETCOLLIDER_H__
@@ -100,7 +100,14 @@ bool SphereCollider::Collide(SphereCache& cache, const Sphere& sphere, const Mod
 	// Init collision query
 	if(InitQuery(cache, sphere, worlds, worldm))	return true;
 
-	if(!model.HasLeafNodes())
+	if(model.IsWide())
+	{
+		const AABBWideTree* Tree = (const AABBWideTree*)model.GetTree();
+
+		// Perform collision query. Primitive tests are skipped or not at the leaves.
+		_Collide(Tree->GetNodes());
+	}
+	else if(!model.HasLeafNodes())
 	{
 		if(model.IsQuantized())
 		{
@@ -551,6 +558,62 @@ void SphereCollider::_CollideNoPrimitiveTest(const AABBQuantizedNoLeafNode* node
 	else					_CollideNoPrimitiveTest(node->GetNeg());
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive collision query for wide AABB trees [PEEL]. All children boxes are tested at once with SIMD.
+ *	\param		node	[in] current collision node
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void SphereCollider::_Collide(const AABBWideNode* node)
+{
+	// Stats: one SIMD test for all children
+	mNbVolumeBVTests++;
+
+	const __m128 CX = _mm_load1_ps(&mCenter.x);
+	const __m128 CY = _mm_load1_ps(&mCenter.y);
+	const __m128 CZ = _mm_load1_ps(&mCenter.z);
+	const __m128 Zero = _mm_setzero_ps();
+
+	// Squared distance from the sphere center to each box. Empty slots have inverted boxes, i.e. infinite distances.
+	const __m128 DX = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node->mMinX), CX), _mm_sub_ps(CX, _mm_loadu_ps(node->mMaxX))), Zero);
+	const __m128 DY = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node->mMinY), CY), _mm_sub_ps(CY, _mm_loadu_ps(node->mMaxY))), Zero);
+	const __m128 DZ = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node->mMinZ), CZ), _mm_sub_ps(CZ, _mm_loadu_ps(node->mMaxZ))), Zero);
+	const __m128 D2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(DX, DX), _mm_mul_ps(DY, DY)), _mm_mul_ps(DZ, DZ));
+	const udword Mask = _mm_movemask_ps(_mm_cmple_ps(D2, _mm_load1_ps(&mRadius2)));
+	if(!Mask)	return;
+
+	for(udword i=0;i<OPC_WIDE_NB_CHILDREN;i++)
+	{
+		if(!(Mask & (1<<i)) || node->IsEmpty(i))	continue;
+
+		if(node->IsLeaf(i))
+		{
+			if(SkipPrimitiveTests())
+			{
+				SET_CONTACT(node->GetPrimitive(i), OPC_CONTACT)
+			}
+			else
+			{
+				SPHERE_PRIM(node->GetPrimitive(i), OPC_CONTACT)
+			}
+		}
+		else
+		{
+			Point Center, Extents;
+			node->GetCenter(i, Center);
+			node->GetExtents(i, Extents);
+			if(SphereContainsBox(Center, Extents))
+			{
+				mFlags |= OPC_CONTACT;
+				_Dump(node->GetChild(i));
+			}
+			else _Collide(node->GetChild(i));
+		}
+
+		if(ContactFound()) return;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /**
  *	Recursive collision query for vanilla AABB trees.
@@ -577,6 +640,62 @@ void SphereCollider::_Collide(const AABBTreeNode* node)
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Collision query for dynamic AABB trees [PEEL]. The touched primitives are the user data of the touched objects.
+ *	\param		cache		[in/out] a sphere cache
+ *	\param		sphere		[in] collision sphere in world space
+ *	\param		tree		[in] dynamic AABB tree
+ *	\return		true if success
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool SphereCollider::Collide(SphereCache& cache, const Sphere& sphere, const DynamicAABBTree* tree)
+{
+	// Same as for vanilla AABB trees, we don't have real primitives here
+	ASSERT( !(FirstContactEnabled() && TemporalCoherenceEnabled()) );
+
+	// Checkings
+	if(!tree)	return false;
+
+	// Init collision query
+	if(InitQuery(cache, sphere))	return true;
+
+	// Perform collision query
+	if(tree->GetRoot()!=INVALID_ID)
+		_Collide(tree->GetNodes(), tree->GetRoot());
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Recursive collision query for dynamic AABB trees [PEEL].
+ *	\param		nodes	[in] tree nodes
+ *	\param		index	[in] current node index
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void SphereCollider::_Collide(const DynamicAABBTreeNode* nodes, udword index)
+{
+	const DynamicAABBTreeNode& Node = nodes[index];
+
+	// Perform Sphere-AABB overlap test
+	Point Center, Extents;
+	Node.mBox.GetCenter(Center);
+	Node.mBox.GetExtents(Extents);
+	if(!SphereAABBOverlap(Center, Extents))	return;
+
+	if(Node.IsLeaf())
+	{
+		mFlags |= OPC_CONTACT;
+		mTouchedPrimitives->Add(Node.mUserData);
+	}
+	else
+	{
+		_Collide(nodes, Node.mChildren[0]);
+		_Collide(nodes, Node.mChildren[1]);
+	}
+}
+
 
 
 
@@ -59,6 +59,8 @@
 
 		// 
 							bool			Collide(SphereCache& cache, const Sphere& sphere, const AABBTree* tree);
+		// [PEEL]
+							bool			Collide(SphereCache& cache, const Sphere& sphere, const DynamicAABBTree* tree);
 		protected:
 		// Sphere in model space
 							Point			mCenter;			//!< Sphere center
@@ -68,7 +70,9 @@
 							void			_Collide(const AABBNoLeafNode* node);
 							void			_Collide(const AABBQuantizedNode* node);
 							void			_Collide(const AABBQuantizedNoLeafNode* node);
+							void			_Collide(const AABBWideNode* node);
 							void			_Collide(const AABBTreeNode* node);
+							void			_Collide(const DynamicAABBTreeNode* nodes, udword index);
 							void			_CollideNoPrimitiveTest(const AABBCollisionNode* node);
 							void			_CollideNoPrimitiveTest(const AABBNoLeafNode* node);
 							void			_CollideNoPrimitiveTest(const AABBQuantizedNode* node);
@@ -31,6 +31,8 @@
 		SPLIT_FIFTY				= (1<<4),		//!< Arbitrary 50-50 split
 		// Node split
 		SPLIT_GEOM_CENTER		= (1<<5),		//!< Split at geometric center (else split in the middle)
+		// Primitive split, cost-based
+		SPLIT_SAH				= (1<<6),		//!< Binned surface area heuristic (takes precedence over other rules) [PEEL]
 		//
 		SPLIT_FORCE_DWORD		= 0x7fffffff
 	};
@@ -51,6 +53,7 @@
 													AABBTreeBuilder() :
 														mNbPrimitives(0),
 														mNodeBase(null),
+														mPrimitiveBoxes(null),
 														mCount(0),
 														mNbInvalidSplits(0)		{}
 		//! Destructor
@@ -110,9 +113,22 @@
 														return TRUE;
 													}
 
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		/**
+		 *	Computes the AABB of a single primitive. Used by SPLIT_SAH.
+		 *	\param		index			[in] index of the primitive
+		 *	\param		box				[out] AABB enclosing the primitive
+		 */
+		///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+		virtual						void			GetPrimitiveBox(udword index, AABB& box)	const
+													{
+														ComputeGlobalBox(&index, 1, box);
+													}
+
 									BuildSettings	mSettings;			//!< Splitting rules & split limit [Opcode 1.3]
 									udword			mNbPrimitives;		//!< Total number of primitives.
 									void*			mNodeBase;			//!< Address of node pool [Opcode 1.3]
+									const AABB*		mPrimitiveBoxes;	//!< Primitive boxes, cached during SPLIT_SAH builds [PEEL]
 		// Stats
 		inline_						void			SetCount(udword nb)				{ mCount=nb;				}
 		inline_						void			IncreaseCount(udword nb)		{ mCount+=nb;				}
@@ -151,6 +167,7 @@
 
 		override(AABBTreeBuilder)	bool			ComputeGlobalBox(const udword* primitives, udword nb_prims, AABB& global_box)	const;
 		override(AABBTreeBuilder)	float			GetSplittingValue(udword index, udword axis)									const;
+		override(AABBTreeBuilder)	void			GetPrimitiveBox(udword index, AABB& box)										const	{ box = mAABBArray[index];	}
 
 		const						AABB*			mAABBArray;			//!< Shortcut to an app-controlled array of AABBs.
 	};
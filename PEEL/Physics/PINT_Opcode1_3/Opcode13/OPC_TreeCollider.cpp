@@ -171,6 +171,9 @@ bool AABBTreeCollider::Collide(BVTCache& cache, const Matrix4x4* world0, const M
 	// Checkings
 	if(!Setup(cache.Model0->GetMeshInterface(), cache.Model1->GetMeshInterface()))	return false;
 
+	// Wide trees aren't supported by this collider [PEEL]
+	if(cache.Model0->IsWide() || cache.Model1->IsWide())	return false;
+
 	// Simple double-dispatch
 	bool Status;
 	if(!cache.Model0->HasLeafNodes())
@@ -102,3 +102,17 @@ IMPLEMENT_NOLEAFDUMP(AABBQuantizedNoLeafNode)
 
 IMPLEMENT_LEAFDUMP(AABBCollisionNode)
 IMPLEMENT_LEAFDUMP(AABBQuantizedNode)
+
+// Wide trees [PEEL]
+void VolumeCollider::_Dump(const AABBWideNode* node)
+{
+	for(udword i=0;i<OPC_WIDE_NB_CHILDREN;i++)
+	{
+		if(node->IsEmpty(i))	break;
+
+		if(node->IsLeaf(i))	mTouchedPrimitives->Add(node->GetPrimitive(i));
+		else				_Dump(node->GetChild(i));
+
+		if(ContactFound()) return;
+	}
+}
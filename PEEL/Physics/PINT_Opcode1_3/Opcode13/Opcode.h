@@ -51,6 +51,9 @@
 
 //	#include "OPC_IceHook.h"
 
+	// SSE, for wide trees [PEEL]
+	#include <xmmintrin.h>
+
 	namespace Opcode
 	{
 		// Bulk-of-the-work
@@ -62,6 +65,7 @@
 		// Trees
 		#include "OPC_AABBTree.h"
 		#include "OPC_OptimizedTree.h"
+		#include "OPC_DynamicAABBTree.h"
 		// Models
 		#include "OPC_BaseModel.h"
 		#include "OPC_Model.h"
@@ -71,6 +75,7 @@
 		#include "OPC_VolumeCollider.h"
 		#include "OPC_TreeCollider.h"
 		#include "OPC_RayCollider.h"
+		#include "OPC_RayPacketCollider.h"
 		#include "OPC_SphereCollider.h"
 		#include "OPC_OBBCollider.h"
 		#include "OPC_AABBCollider.h"
@@ -9,61 +9,112 @@
 #include "stdafx.h"
 #include "PINT_Opcode13.h"
 #include "..\PINT_Common\PINT_Common.h"
+#include "..\PINT_Common\PINT_CommonAllocator.h"
 #include "..\PINT_Common\PINT_IceAllocatorSwitch.h"
 
 static	bool	gDrawMeshAABBs	= false;
 static	bool	gQuantized		= false;
 static	bool	gNoLeaf			= false;
+static	bool	gSAH			= false;
+static	bool	gWide			= false;
+static	udword	gRayPacketSize	= 1;
+static	bool	gSortRays		= false;
 
-// For some insane reason this function was missing in Opcode 1.3 (only from the OBB collider!) and I never noticed!
-class SceneOBBCollider : public OBBCollider
+static udword GetBuildRules()
 {
-	public:
+	return gSAH ? SPLIT_SAH : SPLIT_SPLATTER_POINTS|SPLIT_GEOM_CENTER;
+}
+
+static const char* GetBuildRulesName()
+{
+	return gSAH ? "SAH" : "Splatter points / Geom center";
+}
 
-	bool	Collide(OBBCache& cache, const OBB& box, const AABBTree* tree);
-	void	_Collide(const AABBTreeNode* node);
+// Triangles of a box mesh, indexing the 8 points returned by AABB::ComputePoints(). Faces are counter-clockwise seen from
+// outside, as expected by culled raycasts.
+static const udword gBoxTris[] = {
+	0, 2, 1,	0, 3, 2,	// -Z
+	4, 5, 6,	4, 6, 7,	// +Z
+	0, 1, 5,	0, 5, 4,	// -Y
+	3, 6, 2,	3, 7, 6,	// +Y
+	0, 7, 3,	0, 4, 7,	// -X
+	1, 2, 6,	1, 6, 5,	// +X
 };
 
-bool SceneOBBCollider::Collide(OBBCache& cache, const OBB& box, const AABBTree* tree)
-{
-	// This is typically called for a scene tree, full of -AABBs-, not full of triangles.
-	// So we don't really have "primitives" to deal with. Hence it doesn't work with
-	// "FirstContact" + "TemporalCoherence".
-	ASSERT( !(FirstContactEnabled() && TemporalCoherenceEnabled()) );
+#define CAPSULE_NB_RINGS	6	// Per hemisphere, including the equator
+#define CAPSULE_NB_SECTORS	12
 
-	// Checkings
-	if(!tree)	return false;
+// Spheres & capsules are turned into meshes too: a UV-sphere along Y, whose hemispheres are moved apart by the capsule's
+// half-height (0 for spheres). Vertices are on the actual surface, so the mesh is slightly inside it. Faces are
+// counter-clockwise seen from outside, like gBoxTris.
+class CapsuleMesh
+{
+	public:
+	CapsuleMesh(float radius, float half_height) : mNbVerts(0), mNbTris(0)
+	{
+		// Rings from top to bottom. The equator is duplicated for capsules, to make the cylinder part.
+		float RingY[CAPSULE_NB_RINGS*2];
+		float RingRadius[CAPSULE_NB_RINGS*2];
+		udword NbRings = 0;
+		for(udword i=1;i<=CAPSULE_NB_RINGS;i++)
+		{
+			const float Angle = float(i)*HALFPI/float(CAPSULE_NB_RINGS);
+			RingY[NbRings] = half_height + radius*cosf(Angle);
+			RingRadius[NbRings++] = radius*sinf(Angle);
+		}
+		const udword FirstLowerRing = half_height!=0.0f ? CAPSULE_NB_RINGS : CAPSULE_NB_RINGS-1;
+		for(udword i=FirstLowerRing;i>0;i--)
+		{
+			const float Angle = float(i)*HALFPI/float(CAPSULE_NB_RINGS);
+			RingY[NbRings] = -half_height - radius*cosf(Angle);
+			RingRadius[NbRings++] = radius*sinf(Angle);
+		}
 
-	// Init collision query
-	if(InitQuery(cache, box))	return true;
+		const udword Top = mNbVerts;
+		mVerts[mNbVerts++] = Point(0.0f, half_height + radius, 0.0f);
+		for(udword i=0;i<NbRings;i++)
+		{
+			for(udword j=0;j<CAPSULE_NB_SECTORS;j++)
+			{
+				const float Angle = float(j)*TWOPI/float(CAPSULE_NB_SECTORS);
+				mVerts[mNbVerts++] = Point(RingRadius[i]*cosf(Angle), RingY[i], RingRadius[i]*sinf(Angle));
+			}
+		}
+		const udword Bottom = mNbVerts;
+		mVerts[mNbVerts++] = Point(0.0f, -half_height - radius, 0.0f);
 
-	// Perform collision query
-	_Collide(tree);
+		const udword LastRing = 1 + (NbRings-1)*CAPSULE_NB_SECTORS;
+		for(udword j=0;j<CAPSULE_NB_SECTORS;j++)
+		{
+			const udword Next = (j+1)%CAPSULE_NB_SECTORS;
+			AddTriangle(Top, 1 + Next, 1 + j);
+			AddTriangle(Bottom, LastRing + j, LastRing + Next);
+			for(udword i=0;i<NbRings-1;i++)
+			{
+				const udword Upper = 1 + i*CAPSULE_NB_SECTORS;
+				const udword Lower = Upper + CAPSULE_NB_SECTORS;
+				AddTriangle(Upper + j, Upper + Next, Lower + j);
+				AddTriangle(Lower + j, Upper + Next, Lower + Next);
+			}
+		}
+	}
 
-	return true;
-}
+	inline_	SurfaceInterface	GetSurface()	const	{ return SurfaceInterface(mNbVerts, mVerts, mNbTris, mTris, null);	}
 
-void SceneOBBCollider::_Collide(const AABBTreeNode* node)
-{
-	// Perform OBB-AABB overlap test
-	Point Center, Extents;
-	node->GetAABB()->GetCenter(Center);
-	node->GetAABB()->GetExtents(Extents);
-	if(!BoxBoxOverlap(Extents, Center))	return;
+	private:
+	Point	mVerts[2 + CAPSULE_NB_RINGS*2*CAPSULE_NB_SECTORS];
+	udword	mTris[CAPSULE_NB_RINGS*4*CAPSULE_NB_SECTORS*3];
+	udword	mNbVerts;
+	udword	mNbTris;
 
-	if(node->IsLeaf() || OBBContainsBox(Center, Extents))
-	{
-		mFlags |= OPC_CONTACT;
-		mTouchedPrimitives->Add(node->GetPrimitives(), node->GetNbPrimitives());
-	}
-	else
+	inline_	void	AddTriangle(udword a, udword b, udword c)
 	{
-		_Collide(node->GetPos());
-		_Collide(node->GetNeg());
+		mTris[mNbTris*3+0] = a;
+		mTris[mNbTris*3+1] = b;
+		mTris[mNbTris*3+2] = c;
+		mNbTris++;
 	}
-}
-
-
+};
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -77,8 +128,9 @@ OpcodeMesh::~OpcodeMesh()
 
 ///////////////////////////////////////////////////////////////////////////////
 
-OpcodeActor::OpcodeActor()
+OpcodeActor::OpcodeActor() : mObject(null), mMesh(null), mIndex(INVALID_ID), mTreeHandle(INVALID_ID)
 {
+	mLocalTM.Identity();
 	mMeshTM.Identity();
 }
 
@@ -88,13 +140,24 @@ OpcodeActor::~OpcodeActor()
 
 ///////////////////////////////////////////////////////////////////////////////
 
-Opcode13Pint::Opcode13Pint() : mSceneTree(null)
+OpcodeObject::OpcodeObject() : mIndex(INVALID_ID)
+{
+	mPose.Identity();
+}
+
+OpcodeObject::~OpcodeObject()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Opcode13Pint::Opcode13Pint() : mNbSceneTreeUpdates(0), mSceneTreeBuildTime(0)
 {
 }
 
 Opcode13Pint::~Opcode13Pint()
 {
-	ASSERT(!mSceneTree);
+	ASSERT(!mSceneTree.GetNbObjects());
 }
 
 void Opcode13Pint::GetCaps(PintCaps& caps) const
@@ -103,13 +166,18 @@ void Opcode13Pint::GetCaps(PintCaps& caps) const
 	caps.mSupportRaycasts				= true;
 	caps.mSupportSphereOverlaps			= true;
 	caps.mSupportBoxOverlaps			= true;
+	caps.mSupportKinematics				= true;
 }
 
 void Opcode13Pint::Init(const PINT_WORLD_CREATE& desc)
 {
+	Common_SetAllocator(desc.GetAllocatorType(), desc.GetAllocTracking());
 	InitIceAllocator(GetName());
 
 	AllocSwitch _;
+
+	// Same rules as mesh trees, the scene tree only uses SPLIT_SAH from them
+	mSceneTree.SetBuildRules(GetBuildRules());
 }
 
 void Opcode13Pint::SetGravity(const Point& gravity)
@@ -121,7 +189,14 @@ void Opcode13Pint::Close()
 	{
 		AllocSwitch _;
 
-		DELETESINGLE(mSceneTree);
+		// Reported here rather than in UpdateSceneTree(), which runs within timed calls
+		if(mSceneTree.GetNbObjects())
+			printf("Opcode 1.3 dynamic scene tree (%s): %d objects, %d rebuilds, last rebuild: %d K-cycles, %d updates, height: %d, SAH cost: %f, %d bytes\n",
+				GetBuildRulesName(), mSceneTree.GetNbObjects(), mSceneTree.GetNbRebuilds(), mSceneTreeBuildTime/1024, mNbSceneTreeUpdates, mSceneTree.GetHeight(), mSceneTree.ComputeSAHCost(), mSceneTree.GetUsedBytes());
+		mNbSceneTreeUpdates = 0;
+		mSceneTreeBuildTime = 0;
+
+		mSceneTree.Release();
 
 		const udword NbMeshes = mMeshes.GetNbEntries();
 		for(udword i=0;i<NbMeshes;i++)
@@ -137,6 +212,14 @@ void Opcode13Pint::Close()
 			DELETESINGLE(Actor);
 		}
 
+		const udword NbObjects = mObjects.GetNbEntries();
+		for(udword i=0;i<NbObjects;i++)
+		{
+			OpcodeObject* Object = (OpcodeObject*)mObjects.GetEntries()[i];
+			DELETESINGLE(Object);
+		}
+
+		mObjects.Empty();
 		mActors.Empty();
 		mMeshes.Empty();
 		mWorldBoxes.Empty();
@@ -144,30 +227,35 @@ void Opcode13Pint::Close()
 	}
 
 	ReleaseIceAllocator();
+	Common_ReleaseAllocator();
+}
+
+// Objects are inserted, removed & moved incrementally in the scene tree. It is only rebuilt from scratch here, when its
+// quality has degraded too much.
+void Opcode13Pint::UpdateSceneTree()
+{
+	udword Time;
+	StartProfile(Time);
+		const bool Rebuilt = mSceneTree.RebuildIfNeeded();
+	EndProfile(Time);
+	if(Rebuilt)
+		mSceneTreeBuildTime = Time;
 }
 
 udword Opcode13Pint::Update(float dt)
 {
 	AllocSwitch _;
 
-	if(!mSceneTree)
-	{
-		mSceneTree = ICE_NEW(AABBTree);
-
-		const udword NbObjects = mActors.GetNbEntries();
-		const AABB* Boxes = (const AABB*)mWorldBoxes.GetEntries();
-
-		AABBTreeOfAABBsBuilder TB;
-		TB.mNbPrimitives	= NbObjects;
-		TB.mAABBArray		= Boxes;
-		TB.mSettings.mRules	= SPLIT_SPLATTER_POINTS|SPLIT_GEOM_CENTER;
-		TB.mSettings.mLimit	= 1;
-		bool Status = mSceneTree->Build(&TB);
-	}
+	UpdateSceneTree();
 
 	return GetIceAllocatorUsedMemory();
 }
 
+const PintAllocStats* Opcode13Pint::GetAllocStats()
+{
+	return GetIceAllocatorStats();
+}
+
 Point Opcode13Pint::GetMainColor()
 {
 	return Point(1.0f, 1.0f, 1.0f);
@@ -196,6 +284,51 @@ void Opcode13Pint::Render(PintRender& renderer)
 	}
 }
 
+// Meshes are shared between actors with the same renderer
+OpcodeMesh* Opcode13Pint::FindOrCreateMesh(const SurfaceInterface& surface, PintShapeRenderer* renderer, bool report_build)
+{
+	if(renderer)
+	{
+		const udword NbMeshes = mMeshes.GetNbEntries();
+		for(udword i=0;i<NbMeshes;i++)
+		{
+			OpcodeMesh* CurrentMesh = (OpcodeMesh*)mMeshes.GetEntry(i);
+			if(CurrentMesh->mRenderer==renderer)
+				return CurrentMesh;
+		}
+	}
+
+	OpcodeMesh* NewMesh = ICE_NEW(OpcodeMesh);
+	mMeshes.Add(udword(NewMesh));
+
+	NewMesh->mSurface.Init(surface.mNbFaces, surface.mNbVerts, surface.mVerts, (const IndexedTriangle*)surface.mDFaces);
+	ComputeAABB(NewMesh->mLocalBox, NewMesh->mSurface.GetVerts(), NewMesh->mSurface.GetNbVerts());
+
+	NewMesh->mMeshInterface.SetNbVertices(NewMesh->mSurface.GetNbVerts());
+	NewMesh->mMeshInterface.SetNbTriangles(NewMesh->mSurface.GetNbFaces());
+	NewMesh->mMeshInterface.SetPointers(NewMesh->mSurface.GetFaces(), NewMesh->mSurface.GetVerts());
+
+	OPCODECREATE opcodeCreate;
+	opcodeCreate.mIMesh				= &NewMesh->mMeshInterface;
+	opcodeCreate.mNoLeaf			= gNoLeaf;
+	opcodeCreate.mQuantized			= gQuantized;
+	opcodeCreate.mWide				= gWide;
+	opcodeCreate.mSettings.mLimit	= 1;
+	opcodeCreate.mSettings.mRules	= GetBuildRules();
+	opcodeCreate.mKeepOriginal		= false;
+
+	udword Time;
+	StartProfile(Time);
+		bool Status = NewMesh->mModel.Build(opcodeCreate);
+	EndProfile(Time);
+	ASSERT(Status);
+	if(report_build)
+		printf("Opcode 1.3 mesh (%d tris, %s%s): build: %d K-cycles, SAH cost: %f, %d bytes\n", NewMesh->mSurface.GetNbFaces(), GetBuildRulesName(), gWide ? ", wide" : "", Time/1024, NewMesh->mModel.GetSAHCost(), NewMesh->mModel.GetUsedBytes());
+
+	NewMesh->mRenderer = renderer;
+	return NewMesh;
+}
+
 PintObjectHandle Opcode13Pint::CreateObject(const PINT_OBJECT_CREATE& desc)
 {
 	AllocSwitch _;
@@ -204,17 +337,17 @@ PintObjectHandle Opcode13Pint::CreateObject(const PINT_OBJECT_CREATE& desc)
 	if(!NbShapes)
 		return null;
 
-	if(desc.mMass!=0.0f)
-		return null;
-
+	// Objects with a mass are accepted as well, but they are not simulated. They only move when their poses are set.
 	Matrix4x4 M = desc.mRotation;
 	M.SetTrans(desc.mPosition);
 
-	PintObjectHandle Handle = null;
+	// All the shapes of a compound share the same object, which is what the returned handle refers to
+	OpcodeObject* NewObject = null;
 
 	const PINT_SHAPE_CREATE* CurrentShape = desc.mShapes;
 	while(CurrentShape)
 	{
+		OpcodeMesh* NewMesh = null;
 		if(CurrentShape->mType==PINT_SHAPE_MESH)
 		{
 			const PINT_MESH_CREATE* MeshCreate = static_cast<const PINT_MESH_CREATE*>(CurrentShape);
@@ -222,69 +355,128 @@ PintObjectHandle Opcode13Pint::CreateObject(const PINT_OBJECT_CREATE& desc)
 			ASSERT(MeshCreate->mSurface.mNbFaces);
 			ASSERT(MeshCreate->mSurface.mDFaces);
 
-			Matrix4x4 M2 = CurrentShape->mLocalRot;
-			M2.SetTrans(CurrentShape->mLocalPos);
-
-			OpcodeMesh* NewMesh = null;
-			{
-				const udword NbMeshes = mMeshes.GetNbEntries();
-				for(udword i=0;i<NbMeshes;i++)
-				{
-					OpcodeMesh* CurrentMesh = (OpcodeMesh*)mMeshes.GetEntry(i);
-					if(CurrentMesh->mRenderer==CurrentShape->mRenderer)
-					{
-						NewMesh = CurrentMesh;
-						break;
-					}
-				}
-			}
+			NewMesh = FindOrCreateMesh(MeshCreate->mSurface, CurrentShape->mRenderer, true);
+		}
+		else if(CurrentShape->mType==PINT_SHAPE_BOX)
+		{
+			// Boxes are turned into 12-triangle meshes
+			const PINT_BOX_CREATE* BoxCreate = static_cast<const PINT_BOX_CREATE*>(CurrentShape);
 
-			DELETESINGLE(mSceneTree);
-			if(!NewMesh)
-			{
-				NewMesh = ICE_NEW(OpcodeMesh);
-				mMeshes.Add(udword(NewMesh));
+			AABB Box;
+			Box.SetCenterExtents(Point(0.0f, 0.0f, 0.0f), BoxCreate->mExtents);
+			Point BoxVerts[8];
+			Box.ComputePoints(BoxVerts);
 
-				NewMesh->mSurface.Init(MeshCreate->mSurface.mNbFaces, MeshCreate->mSurface.mNbVerts, MeshCreate->mSurface.mVerts, (const IndexedTriangle*)MeshCreate->mSurface.mDFaces);
+			const SurfaceInterface BoxSurface(8, BoxVerts, 12, gBoxTris, null);
+			NewMesh = FindOrCreateMesh(BoxSurface, CurrentShape->mRenderer, false);
+		}
+		else if(CurrentShape->mType==PINT_SHAPE_SPHERE)
+		{
+			const PINT_SPHERE_CREATE* SphereCreate = static_cast<const PINT_SPHERE_CREATE*>(CurrentShape);
 
-				NewMesh->mMeshInterface.SetNbVertices(NewMesh->mSurface.GetNbVerts());
-				NewMesh->mMeshInterface.SetNbTriangles(NewMesh->mSurface.GetNbFaces());
-				NewMesh->mMeshInterface.SetPointers(NewMesh->mSurface.GetFaces(), NewMesh->mSurface.GetVerts());
+			const CapsuleMesh Sphere(SphereCreate->mRadius, 0.0f);
+			NewMesh = FindOrCreateMesh(Sphere.GetSurface(), CurrentShape->mRenderer, false);
+		}
+		else if(CurrentShape->mType==PINT_SHAPE_CAPSULE)
+		{
+			const PINT_CAPSULE_CREATE* CapsuleCreate = static_cast<const PINT_CAPSULE_CREATE*>(CurrentShape);
 
-				OPCODECREATE opcodeCreate;
-				opcodeCreate.mIMesh				= &NewMesh->mMeshInterface;
-				opcodeCreate.mNoLeaf			= gNoLeaf;
-				opcodeCreate.mQuantized			= gQuantized;
-				opcodeCreate.mSettings.mLimit	= 1;
-				opcodeCreate.mSettings.mRules	= Opcode::SPLIT_SPLATTER_POINTS | Opcode::SPLIT_GEOM_CENTER;
-				opcodeCreate.mKeepOriginal		= false;
+			const CapsuleMesh Capsule(CapsuleCreate->mRadius, CapsuleCreate->mHalfHeight);
+			NewMesh = FindOrCreateMesh(Capsule.GetSurface(), CurrentShape->mRenderer, false);
+		}
 
-				bool Status = NewMesh->mModel.Build(opcodeCreate);
-				ASSERT(Status);
+		if(NewMesh)
+		{
+			Matrix4x4 M2 = CurrentShape->mLocalRot;
+			M2.SetTrans(CurrentShape->mLocalPos);
 
-				NewMesh->mRenderer = CurrentShape->mRenderer;
+			if(!NewObject)
+			{
+				NewObject = ICE_NEW(OpcodeObject);
+				NewObject->mPose = M;
+				NewObject->mIndex = mObjects.GetNbEntries();
+				mObjects.Add(udword(NewObject));
 			}
 
 			OpcodeActor* NewActor = ICE_NEW(OpcodeActor);
-			Handle = NewActor;	// #### this is wrong
+			NewActor->mIndex = mActors.GetNbEntries();
 			mActors.Add(udword(NewActor));
+			NewObject->mActors.Add(udword(NewActor));
+			NewActor->mObject = NewObject;
 			NewActor->mMesh = NewMesh;
+			NewActor->mLocalTM = M2;
 			NewActor->mMeshTM = M * M2;
 
 			{
 				AABB* Memory = (AABB*)mWorldBoxes.Reserve(sizeof(AABB)/sizeof(udword));
 				ComputeAABB(*Memory, NewMesh->mSurface.GetVerts(), NewMesh->mSurface.GetNbVerts(), NewActor->mMeshTM);
+				NewActor->mTreeHandle = mSceneTree.AddObject(*Memory, NewActor->mIndex);
 			}
 		}
 		CurrentShape = CurrentShape->mNext;
 	}
 
-	return Handle;
+	return NewObject;
+}
+
+// Swaps the last actor & box into the released slot. Meshes are kept, they can be shared with other actors.
+void Opcode13Pint::RemoveActor(OpcodeActor* actor)
+{
+	const udword Index = actor->mIndex;
+	const udword LastIndex = mActors.GetNbEntries() - 1;
+	ASSERT(Index<=LastIndex);
+	ASSERT(mActors.GetEntry(Index)==udword(actor));
+
+	mSceneTree.RemoveObject(actor->mTreeHandle);
+
+	AABB* Boxes = (AABB*)mWorldBoxes.GetEntries();
+	if(Index!=LastIndex)
+	{
+		OpcodeActor* LastActor = (OpcodeActor*)mActors.GetEntry(LastIndex);
+		LastActor->mIndex = Index;
+		Boxes[Index] = Boxes[LastIndex];
+		mSceneTree.SetUserData(LastActor->mTreeHandle, Index);
+	}
+	mActors.DeleteIndex(Index);
+	mWorldBoxes.ForceSize(mWorldBoxes.GetNbEntries() - sizeof(AABB)/sizeof(udword));
+
+	DELETESINGLE(actor);
 }
 
 bool Opcode13Pint::ReleaseObject(PintObjectHandle handle)
 {
-	return false;
+	return ReleaseObjects(1, &handle)!=0;
+}
+
+udword Opcode13Pint::ReleaseObjects(udword nb, const PintObjectHandle* handles)
+{
+	AllocSwitch _;
+
+	udword NbReleased = 0;
+	for(udword i=0;i<nb;i++)
+	{
+		OpcodeObject* Object = (OpcodeObject*)handles[i];
+		if(Object)
+		{
+			const udword NbActors = Object->mActors.GetNbEntries();
+			for(udword j=0;j<NbActors;j++)
+				RemoveActor((OpcodeActor*)Object->mActors.GetEntry(j));
+
+			// Swaps the last object into the released slot, like RemoveActor()
+			const udword Index = Object->mIndex;
+			const udword LastIndex = mObjects.GetNbEntries() - 1;
+			ASSERT(mObjects.GetEntry(Index)==udword(Object));
+			if(Index!=LastIndex)
+			{
+				OpcodeObject* LastObject = (OpcodeObject*)mObjects.GetEntry(LastIndex);
+				LastObject->mIndex = Index;
+			}
+			mObjects.DeleteIndex(Index);
+			DELETESINGLE(Object);
+			NbReleased++;
+		}
+	}
+	return NbReleased;
 }
 
 PintJointHandle Opcode13Pint::CreateJoint(const PINT_JOINT_CREATE& desc)
@@ -292,6 +484,82 @@ PintJointHandle Opcode13Pint::CreateJoint(const PINT_JOINT_CREATE& desc)
 	return null;
 }
 
+static inline_ PR GetObjectPose(const OpcodeObject* object)
+{
+	const Matrix3x3 Rot = object->mPose;
+	const Quat Q = Rot;
+	return PR(object->mPose.GetTrans(), Q);
+}
+
+PR Opcode13Pint::GetWorldTransform(PintObjectHandle handle)
+{
+	const OpcodeObject* Object = (const OpcodeObject*)handle;
+	ASSERT(Object);
+	return GetObjectPose(Object);
+}
+
+void Opcode13Pint::GetWorldTransforms(udword nb, const PintObjectHandle* handles, PR* poses)
+{
+	while(nb--)
+		*poses++ = GetObjectPose((const OpcodeObject*)*handles++);
+}
+
+udword Opcode13Pint::GetActiveTransforms(udword max_nb, PintObjectHandle* handles, Point* positions, Quat* rotations)
+{
+	// Nothing is simulated here, objects only move when their poses are set
+	return 0;
+}
+
+// Moves all the actors of an object. The scene tree only needs an update when a new box leaves the actor's fat box.
+void Opcode13Pint::SetObjectPose(OpcodeObject* object, const Matrix4x4& pose)
+{
+	object->mPose = pose;
+
+	AABB* Boxes = (AABB*)mWorldBoxes.GetEntries();
+	const udword NbActors = object->mActors.GetNbEntries();
+	for(udword i=0;i<NbActors;i++)
+	{
+		OpcodeActor* Actor = (OpcodeActor*)object->mActors.GetEntry(i);
+		Actor->mMeshTM = pose * Actor->mLocalTM;
+
+		AABB& Box = Boxes[Actor->mIndex];
+		Actor->mMesh->mLocalBox.Rotate(Actor->mMeshTM, Box);
+		if(mSceneTree.UpdateObject(Actor->mTreeHandle, Box))
+			mNbSceneTreeUpdates++;
+	}
+}
+
+void Opcode13Pint::SetWorldTransform(PintObjectHandle handle, const PR& pose)
+{
+	AllocSwitch _;
+
+	OpcodeObject* Object = (OpcodeObject*)handle;
+	ASSERT(Object);
+
+	Matrix4x4 M = pose.mRot;
+	M.SetTrans(pose.mPos);
+	SetObjectPose(Object, M);
+}
+
+bool Opcode13Pint::SetKinematicPose(PintObjectHandle handle, const Point& pos)
+{
+	AllocSwitch _;
+
+	OpcodeObject* Object = (OpcodeObject*)handle;
+	ASSERT(Object);
+
+	Matrix4x4 M = Object->mPose;
+	M.SetTrans(pos);
+	SetObjectPose(Object, M);
+	return true;
+}
+
+bool Opcode13Pint::SetKinematicPose(PintObjectHandle handle, const PR& pr)
+{
+	SetWorldTransform(handle, pr);
+	return true;
+}
+
 void Opcode13Pint::SetDisabledGroups(udword nb_groups, const PintDisabledGroups* groups)
 {
 }
@@ -321,17 +589,187 @@ void Opcode13Pint::ReleaseSQThreadContext(PintSQThreadContext context)
 	DELETESINGLE(C);
 }
 
+static void FillRaycastHit(PintRaycastHit& dest, const OpcodeActor* touched_actor, const CollisionFace& hit)
+{
+	const OpcodeMesh* TouchedMesh = touched_actor->mMesh;
+
+	dest.mObject		= (PintObjectHandle)touched_actor->mObject;
+	dest.mDistance		= hit.mDistance;
+	dest.mTriangleIndex	= hit.mFaceID;
+
+	const Point* V = TouchedMesh->mMeshInterface.GetVerts();
+	const IndexedTriangle& T = TouchedMesh->mMeshInterface.GetTris()[hit.mFaceID];
+	const Point& p0 = V[T.mRef[0]];
+	const Point& p1 = V[T.mRef[1]];
+	const Point& p2 = V[T.mRef[2]];
+
+	Point LocalPt;
+	ComputeBarycentricPoint(LocalPt, p0, p1, p2, hit.mU, hit.mV);
+	TransformPoint4x3(dest.mImpact, LocalPt, touched_actor->mMeshTM);
+
+	const Point LocalNormal = ((p0-p1)^(p0-p2)).Normalize();
+	TransformPoint3x3(dest.mNormal, LocalNormal, touched_actor->mMeshTM);
+}
+
+// Spreads the 10 low bits of n so that there are two zero bits between each of them
+static inline_ udword SpreadBits3(udword n)
+{
+	n &= 0x000003ff;
+	n = (n ^ (n << 16)) & 0xff0000ff;
+	n = (n ^ (n <<  8)) & 0x0300f00f;
+	n = (n ^ (n <<  4)) & 0x030c30c3;
+	n = (n ^ (n <<  2)) & 0x09249249;
+	return n;
+}
+
+udword Opcode13Pint::BatchRaycastPackets(SQThreadContext* context, udword nb, PintRaycastHit* dest, const PintRaycastData* raycasts)
+{
+	// Stream mode: sort the rays by direction octant first, then by origin along a Morton curve. Incoherent rays
+	// are then gathered in packets of rays with the same direction signs, starting from nearby places.
+	const udword* Sorted = null;
+	if(gSortRays && nb>gRayPacketSize)
+	{
+		Point Min(MAX_FLOAT, MAX_FLOAT, MAX_FLOAT);
+		Point Max(MIN_FLOAT, MIN_FLOAT, MIN_FLOAT);
+		for(udword i=0;i<nb;i++)
+		{
+			Min.Min(raycasts[i].mOrigin);
+			Max.Max(raycasts[i].mOrigin);
+		}
+		const Point Extents = Max - Min;
+		const Point Scale(	Extents.x>0.0f ? 511.0f/Extents.x : 0.0f,
+							Extents.y>0.0f ? 511.0f/Extents.y : 0.0f,
+							Extents.z>0.0f ? 511.0f/Extents.z : 0.0f);
+
+		context->mRayKeys.Reset();
+		udword* Keys = context->mRayKeys.Reserve(nb);
+		for(udword i=0;i<nb;i++)
+		{
+			const Point& Dir = raycasts[i].mDir;
+			const udword Octant = (IS_NEGATIVE_FLOAT(Dir.x) ? 1 : 0) | (IS_NEGATIVE_FLOAT(Dir.y) ? 2 : 0) | (IS_NEGATIVE_FLOAT(Dir.z) ? 4 : 0);
+
+			const Point P = raycasts[i].mOrigin - Min;
+			const udword X = udword(P.x * Scale.x);
+			const udword Y = udword(P.y * Scale.y);
+			const udword Z = udword(P.z * Scale.z);
+			Keys[i] = (Octant<<27) | SpreadBits3(X) | (SpreadBits3(Y)<<1) | (SpreadBits3(Z)<<2);
+		}
+		Sorted = context->mRaySorter.Sort(Keys, nb, RADIX_UNSIGNED).GetRanks();
+	}
+
+	Container& mBoxIndices = context->mBoxIndices;
+
+	RayPacketCollider SceneRC;
+	SceneRC.SetFirstContact(false);
+	SceneRC.SetTemporalCoherence(false);
+	SceneRC.SetPrimitiveTests(true);
+
+	RayPacketCollider RC;
+	RC.SetFirstContact(false);
+	RC.SetTemporalCoherence(false);
+	RC.SetPrimitiveTests(true);
+	RC.SetCulling(true);
+
+	RayPacket Packet;
+	udword Indices[OPC_MAX_PACKET_SIZE];
+	float MaxDists[OPC_MAX_PACKET_SIZE];
+	CollisionFace Hits[OPC_MAX_PACKET_SIZE];
+	const OpcodeActor* TouchedActors[OPC_MAX_PACKET_SIZE];
+
+	udword NbHits = 0;
+	udword Offset = 0;
+	while(Offset<nb)
+	{
+		// Gather the next packet
+		const udword NbRays = MIN(gRayPacketSize, nb-Offset);
+		Packet.mNbRays = NbRays;
+		for(udword i=0;i<NbRays;i++)
+		{
+			const udword Index = Sorted ? Sorted[Offset+i] : Offset+i;
+			Indices[i]			= Index;
+			Packet.mOrigin[i]	= raycasts[Index].mOrigin;
+			Packet.mDir[i]		= raycasts[Index].mDir;
+			MaxDists[i]			= raycasts[Index].mMaxDist;
+			Hits[i].mDistance	= raycasts[Index].mMaxDist;
+			TouchedActors[i]	= null;
+		}
+		Offset += NbRays;
+
+		// Find the touched meshes, and which rays touched them
+		mBoxIndices.Reset();
+		SceneRC.Collide(Packet, MaxDists, (1<<NbRays)-1, &mSceneTree, mBoxIndices);
+
+		// Closest hits. The hit distances shrink from one mesh to the next.
+		const udword NbPairs = mBoxIndices.GetNbEntries()/2;
+		const udword* Pairs = mBoxIndices.GetEntries();
+		for(udword j=0;j<NbPairs;j++)
+		{
+			const OpcodeActor* Actor = (const OpcodeActor*)mActors.GetEntries()[Pairs[j*2]];
+
+			const udword HitMask = RC.Collide(Packet, Pairs[j*2+1], Actor->mMesh->mModel, &Actor->mMeshTM, Hits);
+			for(udword i=0;i<NbRays;i++)
+			{
+				if(HitMask & (1<<i))
+					TouchedActors[i] = Actor;
+			}
+		}
+
+		for(udword i=0;i<NbRays;i++)
+		{
+			PintRaycastHit& Dest = dest[Indices[i]];
+			if(TouchedActors[i])
+			{
+				NbHits++;
+				FillRaycastHit(Dest, TouchedActors[i], Hits[i]);
+			}
+			else
+			{
+				Dest.mObject = null;
+			}
+		}
+	}
+	return NbHits;
+}
+
+struct ClosestRaycastQuery
+{
+	const OpcodeActor**	mActors;
+	const Ray*			mRay;
+	RayCollider*		mRC;
+	CollisionFace*		mMemory;
+	// Results
+	const OpcodeActor*	mTouchedActor;
+	CollisionFace		mHit;
+};
+
+// Called by the scene tree traversal for each touched mesh, nearest-first. Returns the new closest distance.
+static float gClosestRaycastCallback(udword box_index, float max_dist, void* user_data)
+{
+	ClosestRaycastQuery* Query = reinterpret_cast<ClosestRaycastQuery*>(user_data);
+	const OpcodeActor* Actor = Query->mActors[box_index];
+
+	Query->mRC->SetMaxDist(max_dist);
+	Query->mMemory->mDistance = MAX_FLOAT;
+	if(Query->mRC->Collide(*Query->mRay, Actor->mMesh->mModel, &Actor->mMeshTM) && Query->mMemory->mDistance<max_dist)
+	{
+		Query->mHit = *Query->mMemory;
+		Query->mTouchedActor = Actor;
+		return Query->mHit.mDistance;
+	}
+	return max_dist;
+}
+
 udword Opcode13Pint::BatchRaycasts(PintSQThreadContext context, udword nb, PintRaycastHit* dest, const PintRaycastData* raycasts)
 {
 	AllocSwitch _;
 
-	ASSERT(mSceneTree);
+	UpdateSceneTree();
 
-	if(mSceneTree)
-	{
-		SQThreadContext* C = (SQThreadContext*)context;
-		Container& mBoxIndices = C->mBoxIndices;
+	if(mSceneTree.GetNbObjects() && gRayPacketSize>1)
+		return BatchRaycastPackets((SQThreadContext*)context, nb, dest, raycasts);
 
+	if(mSceneTree.GetNbObjects())
+	{
 		RayCollider SceneRC;
 		SceneRC.SetFirstContact(false);
 		SceneRC.SetTemporalCoherence(false);
@@ -349,59 +787,26 @@ udword Opcode13Pint::BatchRaycasts(PintSQThreadContext context, udword nb, PintR
 		RC.SetClosestHit(true);
 		RC.SetDestination(&CF);
 
+		ClosestRaycastQuery Query;
+		Query.mActors	= (const OpcodeActor**)mActors.GetEntries();
+		Query.mRC		= &RC;
+		Query.mMemory	= &Memory;
+
 		udword NbHits = 0;
 		while(nb--)
 		{
 			const Ray& CurrentRay = *reinterpret_cast<const Ray*>(&raycasts->mOrigin.x);
 
+			// Meshes are visited nearest-first, and the traversal stops once the remaining ones are beyond the closest hit
+			Query.mRay			= &CurrentRay;
+			Query.mTouchedActor	= null;
 			SceneRC.SetMaxDist(raycasts->mMaxDist);
-			mBoxIndices.Reset();
-			if(SceneRC.Collide(CurrentRay, mSceneTree, mBoxIndices))
+			if(SceneRC.Collide(CurrentRay, &mSceneTree, gClosestRaycastCallback, &Query))
 			{
-				const OpcodeActor* TouchedActor = null;
-				CollisionFace Hit;
-				Hit.mDistance = raycasts->mMaxDist;
-
-				udword NbMeshes = mBoxIndices.GetNbEntries();
-				for(udword i=0;i<NbMeshes;i++)
-				{
-					const OpcodeActor* Actor = (const OpcodeActor*)mActors.GetEntries()[mBoxIndices[i]];
-					const OpcodeMesh* Mesh = Actor->mMesh;
-
-					RC.SetMaxDist(Hit.mDistance);
-					Memory.mDistance = MAX_FLOAT;
-					if(RC.Collide(CurrentRay, Mesh->mModel, &Actor->mMeshTM/*, udword* cache=null*/))
-					{
-						if(Memory.mDistance<Hit.mDistance)
-						{
-							Hit = Memory;
-							TouchedActor = Actor;
-						}
-					}
-				}
-
-				if(TouchedActor)
+				if(Query.mTouchedActor)
 				{
-					const OpcodeMesh* TouchedMesh = TouchedActor->mMesh;
-
 					NbHits++;
-
-					dest->mObject			= (PintObjectHandle)TouchedActor;	// ###
-					dest->mDistance			= Hit.mDistance;
-					dest->mTriangleIndex	= Hit.mFaceID;
-
-					const Point* V = TouchedMesh->mMeshInterface.GetVerts();
-					const IndexedTriangle& T = TouchedMesh->mMeshInterface.GetTris()[Hit.mFaceID];
-					const Point& p0 = V[T.mRef[0]];
-					const Point& p1 = V[T.mRef[1]];
-					const Point& p2 = V[T.mRef[2]];
-
-					Point LocalPt;
-					ComputeBarycentricPoint(LocalPt, p0, p1, p2, Hit.mU, Hit.mV);
-					TransformPoint4x3(dest->mImpact, LocalPt, TouchedActor->mMeshTM);
-
-					const Point LocalNormal = ((p0-p1)^(p0-p2)).Normalize();
-					TransformPoint3x3(dest->mNormal, LocalNormal, TouchedActor->mMeshTM);
+					FillRaycastHit(*dest, Query.mTouchedActor, Query.mHit);
 				}
 				else
 				{
@@ -415,88 +820,40 @@ udword Opcode13Pint::BatchRaycasts(PintSQThreadContext context, udword nb, PintR
 		return NbHits;
 	}
 	return 0;
+}
 
-#ifdef OLD
-	CollisionFace Memory;
-	CollisionFaces CF;
-	CF.InitSharedBuffers(sizeof(CollisionFace)/sizeof(udword), (udword*)&Memory);
+struct AnyRaycastQuery
+{
+	const OpcodeActor**	mActors;
+	const Ray*			mRay;
+	RayCollider*		mRC;
+	// Results
+	bool				mHit;
+};
 
-	RayCollider RC;
-	RC.SetFirstContact(false);
-	RC.SetTemporalCoherence(false);
-	RC.SetPrimitiveTests(true);
-	RC.SetCulling(true);
-	RC.SetClosestHit(true);
-	RC.SetDestination(&CF);
+// Called by the scene tree traversal for each touched mesh. Returns a negative distance to stop the query at the first hit.
+static float gAnyRaycastCallback(udword box_index, float max_dist, void* user_data)
+{
+	AnyRaycastQuery* Query = reinterpret_cast<AnyRaycastQuery*>(user_data);
+	const OpcodeActor* Actor = Query->mActors[box_index];
 
-	udword NbHits = 0;
-	while(nb--)
+	Query->mRC->SetMaxDist(max_dist);
+	if(Query->mRC->Collide(*Query->mRay, Actor->mMesh->mModel, &Actor->mMeshTM) && Query->mRC->GetContactStatus())
 	{
-		const OpcodeMesh* TouchedMesh = null;
-		CollisionFace Hit;
-		Hit.mDistance = raycasts->mMaxDist;
-
-		udword NbMeshes = mMeshes.GetNbEntries();
-		for(udword i=0;i<NbMeshes;i++)
-		{
-			const OpcodeMesh* Mesh = (const OpcodeMesh*)mMeshes.GetEntries()[i];
-
-			RC.SetMaxDist(Hit.mDistance);
-			Memory.mDistance = MAX_FLOAT;
-			if(RC.Collide(Ray(raycasts->mOrigin, raycasts->mDir), Mesh->mModel, &Mesh->mMeshTM/*, udword* cache=null*/))
-			{
-				if(Memory.mDistance<Hit.mDistance)
-				{
-					Hit = Memory;
-					TouchedMesh = Mesh;
-				}
-			}
-		}
-
-		if(TouchedMesh)
-		{
-			NbHits++;
-
-			dest->mObject			= (PintObjectHandle)TouchedMesh;
-			dest->mDistance			= Hit.mDistance;
-			dest->mTriangleIndex	= Hit.mFaceID;
-
-			const Point* V = TouchedMesh->mMeshInterface.GetVerts();
-			const IndexedTriangle& T = TouchedMesh->mMeshInterface.GetTris()[Hit.mFaceID];
-			const Point& p0 = V[T.mRef[0]];
-			const Point& p1 = V[T.mRef[1]];
-			const Point& p2 = V[T.mRef[2]];
-
-			const float w = 1.0f - Hit.mU - Hit.mV;
-			dest->mImpact.x = w*p0.x + Hit.mU*p1.x + Hit.mV*p2.x;
-			dest->mImpact.y = w*p0.y + Hit.mU*p1.y + Hit.mV*p2.y;
-			dest->mImpact.z = w*p0.z + Hit.mU*p1.z + Hit.mV*p2.z;
-
-			dest->mNormal = ((p0-p1)^(p0-p2)).Normalize();
-		}
-		else
-		{
-			dest->mObject = null;
-		}
-
-		raycasts++;
-		dest++;
+		Query->mHit = true;
+		return -1.0f;
 	}
-	return NbHits;
-#endif
+	return max_dist;
 }
 
 udword Opcode13Pint::BatchRaycastAny(PintSQThreadContext context, udword nb, PintBooleanHit* dest, const PintRaycastData* raycasts)
 {
 	AllocSwitch _;
 
-	ASSERT(mSceneTree);
+	UpdateSceneTree();
 
-	if(mSceneTree)
+	if(mSceneTree.GetNbObjects())
 	{
-		SQThreadContext* C = (SQThreadContext*)context;
-		Container& mBoxIndices = C->mBoxIndices;
-
 		RayCollider SceneRC;
 		SceneRC.SetFirstContact(false);
 		SceneRC.SetTemporalCoherence(false);
@@ -509,34 +866,23 @@ udword Opcode13Pint::BatchRaycastAny(PintSQThreadContext context, udword nb, Pin
 		RC.SetCulling(true);
 		RC.SetClosestHit(false);
 
+		AnyRaycastQuery Query;
+		Query.mActors	= (const OpcodeActor**)mActors.GetEntries();
+		Query.mRC		= &RC;
+
 		udword NbHits = 0;
 		while(nb--)
 		{
 			const Ray& CurrentRay = *reinterpret_cast<const Ray*>(&raycasts->mOrigin.x);
 
+			// The traversal stops as soon as a mesh is hit
+			Query.mRay = &CurrentRay;
+			Query.mHit = false;
 			SceneRC.SetMaxDist(raycasts->mMaxDist);
-			mBoxIndices.Reset();
-			if(SceneRC.Collide(CurrentRay, mSceneTree, mBoxIndices))
+			if(SceneRC.Collide(CurrentRay, &mSceneTree, gAnyRaycastCallback, &Query))
 			{
-				bool AnyHit=false;
-				udword NbMeshes = mBoxIndices.GetNbEntries();
-				for(udword i=0;i<NbMeshes;i++)
-				{
-					const OpcodeActor* Actor = (const OpcodeActor*)mActors.GetEntries()[mBoxIndices[i]];
-					const OpcodeMesh* Mesh = Actor->mMesh;
-
-					RC.SetMaxDist(raycasts->mMaxDist);
-					if(RC.Collide(CurrentRay, Mesh->mModel, &Actor->mMeshTM/*, udword* cache=null*/))
-					{
-						if(RC.GetContactStatus())
-						{
-							AnyHit = true;
-							break;
-						}
-					}
-				}
-				NbHits += AnyHit;
-				dest->mHit = AnyHit;
+				NbHits += Query.mHit;
+				dest->mHit = Query.mHit;
 			}
 
 			raycasts++;
@@ -566,9 +912,9 @@ udword Opcode13Pint::BatchSphereOverlapAny(PintSQThreadContext context, udword n
 {
 	AllocSwitch _;
 
-	ASSERT(mSceneTree);
+	UpdateSceneTree();
 
-	if(mSceneTree)
+	if(mSceneTree.GetNbObjects())
 	{
 		SQThreadContext* C = (SQThreadContext*)context;
 		Container& mBoxIndices = C->mBoxIndices;
@@ -596,7 +942,7 @@ udword Opcode13Pint::BatchSphereOverlapAny(PintSQThreadContext context, udword n
 		while(nb--)
 		{
 			udword Touched=0;
-			if(SceneRC.Collide(Cache, overlaps->mSphere, mSceneTree) && SceneRC.GetContactStatus())
+			if(SceneRC.Collide(Cache, overlaps->mSphere, &mSceneTree) && SceneRC.GetContactStatus())
 			{
 				const udword NbMeshes = SceneRC.GetNbTouchedPrimitives();
 				for(udword i=0;i<NbMeshes;i++)
@@ -627,12 +973,13 @@ udword Opcode13Pint::BatchSphereOverlapObjects(PintSQThreadContext context, udwo
 {
 	AllocSwitch _;
 
-	ASSERT(mSceneTree);
+	UpdateSceneTree();
 
-	if(mSceneTree)
+	if(mSceneTree.GetNbObjects())
 	{
 		SQThreadContext* C = (SQThreadContext*)context;
 		Container& mBoxIndices = C->mBoxIndices;
+		Container& TouchedObjects = C->mTouchedObjects;
 
 		SphereCollider SceneRC;
 		SceneRC.SetFirstContact(false);
@@ -657,7 +1004,8 @@ udword Opcode13Pint::BatchSphereOverlapObjects(PintSQThreadContext context, udwo
 		while(nb--)
 		{
 			udword Touched=0;
-			if(SceneRC.Collide(Cache, overlaps->mSphere, mSceneTree) && SceneRC.GetContactStatus())
+			TouchedObjects.Reset();
+			if(SceneRC.Collide(Cache, overlaps->mSphere, &mSceneTree) && SceneRC.GetContactStatus())
 			{
 				const udword NbMeshes = SceneRC.GetNbTouchedPrimitives();
 				for(udword i=0;i<NbMeshes;i++)
@@ -666,8 +1014,16 @@ udword Opcode13Pint::BatchSphereOverlapObjects(PintSQThreadContext context, udwo
 					const OpcodeActor* Actor = (const OpcodeActor*)mActors.GetEntries()[Index];
 					const OpcodeMesh* Mesh = Actor->mMesh;
 
+					// A compound touched by several of its shapes is only counted once
+					const OpcodeObject* Object = Actor->mObject;
+					const bool Compound = Object->mActors.GetNbEntries()>1;
+					if(Compound && TouchedObjects.Contains(udword(Object)))
+						continue;
+
 					if(RC.Collide(Cache2, overlaps->mSphere, Mesh->mModel, null, &Actor->mMeshTM) && RC.GetContactStatus())
 					{
+						if(Compound)
+							TouchedObjects.Add(udword(Object));
 						Touched++;
 					}
 				}
@@ -687,14 +1043,14 @@ udword Opcode13Pint::BatchBoxOverlapAny(PintSQThreadContext context, udword nb,
 {
 	AllocSwitch _;
 
-	ASSERT(mSceneTree);
+	UpdateSceneTree();
 
-	if(mSceneTree)
+	if(mSceneTree.GetNbObjects())
 	{
 		SQThreadContext* C = (SQThreadContext*)context;
 		Container& mBoxIndices = C->mBoxIndices;
 
-		SceneOBBCollider SceneRC;
+		OBBCollider SceneRC;
 		SceneRC.SetFirstContact(false);
 		SceneRC.SetTemporalCoherence(false);
 		SceneRC.SetPrimitiveTests(true);
@@ -718,7 +1074,7 @@ udword Opcode13Pint::BatchBoxOverlapAny(PintSQThreadContext context, udword nb,
 		while(nb--)
 		{
 			udword Touched=0;
-			if(SceneRC.Collide(Cache, overlaps->mBox, mSceneTree) && SceneRC.GetContactStatus())
+			if(SceneRC.Collide(Cache, overlaps->mBox, &mSceneTree) && SceneRC.GetContactStatus())
 			{
 				const udword NbMeshes = SceneRC.GetNbTouchedPrimitives();
 				for(udword i=0;i<NbMeshes;i++)
@@ -749,14 +1105,15 @@ udword Opcode13Pint::BatchBoxOverlapObjects(PintSQThreadContext context, udword
 {
 	AllocSwitch _;
 
-	ASSERT(mSceneTree);
+	UpdateSceneTree();
 
-	if(mSceneTree)
+	if(mSceneTree.GetNbObjects())
 	{
 		SQThreadContext* C = (SQThreadContext*)context;
 		Container& mBoxIndices = C->mBoxIndices;
+		Container& TouchedObjects = C->mTouchedObjects;
 
-		SceneOBBCollider SceneRC;
+		OBBCollider SceneRC;
 		SceneRC.SetFirstContact(false);
 		SceneRC.SetTemporalCoherence(false);
 		SceneRC.SetPrimitiveTests(true);
@@ -780,7 +1137,8 @@ udword Opcode13Pint::BatchBoxOverlapObjects(PintSQThreadContext context, udword
 		while(nb--)
 		{
 			udword Touched=0;
-			if(SceneRC.Collide(Cache, overlaps->mBox, mSceneTree) && SceneRC.GetContactStatus())
+			TouchedObjects.Reset();
+			if(SceneRC.Collide(Cache, overlaps->mBox, &mSceneTree) && SceneRC.GetContactStatus())
 			{
 				const udword NbMeshes = SceneRC.GetNbTouchedPrimitives();
 				for(udword i=0;i<NbMeshes;i++)
@@ -789,8 +1147,16 @@ udword Opcode13Pint::BatchBoxOverlapObjects(PintSQThreadContext context, udword
 					const OpcodeActor* Actor = (const OpcodeActor*)mActors.GetEntries()[Index];
 					const OpcodeMesh* Mesh = Actor->mMesh;
 
+					// A compound touched by several of its shapes is only counted once
+					const OpcodeObject* Object = Actor->mObject;
+					const bool Compound = Object->mActors.GetNbEntries()>1;
+					if(Compound && TouchedObjects.Contains(udword(Object)))
+						continue;
+
 					if(RC.Collide(Cache2, overlaps->mBox, Mesh->mModel, null, &Actor->mMeshTM) && RC.GetContactStatus())
 					{
+						if(Compound)
+							TouchedObjects.Add(udword(Object));
 						Touched++;
 					}
 				}
@@ -810,9 +1176,9 @@ udword Opcode13Pint::FindTriangles_MeshSphereOverlap(PintSQThreadContext context
 {
 	AllocSwitch _;
 
-	ASSERT(mSceneTree);
+	UpdateSceneTree();
 
-	if(!mSceneTree)
+	if(!mSceneTree.GetNbObjects())
 		return 0;
 
 	SphereCollider RC;
@@ -822,15 +1188,20 @@ udword Opcode13Pint::FindTriangles_MeshSphereOverlap(PintSQThreadContext context
 
 	SphereCache Cache;
 
-	OpcodeActor* Actor = (OpcodeActor*)handle;
-	const OpcodeMesh* Mesh = Actor->mMesh;
+	const OpcodeObject* Object = (const OpcodeObject*)handle;
+	ASSERT(Object);
+	const udword NbActors = Object->mActors.GetNbEntries();
 
 	udword NbTouchedTriangles = 0;
 	while(nb--)
 	{
-		if(RC.Collide(Cache, overlaps->mSphere, Mesh->mModel, null, &Actor->mMeshTM) && RC.GetContactStatus())
+		for(udword i=0;i<NbActors;i++)
 		{
-			NbTouchedTriangles += Cache.TouchedPrimitives.GetNbEntries();
+			const OpcodeActor* Actor = (const OpcodeActor*)Object->mActors.GetEntry(i);
+			if(RC.Collide(Cache, overlaps->mSphere, Actor->mMesh->mModel, null, &Actor->mMeshTM) && RC.GetContactStatus())
+			{
+				NbTouchedTriangles += Cache.TouchedPrimitives.GetNbEntries();
+			}
 		}
 
 		overlaps++;
@@ -843,8 +1214,12 @@ udword Opcode13Pint::FindTriangles_MeshSphereOverlap(PintSQThreadContext context
 
 static Opcode13Pint* gOpcode = null;
 
+static void gOpcode_GetOptionsFromGUI();
+
 void Opcode_Init(const PINT_WORLD_CREATE& desc)
 {
+	gOpcode_GetOptionsFromGUI();
+
 	ASSERT(!gOpcode);
 	gOpcode = ICE_NEW(Opcode13Pint);
 	gOpcode->Init(desc);
@@ -871,6 +1246,10 @@ static Container*	gOpcodeGUI = null;
 static IceCheckBox*	gCheckBox_DrawMeshAABBS = null;
 static IceCheckBox*	gCheckBox_Quantized = null;
 static IceCheckBox*	gCheckBox_NoLeaf = null;
+static IceCheckBox*	gCheckBox_SAH = null;
+static IceCheckBox*	gCheckBox_Wide = null;
+static IceCheckBox*	gCheckBox_SortRays = null;
+static IceComboBox*	gComboBox_RayPacketSize = null;
 
 enum OpcodeGUIElement
 {
@@ -880,8 +1259,26 @@ enum OpcodeGUIElement
 	//
 	OPCODE_GUI_QUANTIZED,
 	OPCODE_GUI_NOLEAF,
+	OPCODE_GUI_SAH,
+	OPCODE_GUI_WIDE,
+	//
+	OPCODE_GUI_RAY_PACKET_SIZE,
+	OPCODE_GUI_SORT_RAYS,
 };
 
+static udword gIndexToRayPacketSize[] = { 1, 4, 8, 16 };
+
+static void gOpcode_GetOptionsFromGUI()
+{
+	if(gComboBox_RayPacketSize)
+	{
+		const udword Index = gComboBox_RayPacketSize->GetSelectedIndex();
+		ASSERT(Index<sizeof(gIndexToRayPacketSize)/sizeof(gIndexToRayPacketSize[0]));
+		gRayPacketSize = gIndexToRayPacketSize[Index];
+		ASSERT(gRayPacketSize<=OPC_MAX_PACKET_SIZE);
+	}
+}
+
 static void gCheckBoxCallback(const IceCheckBox& check_box, bool checked, void* user_data)
 {
 	const udword id = check_box.GetID();
@@ -896,6 +1293,15 @@ static void gCheckBoxCallback(const IceCheckBox& check_box, bool checked, void*
 		case OPCODE_GUI_NOLEAF:
 			gNoLeaf = checked;
 			break;
+		case OPCODE_GUI_SAH:
+			gSAH = checked;
+			break;
+		case OPCODE_GUI_WIDE:
+			gWide = checked;
+			break;
+		case OPCODE_GUI_SORT_RAYS:
+			gSortRays = checked;
+			break;
 	}
 
 //	if(gPhysX)
@@ -921,6 +1327,44 @@ IceWindow* Opcode_InitGUI(IceWidget* parent, PintGUIHelper& helper)
 
 		gCheckBox_NoLeaf = helper.CreateCheckBox(Main, OPCODE_GUI_NOLEAF, 4, y, CheckBoxWidth, 20, "No Leaf", gOpcodeGUI, gNoLeaf, gCheckBoxCallback);
 		y += YStepCB;
+
+		gCheckBox_SAH = helper.CreateCheckBox(Main, OPCODE_GUI_SAH, 4, y, CheckBoxWidth, 20, "SAH tree build", gOpcodeGUI, gSAH, gCheckBoxCallback);
+		y += YStepCB;
+
+		gCheckBox_Wide = helper.CreateCheckBox(Main, OPCODE_GUI_WIDE, 4, y, CheckBoxWidth, 20, "Wide SIMD trees", gOpcodeGUI, gWide, gCheckBoxCallback);
+		y += YStepCB;
+
+		gCheckBox_SortRays = helper.CreateCheckBox(Main, OPCODE_GUI_SORT_RAYS, 4, y, CheckBoxWidth, 20, "Sort rays (stream mode)", gOpcodeGUI, gSortRays, gCheckBoxCallback);
+		y += YStepCB;
+	}
+
+	y += YStep;
+
+	const sdword OffsetX = 90;
+	const sdword LabelOffsetY = 2;
+	{
+		helper.CreateLabel(Main, 4, y+LabelOffsetY, 90, 20, "Ray packets:", gOpcodeGUI);
+
+		ComboBoxDesc CBBD;
+		CBBD.mID		= OPCODE_GUI_RAY_PACKET_SIZE;
+		CBBD.mParent	= Main;
+		CBBD.mX			= 4+OffsetX;
+		CBBD.mY			= y;
+		CBBD.mWidth		= 150;
+		CBBD.mHeight	= 20;
+		CBBD.mLabel		= "Ray packets";
+		gComboBox_RayPacketSize = ICE_NEW(IceComboBox)(CBBD);
+		gOpcodeGUI->Add(udword(gComboBox_RayPacketSize));
+		gComboBox_RayPacketSize->Add("Disabled");
+		gComboBox_RayPacketSize->Add("4 rays");
+		gComboBox_RayPacketSize->Add("8 rays");
+		gComboBox_RayPacketSize->Add("16 rays");
+		udword Index = 0;
+		while(Index<sizeof(gIndexToRayPacketSize)/sizeof(gIndexToRayPacketSize[0]) && gIndexToRayPacketSize[Index]!=gRayPacketSize)
+			Index++;
+		gComboBox_RayPacketSize->Select(Index);
+		gComboBox_RayPacketSize->SetVisible(true);
+		y += YStep;
 	}
 
 	return Main;
@@ -932,6 +1376,10 @@ void Opcode_CloseGUI()
 	gCheckBox_DrawMeshAABBS = null;
 	gCheckBox_Quantized = null;
 	gCheckBox_NoLeaf = null;
+	gCheckBox_SAH = null;
+	gCheckBox_Wide = null;
+	gCheckBox_SortRays = null;
+	gComboBox_RayPacketSize = null;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
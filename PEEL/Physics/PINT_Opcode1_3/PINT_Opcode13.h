@@ -18,19 +18,39 @@
 									~OpcodeMesh();
 
 				IndexedSurface		mSurface;
+				AABB				mLocalBox;
 				Model				mModel;
 				MeshInterface		mMeshInterface;
 				PintShapeRenderer*	mRenderer;
 	};
 
+	class OpcodeObject;
+
+	// One actor per shape. Actors are the scene tree's leaves.
 	class OpcodeActor : public Allocateable
 	{
 		public:
 									OpcodeActor();
 									~OpcodeActor();
 
+				OpcodeObject*		mObject;		// Owner
 				OpcodeMesh*			mMesh;
-				Matrix4x4			mMeshTM;
+				Matrix4x4			mLocalTM;		// Shape's local pose
+				Matrix4x4			mMeshTM;		// Object's pose * mLocalTM
+				udword				mIndex;			// In mActors & mWorldBoxes
+				udword				mTreeHandle;	// In the scene tree
+	};
+
+	// One object per CreateObject() call, i.e. per PintObjectHandle. Owns the actors of all its shapes.
+	class OpcodeObject : public Allocateable
+	{
+		public:
+									OpcodeObject();
+									~OpcodeObject();
+
+				Matrix4x4			mPose;
+				Container			mActors;
+				udword				mIndex;			// In Opcode13Pint::mObjects
 	};
 
 	class Opcode13Pint : public Pint
@@ -41,19 +61,30 @@
 
 		// Pint
 		virtual	const char*			GetName()				const	{ return "Opcode 1.3";	}
+		virtual	udword				GetFlags()				const	{ return PINT_DEFAULT|PINT_MAIN_THREAD_ONLY;	}
 		virtual	void				GetCaps(PintCaps& caps)	const;
 		virtual	void				Init(const PINT_WORLD_CREATE& desc);
 		virtual	void				SetGravity(const Point& gravity);
 		virtual	void				Close();
 		virtual	udword				Update(float dt);
+		virtual	const PintAllocStats*	GetAllocStats();
 		virtual	Point				GetMainColor();
 		virtual	void				Render(PintRender& renderer);
 
 		virtual	void				SetDisabledGroups(udword nb_groups, const PintDisabledGroups* groups);
 		virtual	PintObjectHandle	CreateObject(const PINT_OBJECT_CREATE& desc);
 		virtual	bool				ReleaseObject(PintObjectHandle handle);
+		virtual	udword				ReleaseObjects(udword nb, const PintObjectHandle* handles);
 		virtual	PintJointHandle		CreateJoint(const PINT_JOINT_CREATE& desc);
 
+		virtual	PR					GetWorldTransform(PintObjectHandle handle);
+		virtual	void				SetWorldTransform(PintObjectHandle handle, const PR& pose);
+		virtual	void				GetWorldTransforms(udword nb, const PintObjectHandle* handles, PR* poses);
+		virtual	udword				GetActiveTransforms(udword max_nb, PintObjectHandle* handles, Point* positions, Quat* rotations);
+
+		virtual	bool				SetKinematicPose(PintObjectHandle handle, const Point& pos);
+		virtual	bool				SetKinematicPose(PintObjectHandle handle, const PR& pr);
+
 		virtual	void*				CreatePhantom(const AABB& box);
 		virtual	udword				BatchRaycastsPhantom(udword nb, PintRaycastHit* dest, const PintRaycastData* raycasts, void**);
 
@@ -77,15 +108,28 @@
 		//~Pint
 
 		private:
+				void				UpdateSceneTree();
+				OpcodeMesh*			FindOrCreateMesh(const SurfaceInterface& surface, PintShapeRenderer* renderer, bool report_build);
+				void				SetObjectPose(OpcodeObject* object, const Matrix4x4& pose);
+				void				RemoveActor(OpcodeActor* actor);
+
 				Container			mMeshes;
+				Container			mObjects;
 				Container			mActors;
 				Container			mWorldBoxes;
-				AABBTree*			mSceneTree;
+				DynamicAABBTree		mSceneTree;
+				udword				mNbSceneTreeUpdates;	// Objects reinserted after moving out of their fat boxes
+				udword				mSceneTreeBuildTime;	// Cycles, last full rebuild
 
 				struct SQThreadContext : public Allocateable
 				{
 					Container		mBoxIndices;
+					Container		mRayKeys;		// Stream mode sort keys
+					Container		mTouchedObjects;	// Compounds already reported by the current overlap query
+					RadixSort		mRaySorter;
 				};
+
+				udword				BatchRaycastPackets(SQThreadContext* context, udword nb, PintRaycastHit* dest, const PintRaycastData* raycasts);
 	};
 
 	IceWindow*		Opcode_InitGUI(IceWidget* parent, PintGUIHelper& helper);
@@ -15,6 +15,7 @@
 #include "stdafx.h"
 #include "PINT_PhysX284.h"
 #include "..\PINT_Common\PINT_Common.h"
+#include "..\PINT_Common\PINT_CommonAllocator.h"
 
 #include "NxPhysics.h"
 #include "NxCooking.h"
@@ -304,12 +305,13 @@ void MemoryReadBuffer::readBuffer(void* dest, NxU32 size) const
 		{
 //			return ::malloc(size);
 
-			char* memory = (char*)_aligned_malloc(size+16, 16);
+			char* memory = (char*)Common_Alloc(size+16);
 			Header* H = (Header*)memory;
 			H->mMagic = 0x12345678;
 			H->mSize = size;
 			mNbAllocs++;
 			mCurrentMemory+=size;
+			mTracker.OnAlloc(size);
 			return memory + 16;
 		}
 
@@ -317,12 +319,13 @@ void MemoryReadBuffer::readBuffer(void* dest, NxU32 size) const
 		{
 //			return ::malloc(size);
 
-			char* memory = (char*)_aligned_malloc(size+16, 16);
+			char* memory = (char*)Common_Alloc(size+16);
 			Header* H = (Header*)memory;
 			H->mMagic = 0x12345678;
 			H->mSize = size;
 			mNbAllocs++;
 			mCurrentMemory+=size;
+			mTracker.OnAlloc(size);
 			return memory + 16;
 		}
 
@@ -344,13 +347,15 @@ void MemoryReadBuffer::readBuffer(void* dest, NxU32 size) const
 			Header* H = (Header*)(bptr - 16);
 			ASSERT(H->mMagic==0x12345678);
 			const udword Size = H->mSize;
-			_aligned_free(H);
+			Common_Free(H);
 			mNbAllocs--;
 			mCurrentMemory-=Size;
+			mTracker.OnFree(Size);
 		}
 
 		udword	mNbAllocs;
 		udword	mCurrentMemory;
+		PintAllocTracker	mTracker;
 	};
 
 	class MyNxUserOutputStream : public NxUserOutputStream
@@ -418,6 +423,7 @@ void PhysX284::GetCaps(PintCaps& caps) const
 void PhysX284::Init(const PINT_WORLD_CREATE& desc)
 {
 	ASSERT(!gMyNxUserAllocator);
+	Common_SetAllocator(desc.GetAllocatorType(), desc.GetAllocTracking());
 	gMyNxUserAllocator = new MyNxUserAllocator;
 	ASSERT(gMyNxUserAllocator);
 
@@ -533,6 +539,7 @@ void PhysX284::Close()
 	}
 
 	DELETESINGLE(gMyNxUserAllocator);
+	Common_ReleaseAllocator();
 }
 
 void PhysX284::UpdateFromUI()
@@ -557,6 +564,11 @@ udword PhysX284::Update(float dt)
 	return gMyNxUserAllocator->mCurrentMemory;
 }
 
+const PintAllocStats* PhysX284::GetAllocStats()
+{
+	return gMyNxUserAllocator ? &gMyNxUserAllocator->mTracker.GetStats() : null;
+}
+
 Point PhysX284::GetMainColor()
 {
 	return Point(1.0f, 0.0f, 1.0f);
@@ -13,6 +13,7 @@
 #include "stdafx.h"
 #include "PINT_PhysX31.h"
 #include "..\PINT_Common\PINT_Common.h"
+#include "..\PINT_Common\PINT_CommonAllocator.h"
 
 #include "extensions\PxExtensionsAPI.h"
 #include "common/PxRenderBuffer.h"
@@ -331,12 +332,13 @@ void PVDHelper::onPvdDisconnected(PvdConnection& )
 		void* allocate(size_t size, const char*, const char*, int)
 		{
 //return _aligned_malloc(size, 16);
-			char* memory = (char*)_aligned_malloc(size+16, 16);
+			char* memory = (char*)Common_Alloc(size+16);
 			Header* H = (Header*)memory;
 			H->mMagic = 0x12345678;
 			H->mSize = size;
 			mNbAllocs++;
 			mCurrentMemory+=size;
+			mTracker.OnAlloc(size);
 			return memory + 16;
 		}
 
@@ -349,13 +351,15 @@ void PVDHelper::onPvdDisconnected(PvdConnection& )
 			Header* H = (Header*)(bptr - 16);
 			ASSERT(H->mMagic==0x12345678);
 			const udword Size = H->mSize;
-			_aligned_free(H);
+			Common_Free(H);
 			mNbAllocs--;
 			mCurrentMemory-=Size;
+			mTracker.OnFree(Size);
 		}
 
 		udword	mNbAllocs;
 		udword	mCurrentMemory;
+		PintAllocTracker	mTracker;
 	};
 
 //static PxDefaultAllocator* gDefaultAllocator = null;
@@ -565,6 +569,7 @@ void PhysX::Init(const PINT_WORLD_CREATE& desc)
 {
 //	gDefaultAllocator = new PxDefaultAllocator;
 //	gDefaultErrorCallback = new PxDefaultErrorCallback;
+	Common_SetAllocator(desc.GetAllocatorType(), desc.GetAllocTracking());
 	gDefaultAllocator = new MyAllocator;
 	gDefaultErrorCallback = new MyErrorCallback;
 
@@ -590,7 +595,9 @@ void PhysX::Init(const PINT_WORLD_CREATE& desc)
 
 	bool status = PxInitExtensions(*mPhysics);
 	ASSERT(status);
-	gDefaultCPUDispatcher = PxDefaultCpuDispatcherCreate(gNbThreads, null);
+	udword AffinityMasks[32];
+	PxU32* Affinities = gNbThreads<=32 ? desc.GetWorkerThreadAffinities(gNbThreads, AffinityMasks) : null;
+	gDefaultCPUDispatcher = PxDefaultCpuDispatcherCreate(gNbThreads, Affinities);
 
 	ASSERT(!mCooking);
 	PxCookingParams Params;
@@ -682,6 +689,7 @@ void PhysX::Close()
 //	SAFE_RELEASE(mFoundation)
 	DELETESINGLE(gDefaultErrorCallback);
 	DELETESINGLE(gDefaultAllocator);
+	Common_ReleaseAllocator();
 }
 
 void PhysX::UpdateFromUI()
@@ -709,6 +717,11 @@ udword PhysX::Update(float dt)
 //	return 0;
 }
 
+const PintAllocStats* PhysX::GetAllocStats()
+{
+	return gDefaultAllocator ? &gDefaultAllocator->mTracker.GetStats() : null;
+}
+
 Point PhysX::GetMainColor()
 {
 	return Point(0.75f, 0.25f, 0.5f);
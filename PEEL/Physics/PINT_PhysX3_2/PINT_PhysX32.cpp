@@ -22,6 +22,7 @@
 #include "stdafx.h"
 #include "PINT_PhysX32.h"
 #include "..\PINT_Common\PINT_Common.h"
+#include "..\PINT_Common\PINT_CommonAllocator.h"
 
 #include "extensions\PxExtensionsAPI.h"
 #include "common/PxIO.h"
@@ -365,6 +366,7 @@ void PhysX::Init(const PINT_WORLD_CREATE& desc)
 
 //	gDefaultAllocator = new PxDefaultAllocator;
 //	gDefaultErrorCallback = new PxDefaultErrorCallback;
+	Common_SetAllocator(desc.GetAllocatorType(), desc.GetAllocTracking());
 	gDefaultAllocator = new PEEL_PhysX3_AllocatorCallback;
 	gDefaultErrorCallback = new PEEL_PhysX3_ErrorCallback;
 
@@ -400,7 +402,9 @@ void PhysX::Init(const PINT_WORLD_CREATE& desc)
 
 	bool status = PxInitExtensions(*mPhysics);
 	ASSERT(status);
-	gDefaultCPUDispatcher = PxDefaultCpuDispatcherCreate(mParams.mNbThreads, null);
+	udword AffinityMasks[32];
+	PxU32* Affinities = mParams.mNbThreads<=32 ? desc.GetWorkerThreadAffinities(mParams.mNbThreads, AffinityMasks) : null;
+	gDefaultCPUDispatcher = PxDefaultCpuDispatcherCreate(mParams.mNbThreads, Affinities);
 
 	{
 		ASSERT(!mCooking);
@@ -491,6 +495,7 @@ void PhysX::Close()
 	SAFE_RELEASE(mFoundation)
 	DELETESINGLE(gDefaultErrorCallback);
 	DELETESINGLE(gDefaultAllocator);
+	Common_ReleaseAllocator();
 }
 
 void PhysX::UpdateFromUI()
@@ -508,6 +513,11 @@ udword PhysX::Update(float dt)
 	return gDefaultAllocator->mCurrentMemory;
 }
 
+const PintAllocStats* PhysX::GetAllocStats()
+{
+	return gDefaultAllocator ? &gDefaultAllocator->mTracker.GetStats() : null;
+}
+
 Point PhysX::GetMainColor()
 {
 	return Point(1.0f, 0.0f, 0.0f);
@@ -910,6 +920,7 @@ class MyUICallback : public UICallback
 void PhysX_Init(const PINT_WORLD_CREATE& desc)
 {
 	PhysX3::GetOptionsFromGUI(desc.GetTestName());
+	PhysX3::GetOptionsFromDesc(desc);
 
 	for(PxU16 j=0;j<32;j++)
 		for(PxU16 i=0;i<32;i++)
@@ -1388,6 +1399,7 @@ class PhysXPlugIn : public PintPlugin
 	virtual	void		Init(const PINT_WORLD_CREATE& desc)					{ PhysX_Init(desc);						}
 	virtual	void		Close()												{ PhysX_Close();						}
 	virtual	Pint*		GetPint()											{ return GetPhysX();					}
+	virtual	void		GetSettings(PintSettingsCallback& callback)			{ PhysX3::GetSettings(callback);		}
 };
 static PhysXPlugIn gPlugIn;
 
@@ -24,6 +24,7 @@
 		virtual	void					Init(const PINT_WORLD_CREATE& desc);
 		virtual	void					Close();
 		virtual	udword					Update(float dt);
+		virtual	const PintAllocStats*			GetAllocStats();
 		virtual	Point					GetMainColor();
 
 //		virtual	PintObjectHandle		CreateObject(const PINT_OBJECT_CREATE& desc);
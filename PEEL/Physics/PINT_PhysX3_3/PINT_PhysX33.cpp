@@ -9,6 +9,7 @@
 #include "stdafx.h"
 #include "PINT_PhysX33.h"
 #include "..\PINT_Common\PINT_Common.h"
+#include "..\PINT_Common\PINT_CommonAllocator.h"
 
 #include "extensions\PxExtensionsAPI.h"
 #include "common/PxIO.h"
@@ -345,6 +346,7 @@ void PhysX::Init(const PINT_WORLD_CREATE& desc)
 
 //	gDefaultAllocator = new PxDefaultAllocator;
 //	gDefaultErrorCallback = new PxDefaultErrorCallback;
+	Common_SetAllocator(desc.GetAllocatorType(), desc.GetAllocTracking());
 	gDefaultAllocator = new PEEL_PhysX3_AllocatorCallback;
 	gDefaultErrorCallback = new PEEL_PhysX3_ErrorCallback;
 
@@ -382,7 +384,9 @@ void PhysX::Init(const PINT_WORLD_CREATE& desc)
 
 	bool status = PxInitExtensions(*mPhysics);
 	ASSERT(status);
-	gDefaultCPUDispatcher = PxDefaultCpuDispatcherCreate(gNbThreads, null);
+	udword AffinityMasks[32];
+	PxU32* Affinities = gNbThreads<=32 ? desc.GetWorkerThreadAffinities(gNbThreads, AffinityMasks) : null;
+	gDefaultCPUDispatcher = PxDefaultCpuDispatcherCreate(gNbThreads, Affinities);
 
 	{
 		ASSERT(!mCooking);
@@ -516,6 +520,7 @@ void PhysX::Close()
 	SAFE_RELEASE(mFoundation)
 	DELETESINGLE(gDefaultErrorCallback);
 	DELETESINGLE(gDefaultAllocator);
+	Common_ReleaseAllocator();
 }
 
 void PhysX::UpdateFromUI()
@@ -576,6 +581,11 @@ udword PhysX::Update(float dt)
 //	return 0;
 }
 
+const PintAllocStats* PhysX::GetAllocStats()
+{
+	return gDefaultAllocator ? &gDefaultAllocator->mTracker.GetStats() : null;
+}
+
 Point PhysX::GetMainColor()
 {
 	return Point(1.0f, 0.75f, 0.0f);
@@ -2343,6 +2353,7 @@ class PhysXPlugIn : public PintPlugin
 	virtual	void		Init(const PINT_WORLD_CREATE& desc)					{ PhysX_Init(desc);						}
 	virtual	void		Close()												{ PhysX_Close();						}
 	virtual	Pint*		GetPint()											{ return GetPhysX();					}
+	virtual	void		GetSettings(PintSettingsCallback& callback)			{ PhysX3::GetSettings(callback);		}
 };
 static PhysXPlugIn gPlugIn;
 
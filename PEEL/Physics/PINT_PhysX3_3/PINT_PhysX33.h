@@ -28,6 +28,7 @@
 		virtual	void								Init(const PINT_WORLD_CREATE& desc);
 		virtual	void								Close();
 		virtual	udword								Update(float dt);
+		virtual	const PintAllocStats*						GetAllocStats();
 		virtual	Point								GetMainColor();
 		virtual	void								Render(PintRender& renderer);
 
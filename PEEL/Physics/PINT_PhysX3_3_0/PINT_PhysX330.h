@@ -29,6 +29,9 @@
 		virtual	void								Init(const PINT_WORLD_CREATE& desc);
 		virtual	void								Close();
 		virtual	udword								Update(float dt);
+		virtual	void								BeginUpdate(float dt);
+		virtual	udword								EndUpdate();
+		virtual	const PintAllocStats*						GetAllocStats();
 		virtual	Point								GetMainColor();
 
 		virtual	void*								CreatePhantom(const AABB& box);
@@ -24,6 +24,7 @@
 #include "stdafx.h"
 #include "PINT_PhysX331.h"
 #include "..\PINT_Common\PINT_Common.h"
+#include "..\PINT_Common\PINT_CommonAllocator.h"
 
 #include "extensions\PxExtensionsAPI.h"
 #include "common/PxIO.h"
@@ -302,6 +303,7 @@ void PhysX::Init(const PINT_WORLD_CREATE& desc)
 
 //	gDefaultAllocator = new PxDefaultAllocator;
 //	gDefaultErrorCallback = new PxDefaultErrorCallback;
+	Common_SetAllocator(desc.GetAllocatorType(), desc.GetAllocTracking());
 	gDefaultAllocator = new PEEL_PhysX3_AllocatorCallback;
 	gDefaultErrorCallback = new PEEL_PhysX3_ErrorCallback;
 
@@ -339,7 +341,9 @@ void PhysX::Init(const PINT_WORLD_CREATE& desc)
 
 	bool status = PxInitExtensions(*mPhysics);
 	ASSERT(status);
-	gDefaultCPUDispatcher = PxDefaultCpuDispatcherCreate(mParams.mNbThreads, null);
+	udword AffinityMasks[32];
+	PxU32* Affinities = mParams.mNbThreads<=32 ? desc.GetWorkerThreadAffinities(mParams.mNbThreads, AffinityMasks) : null;
+	gDefaultCPUDispatcher = PxDefaultCpuDispatcherCreate(mParams.mNbThreads, Affinities);
 
 	CreateCooking(scale, PxMeshPreprocessingFlags(PxMeshPreprocessingFlag::eWELD_VERTICES|PxMeshPreprocessingFlag::eREMOVE_UNREFERENCED_VERTICES|PxMeshPreprocessingFlag::eREMOVE_DUPLICATED_TRIANGLES));
 
@@ -458,6 +462,7 @@ void PhysX::Close()
 	SAFE_RELEASE(mFoundation)
 	DELETESINGLE(gDefaultErrorCallback);
 	DELETESINGLE(gDefaultAllocator);
+	Common_ReleaseAllocator();
 }
 
 void PhysX::UpdateFromUI()
@@ -476,6 +481,23 @@ udword PhysX::Update(float dt)
 	return gDefaultAllocator->mCurrentMemory;
 }
 
+void PhysX::BeginUpdate(float dt)
+{
+	UpdateVehicles();
+	BeginUpdateCommon(dt);
+}
+
+udword PhysX::EndUpdate()
+{
+	EndUpdateCommon();
+	return gDefaultAllocator->mCurrentMemory;
+}
+
+const PintAllocStats* PhysX::GetAllocStats()
+{
+	return gDefaultAllocator ? &gDefaultAllocator->mTracker.GetStats() : null;
+}
+
 Point PhysX::GetMainColor()
 {
 	return Point(1.0f, 0.75f, 0.0f);
@@ -754,6 +776,7 @@ udword PhysX::BatchRaycastsPhantom(udword nb, PintRaycastHit* dest, const PintRa
 udword PhysX::BatchRaycasts(PintSQThreadContext context, udword nb, PintRaycastHit* dest, const PintRaycastData* raycasts)
 {
 	ASSERT(mScene);
+	PHYSX_SQ_READ_LOCK;
 
 	const PxQueryFilterData PF = GetSQFilterData();
 	const PxSceneQueryFlags sqFlags = PxSceneQueryFlag::eIMPACT|PxSceneQueryFlag::eNORMAL|PxSceneQueryFlag::eDISTANCE;
@@ -856,6 +879,7 @@ static inline_ PxSceneQueryFlags GetSweepQueryFlags(const EditableParams& params
 udword PhysX::BatchBoxSweeps(PintSQThreadContext context, udword nb, PintRaycastHit* dest, const PintBoxSweepData* sweeps)
 {
 	ASSERT(mScene);
+	PHYSX_SQ_READ_LOCK;
 
 	const PxQueryFilterData PF = GetSQFilterData();
 	const PxSceneQueryFlags sweepQueryFlags = GetSweepQueryFlags(mParams);
@@ -887,6 +911,7 @@ udword PhysX::BatchBoxSweeps(PintSQThreadContext context, udword nb, PintRaycast
 udword PhysX::BatchSphereSweeps(PintSQThreadContext context, udword nb, PintRaycastHit* dest, const PintSphereSweepData* sweeps)
 {
 	ASSERT(mScene);
+	PHYSX_SQ_READ_LOCK;
 
 	const PxQueryFilterData PF = GetSQFilterData();
 	const PxSceneQueryFlags sweepQueryFlags = GetSweepQueryFlags(mParams);
@@ -916,6 +941,7 @@ udword PhysX::BatchSphereSweeps(PintSQThreadContext context, udword nb, PintRayc
 udword PhysX::BatchCapsuleSweeps(PintSQThreadContext context, udword nb, PintRaycastHit* dest, const PintCapsuleSweepData* sweeps)
 {
 	ASSERT(mScene);
+	PHYSX_SQ_READ_LOCK;
 
 	const PxQueryFilterData PF = GetSQFilterData();
 	const PxSceneQueryFlags sweepQueryFlags = GetSweepQueryFlags(mParams);
@@ -968,6 +994,7 @@ class MyUICallback : public UICallback
 void PhysX_Init(const PINT_WORLD_CREATE& desc)
 {
 	PhysX3::GetOptionsFromGUI(desc.GetTestName());
+	PhysX3::GetOptionsFromDesc(desc);
 
 	for(PxU16 j=0;j<32;j++)
 		for(PxU16 i=0;i<32;i++)
@@ -1015,6 +1042,7 @@ class PhysXPlugIn : public PintPlugin
 	virtual	void		Init(const PINT_WORLD_CREATE& desc)					{ PhysX_Init(desc);						}
 	virtual	void		Close()												{ PhysX_Close();						}
 	virtual	Pint*		GetPint()											{ return GetPhysX();					}
+	virtual	void		GetSettings(PintSettingsCallback& callback)			{ PhysX3::GetSettings(callback);		}
 };
 static PhysXPlugIn gPlugIn;
 
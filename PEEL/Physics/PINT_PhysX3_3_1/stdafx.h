@@ -26,6 +26,11 @@ using namespace physx;
 #define PHYSX_SUPPORT_DISABLE_ACTIVE_EDGES_PRECOMPUTE
 #define PHYSX_SUPPORT_SCRATCH_BUFFER
 #define PHYSX_SUPPORT_SUBSTEPS
+#define PHYSX_SUPPORT_ADD_ACTORS
+#define PHYSX_SUPPORT_REMOVE_ACTORS
+#define PHYSX_SUPPORT_CONCURRENT_SQ
+#define PHYSX_SUPPORT_SCENE_RW_LOCK
+#define PHYSX_SUPPORT_ASYNC_UPDATE
 
 typedef PxPruningStructure	PxPruningStructureType;
 
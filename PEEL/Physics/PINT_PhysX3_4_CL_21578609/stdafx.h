@@ -48,6 +48,12 @@ using namespace physx;
 #define PHYSX_SUPPORT_USER_DEFINED_GAUSSMAP_LIMIT
 #define PHYSX_REMOVE_JOINT_32_COMPATIBILITY
 #define PHYSX_SUPPORT_SUBSTEPS
+#define PHYSX_SUPPORT_ADD_ACTORS
+#define PHYSX_SUPPORT_REMOVE_ACTORS
+#define PHYSX_SUPPORT_PRUNING_STRUCTURE
+#define PHYSX_SUPPORT_CONCURRENT_SQ
+#define PHYSX_SUPPORT_SCENE_RW_LOCK
+#define PHYSX_SUPPORT_ASYNC_UPDATE
 
 // Copy of deprecated 3.3 stuff
 #define PxSceneQueryFlag PxHitFlag
@@ -10,6 +10,7 @@
 #define PINT_H
 
 #include "PintDef.h"
+#include "PintAllocTracker.h"
 
 	class PintSQ;
 	class ObjectsManager;
@@ -91,10 +92,18 @@
 	class PINT_WORLD_CREATE : public Allocateable
 	{
 		protected:
-		const char*					mTestName;	// Setup by the system
+		const char*					mTestName;				// Setup by the system
+		udword						mWorkerThreadAffinity;	// Setup by the system
+		PintAllocatorType			mAllocatorType;			// Setup by the system
+		udword						mNbWorkerThreads;		// Setup by the system
+		bool						mAllocTracking;			// Setup by the system
 		public:
 									PINT_WORLD_CREATE() :
 										mTestName				(null),
+										mWorkerThreadAffinity	(0),
+										mAllocatorType			(PINT_ALLOCATOR_SYSTEM),
+										mNbWorkerThreads		(INVALID_ID),
+										mAllocTracking			(false),
 										mGravity				(0.0f, 0.0f, 0.0f),
 										mNbSimulateCallsPerFrame(1),
 										mTimestep				(1.0f/60.0f)
@@ -121,6 +130,37 @@
 				float				mTimestep;
 
 		inline	const char*			GetTestName()	const	{ return mTestName;	}
+
+		// Mask of cores the engine's own worker threads should run on (bit i = core i), or 0 to let the OS decide.
+		inline	udword				GetWorkerThreadAffinity()	const	{ return mWorkerThreadAffinity;	}
+
+		// Allocator backend the plugin's allocator hooks should use (see PINT_Common\PINT_CommonAllocator.h).
+		inline	PintAllocatorType	GetAllocatorType()	const	{ return mAllocatorType;	}
+
+		// Number of worker threads the engine should use, overriding the plugin's own setting, or INVALID_ID to keep it.
+		// This is used to compare runs with different thread counts, e.g. for determinism checks.
+		inline	udword				GetNbWorkerThreads()	const	{ return mNbWorkerThreads;	}
+
+		// True if the plugin's PintAllocTracker should record allocations (see PintAllocTracker.h). It is off by default
+		// because the tracking itself runs within the timed updates.
+		inline	bool				GetAllocTracking()	const	{ return mAllocTracking;	}
+
+		// Fills one single-core mask per worker thread, spreading the threads over the cores of the affinity mask.
+		// Returns null if there is no affinity, so that the result can be passed as-is to engines' thread pools.
+		inline	udword*				GetWorkerThreadAffinities(udword nb_threads, udword* masks)	const
+									{
+										if(!mWorkerThreadAffinity)
+											return null;
+										udword Core = 0;
+										for(udword i=0;i<nb_threads;i++)
+										{
+											while(!(mWorkerThreadAffinity & (udword(1)<<Core)))
+												Core = (Core+1) & 31;
+											masks[i] = udword(1)<<Core;
+											Core = (Core+1) & 31;
+										}
+										return masks;
+									}
 	};
 
 	struct PINT_MATERIAL_CREATE	: public Allocateable
@@ -716,6 +756,10 @@
 	{
 		PINT_IS_ACTIVE				= (1<<0),
 		PINT_HAS_RAYTRACING_WINDOW	= (1<<1),
+		PINT_MAIN_THREAD_ONLY		= (1<<2),	// Relies on process-wide or per-thread state (e.g. Ice allocator switch, Havok memory router): must be updated alone, from the main thread
+		PINT_CONCURRENT_SQ			= (1<<3),	// Batch* queries can be called from several threads at the same time (outside of simulation), each with its own PintSQThreadContext
+		PINT_SQ_DURING_UPDATE		= (1<<4),	// Batch* queries can be called from other threads while Update() runs on the main thread (e.g. against the previous frame's state)
+		PINT_ASYNC_UPDATE			= (1<<5),	// Implements BeginUpdate() & EndUpdate()
 		PINT_DEFAULT				= PINT_IS_ACTIVE|PINT_HAS_RAYTRACING_WINDOW,
 	};
 
@@ -737,13 +781,44 @@
 		virtual	void				SetGravity(const Point& gravity)																						= 0;
 		virtual	void				Close()																													= 0;
 		virtual	udword				Update(float dt)																										= 0;
+		// Asynchronous version of Update(), for engines flagged PINT_ASYNC_UPDATE. BeginUpdate() starts the step and returns as
+		// soon as possible, EndUpdate() waits for it to complete and returns the same as Update(). Nothing else can be called
+		// in between, except Batch* queries from other threads for engines flagged PINT_SQ_DURING_UPDATE.
+		virtual	void				BeginUpdate(float dt)																									{ NotImplemented("BeginUpdate");				}
+		virtual	udword				EndUpdate()																												{ NotImplemented("EndUpdate");	return 0;		}
 		virtual	void				UpdateNonProfiled(float dt)																								{}
+		// Allocation telemetry (see PintAllocTracker.h), or null if the plugin doesn't track its allocations.
+		virtual	const PintAllocStats*	GetAllocStats()																										{ return null;	}
 		virtual	Point				GetMainColor()																											= 0;
 		virtual	void				Render(PintRender& renderer)																							= 0;
 
 		virtual	void				SetDisabledGroups(udword nb_groups, const PintDisabledGroups* groups)													= 0;
 		virtual	PintObjectHandle	CreateObject(const PINT_OBJECT_CREATE& desc)																			= 0;
 		virtual	bool				ReleaseObject(PintObjectHandle handle)																					= 0;
+		// Batched version of CreateObject(). handles[i] receives the handle for descs[i] (null if creation failed), returns the
+		// number of created objects. Engines should override this to use their bulk insertion paths.
+		virtual	udword				CreateObjects(udword nb, const PINT_OBJECT_CREATE* descs, PintObjectHandle* handles)
+									{
+										udword NbCreated = 0;
+										for(udword i=0;i<nb;i++)
+										{
+											handles[i] = CreateObject(descs[i]);
+											if(handles[i])
+												NbCreated++;
+										}
+										return NbCreated;
+									}
+		// Batched version of ReleaseObject(). Null handles are skipped. Returns the number of released objects.
+		virtual	udword				ReleaseObjects(udword nb, const PintObjectHandle* handles)
+									{
+										udword NbReleased = 0;
+										for(udword i=0;i<nb;i++)
+										{
+											if(handles[i] && ReleaseObject(handles[i]))
+												NbReleased++;
+										}
+										return NbReleased;
+									}
 		virtual	PintJointHandle		CreateJoint(const PINT_JOINT_CREATE& desc)																				= 0;
 
 		virtual	void*				CreatePhantom(const AABB& box)																												{ NotImplemented("CreatePhantom");			return null;}
@@ -771,6 +846,16 @@
 
 		virtual	PR					GetWorldTransform(PintObjectHandle handle)																				{ NotImplemented("GetWorldTransform");	PR Idt; Idt.Identity();	return Idt;	}
 		virtual	void				SetWorldTransform(PintObjectHandle handle, const PR& pose)																{ NotImplemented("SetWorldTransform");	}
+		// Bulk pose readback. poses[i] receives the pose of handles[i]. Engines should override this to avoid one virtual call per object.
+		virtual	void				GetWorldTransforms(udword nb, const PintObjectHandle* handles, PR* poses)
+									{
+										for(udword i=0;i<nb;i++)
+											poses[i] = GetWorldTransform(handles[i]);
+									}
+		// SoA readback of the objects that moved during the last update. Writes at most max_nb entries and returns the number
+		// of written entries. "handles" can be null. Returns INVALID_ID when the engine cannot tell which objects moved, in
+		// which case the caller should use GetWorldTransforms() on all its handles (see ObjectsManager::GetWorldTransforms).
+		virtual	udword				GetActiveTransforms(udword max_nb, PintObjectHandle* handles, Point* positions, Quat* rotations)	{ return INVALID_ID;	}
 
 		// Deprecated
 //		virtual	void				ApplyActionAtPoint(PintObjectHandle handle, PintActionType action_type, const Point& action, const Point& pos)			{ NotImplemented("ApplyActionAtPoint");	}
@@ -822,6 +907,13 @@
 				void*				mUserData;
 	};
 
+	// Receives a plugin's current settings as name/value pairs. Values are copied, they can live in temporary buffers.
+	class PintSettingsCallback
+	{
+		public:
+		virtual	void				ReportSetting(const char* name, const char* value)	= 0;
+	};
+
 	class PintPlugin : public Allocateable
 	{
 		public:
@@ -833,6 +925,8 @@
 		virtual	void				Init(const PINT_WORLD_CREATE& desc)					= 0;
 		virtual	void				Close()												= 0;
 		virtual	Pint*				GetPint()											= 0;
+		// Reports the settings (usually from the plugin's UI) used by the current test. Stored with the results.
+		virtual	void				GetSettings(PintSettingsCallback& callback)			{}
 	};
 
 #endif
@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef PINT_ALLOC_TRACKER_H
+#define PINT_ALLOC_TRACKER_H
+
+#ifdef _WIN32
+	#include <intrin.h>
+#endif
+
+	// Allocation telemetry common to all plugins. A plugin feeds a PintAllocTracker from its allocator hooks and returns
+	// the tracker's stats from Pint::GetAllocStats(). Counters are cumulative since the last Reset(): PEEL computes the
+	// per-frame values itself, from the difference between the stats before & after each Pint::Update() call.
+	//
+	// Updates are atomic, so engines can allocate from their worker threads. Everything is inline, plugins don't need
+	// to link anything.
+	//
+	// Tracking is off by default: the updates run in the allocator hooks, i.e. within the timed Pint::Update() calls,
+	// and the atomics would inflate the timings. Plugins enable it in Init() when PINT_WORLD_CREATE::GetAllocTracking()
+	// is set, see Common_SetAllocator().
+
+	// Allocator backends the plugins' allocator hooks run on, see PINT_WORLD_CREATE::GetAllocatorType().
+	enum PintAllocatorType
+	{
+		PINT_ALLOCATOR_SYSTEM,	// Plain aligned malloc/free
+		PINT_ALLOCATOR_ARENA,	// Bump allocation from large chunks, a chunk is reset once all its blocks have been freed
+		PINT_ALLOCATOR_POOL,	// Size-class free lists with per-thread caches
+	};
+
+	// Size class i contains allocations up to (PINT_ALLOC_SIZE_CLASS_MIN<<i) bytes, the last one all larger allocations.
+	#define PINT_NB_ALLOC_SIZE_CLASSES	16
+	#define PINT_ALLOC_SIZE_CLASS_MIN	16
+
+	struct PintAllocStats
+	{
+		uqword	mNbAllocs;
+		uqword	mNbFrees;
+		uqword	mAllocatedBytes;
+		uqword	mFreedBytes;
+		uqword	mCurrentBytes;
+		uqword	mPeakBytes;
+		uqword	mSizeClasses[PINT_NB_ALLOC_SIZE_CLASSES];	// Number of allocations per size class
+	};
+
+	inline_	udword	GetPintAllocSizeClass(size_t size)
+	{
+		udword SizeClass = 0;
+		size_t Limit = PINT_ALLOC_SIZE_CLASS_MIN;
+		while(size>Limit && SizeClass<PINT_NB_ALLOC_SIZE_CLASSES-1)
+		{
+			Limit<<=1;
+			SizeClass++;
+		}
+		return SizeClass;
+	}
+
+	// Upper bound of a size class in bytes, or 0 for the last (unbounded) one
+	inline_	udword	GetPintAllocSizeClassLimit(udword size_class)
+	{
+		return size_class<PINT_NB_ALLOC_SIZE_CLASSES-1 ? PINT_ALLOC_SIZE_CLASS_MIN<<size_class : 0;
+	}
+
+	// Returns the new value
+	inline_	uqword	PintAtomicAdd(volatile uqword* value, uqword delta)
+	{
+#ifdef _WIN32
+		uqword OldValue, NewValue;
+		do
+		{
+			OldValue = *value;
+			NewValue = OldValue + delta;
+		} while(uqword(_InterlockedCompareExchange64((volatile __int64*)value, __int64(NewValue), __int64(OldValue)))!=OldValue);
+		return NewValue;
+#else
+		return __sync_add_and_fetch(value, delta);
+#endif
+	}
+
+	inline_	void	PintAtomicMax(volatile uqword* value, uqword candidate)
+	{
+		uqword OldValue;
+		while((OldValue = *value)<candidate)
+		{
+#ifdef _WIN32
+			if(uqword(_InterlockedCompareExchange64((volatile __int64*)value, __int64(candidate), __int64(OldValue)))==OldValue)
+#else
+			if(__sync_bool_compare_and_swap(value, OldValue, candidate))
+#endif
+				break;
+		}
+	}
+
+	// Per-module switch, i.e. each plugin has its own
+	inline_	bool&	PintAllocTracking()
+	{
+		static bool Enabled = false;
+		return Enabled;
+	}
+
+	class PintAllocTracker
+	{
+		public:
+		inline_						PintAllocTracker()	{ Reset();	}
+
+		inline_	void				Reset()
+									{
+										memset((void*)&mStats, 0, sizeof(PintAllocStats));
+									}
+
+		// Restarts peak tracking from the current live bytes, for allocators that outlive Pint::Init/Close (live blocks stay counted).
+		// Their live bytes are only exact if tracking isn't switched on or off between tests.
+		inline_	void				ResetPeak()
+									{
+										mStats.mPeakBytes = mStats.mCurrentBytes;
+									}
+
+		inline_	void				OnAlloc(size_t size)
+									{
+										if(!PintAllocTracking())
+											return;
+										PintAtomicAdd(&mStats.mNbAllocs, 1);
+										PintAtomicAdd(&mStats.mAllocatedBytes, size);
+										PintAtomicMax(&mStats.mPeakBytes, PintAtomicAdd(&mStats.mCurrentBytes, size));
+										PintAtomicAdd(&mStats.mSizeClasses[GetPintAllocSizeClass(size)], 1);
+									}
+
+		inline_	void				OnFree(size_t size)
+									{
+										if(!PintAllocTracking())
+											return;
+										PintAtomicAdd(&mStats.mNbFrees, 1);
+										PintAtomicAdd(&mStats.mFreedBytes, size);
+										PintAtomicAdd(&mStats.mCurrentBytes, uqword(0)-uqword(size));
+									}
+
+		inline_	const PintAllocStats&	GetStats()	const	{ return const_cast<const PintAllocStats&>(mStats);	}
+
+		// Live bytes for Pint::Update()'s return value, saturated to 32 bits
+		inline_	udword				GetCurrentMemory()	const
+									{
+										const uqword Current = mStats.mCurrentBytes;
+										return Current<0xffffffff ? udword(Current) : 0xffffffff;
+									}
+		private:
+		volatile PintAllocStats		mStats;
+	};
+
+#endif
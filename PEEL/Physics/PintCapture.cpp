@@ -0,0 +1,1920 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "PintCapture.h"
+#include "PintSQ.h"
+#include "Simulation.h"
+
+// File format: a header (magic, version, test name, recorded engine's name, world params) followed by a stream of calls.
+// Each call is a CaptureOp followed by its parameters. All values are 32-bit, arrays are padded to 4 bytes, so that
+// the replay can use the data in place.
+#define CAPTURE_MAGIC	udword('PCF!')
+#define CAPTURE_VERSION	1
+
+namespace
+{
+	enum CaptureOp
+	{
+		CAPTURE_END,
+		CAPTURE_UPDATE,
+		CAPTURE_UPDATE_NON_PROFILED,
+		CAPTURE_SET_GRAVITY,
+		CAPTURE_SET_DISABLED_GROUPS,
+		CAPTURE_CREATE_OBJECT,
+		CAPTURE_CREATE_OBJECTS,
+		CAPTURE_RELEASE_OBJECT,
+		CAPTURE_RELEASE_OBJECTS,
+		CAPTURE_CREATE_JOINT,
+		CAPTURE_CREATE_PHANTOM,
+		CAPTURE_BATCH_RAYCASTS_PHANTOM,
+		CAPTURE_BATCH_RAYCASTS,
+		CAPTURE_BATCH_RAYCAST_ANY,
+		CAPTURE_BATCH_RAYCAST_ALL,
+		CAPTURE_BATCH_BOX_SWEEPS,
+		CAPTURE_BATCH_SPHERE_SWEEPS,
+		CAPTURE_BATCH_CAPSULE_SWEEPS,
+		CAPTURE_BATCH_CONVEX_SWEEPS,
+		CAPTURE_BATCH_SPHERE_OVERLAP_ANY,
+		CAPTURE_BATCH_SPHERE_OVERLAP_OBJECTS,
+		CAPTURE_BATCH_BOX_OVERLAP_ANY,
+		CAPTURE_BATCH_BOX_OVERLAP_OBJECTS,
+		CAPTURE_BATCH_CAPSULE_OVERLAP_ANY,
+		CAPTURE_BATCH_CAPSULE_OVERLAP_OBJECTS,
+		CAPTURE_FIND_TRIANGLES_SPHERE,
+		CAPTURE_FIND_TRIANGLES_BOX,
+		CAPTURE_FIND_TRIANGLES_CAPSULE,
+		CAPTURE_SET_WORLD_TRANSFORM,
+		CAPTURE_ADD_WORLD_IMPULSE,
+		CAPTURE_ADD_LOCAL_TORQUE,
+		CAPTURE_SET_ANGULAR_VELOCITY,
+		CAPTURE_GET_SHAPES,
+		CAPTURE_SET_LOCAL_ROT,
+		CAPTURE_SET_KINEMATIC_POSITION,
+		CAPTURE_SET_KINEMATIC_POSE,
+		CAPTURE_CREATE_CONVEX_OBJECT,
+		CAPTURE_CREATE_AGGREGATE,
+		CAPTURE_ADD_TO_AGGREGATE,
+		CAPTURE_ADD_AGGREGATE_TO_SCENE,
+		CAPTURE_CREATE_ARTICULATION,
+		CAPTURE_CREATE_ARTICULATED_OBJECT,
+		CAPTURE_ADD_ARTICULATION_TO_SCENE,
+		CAPTURE_SET_ARTICULATED_MOTOR,
+		CAPTURE_CREATE_VEHICLE,
+		CAPTURE_SET_VEHICLE_INPUT,
+	};
+
+	enum CaptureVehicleInput
+	{
+		CAPTURE_VEHICLE_ACCELERATE	= (1<<0),
+		CAPTURE_VEHICLE_BRAKE		= (1<<1),
+		CAPTURE_VEHICLE_LEFT		= (1<<2),
+		CAPTURE_VEHICLE_RIGHT		= (1<<3),
+	};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static inline_ udword HashPointer(const void* key)
+{
+	// Fibonacci hashing, low bits are mostly zero because of alignment
+	const size_t Value = size_t(key);
+	return (udword(Value>>4) ^ udword(uqword(Value)>>32)) * 2654435761u;
+}
+
+CaptureIDMap::CaptureIDMap() :
+	mKeys		(null),
+	mIDs		(null),
+	mCapacity	(0),
+	mNbKeys		(0)
+{
+}
+
+CaptureIDMap::~CaptureIDMap()
+{
+	Reset();
+}
+
+void CaptureIDMap::Reset()
+{
+	ICE_FREE(mIDs);
+	ICE_FREE(mKeys);
+	mCapacity = 0;
+	mNbKeys = 0;
+}
+
+void CaptureIDMap::Grow()
+{
+	const void** OldKeys = mKeys;
+	udword* OldIDs = mIDs;
+	const udword OldCapacity = mCapacity;
+
+	mCapacity = mCapacity ? mCapacity*2 : 256;
+	mKeys = (const void**)ICE_ALLOC(sizeof(void*)*mCapacity);
+	mIDs = (udword*)ICE_ALLOC(sizeof(udword)*mCapacity);
+	ZeroMemory(mKeys, sizeof(void*)*mCapacity);
+	mNbKeys = 0;
+
+	for(udword i=0;i<OldCapacity;i++)
+	{
+		if(OldKeys[i])
+			SetID(OldKeys[i], OldIDs[i]);
+	}
+	ICE_FREE(OldIDs);
+	ICE_FREE(OldKeys);
+}
+
+void CaptureIDMap::SetID(const void* key, udword id)
+{
+	if(!key)
+		return;
+
+	// Released keys keep their slot (with INVALID_ID), engines often reuse them
+	if((mNbKeys+1)*2>mCapacity)
+		Grow();
+
+	const udword Mask = mCapacity-1;
+	udword Index = HashPointer(key) & Mask;
+	while(mKeys[Index] && mKeys[Index]!=key)
+		Index = (Index+1) & Mask;
+
+	if(!mKeys[Index])
+	{
+		mKeys[Index] = key;
+		mNbKeys++;
+	}
+	mIDs[Index] = id;
+}
+
+udword CaptureIDMap::GetID(const void* key) const
+{
+	if(!key || !mCapacity)
+		return INVALID_ID;
+
+	const udword Mask = mCapacity-1;
+	udword Index = HashPointer(key) & Mask;
+	while(mKeys[Index])
+	{
+		if(mKeys[Index]==key)
+			return mIDs[Index];
+		Index = (Index+1) & Mask;
+	}
+	return INVALID_ID;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+PintRecorder::PintRecorder(Pint& engine) :
+	mEngine		(engine),
+	mFile		(null),
+	mNbHandles	(0),
+	mNbRenderers(0)
+{
+}
+
+PintRecorder::~PintRecorder()
+{
+	Finish();
+}
+
+bool PintRecorder::Open(const char* filename, const PINT_WORLD_CREATE& desc)
+{
+	Finish();
+
+	mFile = fopen(filename, "wb");
+	if(!mFile)
+		return false;
+
+	WriteDword(CAPTURE_MAGIC);
+	WriteDword(CAPTURE_VERSION);
+	WriteString(desc.GetTestName());
+	WriteString(mEngine.GetName());
+	WriteData(&desc.mGravity, sizeof(Point));
+	WriteData(&desc.mGlobalBounds, sizeof(AABB));
+	WriteDword(desc.mNbSimulateCallsPerFrame);
+	WriteFloat(desc.mTimestep);
+	return true;
+}
+
+void PintRecorder::Finish()
+{
+	if(mFile)
+	{
+		WriteDword(CAPTURE_END);
+		fclose(mFile);
+		mFile = null;
+	}
+	mHandles.Reset();
+	mRenderers.Reset();
+	mConvexObjects.Empty();
+	mNbHandles = 0;
+	mNbRenderers = 0;
+}
+
+void PintRecorder::WriteDword(udword value)
+{
+	if(mFile)
+		fwrite(&value, sizeof(udword), 1, mFile);
+}
+
+void PintRecorder::WriteFloat(float value)
+{
+	if(mFile)
+		fwrite(&value, sizeof(float), 1, mFile);
+}
+
+void PintRecorder::WriteData(const void* data, udword size)
+{
+	if(!mFile || !size)
+		return;
+	fwrite(data, size, 1, mFile);
+
+	const udword Padding = (4 - (size & 3)) & 3;
+	if(Padding)
+	{
+		const udword Zero = 0;
+		fwrite(&Zero, Padding, 1, mFile);
+	}
+}
+
+void PintRecorder::WriteString(const char* string)
+{
+	const udword Length = string ? udword(strlen(string))+1 : 0;
+	WriteDword(Length);
+	WriteData(string, Length);
+}
+
+void PintRecorder::WriteHandle(PintObjectHandle handle)
+{
+	WriteDword(mHandles.GetID(handle));
+}
+
+void PintRecorder::WriteRenderer(const PintShapeRenderer* renderer)
+{
+	// New renderers get the next ID, the replay creates them on first use
+	udword ID = mRenderers.GetID(renderer);
+	if(renderer && ID==INVALID_ID)
+	{
+		ID = mNbRenderers++;
+		mRenderers.SetID(renderer, ID);
+	}
+	WriteDword(ID);
+}
+
+PintObjectHandle PintRecorder::NewHandle(PintObjectHandle handle)
+{
+	mHandles.SetID(handle, mNbHandles++);
+	return handle;
+}
+
+void PintRecorder::WriteShape(const PINT_SHAPE_CREATE& shape)
+{
+	WriteDword(shape.mType);
+	WriteData(&shape.mLocalPos, sizeof(Point));
+	WriteData(&shape.mLocalRot, sizeof(Quat));
+	WriteDword(shape.mMaterial!=null);
+	if(shape.mMaterial)
+	{
+		WriteFloat(shape.mMaterial->mStaticFriction);
+		WriteFloat(shape.mMaterial->mDynamicFriction);
+		WriteFloat(shape.mMaterial->mRestitution);
+	}
+	WriteRenderer(shape.mRenderer);
+
+	switch(shape.mType)
+	{
+		case PINT_SHAPE_SPHERE:
+		{
+			const PINT_SPHERE_CREATE& Create = static_cast<const PINT_SPHERE_CREATE&>(shape);
+			WriteFloat(Create.mRadius);
+		}
+		break;
+
+		case PINT_SHAPE_CAPSULE:
+		{
+			const PINT_CAPSULE_CREATE& Create = static_cast<const PINT_CAPSULE_CREATE&>(shape);
+			WriteFloat(Create.mRadius);
+			WriteFloat(Create.mHalfHeight);
+		}
+		break;
+
+		case PINT_SHAPE_CYLINDER:
+		{
+			const PINT_CYLINDER_CREATE& Create = static_cast<const PINT_CYLINDER_CREATE&>(shape);
+			WriteFloat(Create.mRadius);
+			WriteFloat(Create.mHalfHeight);
+		}
+		break;
+
+		case PINT_SHAPE_BOX:
+		{
+			const PINT_BOX_CREATE& Create = static_cast<const PINT_BOX_CREATE&>(shape);
+			WriteData(&Create.mExtents, sizeof(Point));
+		}
+		break;
+
+		case PINT_SHAPE_CONVEX:
+		{
+			const PINT_CONVEX_CREATE& Create = static_cast<const PINT_CONVEX_CREATE&>(shape);
+			WriteDword(Create.mNbVerts);
+			WriteData(Create.mVerts, sizeof(Point)*Create.mNbVerts);
+		}
+		break;
+
+		case PINT_SHAPE_MESH:
+		{
+			const SurfaceInterface& Surface = static_cast<const PINT_MESH_CREATE&>(shape).mSurface;
+			WriteDword(Surface.mNbVerts);
+			WriteData(Surface.mVerts, sizeof(Point)*Surface.mNbVerts);
+			WriteDword(Surface.mNbFaces);
+			// 1 for 32-bit indices, 0 for 16-bit indices
+			WriteDword(Surface.mDFaces!=null);
+			if(Surface.mDFaces)
+				WriteData(Surface.mDFaces, sizeof(udword)*3*Surface.mNbFaces);
+			else
+				WriteData(Surface.mWFaces, sizeof(uword)*3*Surface.mNbFaces);
+		}
+		break;
+	};
+}
+
+void PintRecorder::WriteObject(const PINT_OBJECT_CREATE& desc)
+{
+	WriteDword(desc.GetNbShapes());
+	const PINT_SHAPE_CREATE* CurrentShape = desc.mShapes;
+	while(CurrentShape)
+	{
+		WriteShape(*CurrentShape);
+		CurrentShape = CurrentShape->mNext;
+	}
+	WriteData(&desc.mPosition, sizeof(Point));
+	WriteData(&desc.mRotation, sizeof(Quat));
+	WriteData(&desc.mCOMLocalOffset, sizeof(Point));
+	WriteData(&desc.mLinearVelocity, sizeof(Point));
+	WriteData(&desc.mAngularVelocity, sizeof(Point));
+	WriteFloat(desc.mMass);
+	WriteFloat(desc.mMassForInertia);
+	WriteDword(desc.mCollisionGroup);
+	WriteDword(desc.mKinematic);
+	WriteDword(desc.mAddToWorld);
+}
+
+void PintRecorder::WriteMotor(const PINT_ARTICULATED_MOTOR_CREATE& motor)
+{
+	WriteData(&motor.mTargetOrientation, sizeof(Quat));
+	WriteData(&motor.mTargetVelocity, sizeof(Point));
+	WriteFloat(motor.mExternalCompliance);
+	WriteFloat(motor.mInternalCompliance);
+	WriteFloat(motor.mStiffness);
+	WriteFloat(motor.mDamping);
+}
+
+void PintRecorder::WriteQueries(udword op, udword nb, const void* queries, udword size)
+{
+	WriteDword(op);
+	WriteDword(nb);
+	WriteData(queries, nb*size);
+}
+
+const char* PintRecorder::GetName() const
+{
+	return mEngine.GetName();
+}
+
+void PintRecorder::GetCaps(PintCaps& caps) const
+{
+	mEngine.GetCaps(caps);
+}
+
+udword PintRecorder::GetFlags() const
+{
+	return (mEngine.GetFlags() & ~(PINT_CONCURRENT_SQ|PINT_SQ_DURING_UPDATE|PINT_ASYNC_UPDATE)) | PINT_MAIN_THREAD_ONLY;
+}
+
+void PintRecorder::Init(const PINT_WORLD_CREATE& desc)
+{
+	mEngine.Init(desc);
+}
+
+void PintRecorder::SetGravity(const Point& gravity)
+{
+	WriteDword(CAPTURE_SET_GRAVITY);
+	WriteData(&gravity, sizeof(Point));
+	mEngine.SetGravity(gravity);
+}
+
+void PintRecorder::Close()
+{
+	mEngine.Close();
+}
+
+udword PintRecorder::Update(float dt)
+{
+	WriteDword(CAPTURE_UPDATE);
+	WriteFloat(dt);
+	return mEngine.Update(dt);
+}
+
+void PintRecorder::UpdateNonProfiled(float dt)
+{
+	WriteDword(CAPTURE_UPDATE_NON_PROFILED);
+	WriteFloat(dt);
+	mEngine.UpdateNonProfiled(dt);
+}
+
+const PintAllocStats* PintRecorder::GetAllocStats()
+{
+	return mEngine.GetAllocStats();
+}
+
+Point PintRecorder::GetMainColor()
+{
+	return mEngine.GetMainColor();
+}
+
+void PintRecorder::Render(PintRender& renderer)
+{
+	mEngine.Render(renderer);
+}
+
+void PintRecorder::SetDisabledGroups(udword nb_groups, const PintDisabledGroups* groups)
+{
+	WriteDword(CAPTURE_SET_DISABLED_GROUPS);
+	WriteDword(nb_groups);
+	for(udword i=0;i<nb_groups;i++)
+	{
+		WriteDword(groups[i].mGroup0);
+		WriteDword(groups[i].mGroup1);
+	}
+	mEngine.SetDisabledGroups(nb_groups, groups);
+}
+
+PintObjectHandle PintRecorder::CreateObject(const PINT_OBJECT_CREATE& desc)
+{
+	WriteDword(CAPTURE_CREATE_OBJECT);
+	WriteObject(desc);
+	return NewHandle(mEngine.CreateObject(desc));
+}
+
+bool PintRecorder::ReleaseObject(PintObjectHandle handle)
+{
+	WriteDword(CAPTURE_RELEASE_OBJECT);
+	WriteHandle(handle);
+	mHandles.SetID(handle, INVALID_ID);
+	return mEngine.ReleaseObject(handle);
+}
+
+udword PintRecorder::CreateObjects(udword nb, const PINT_OBJECT_CREATE* descs, PintObjectHandle* handles)
+{
+	// The total number of shapes comes first, so that the replay can allocate them all at once
+	udword NbShapes = 0;
+	for(udword i=0;i<nb;i++)
+		NbShapes += descs[i].GetNbShapes();
+
+	WriteDword(CAPTURE_CREATE_OBJECTS);
+	WriteDword(nb);
+	WriteDword(NbShapes);
+	for(udword i=0;i<nb;i++)
+		WriteObject(descs[i]);
+
+	const udword NbCreated = mEngine.CreateObjects(nb, descs, handles);
+	for(udword i=0;i<nb;i++)
+		NewHandle(handles[i]);
+	return NbCreated;
+}
+
+udword PintRecorder::ReleaseObjects(udword nb, const PintObjectHandle* handles)
+{
+	WriteDword(CAPTURE_RELEASE_OBJECTS);
+	WriteDword(nb);
+	for(udword i=0;i<nb;i++)
+		WriteHandle(handles[i]);
+	for(udword i=0;i<nb;i++)
+		mHandles.SetID(handles[i], INVALID_ID);
+	return mEngine.ReleaseObjects(nb, handles);
+}
+
+PintJointHandle PintRecorder::CreateJoint(const PINT_JOINT_CREATE& desc)
+{
+	// Joint handles are not used by the Pint API, they don't need IDs
+	WriteDword(CAPTURE_CREATE_JOINT);
+	WriteDword(desc.mType);
+	WriteHandle(desc.mObject0);
+	WriteHandle(desc.mObject1);
+	switch(desc.mType)
+	{
+		case PINT_JOINT_SPHERICAL:
+		{
+			const PINT_SPHERICAL_JOINT_CREATE& Create = static_cast<const PINT_SPHERICAL_JOINT_CREATE&>(desc);
+			WriteData(&Create.mLocalPivot0, sizeof(Point));
+			WriteData(&Create.mLocalPivot1, sizeof(Point));
+		}
+		break;
+
+		case PINT_JOINT_HINGE:
+		{
+			const PINT_HINGE_JOINT_CREATE& Create = static_cast<const PINT_HINGE_JOINT_CREATE&>(desc);
+			WriteData(&Create.mLocalPivot0, sizeof(Point));
+			WriteData(&Create.mLocalPivot1, sizeof(Point));
+			WriteData(&Create.mLocalAxis0, sizeof(Point));
+			WriteData(&Create.mLocalAxis1, sizeof(Point));
+			WriteFloat(Create.mMinLimitAngle);
+			WriteFloat(Create.mMaxLimitAngle);
+			WriteData(&Create.mGlobalAnchor, sizeof(Point));
+			WriteData(&Create.mGlobalAxis, sizeof(Point));
+		}
+		break;
+
+		case PINT_JOINT_PRISMATIC:
+		{
+			const PINT_PRISMATIC_JOINT_CREATE& Create = static_cast<const PINT_PRISMATIC_JOINT_CREATE&>(desc);
+			WriteData(&Create.mLocalPivot0, sizeof(Point));
+			WriteData(&Create.mLocalPivot1, sizeof(Point));
+			WriteData(&Create.mLocalAxis0, sizeof(Point));
+			WriteData(&Create.mLocalAxis1, sizeof(Point));
+			WriteFloat(Create.mMinLimit);
+			WriteFloat(Create.mMaxLimit);
+			WriteFloat(Create.mSpringStiffness);
+			WriteFloat(Create.mSpringDamping);
+		}
+		break;
+
+		case PINT_JOINT_FIXED:
+		{
+			const PINT_FIXED_JOINT_CREATE& Create = static_cast<const PINT_FIXED_JOINT_CREATE&>(desc);
+			WriteData(&Create.mLocalPivot0, sizeof(Point));
+			WriteData(&Create.mLocalPivot1, sizeof(Point));
+		}
+		break;
+
+		case PINT_JOINT_DISTANCE:
+		{
+			const PINT_DISTANCE_JOINT_CREATE& Create = static_cast<const PINT_DISTANCE_JOINT_CREATE&>(desc);
+			WriteData(&Create.mLocalPivot0, sizeof(Point));
+			WriteData(&Create.mLocalPivot1, sizeof(Point));
+			WriteFloat(Create.mMinDistance);
+			WriteFloat(Create.mMaxDistance);
+		}
+		break;
+	};
+	return mEngine.CreateJoint(desc);
+}
+
+void* PintRecorder::CreatePhantom(const AABB& box)
+{
+	WriteDword(CAPTURE_CREATE_PHANTOM);
+	WriteData(&box, sizeof(AABB));
+	return NewHandle(mEngine.CreatePhantom(box));
+}
+
+udword PintRecorder::BatchRaycastsPhantom(udword nb, PintRaycastHit* dest, const PintRaycastData* raycasts, void** phantoms)
+{
+	WriteQueries(CAPTURE_BATCH_RAYCASTS_PHANTOM, nb, raycasts, sizeof(PintRaycastData));
+	for(udword i=0;i<nb;i++)
+		WriteHandle(phantoms[i]);
+	return mEngine.BatchRaycastsPhantom(nb, dest, raycasts, phantoms);
+}
+
+udword PintRecorder::BatchRaycasts(PintSQThreadContext context, udword nb, PintRaycastHit* dest, const PintRaycastData* raycasts)
+{
+	WriteQueries(CAPTURE_BATCH_RAYCASTS, nb, raycasts, sizeof(PintRaycastData));
+	return mEngine.BatchRaycasts(context, nb, dest, raycasts);
+}
+
+udword PintRecorder::BatchRaycastAny(PintSQThreadContext context, udword nb, PintBooleanHit* dest, const PintRaycastData* raycasts)
+{
+	WriteQueries(CAPTURE_BATCH_RAYCAST_ANY, nb, raycasts, sizeof(PintRaycastData));
+	return mEngine.BatchRaycastAny(context, nb, dest, raycasts);
+}
+
+udword PintRecorder::BatchRaycastAll(PintSQThreadContext context, udword nb, PintOverlapObjectHit* dest, const PintRaycastData* raycasts)
+{
+	WriteQueries(CAPTURE_BATCH_RAYCAST_ALL, nb, raycasts, sizeof(PintRaycastData));
+	return mEngine.BatchRaycastAll(context, nb, dest, raycasts);
+}
+
+udword PintRecorder::BatchBoxSweeps(PintSQThreadContext context, udword nb, PintRaycastHit* dest, const PintBoxSweepData* sweeps)
+{
+	WriteQueries(CAPTURE_BATCH_BOX_SWEEPS, nb, sweeps, sizeof(PintBoxSweepData));
+	return mEngine.BatchBoxSweeps(context, nb, dest, sweeps);
+}
+
+udword PintRecorder::BatchSphereSweeps(PintSQThreadContext context, udword nb, PintRaycastHit* dest, const PintSphereSweepData* sweeps)
+{
+	WriteQueries(CAPTURE_BATCH_SPHERE_SWEEPS, nb, sweeps, sizeof(PintSphereSweepData));
+	return mEngine.BatchSphereSweeps(context, nb, dest, sweeps);
+}
+
+udword PintRecorder::BatchCapsuleSweeps(PintSQThreadContext context, udword nb, PintRaycastHit* dest, const PintCapsuleSweepData* sweeps)
+{
+	WriteQueries(CAPTURE_BATCH_CAPSULE_SWEEPS, nb, sweeps, sizeof(PintCapsuleSweepData));
+	return mEngine.BatchCapsuleSweeps(context, nb, dest, sweeps);
+}
+
+udword PintRecorder::BatchSphereOverlapAny(PintSQThreadContext context, udword nb, PintBooleanHit* dest, const PintSphereOverlapData* overlaps)
+{
+	WriteQueries(CAPTURE_BATCH_SPHERE_OVERLAP_ANY, nb, overlaps, sizeof(PintSphereOverlapData));
+	return mEngine.BatchSphereOverlapAny(context, nb, dest, overlaps);
+}
+
+udword PintRecorder::BatchSphereOverlapObjects(PintSQThreadContext context, udword nb, PintOverlapObjectHit* dest, const PintSphereOverlapData* overlaps)
+{
+	WriteQueries(CAPTURE_BATCH_SPHERE_OVERLAP_OBJECTS, nb, overlaps, sizeof(PintSphereOverlapData));
+	return mEngine.BatchSphereOverlapObjects(context, nb, dest, overlaps);
+}
+
+udword PintRecorder::BatchBoxOverlapAny(PintSQThreadContext context, udword nb, PintBooleanHit* dest, const PintBoxOverlapData* overlaps)
+{
+	WriteQueries(CAPTURE_BATCH_BOX_OVERLAP_ANY, nb, overlaps, sizeof(PintBoxOverlapData));
+	return mEngine.BatchBoxOverlapAny(context, nb, dest, overlaps);
+}
+
+udword PintRecorder::BatchBoxOverlapObjects(PintSQThreadContext context, udword nb, PintOverlapObjectHit* dest, const PintBoxOverlapData* overlaps)
+{
+	WriteQueries(CAPTURE_BATCH_BOX_OVERLAP_OBJECTS, nb, overlaps, sizeof(PintBoxOverlapData));
+	return mEngine.BatchBoxOverlapObjects(context, nb, dest, overlaps);
+}
+
+udword PintRecorder::BatchCapsuleOverlapAny(PintSQThreadContext context, udword nb, PintBooleanHit* dest, const PintCapsuleOverlapData* overlaps)
+{
+	WriteQueries(CAPTURE_BATCH_CAPSULE_OVERLAP_ANY, nb, overlaps, sizeof(PintCapsuleOverlapData));
+	return mEngine.BatchCapsuleOverlapAny(context, nb, dest, overlaps);
+}
+
+udword PintRecorder::BatchCapsuleOverlapObjects(PintSQThreadContext context, udword nb, PintOverlapObjectHit* dest, const PintCapsuleOverlapData* overlaps)
+{
+	WriteQueries(CAPTURE_BATCH_CAPSULE_OVERLAP_OBJECTS, nb, overlaps, sizeof(PintCapsuleOverlapData));
+	return mEngine.BatchCapsuleOverlapObjects(context, nb, dest, overlaps);
+}
+
+udword PintRecorder::FindTriangles_MeshSphereOverlap(PintSQThreadContext context, PintObjectHandle handle, udword nb, const PintSphereOverlapData* overlaps)
+{
+	WriteDword(CAPTURE_FIND_TRIANGLES_SPHERE);
+	WriteHandle(handle);
+	WriteDword(nb);
+	WriteData(overlaps, sizeof(PintSphereOverlapData)*nb);
+	return mEngine.FindTriangles_MeshSphereOverlap(context, handle, nb, overlaps);
+}
+
+udword PintRecorder::FindTriangles_MeshBoxOverlap(PintSQThreadContext context, PintObjectHandle handle, udword nb, const PintBoxOverlapData* overlaps)
+{
+	WriteDword(CAPTURE_FIND_TRIANGLES_BOX);
+	WriteHandle(handle);
+	WriteDword(nb);
+	WriteData(overlaps, sizeof(PintBoxOverlapData)*nb);
+	return mEngine.FindTriangles_MeshBoxOverlap(context, handle, nb, overlaps);
+}
+
+udword PintRecorder::FindTriangles_MeshCapsuleOverlap(PintSQThreadContext context, PintObjectHandle handle, udword nb, const PintCapsuleOverlapData* overlaps)
+{
+	WriteDword(CAPTURE_FIND_TRIANGLES_CAPSULE);
+	WriteHandle(handle);
+	WriteDword(nb);
+	WriteData(overlaps, sizeof(PintCapsuleOverlapData)*nb);
+	return mEngine.FindTriangles_MeshCapsuleOverlap(context, handle, nb, overlaps);
+}
+
+PR PintRecorder::GetWorldTransform(PintObjectHandle handle)
+{
+	return mEngine.GetWorldTransform(handle);
+}
+
+void PintRecorder::SetWorldTransform(PintObjectHandle handle, const PR& pose)
+{
+	WriteDword(CAPTURE_SET_WORLD_TRANSFORM);
+	WriteHandle(handle);
+	WriteData(&pose, sizeof(PR));
+	mEngine.SetWorldTransform(handle, pose);
+}
+
+void PintRecorder::GetWorldTransforms(udword nb, const PintObjectHandle* handles, PR* poses)
+{
+	mEngine.GetWorldTransforms(nb, handles, poses);
+}
+
+udword PintRecorder::GetActiveTransforms(udword max_nb, PintObjectHandle* handles, Point* positions, Quat* rotations)
+{
+	return mEngine.GetActiveTransforms(max_nb, handles, positions, rotations);
+}
+
+void PintRecorder::AddWorldImpulseAtWorldPos(PintObjectHandle handle, const Point& world_impulse, const Point& world_pos)
+{
+	WriteDword(CAPTURE_ADD_WORLD_IMPULSE);
+	WriteHandle(handle);
+	WriteData(&world_impulse, sizeof(Point));
+	WriteData(&world_pos, sizeof(Point));
+	mEngine.AddWorldImpulseAtWorldPos(handle, world_impulse, world_pos);
+}
+
+void PintRecorder::AddLocalTorque(PintObjectHandle handle, const Point& local_torque)
+{
+	WriteDword(CAPTURE_ADD_LOCAL_TORQUE);
+	WriteHandle(handle);
+	WriteData(&local_torque, sizeof(Point));
+	mEngine.AddLocalTorque(handle, local_torque);
+}
+
+Point PintRecorder::GetAngularVelocity(PintObjectHandle handle)
+{
+	return mEngine.GetAngularVelocity(handle);
+}
+
+void PintRecorder::SetAngularVelocity(PintObjectHandle handle, const Point& angular_velocity)
+{
+	WriteDword(CAPTURE_SET_ANGULAR_VELOCITY);
+	WriteHandle(handle);
+	WriteData(&angular_velocity, sizeof(Point));
+	mEngine.SetAngularVelocity(handle, angular_velocity);
+}
+
+float PintRecorder::GetMass(PintObjectHandle handle)
+{
+	return mEngine.GetMass(handle);
+}
+
+Point PintRecorder::GetLocalInertia(PintObjectHandle handle)
+{
+	return mEngine.GetLocalInertia(handle);
+}
+
+udword PintRecorder::GetShapes(PintObjectHandle* shapes, PintObjectHandle handle)
+{
+	// Recorded because the returned shape handles can be passed to SetLocalRot()
+	const udword NbShapes = mEngine.GetShapes(shapes, handle);
+	WriteDword(CAPTURE_GET_SHAPES);
+	WriteHandle(handle);
+	WriteDword(NbShapes);
+	for(udword i=0;i<NbShapes;i++)
+		NewHandle(shapes[i]);
+	return NbShapes;
+}
+
+void PintRecorder::SetLocalRot(PintObjectHandle handle, const Quat& q)
+{
+	WriteDword(CAPTURE_SET_LOCAL_ROT);
+	WriteHandle(handle);
+	WriteData(&q, sizeof(Quat));
+	mEngine.SetLocalRot(handle, q);
+}
+
+bool PintRecorder::SetKinematicPose(PintObjectHandle handle, const Point& pos)
+{
+	WriteDword(CAPTURE_SET_KINEMATIC_POSITION);
+	WriteHandle(handle);
+	WriteData(&pos, sizeof(Point));
+	return mEngine.SetKinematicPose(handle, pos);
+}
+
+bool PintRecorder::SetKinematicPose(PintObjectHandle handle, const PR& pr)
+{
+	WriteDword(CAPTURE_SET_KINEMATIC_POSE);
+	WriteHandle(handle);
+	WriteData(&pr, sizeof(PR));
+	return mEngine.SetKinematicPose(handle, pr);
+}
+
+PintSQThreadContext PintRecorder::CreateSQThreadContext()
+{
+	return mEngine.CreateSQThreadContext();
+}
+
+void PintRecorder::ReleaseSQThreadContext(PintSQThreadContext context)
+{
+	mEngine.ReleaseSQThreadContext(context);
+}
+
+udword PintRecorder::CreateConvexObject(const PINT_CONVEX_DATA_CREATE& desc)
+{
+	WriteDword(CAPTURE_CREATE_CONVEX_OBJECT);
+	WriteDword(desc.mNbVerts);
+	WriteData(desc.mVerts, sizeof(Point)*desc.mNbVerts);
+	WriteRenderer(desc.mRenderer);
+
+	const udword Index = mEngine.CreateConvexObject(desc);
+	mConvexObjects.Add(Index);
+	return Index;
+}
+
+udword PintRecorder::BatchConvexSweeps(PintSQThreadContext context, udword nb, PintRaycastHit* dest, const PintConvexSweepData* sweeps)
+{
+	WriteDword(CAPTURE_BATCH_CONVEX_SWEEPS);
+	WriteDword(nb);
+	for(udword i=0;i<nb;i++)
+	{
+		// Convex objects are recorded by ID, i.e. in creation order. There are only a few of them.
+		const udword* Indices = mConvexObjects.GetEntries();
+		const udword NbConvexObjects = mConvexObjects.GetNbEntries();
+		udword ID = INVALID_ID;
+		for(udword j=0;j<NbConvexObjects;j++)
+		{
+			if(Indices[j]==sweeps[i].mConvexObjectIndex)
+			{
+				ID = j;
+				break;
+			}
+		}
+		WriteDword(ID);
+		WriteData(&sweeps[i].mTransform, sizeof(PR));
+		WriteData(&sweeps[i].mDir, sizeof(Point));
+		WriteFloat(sweeps[i].mMaxDist);
+		WriteRenderer(sweeps[i].mRenderer);
+	}
+	return mEngine.BatchConvexSweeps(context, nb, dest, sweeps);
+}
+
+PintObjectHandle PintRecorder::CreateAggregate(udword max_size, bool enable_self_collision)
+{
+	WriteDword(CAPTURE_CREATE_AGGREGATE);
+	WriteDword(max_size);
+	WriteDword(enable_self_collision);
+	return NewHandle(mEngine.CreateAggregate(max_size, enable_self_collision));
+}
+
+bool PintRecorder::AddToAggregate(PintObjectHandle object, PintObjectHandle aggregate)
+{
+	WriteDword(CAPTURE_ADD_TO_AGGREGATE);
+	WriteHandle(object);
+	WriteHandle(aggregate);
+	return mEngine.AddToAggregate(object, aggregate);
+}
+
+bool PintRecorder::AddAggregateToScene(PintObjectHandle aggregate)
+{
+	WriteDword(CAPTURE_ADD_AGGREGATE_TO_SCENE);
+	WriteHandle(aggregate);
+	return mEngine.AddAggregateToScene(aggregate);
+}
+
+PintObjectHandle PintRecorder::CreateArticulation(const PINT_ARTICULATION_CREATE& desc)
+{
+	WriteDword(CAPTURE_CREATE_ARTICULATION);
+	return NewHandle(mEngine.CreateArticulation(desc));
+}
+
+PintObjectHandle PintRecorder::CreateArticulatedObject(const PINT_OBJECT_CREATE& desc, const PINT_ARTICULATED_BODY_CREATE& body, PintObjectHandle articulation)
+{
+	WriteDword(CAPTURE_CREATE_ARTICULATED_OBJECT);
+	WriteObject(desc);
+	WriteHandle(articulation);
+	WriteHandle(body.mParent);
+	WriteData(&body.mLocalPivot0, sizeof(Point));
+	WriteData(&body.mLocalPivot1, sizeof(Point));
+	WriteData(&body.mX, sizeof(Point));
+	WriteFloat(body.mSwingYLimit);
+	WriteFloat(body.mSwingZLimit);
+	WriteFloat(body.mTwistLowerLimit);
+	WriteFloat(body.mTwistUpperLimit);
+	WriteDword(body.mEnableTwistLimit);
+	WriteDword(body.mEnableSwingLimit);
+	WriteDword(body.mUseMotor);
+	WriteMotor(body.mMotor);
+	return NewHandle(mEngine.CreateArticulatedObject(desc, body, articulation));
+}
+
+bool PintRecorder::AddArticulationToScene(PintObjectHandle articulation)
+{
+	WriteDword(CAPTURE_ADD_ARTICULATION_TO_SCENE);
+	WriteHandle(articulation);
+	return mEngine.AddArticulationToScene(articulation);
+}
+
+void PintRecorder::SetArticulatedMotor(PintObjectHandle object, const PINT_ARTICULATED_MOTOR_CREATE& motor)
+{
+	WriteDword(CAPTURE_SET_ARTICULATED_MOTOR);
+	WriteHandle(object);
+	WriteMotor(motor);
+	mEngine.SetArticulatedMotor(object, motor);
+}
+
+PintObjectHandle PintRecorder::CreateVehicle(PintVehicleData& data, const PINT_VEHICLE_CREATE& vehicle)
+{
+	WriteDword(CAPTURE_CREATE_VEHICLE);
+	WriteData(&vehicle.mStartPose, sizeof(PR));
+	// Chassis
+	WriteShape(vehicle.mChassis);
+	WriteFloat(vehicle.mChassisMass);
+	WriteFloat(vehicle.mChassisMOICoeffY);
+	WriteFloat(vehicle.mChassisCMOffsetY);
+	WriteFloat(vehicle.mChassisCMOffsetZ);
+	WriteFloat(vehicle.mForceApplicationCMOffsetY);
+	// Wheels
+	WriteShape(vehicle.mWheel);
+	WriteData(vehicle.mWheelOffset, sizeof(Point)*4);
+	WriteFloat(vehicle.mWheelMass);
+	WriteFloat(vehicle.mWheelMaxBrakeTorqueFront);
+	WriteFloat(vehicle.mWheelMaxBrakeTorqueRear);
+	WriteFloat(vehicle.mWheelMaxSteerFront);
+	WriteFloat(vehicle.mWheelMaxSteerRear);
+	WriteFloat(vehicle.mTireFrictionMultiplier);
+	// Engine, gears, clutch & differential
+	WriteFloat(vehicle.mEnginePeakTorque);
+	WriteFloat(vehicle.mEngineMaxOmega);
+	WriteFloat(vehicle.mGearsSwitchTime);
+	WriteFloat(vehicle.mClutchStrength);
+	WriteDword(vehicle.mDifferential);
+	// Suspension
+	WriteFloat(vehicle.mSuspMaxCompression);
+	WriteFloat(vehicle.mSuspMaxDroop);
+	WriteFloat(vehicle.mSuspSpringStrength);
+	WriteFloat(vehicle.mSuspSpringDamperRate);
+	WriteFloat(vehicle.mSuspCamberAngleAtRest);
+	WriteFloat(vehicle.mSuspCamberAngleAtMaxCompr);
+	WriteFloat(vehicle.mSuspCamberAngleAtMaxDroop);
+
+	// Vehicle first, then its chassis
+	PintObjectHandle Vehicle = NewHandle(mEngine.CreateVehicle(data, vehicle));
+	NewHandle(data.mChassis);
+	return Vehicle;
+}
+
+void PintRecorder::SetVehicleInput(PintObjectHandle vehicle, const PINT_VEHICLE_INPUT& input)
+{
+	udword Flags = 0;
+	if(input.mAccelerate)	Flags |= CAPTURE_VEHICLE_ACCELERATE;
+	if(input.mBrake)		Flags |= CAPTURE_VEHICLE_BRAKE;
+	if(input.mLeft)			Flags |= CAPTURE_VEHICLE_LEFT;
+	if(input.mRight)		Flags |= CAPTURE_VEHICLE_RIGHT;
+
+	WriteDword(CAPTURE_SET_VEHICLE_INPUT);
+	WriteHandle(vehicle);
+	WriteDword(Flags);
+	mEngine.SetVehicleInput(vehicle, input);
+}
+
+void PintRecorder::TestNewFeature()
+{
+	mEngine.TestNewFeature();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	// Reads the capture in place. Reading past the end returns zeros and flags the stream as invalid.
+	class CaptureReader
+	{
+		public:
+							CaptureReader(const ubyte* data, udword size) : mStart(data), mCurrent(data), mEnd(data+size), mInvalid(false)	{}
+
+		inline_	void		SetOffset(udword offset)	{ mCurrent = mStart + offset; mInvalid = false;	}
+		inline_	void		SetInvalid()			{ mInvalid = true;						}
+		inline_	bool		IsInvalid()		const	{ return mInvalid;						}
+		inline_	udword		GetOffset()		const	{ return udword(mCurrent - mStart);		}
+
+				const void*	ReadData(udword size)
+							{
+								const udword PaddedSize = (size+3) & ~3;
+								if(mInvalid || PaddedSize>udword(mEnd - mCurrent))
+								{
+									mInvalid = true;
+									return null;
+								}
+								const void* Data = mCurrent;
+								mCurrent += PaddedSize;
+								return Data;
+							}
+
+				template<class T>
+				void		Read(T& value)
+							{
+								const void* Data = ReadData(sizeof(T));
+								if(Data)
+									CopyMemory(&value, Data, sizeof(T));
+								else
+									ZeroMemory(&value, sizeof(T));
+							}
+
+				udword		ReadDword()		{ udword Value;	Read(Value);	return Value;	}
+				udword		PeekDword()	const	{ return !mInvalid && mEnd - mCurrent>=4 ? *(const udword*)mCurrent : 0;	}
+				float		ReadFloat()		{ float Value;	Read(Value);	return Value;	}
+				bool		ReadBool()		{ return ReadDword()!=0;						}
+
+				const char*	ReadString()
+							{
+								const udword Length = ReadDword();
+								if(!Length)
+									return null;
+								const char* String = (const char*)ReadData(Length);
+								if(String && String[Length-1])
+								{
+									mInvalid = true;
+									return null;
+								}
+								return String;
+							}
+		private:
+				const ubyte*	mStart;
+				const ubyte*	mCurrent;
+				const ubyte*	mEnd;
+				bool			mInvalid;
+	};
+
+	// Stands for the renderers of the recorded session. Engines use them to share shapes, they never draw here.
+	class ReplayShapeRenderer : public PintShapeRenderer
+	{
+		public:
+		virtual	void	Render(const PR& pose)						{}
+		virtual	void	SetColor(const Point& color, bool isStatic)	{}
+		virtual	void	SetShadows(bool flag)						{}
+	};
+
+	// Storage for one decoded shape
+	struct ReplayShape : public Allocateable
+	{
+		PINT_MATERIAL_CREATE	mMaterial;
+		PINT_SPHERE_CREATE		mSphere;
+		PINT_CAPSULE_CREATE		mCapsule;
+		PINT_CYLINDER_CREATE	mCylinder;
+		PINT_BOX_CREATE			mBox;
+		PINT_CONVEX_CREATE		mConvex;
+		PINT_MESH_CREATE		mMesh;
+	};
+
+	class CaptureReplayer
+	{
+		public:
+								CaptureReplayer(CaptureReader& reader, Pint& engine, PintTiming& timing);
+								~CaptureReplayer();
+
+				// Runs the call stream, from the current position to the end marker. Returns false if the stream is invalid.
+				bool			Run();
+
+				udword			mNbFrames;
+				udword			mNbQueries;
+				udword			mNbHits;
+		private:
+				CaptureReader&	mReader;
+				Pint&			mEngine;
+				PintTiming&		mTiming;
+				const ProfilingTimer&	mTimer;
+				Container		mHandles;		// Replayed handles, by ID
+				Container		mRenderers;		// ReplayShapeRenderer pointers, by ID
+				Container		mConvexObjects;	// Replayed CreateConvexObject() indices, by ID
+				ReplayShape*	mShapes;
+				udword			mMaxNbShapes;
+				PINT_OBJECT_CREATE*	mObjects;
+				udword			mMaxNbObjects;
+				Hits<PintRaycastHit>		mRaycastHits;
+				Hits<PintBooleanHit>		mBooleanHits;
+				Hits<PintOverlapObjectHit>	mOverlapObjectHits;
+				Hits<PintConvexSweepData>	mConvexSweeps;
+				Hits<PintObjectHandle>		mTmpHandles;
+				udword			mFrameQueryTime;
+				bool			mFrameHasQueries;
+
+				PintObjectHandle	ReadHandle();
+				void				AddHandle(PintObjectHandle handle);
+				PintShapeRenderer*	ReadRenderer();
+				ReplayShape*		ReserveShapes(udword nb);
+				PINT_OBJECT_CREATE*	ReserveObjects(udword nb);
+				PINT_SHAPE_CREATE*	ReadShape(ReplayShape& storage);
+				void				ReadObject(PINT_OBJECT_CREATE& desc, ReplayShape*& shapes, const ReplayShape* shapes_end);
+				void				ReadMotor(PINT_ARTICULATED_MOTOR_CREATE& motor);
+				void				EndFrame();
+
+				template<class QueryT, class HitT>
+				void				RunQueries(udword (Pint::*batch)(PintSQThreadContext, udword, HitT*, const QueryT*), Hits<HitT>& hits)
+									{
+										const udword Nb = mReader.ReadDword();
+										const QueryT* Queries = (const QueryT*)mReader.ReadData(sizeof(QueryT)*Nb);
+										if(!Queries)
+											return;
+										HitT* Dest = hits.PrepareQuery(Nb);
+
+										const uqword Start = mTimer.Start();
+											const udword NbHits = (mEngine.*batch)(null, Nb, Dest, Queries);
+										RecordQueries(mTimer.GetElapsed(Start), Nb, NbHits);
+									}
+
+				void				RecordQueries(udword time, udword nb_queries, udword nb_hits)
+									{
+										mFrameQueryTime += time;
+										mFrameHasQueries = true;
+										mNbQueries += nb_queries;
+										mNbHits += nb_hits;
+									}
+	};
+}
+
+static udword gReplayEntrySize = sizeof(void*)/sizeof(udword);
+
+CaptureReplayer::CaptureReplayer(CaptureReader& reader, Pint& engine, PintTiming& timing) :
+	mNbFrames		(0),
+	mNbQueries		(0),
+	mNbHits			(0),
+	mReader			(reader),
+	mEngine			(engine),
+	mTiming			(timing),
+	mTimer			(GetProfilingTimer(gProfilingUnits)),
+	mShapes			(null),
+	mMaxNbShapes	(0),
+	mObjects		(null),
+	mMaxNbObjects	(0),
+	mFrameQueryTime	(0),
+	mFrameHasQueries(false)
+{
+}
+
+CaptureReplayer::~CaptureReplayer()
+{
+	const udword NbRenderers = mRenderers.GetNbEntries()/gReplayEntrySize;
+	ReplayShapeRenderer** Renderers = (ReplayShapeRenderer**)mRenderers.GetEntries();
+	for(udword i=0;i<NbRenderers;i++)
+		DELETESINGLE(Renderers[i]);
+
+	DELETEARRAY(mObjects);
+	DELETEARRAY(mShapes);
+	mRaycastHits.Reset();
+	mBooleanHits.Reset();
+	mOverlapObjectHits.Reset();
+	mConvexSweeps.Reset();
+	mTmpHandles.Reset();
+}
+
+PintObjectHandle CaptureReplayer::ReadHandle()
+{
+	const udword ID = mReader.ReadDword();
+	if(ID>=mHandles.GetNbEntries()/gReplayEntrySize)
+		return null;
+	return ((PintObjectHandle*)mHandles.GetEntries())[ID];
+}
+
+void CaptureReplayer::AddHandle(PintObjectHandle handle)
+{
+	PintObjectHandle* Memory = (PintObjectHandle*)mHandles.Reserve(gReplayEntrySize);
+	*Memory = handle;
+}
+
+PintShapeRenderer* CaptureReplayer::ReadRenderer()
+{
+	const udword ID = mReader.ReadDword();
+	if(ID==INVALID_ID)
+		return null;
+
+	const udword NbRenderers = mRenderers.GetNbEntries()/gReplayEntrySize;
+	if(ID==NbRenderers)
+	{
+		ReplayShapeRenderer** Memory = (ReplayShapeRenderer**)mRenderers.Reserve(gReplayEntrySize);
+		*Memory = ICE_NEW(ReplayShapeRenderer);
+	}
+	else if(ID>NbRenderers)
+	{
+		mReader.SetInvalid();
+		return null;
+	}
+	return ((PintShapeRenderer**)mRenderers.GetEntries())[ID];
+}
+
+ReplayShape* CaptureReplayer::ReserveShapes(udword nb)
+{
+	if(nb>mMaxNbShapes)
+	{
+		DELETEARRAY(mShapes);
+		mShapes = ICE_NEW(ReplayShape)[nb];
+		mMaxNbShapes = nb;
+	}
+	return mShapes;
+}
+
+PINT_OBJECT_CREATE* CaptureReplayer::ReserveObjects(udword nb)
+{
+	if(nb>mMaxNbObjects)
+	{
+		DELETEARRAY(mObjects);
+		mObjects = ICE_NEW(PINT_OBJECT_CREATE)[nb];
+		mMaxNbObjects = nb;
+	}
+	return mObjects;
+}
+
+PINT_SHAPE_CREATE* CaptureReplayer::ReadShape(ReplayShape& storage)
+{
+	PINT_SHAPE_CREATE* Shape;
+	const udword Type = mReader.ReadDword();
+	switch(Type)
+	{
+		case PINT_SHAPE_SPHERE:		Shape = &storage.mSphere;	break;
+		case PINT_SHAPE_CAPSULE:	Shape = &storage.mCapsule;	break;
+		case PINT_SHAPE_CYLINDER:	Shape = &storage.mCylinder;	break;
+		case PINT_SHAPE_BOX:		Shape = &storage.mBox;		break;
+		case PINT_SHAPE_CONVEX:		Shape = &storage.mConvex;	break;
+		case PINT_SHAPE_MESH:		Shape = &storage.mMesh;		break;
+		default:
+			mReader.SetInvalid();
+			return null;
+	};
+
+	mReader.Read(Shape->mLocalPos);
+	mReader.Read(Shape->mLocalRot);
+	Shape->mMaterial = null;
+	if(mReader.ReadBool())
+	{
+		storage.mMaterial.mStaticFriction = mReader.ReadFloat();
+		storage.mMaterial.mDynamicFriction = mReader.ReadFloat();
+		storage.mMaterial.mRestitution = mReader.ReadFloat();
+		Shape->mMaterial = &storage.mMaterial;
+	}
+	Shape->mRenderer = ReadRenderer();
+	Shape->mNext = null;
+
+	switch(Type)
+	{
+		case PINT_SHAPE_SPHERE:
+			storage.mSphere.mRadius = mReader.ReadFloat();
+			break;
+
+		case PINT_SHAPE_CAPSULE:
+			storage.mCapsule.mRadius = mReader.ReadFloat();
+			storage.mCapsule.mHalfHeight = mReader.ReadFloat();
+			break;
+
+		case PINT_SHAPE_CYLINDER:
+			storage.mCylinder.mRadius = mReader.ReadFloat();
+			storage.mCylinder.mHalfHeight = mReader.ReadFloat();
+			break;
+
+		case PINT_SHAPE_BOX:
+			mReader.Read(storage.mBox.mExtents);
+			break;
+
+		case PINT_SHAPE_CONVEX:
+			storage.mConvex.mNbVerts = mReader.ReadDword();
+			storage.mConvex.mVerts = (const Point*)mReader.ReadData(sizeof(Point)*storage.mConvex.mNbVerts);
+			break;
+
+		case PINT_SHAPE_MESH:
+		{
+			SurfaceInterface& Surface = storage.mMesh.mSurface;
+			Surface.mNbVerts = mReader.ReadDword();
+			Surface.mVerts = (const Point*)mReader.ReadData(sizeof(Point)*Surface.mNbVerts);
+			Surface.mNbFaces = mReader.ReadDword();
+			Surface.mDFaces = null;
+			Surface.mWFaces = null;
+			if(mReader.ReadBool())
+				Surface.mDFaces = (const udword*)mReader.ReadData(sizeof(udword)*3*Surface.mNbFaces);
+			else
+				Surface.mWFaces = (const uword*)mReader.ReadData(sizeof(uword)*3*Surface.mNbFaces);
+		}
+		break;
+	};
+	return mReader.IsInvalid() ? null : Shape;
+}
+
+void CaptureReplayer::ReadObject(PINT_OBJECT_CREATE& desc, ReplayShape*& shapes, const ReplayShape* shapes_end)
+{
+	// Shapes are decoded in the next free entries of the caller's storage
+	desc.mShapes = null;
+	PINT_SHAPE_CREATE* LastShape = null;
+	const udword NbShapes = mReader.ReadDword();
+	if(NbShapes>udword(shapes_end - shapes))
+	{
+		mReader.SetInvalid();
+		return;
+	}
+	for(udword i=0;i<NbShapes;i++)
+	{
+		PINT_SHAPE_CREATE* Shape = ReadShape(*shapes++);
+		if(!Shape)
+			return;
+		if(LastShape)
+			LastShape->mNext = Shape;
+		else
+			desc.mShapes = Shape;
+		LastShape = Shape;
+	}
+	mReader.Read(desc.mPosition);
+	mReader.Read(desc.mRotation);
+	mReader.Read(desc.mCOMLocalOffset);
+	mReader.Read(desc.mLinearVelocity);
+	mReader.Read(desc.mAngularVelocity);
+	desc.mMass = mReader.ReadFloat();
+	desc.mMassForInertia = mReader.ReadFloat();
+	desc.mCollisionGroup = PintCollisionGroup(mReader.ReadDword());
+	desc.mKinematic = mReader.ReadBool();
+	desc.mAddToWorld = mReader.ReadBool();
+}
+
+void CaptureReplayer::ReadMotor(PINT_ARTICULATED_MOTOR_CREATE& motor)
+{
+	mReader.Read(motor.mTargetOrientation);
+	mReader.Read(motor.mTargetVelocity);
+	motor.mExternalCompliance = mReader.ReadFloat();
+	motor.mInternalCompliance = mReader.ReadFloat();
+	motor.mStiffness = mReader.ReadFloat();
+	motor.mDamping = mReader.ReadFloat();
+}
+
+void CaptureReplayer::EndFrame()
+{
+	// Queries are recorded like the test update in regular runs, i.e. added to the frame they follow
+	if(mFrameHasQueries && mNbFrames)
+		mTiming.UpdateRecordedTime(PINT_TIMING_TEST_UPDATE, mFrameQueryTime, mNbFrames-1);
+	mFrameQueryTime = 0;
+	mFrameHasQueries = false;
+	mTiming.EndFrame();
+}
+
+bool CaptureReplayer::Run()
+{
+	while(!mReader.IsInvalid())
+	{
+		const udword Op = mReader.ReadDword();
+		switch(Op)
+		{
+			case CAPTURE_END:
+				EndFrame();
+				return !mReader.IsInvalid();
+
+			case CAPTURE_UPDATE:
+			{
+				const float dt = mReader.ReadFloat();
+				EndFrame();
+
+				const uqword Start = mTimer.Start();
+					const udword CurrentMemory = mEngine.Update(dt);
+				const udword Time = mTimer.GetElapsed(Start);
+				mTiming.RecordTimeAndMemory(PINT_TIMING_SIMULATE, Time, CurrentMemory, mNbFrames++);
+			}
+			break;
+
+			case CAPTURE_UPDATE_NON_PROFILED:
+				mEngine.UpdateNonProfiled(mReader.ReadFloat());
+				break;
+
+			case CAPTURE_SET_GRAVITY:
+			{
+				Point Gravity;
+				mReader.Read(Gravity);
+				mEngine.SetGravity(Gravity);
+			}
+			break;
+
+			case CAPTURE_SET_DISABLED_GROUPS:
+			{
+				const udword Nb = mReader.ReadDword();
+				if(Nb>32*32)
+				{
+					mReader.SetInvalid();
+					break;
+				}
+				PintDisabledGroups* Groups = (PintDisabledGroups*)StackAlloc(sizeof(PintDisabledGroups)*(Nb+1));
+				for(udword i=0;i<Nb;i++)
+				{
+					Groups[i].mGroup0 = PintCollisionGroup(mReader.ReadDword());
+					Groups[i].mGroup1 = PintCollisionGroup(mReader.ReadDword());
+				}
+				mEngine.SetDisabledGroups(Nb, Groups);
+			}
+			break;
+
+			case CAPTURE_CREATE_OBJECT:
+			{
+				// ReadObject() reads the number of shapes again
+				const udword NbShapes = mReader.PeekDword();
+
+				ReplayShape* Shapes = ReserveShapes(NbShapes);
+				PINT_OBJECT_CREATE Desc;
+				ReadObject(Desc, Shapes, Shapes + NbShapes);
+				if(!mReader.IsInvalid())
+					AddHandle(mEngine.CreateObject(Desc));
+			}
+			break;
+
+			case CAPTURE_CREATE_OBJECTS:
+			{
+				const udword Nb = mReader.ReadDword();
+				const udword NbShapes = mReader.ReadDword();
+				ReplayShape* Shapes = ReserveShapes(NbShapes);
+				const ReplayShape* ShapesEnd = Shapes + NbShapes;
+				PINT_OBJECT_CREATE* Descs = ReserveObjects(Nb);
+				for(udword i=0;i<Nb && !mReader.IsInvalid();i++)
+					ReadObject(Descs[i], Shapes, ShapesEnd);
+				if(mReader.IsInvalid())
+					break;
+
+				PintObjectHandle* Handles = (PintObjectHandle*)mHandles.Reserve(Nb*gReplayEntrySize);
+				mEngine.CreateObjects(Nb, Descs, Handles);
+			}
+			break;
+
+			case CAPTURE_RELEASE_OBJECT:
+				mEngine.ReleaseObject(ReadHandle());
+				break;
+
+			case CAPTURE_RELEASE_OBJECTS:
+			{
+				const udword Nb = mReader.ReadDword();
+				PintObjectHandle* Handles = mTmpHandles.PrepareQuery(Nb);
+				for(udword i=0;i<Nb;i++)
+					Handles[i] = ReadHandle();
+				if(!mReader.IsInvalid())
+					mEngine.ReleaseObjects(Nb, Handles);
+			}
+			break;
+
+			case CAPTURE_CREATE_JOINT:
+			{
+				const udword Type = mReader.ReadDword();
+				PintObjectHandle Object0 = ReadHandle();
+				PintObjectHandle Object1 = ReadHandle();
+				switch(Type)
+				{
+					case PINT_JOINT_SPHERICAL:
+					{
+						PINT_SPHERICAL_JOINT_CREATE Desc;
+						Desc.mObject0 = Object0;
+						Desc.mObject1 = Object1;
+						mReader.Read(Desc.mLocalPivot0);
+						mReader.Read(Desc.mLocalPivot1);
+						mEngine.CreateJoint(Desc);
+					}
+					break;
+
+					case PINT_JOINT_HINGE:
+					{
+						PINT_HINGE_JOINT_CREATE Desc;
+						Desc.mObject0 = Object0;
+						Desc.mObject1 = Object1;
+						mReader.Read(Desc.mLocalPivot0);
+						mReader.Read(Desc.mLocalPivot1);
+						mReader.Read(Desc.mLocalAxis0);
+						mReader.Read(Desc.mLocalAxis1);
+						Desc.mMinLimitAngle = mReader.ReadFloat();
+						Desc.mMaxLimitAngle = mReader.ReadFloat();
+						mReader.Read(Desc.mGlobalAnchor);
+						mReader.Read(Desc.mGlobalAxis);
+						mEngine.CreateJoint(Desc);
+					}
+					break;
+
+					case PINT_JOINT_PRISMATIC:
+					{
+						PINT_PRISMATIC_JOINT_CREATE Desc;
+						Desc.mObject0 = Object0;
+						Desc.mObject1 = Object1;
+						mReader.Read(Desc.mLocalPivot0);
+						mReader.Read(Desc.mLocalPivot1);
+						mReader.Read(Desc.mLocalAxis0);
+						mReader.Read(Desc.mLocalAxis1);
+						Desc.mMinLimit = mReader.ReadFloat();
+						Desc.mMaxLimit = mReader.ReadFloat();
+						Desc.mSpringStiffness = mReader.ReadFloat();
+						Desc.mSpringDamping = mReader.ReadFloat();
+						mEngine.CreateJoint(Desc);
+					}
+					break;
+
+					case PINT_JOINT_FIXED:
+					{
+						PINT_FIXED_JOINT_CREATE Desc;
+						Desc.mObject0 = Object0;
+						Desc.mObject1 = Object1;
+						mReader.Read(Desc.mLocalPivot0);
+						mReader.Read(Desc.mLocalPivot1);
+						mEngine.CreateJoint(Desc);
+					}
+					break;
+
+					case PINT_JOINT_DISTANCE:
+					{
+						PINT_DISTANCE_JOINT_CREATE Desc;
+						Desc.mObject0 = Object0;
+						Desc.mObject1 = Object1;
+						mReader.Read(Desc.mLocalPivot0);
+						mReader.Read(Desc.mLocalPivot1);
+						Desc.mMinDistance = mReader.ReadFloat();
+						Desc.mMaxDistance = mReader.ReadFloat();
+						mEngine.CreateJoint(Desc);
+					}
+					break;
+
+					default:
+						mReader.SetInvalid();
+						break;
+				};
+			}
+			break;
+
+			case CAPTURE_CREATE_PHANTOM:
+			{
+				AABB Box;
+				mReader.Read(Box);
+				AddHandle(mEngine.CreatePhantom(Box));
+			}
+			break;
+
+			case CAPTURE_BATCH_RAYCASTS_PHANTOM:
+			{
+				const udword Nb = mReader.ReadDword();
+				const PintRaycastData* Raycasts = (const PintRaycastData*)mReader.ReadData(sizeof(PintRaycastData)*Nb);
+				PintObjectHandle* Phantoms = mTmpHandles.PrepareQuery(Nb);
+				for(udword i=0;i<Nb;i++)
+					Phantoms[i] = ReadHandle();
+				if(mReader.IsInvalid())
+					break;
+				PintRaycastHit* Dest = mRaycastHits.PrepareQuery(Nb);
+
+				const uqword Start = mTimer.Start();
+					const udword NbHits = mEngine.BatchRaycastsPhantom(Nb, Dest, Raycasts, Phantoms);
+				RecordQueries(mTimer.GetElapsed(Start), Nb, NbHits);
+			}
+			break;
+
+			case CAPTURE_BATCH_RAYCASTS:				RunQueries(&Pint::BatchRaycasts, mRaycastHits);						break;
+			case CAPTURE_BATCH_RAYCAST_ANY:				RunQueries(&Pint::BatchRaycastAny, mBooleanHits);					break;
+			case CAPTURE_BATCH_RAYCAST_ALL:				RunQueries(&Pint::BatchRaycastAll, mOverlapObjectHits);				break;
+			case CAPTURE_BATCH_BOX_SWEEPS:				RunQueries(&Pint::BatchBoxSweeps, mRaycastHits);					break;
+			case CAPTURE_BATCH_SPHERE_SWEEPS:			RunQueries(&Pint::BatchSphereSweeps, mRaycastHits);					break;
+			case CAPTURE_BATCH_CAPSULE_SWEEPS:			RunQueries(&Pint::BatchCapsuleSweeps, mRaycastHits);				break;
+			case CAPTURE_BATCH_SPHERE_OVERLAP_ANY:		RunQueries(&Pint::BatchSphereOverlapAny, mBooleanHits);				break;
+			case CAPTURE_BATCH_SPHERE_OVERLAP_OBJECTS:	RunQueries(&Pint::BatchSphereOverlapObjects, mOverlapObjectHits);	break;
+			case CAPTURE_BATCH_BOX_OVERLAP_ANY:			RunQueries(&Pint::BatchBoxOverlapAny, mBooleanHits);				break;
+			case CAPTURE_BATCH_BOX_OVERLAP_OBJECTS:		RunQueries(&Pint::BatchBoxOverlapObjects, mOverlapObjectHits);		break;
+			case CAPTURE_BATCH_CAPSULE_OVERLAP_ANY:		RunQueries(&Pint::BatchCapsuleOverlapAny, mBooleanHits);			break;
+			case CAPTURE_BATCH_CAPSULE_OVERLAP_OBJECTS:	RunQueries(&Pint::BatchCapsuleOverlapObjects, mOverlapObjectHits);	break;
+
+			case CAPTURE_BATCH_CONVEX_SWEEPS:
+			{
+				const udword Nb = mReader.ReadDword();
+				PintConvexSweepData* Sweeps = mConvexSweeps.PrepareQuery(Nb);
+				const udword NbConvexObjects = mConvexObjects.GetNbEntries();
+				for(udword i=0;i<Nb;i++)
+				{
+					const udword ID = mReader.ReadDword();
+					Sweeps[i].mConvexObjectIndex = ID<NbConvexObjects ? mConvexObjects.GetEntry(ID) : INVALID_ID;
+					mReader.Read(Sweeps[i].mTransform);
+					mReader.Read(Sweeps[i].mDir);
+					Sweeps[i].mMaxDist = mReader.ReadFloat();
+					Sweeps[i].mRenderer = ReadRenderer();
+				}
+				if(mReader.IsInvalid())
+					break;
+				PintRaycastHit* Dest = mRaycastHits.PrepareQuery(Nb);
+
+				const uqword Start = mTimer.Start();
+					const udword NbHits = mEngine.BatchConvexSweeps(null, Nb, Dest, Sweeps);
+				RecordQueries(mTimer.GetElapsed(Start), Nb, NbHits);
+			}
+			break;
+
+			case CAPTURE_FIND_TRIANGLES_SPHERE:
+			{
+				PintObjectHandle Handle = ReadHandle();
+				const udword Nb = mReader.ReadDword();
+				const PintSphereOverlapData* Overlaps = (const PintSphereOverlapData*)mReader.ReadData(sizeof(PintSphereOverlapData)*Nb);
+				if(!Overlaps)
+					break;
+				const uqword Start = mTimer.Start();
+					const udword NbHits = mEngine.FindTriangles_MeshSphereOverlap(null, Handle, Nb, Overlaps);
+				RecordQueries(mTimer.GetElapsed(Start), Nb, NbHits);
+			}
+			break;
+
+			case CAPTURE_FIND_TRIANGLES_BOX:
+			{
+				PintObjectHandle Handle = ReadHandle();
+				const udword Nb = mReader.ReadDword();
+				const PintBoxOverlapData* Overlaps = (const PintBoxOverlapData*)mReader.ReadData(sizeof(PintBoxOverlapData)*Nb);
+				if(!Overlaps)
+					break;
+				const uqword Start = mTimer.Start();
+					const udword NbHits = mEngine.FindTriangles_MeshBoxOverlap(null, Handle, Nb, Overlaps);
+				RecordQueries(mTimer.GetElapsed(Start), Nb, NbHits);
+			}
+			break;
+
+			case CAPTURE_FIND_TRIANGLES_CAPSULE:
+			{
+				PintObjectHandle Handle = ReadHandle();
+				const udword Nb = mReader.ReadDword();
+				const PintCapsuleOverlapData* Overlaps = (const PintCapsuleOverlapData*)mReader.ReadData(sizeof(PintCapsuleOverlapData)*Nb);
+				if(!Overlaps)
+					break;
+				const uqword Start = mTimer.Start();
+					const udword NbHits = mEngine.FindTriangles_MeshCapsuleOverlap(null, Handle, Nb, Overlaps);
+				RecordQueries(mTimer.GetElapsed(Start), Nb, NbHits);
+			}
+			break;
+
+			case CAPTURE_SET_WORLD_TRANSFORM:
+			{
+				PintObjectHandle Handle = ReadHandle();
+				PR Pose;
+				mReader.Read(Pose);
+				mEngine.SetWorldTransform(Handle, Pose);
+			}
+			break;
+
+			case CAPTURE_ADD_WORLD_IMPULSE:
+			{
+				PintObjectHandle Handle = ReadHandle();
+				Point Impulse, Pos;
+				mReader.Read(Impulse);
+				mReader.Read(Pos);
+				mEngine.AddWorldImpulseAtWorldPos(Handle, Impulse, Pos);
+			}
+			break;
+
+			case CAPTURE_ADD_LOCAL_TORQUE:
+			{
+				PintObjectHandle Handle = ReadHandle();
+				Point Torque;
+				mReader.Read(Torque);
+				mEngine.AddLocalTorque(Handle, Torque);
+			}
+			break;
+
+			case CAPTURE_SET_ANGULAR_VELOCITY:
+			{
+				PintObjectHandle Handle = ReadHandle();
+				Point AngularVelocity;
+				mReader.Read(AngularVelocity);
+				mEngine.SetAngularVelocity(Handle, AngularVelocity);
+			}
+			break;
+
+			case CAPTURE_GET_SHAPES:
+			{
+				PintObjectHandle Handle = ReadHandle();
+				const udword NbShapes = mReader.ReadDword();
+				// The engine may return a different number of shapes, IDs must still be consumed as recorded
+				PintObjectHandle* Shapes = mTmpHandles.PrepareQuery(NbShapes+32);
+				const udword NbReplayed = mEngine.GetShapes(Shapes, Handle);
+				for(udword i=0;i<NbShapes;i++)
+					AddHandle(i<NbReplayed ? Shapes[i] : null);
+			}
+			break;
+
+			case CAPTURE_SET_LOCAL_ROT:
+			{
+				PintObjectHandle Handle = ReadHandle();
+				Quat Rot;
+				mReader.Read(Rot);
+				mEngine.SetLocalRot(Handle, Rot);
+			}
+			break;
+
+			case CAPTURE_SET_KINEMATIC_POSITION:
+			{
+				PintObjectHandle Handle = ReadHandle();
+				Point Pos;
+				mReader.Read(Pos);
+				mEngine.SetKinematicPose(Handle, Pos);
+			}
+			break;
+
+			case CAPTURE_SET_KINEMATIC_POSE:
+			{
+				PintObjectHandle Handle = ReadHandle();
+				PR Pose;
+				mReader.Read(Pose);
+				mEngine.SetKinematicPose(Handle, Pose);
+			}
+			break;
+
+			case CAPTURE_CREATE_CONVEX_OBJECT:
+			{
+				PINT_CONVEX_DATA_CREATE Desc;
+				Desc.mNbVerts = mReader.ReadDword();
+				Desc.mVerts = (const Point*)mReader.ReadData(sizeof(Point)*Desc.mNbVerts);
+				Desc.mRenderer = ReadRenderer();
+				if(!mReader.IsInvalid())
+					mConvexObjects.Add(mEngine.CreateConvexObject(Desc));
+			}
+			break;
+
+			case CAPTURE_CREATE_AGGREGATE:
+			{
+				const udword MaxSize = mReader.ReadDword();
+				const bool EnableSelfCollision = mReader.ReadBool();
+				AddHandle(mEngine.CreateAggregate(MaxSize, EnableSelfCollision));
+			}
+			break;
+
+			case CAPTURE_ADD_TO_AGGREGATE:
+			{
+				PintObjectHandle Object = ReadHandle();
+				PintObjectHandle Aggregate = ReadHandle();
+				mEngine.AddToAggregate(Object, Aggregate);
+			}
+			break;
+
+			case CAPTURE_ADD_AGGREGATE_TO_SCENE:
+				mEngine.AddAggregateToScene(ReadHandle());
+				break;
+
+			case CAPTURE_CREATE_ARTICULATION:
+			{
+				PINT_ARTICULATION_CREATE Desc;
+				AddHandle(mEngine.CreateArticulation(Desc));
+			}
+			break;
+
+			case CAPTURE_CREATE_ARTICULATED_OBJECT:
+			{
+				const udword NbShapes = mReader.PeekDword();
+
+				ReplayShape* Shapes = ReserveShapes(NbShapes);
+				PINT_OBJECT_CREATE Desc;
+				ReadObject(Desc, Shapes, Shapes + NbShapes);
+				PintObjectHandle Articulation = ReadHandle();
+
+				PINT_ARTICULATED_BODY_CREATE Body;
+				Body.mParent = ReadHandle();
+				mReader.Read(Body.mLocalPivot0);
+				mReader.Read(Body.mLocalPivot1);
+				mReader.Read(Body.mX);
+				Body.mSwingYLimit = mReader.ReadFloat();
+				Body.mSwingZLimit = mReader.ReadFloat();
+				Body.mTwistLowerLimit = mReader.ReadFloat();
+				Body.mTwistUpperLimit = mReader.ReadFloat();
+				Body.mEnableTwistLimit = mReader.ReadBool();
+				Body.mEnableSwingLimit = mReader.ReadBool();
+				Body.mUseMotor = mReader.ReadBool();
+				ReadMotor(Body.mMotor);
+				if(!mReader.IsInvalid())
+					AddHandle(mEngine.CreateArticulatedObject(Desc, Body, Articulation));
+			}
+			break;
+
+			case CAPTURE_ADD_ARTICULATION_TO_SCENE:
+				mEngine.AddArticulationToScene(ReadHandle());
+				break;
+
+			case CAPTURE_SET_ARTICULATED_MOTOR:
+			{
+				PintObjectHandle Object = ReadHandle();
+				PINT_ARTICULATED_MOTOR_CREATE Motor;
+				ReadMotor(Motor);
+				mEngine.SetArticulatedMotor(Object, Motor);
+			}
+			break;
+
+			case CAPTURE_CREATE_VEHICLE:
+			{
+				ReplayShape* Shapes = ReserveShapes(2);
+				PINT_VEHICLE_CREATE Desc;
+				mReader.Read(Desc.mStartPose);
+				// Chassis
+				const PINT_SHAPE_CREATE* Chassis = ReadShape(Shapes[0]);
+				Desc.mChassisMass = mReader.ReadFloat();
+				Desc.mChassisMOICoeffY = mReader.ReadFloat();
+				Desc.mChassisCMOffsetY = mReader.ReadFloat();
+				Desc.mChassisCMOffsetZ = mReader.ReadFloat();
+				Desc.mForceApplicationCMOffsetY = mReader.ReadFloat();
+				// Wheels
+				const PINT_SHAPE_CREATE* Wheel = ReadShape(Shapes[1]);
+				for(udword i=0;i<4;i++)
+					mReader.Read(Desc.mWheelOffset[i]);
+				Desc.mWheelMass = mReader.ReadFloat();
+				Desc.mWheelMaxBrakeTorqueFront = mReader.ReadFloat();
+				Desc.mWheelMaxBrakeTorqueRear = mReader.ReadFloat();
+				Desc.mWheelMaxSteerFront = mReader.ReadFloat();
+				Desc.mWheelMaxSteerRear = mReader.ReadFloat();
+				Desc.mTireFrictionMultiplier = mReader.ReadFloat();
+				// Engine, gears, clutch & differential
+				Desc.mEnginePeakTorque = mReader.ReadFloat();
+				Desc.mEngineMaxOmega = mReader.ReadFloat();
+				Desc.mGearsSwitchTime = mReader.ReadFloat();
+				Desc.mClutchStrength = mReader.ReadFloat();
+				Desc.mDifferential = PintVehicleDifferential(mReader.ReadDword());
+				// Suspension
+				Desc.mSuspMaxCompression = mReader.ReadFloat();
+				Desc.mSuspMaxDroop = mReader.ReadFloat();
+				Desc.mSuspSpringStrength = mReader.ReadFloat();
+				Desc.mSuspSpringDamperRate = mReader.ReadFloat();
+				Desc.mSuspCamberAngleAtRest = mReader.ReadFloat();
+				Desc.mSuspCamberAngleAtMaxCompr = mReader.ReadFloat();
+				Desc.mSuspCamberAngleAtMaxDroop = mReader.ReadFloat();
+
+				if(!Chassis || !Wheel || Chassis->mType!=PINT_SHAPE_CONVEX || Wheel->mType!=PINT_SHAPE_CONVEX)
+				{
+					mReader.SetInvalid();
+					break;
+				}
+				Desc.mChassis = Shapes[0].mConvex;
+				Desc.mWheel = Shapes[1].mConvex;
+
+				PintVehicleData Data;
+				Data.mChassis = null;
+				AddHandle(mEngine.CreateVehicle(Data, Desc));
+				AddHandle(Data.mChassis);
+			}
+			break;
+
+			case CAPTURE_SET_VEHICLE_INPUT:
+			{
+				PintObjectHandle Vehicle = ReadHandle();
+				const udword Flags = mReader.ReadDword();
+				PINT_VEHICLE_INPUT Input;
+				Input.mAccelerate	= (Flags & CAPTURE_VEHICLE_ACCELERATE)!=0;
+				Input.mBrake		= (Flags & CAPTURE_VEHICLE_BRAKE)!=0;
+				Input.mLeft			= (Flags & CAPTURE_VEHICLE_LEFT)!=0;
+				Input.mRight		= (Flags & CAPTURE_VEHICLE_RIGHT)!=0;
+				mEngine.SetVehicleInput(Vehicle, Input);
+			}
+			break;
+
+			default:
+				mReader.SetInvalid();
+				break;
+		};
+	}
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool ReplayCapture(const char* filename)
+{
+	FILE* fp = fopen(filename, "rb");
+	if(!fp)
+	{
+		printf("Cannot open capture %s.\n", filename);
+		return false;
+	}
+	fseek(fp, 0, SEEK_END);
+	const udword Size = udword(ftell(fp));
+	fseek(fp, 0, SEEK_SET);
+	ubyte* Buffer = (ubyte*)ICE_ALLOC(Size+1);
+	const bool Loaded = fread(Buffer, 1, Size, fp)==Size;
+	fclose(fp);
+
+	CaptureReader Reader(Buffer, Loaded ? Size : 0);
+	const udword Magic = Reader.ReadDword();
+	const udword Version = Reader.ReadDword();
+	const char* TestName = Reader.ReadString();
+	const char* RecordedEngine = Reader.ReadString();
+	PINT_WORLD_CREATE Desc;
+	Reader.Read(Desc.mGravity);
+	Reader.Read(Desc.mGlobalBounds);
+	Desc.mNbSimulateCallsPerFrame = Reader.ReadDword();
+	Desc.mTimestep = Reader.ReadFloat();
+	if(Reader.IsInvalid() || Magic!=CAPTURE_MAGIC || Version!=CAPTURE_VERSION)
+	{
+		printf("Invalid capture: %s\n", filename);
+		ICE_FREE(Buffer);
+		return false;
+	}
+	const udword StreamStart = Reader.GetOffset();
+
+	// Same settings as tests (thread affinity, allocator), but no camera poses
+	SetupWorldDesc(Desc, TestName);
+
+	char CSVFilename[1024];
+	sprintf_s(CSVFilename, sizeof(CSVFilename), "%s.csv", filename);
+	FILE* CSV = fopen(CSVFilename, "w");
+	const char* Sep = gCommaSeparator ? ", " : "; ";
+	const char* Units = GetProfilingTimer(gProfilingUnits).mUnits;
+
+	printf("Replaying %s (%s, recorded with %s, %s):\n", filename, TestName ? TestName : "unknown test", RecordedEngine ? RecordedEngine : "unknown engine", Units);
+	if(CSV)
+	{
+		fprintf_s(CSV, "%s - replay of %s (%s)\n\n", TestName ? TestName : "", filename, Units);
+		fprintf_s(CSV, "Engine%sFrames%sAvg%sp50%sp90%sp99%sWorst%sSimulate avg%sQueries avg%sQueries%sHits%sPeak memory (Kb)\n", Sep, Sep, Sep, Sep, Sep, Sep, Sep, Sep, Sep, Sep, Sep);
+	}
+
+	bool Status = true;
+	PintTiming* Timing = ICE_NEW(PintTiming);
+	for(udword i=0;i<gNbPlugIns;i++)
+	{
+		gPlugIns[i]->Init(Desc);
+		Pint* Engine = gPlugIns[i]->GetPint();
+		if(Engine && (Engine->GetFlags() & PINT_IS_ACTIVE))
+		{
+			Timing->ResetTimings();
+			Reader.SetOffset(StreamStart);
+
+			CaptureReplayer Replayer(Reader, *Engine, *Timing);
+			const bool Valid = Replayer.Run();
+			if(!Valid)
+			{
+				printf("  %s: invalid call stream at offset %d, results are incomplete.\n", Engine->GetName(), Reader.GetOffset());
+				Status = false;
+			}
+
+			const PintHistogram& H = Timing->mHistogram;
+			const float SimAvg = Timing->mPhaseHistograms[PINT_TIMING_SIMULATE].GetMean();
+			const float SQAvg = Timing->mPhaseHistograms[PINT_TIMING_TEST_UPDATE].GetMean();
+			printf("  %s: %d frames, Avg: %d, p50: %d, p90: %d, p99: %d, Worst: %d, Simulate: %.0f, Queries: %.0f (%d queries, %d hits), %d Kb\n",
+				Engine->GetName(), Replayer.mNbFrames, Timing->GetAvgTime(), H.GetPercentile(50.0f), H.GetPercentile(90.0f), H.GetPercentile(99.0f), Timing->GetWorstTime(),
+				SimAvg, SQAvg, Replayer.mNbQueries, Replayer.mNbHits, udword(Timing->mPeakMemory/1024));
+			if(CSV)
+				fprintf_s(CSV, "%s%s%d%s%d%s%d%s%d%s%d%s%d%s%.0f%s%.0f%s%d%s%d%s%d\n", Engine->GetName(), Sep, Replayer.mNbFrames, Sep, Timing->GetAvgTime(), Sep,
+					H.GetPercentile(50.0f), Sep, H.GetPercentile(90.0f), Sep, H.GetPercentile(99.0f), Sep, Timing->GetWorstTime(), Sep, SimAvg, Sep, SQAvg, Sep,
+					Replayer.mNbQueries, Sep, Replayer.mNbHits, Sep, udword(Timing->mPeakMemory/1024));
+		}
+		gPlugIns[i]->Close();
+	}
+	DELETESINGLE(Timing);
+
+	if(CSV)
+		fclose(CSV);
+	ICE_FREE(Buffer);
+	return Status;
+}
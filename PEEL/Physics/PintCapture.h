@@ -0,0 +1,169 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef PINT_CAPTURE_H
+#define PINT_CAPTURE_H
+
+#include "Pint.h"
+
+	// Capture & replay of Pint call streams.
+	//
+	// PintRecorder wraps an engine and forwards all calls to it, after writing the ones that modify the scene (object &
+	// joint creation, kinematic poses, impulses, etc), the Update() calls and the Batch* queries to a binary file. Descriptors
+	// are written with their shapes, materials, vertices & indices, so the file doesn't depend on the test that produced it.
+	// Handles are written as sequential IDs, in creation order. Shape renderers are written as IDs too, since engines use
+	// them to share shapes between objects. Calls that only read the scene (poses, velocities, ...) are not recorded.
+	//
+	// ReplayCapture() then drives each registered plugin from such a file, without tests, UI or picking: the replay is open-
+	// loop, i.e. test logic that depended on the scene's state is replayed with the recorded values. Only Pint::Update and
+	// the queries are timed.
+	//
+	// The recorder is not thread-safe: it hides PINT_CONCURRENT_SQ, PINT_SQ_DURING_UPDATE & PINT_ASYNC_UPDATE and sets
+	// PINT_MAIN_THREAD_ONLY, so that all calls are serialized. Timings of the recorded engine include the writes.
+
+	#define DEFAULT_CAPTURE_FILENAME	"Capture.pcf"
+
+	// Pointer to sequential ID map, for handles & renderers
+	class CaptureIDMap : public Allocateable
+	{
+		public:
+								CaptureIDMap();
+								~CaptureIDMap();
+
+				void			Reset();
+				void			SetID(const void* key, udword id);
+				// Returns INVALID_ID for null or unknown keys
+				udword			GetID(const void* key)	const;
+		private:
+				const void**	mKeys;
+				udword*			mIDs;
+				udword			mCapacity;	// Power of 2
+				udword			mNbKeys;
+
+				void			Grow();
+	};
+
+	class PintRecorder : public Pint
+	{
+		public:
+									PintRecorder(Pint& engine);
+		virtual						~PintRecorder();
+
+				// Creates the file & writes the header. Returns false if the file cannot be created.
+				bool				Open(const char* filename, const PINT_WORLD_CREATE& desc);
+				// Writes the end marker & closes the file
+				void				Finish();
+
+		inline_	Pint&				GetEngine()			{ return mEngine;	}
+
+		virtual	const char*			GetName()				const;
+		virtual	void				GetCaps(PintCaps& caps)	const;
+		virtual	udword				GetFlags()				const;
+		virtual	void				Init(const PINT_WORLD_CREATE& desc);
+		virtual	void				SetGravity(const Point& gravity);
+		virtual	void				Close();
+		virtual	udword				Update(float dt);
+		virtual	void				UpdateNonProfiled(float dt);
+		virtual	const PintAllocStats*	GetAllocStats();
+		virtual	Point				GetMainColor();
+		virtual	void				Render(PintRender& renderer);
+
+		virtual	void				SetDisabledGroups(udword nb_groups, const PintDisabledGroups* groups);
+		virtual	PintObjectHandle	CreateObject(const PINT_OBJECT_CREATE& desc);
+		virtual	bool				ReleaseObject(PintObjectHandle handle);
+		virtual	udword				CreateObjects(udword nb, const PINT_OBJECT_CREATE* descs, PintObjectHandle* handles);
+		virtual	udword				ReleaseObjects(udword nb, const PintObjectHandle* handles);
+		virtual	PintJointHandle		CreateJoint(const PINT_JOINT_CREATE& desc);
+
+		virtual	void*				CreatePhantom(const AABB& box);
+		virtual	udword				BatchRaycastsPhantom(udword nb, PintRaycastHit* dest, const PintRaycastData* raycasts, void** phantoms);
+
+		virtual	udword				BatchRaycasts				(PintSQThreadContext context, udword nb, PintRaycastHit* dest, const PintRaycastData* raycasts);
+		virtual	udword				BatchRaycastAny				(PintSQThreadContext context, udword nb, PintBooleanHit* dest, const PintRaycastData* raycasts);
+		virtual	udword				BatchRaycastAll				(PintSQThreadContext context, udword nb, PintOverlapObjectHit* dest, const PintRaycastData* raycasts);
+		virtual	udword				BatchBoxSweeps				(PintSQThreadContext context, udword nb, PintRaycastHit* dest, const PintBoxSweepData* sweeps);
+		virtual	udword				BatchSphereSweeps			(PintSQThreadContext context, udword nb, PintRaycastHit* dest, const PintSphereSweepData* sweeps);
+		virtual	udword				BatchCapsuleSweeps			(PintSQThreadContext context, udword nb, PintRaycastHit* dest, const PintCapsuleSweepData* sweeps);
+		virtual	udword				BatchSphereOverlapAny		(PintSQThreadContext context, udword nb, PintBooleanHit* dest, const PintSphereOverlapData* overlaps);
+		virtual	udword				BatchSphereOverlapObjects	(PintSQThreadContext context, udword nb, PintOverlapObjectHit* dest, const PintSphereOverlapData* overlaps);
+		virtual	udword				BatchBoxOverlapAny			(PintSQThreadContext context, udword nb, PintBooleanHit* dest, const PintBoxOverlapData* overlaps);
+		virtual	udword				BatchBoxOverlapObjects		(PintSQThreadContext context, udword nb, PintOverlapObjectHit* dest, const PintBoxOverlapData* overlaps);
+		virtual	udword				BatchCapsuleOverlapAny		(PintSQThreadContext context, udword nb, PintBooleanHit* dest, const PintCapsuleOverlapData* overlaps);
+		virtual	udword				BatchCapsuleOverlapObjects	(PintSQThreadContext context, udword nb, PintOverlapObjectHit* dest, const PintCapsuleOverlapData* overlaps);
+
+		virtual	udword				FindTriangles_MeshSphereOverlap	(PintSQThreadContext context, PintObjectHandle handle, udword nb, const PintSphereOverlapData* overlaps);
+		virtual	udword				FindTriangles_MeshBoxOverlap	(PintSQThreadContext context, PintObjectHandle handle, udword nb, const PintBoxOverlapData* overlaps);
+		virtual	udword				FindTriangles_MeshCapsuleOverlap(PintSQThreadContext context, PintObjectHandle handle, udword nb, const PintCapsuleOverlapData* overlaps);
+
+		virtual	PR					GetWorldTransform(PintObjectHandle handle);
+		virtual	void				SetWorldTransform(PintObjectHandle handle, const PR& pose);
+		virtual	void				GetWorldTransforms(udword nb, const PintObjectHandle* handles, PR* poses);
+		virtual	udword				GetActiveTransforms(udword max_nb, PintObjectHandle* handles, Point* positions, Quat* rotations);
+
+		virtual	void				AddWorldImpulseAtWorldPos(PintObjectHandle handle, const Point& world_impulse, const Point& world_pos);
+		virtual	void				AddLocalTorque(PintObjectHandle handle, const Point& local_torque);
+
+		virtual	Point				GetAngularVelocity(PintObjectHandle handle);
+		virtual	void				SetAngularVelocity(PintObjectHandle handle, const Point& angular_velocity);
+
+		virtual	float				GetMass(PintObjectHandle handle);
+		virtual	Point				GetLocalInertia(PintObjectHandle handle);
+
+		virtual	udword				GetShapes(PintObjectHandle* shapes, PintObjectHandle handle);
+		virtual	void				SetLocalRot(PintObjectHandle handle, const Quat& q);
+
+		virtual	bool				SetKinematicPose(PintObjectHandle handle, const Point& pos);
+		virtual	bool				SetKinematicPose(PintObjectHandle handle, const PR& pr);
+
+		virtual	PintSQThreadContext	CreateSQThreadContext();
+		virtual	void				ReleaseSQThreadContext(PintSQThreadContext context);
+
+		virtual	udword				CreateConvexObject(const PINT_CONVEX_DATA_CREATE& desc);
+		virtual	udword				BatchConvexSweeps	(PintSQThreadContext context, udword nb, PintRaycastHit* dest, const PintConvexSweepData* sweeps);
+
+		virtual	PintObjectHandle	CreateAggregate(udword max_size, bool enable_self_collision);
+		virtual	bool				AddToAggregate(PintObjectHandle object, PintObjectHandle aggregate);
+		virtual	bool				AddAggregateToScene(PintObjectHandle aggregate);
+
+		virtual	PintObjectHandle	CreateArticulation(const PINT_ARTICULATION_CREATE& desc);
+		virtual	PintObjectHandle	CreateArticulatedObject(const PINT_OBJECT_CREATE& desc, const PINT_ARTICULATED_BODY_CREATE& body, PintObjectHandle articulation);
+		virtual	bool				AddArticulationToScene(PintObjectHandle articulation);
+		virtual	void				SetArticulatedMotor(PintObjectHandle object, const PINT_ARTICULATED_MOTOR_CREATE& motor);
+
+		virtual	PintObjectHandle	CreateVehicle(PintVehicleData& data, const PINT_VEHICLE_CREATE& vehicle);
+		virtual	void				SetVehicleInput(PintObjectHandle vehicle, const PINT_VEHICLE_INPUT& input);
+
+		virtual	void				TestNewFeature();
+		private:
+				Pint&				mEngine;
+				FILE*				mFile;
+				CaptureIDMap		mHandles;		// Objects, aggregates, articulations, vehicles, phantoms & shapes
+				CaptureIDMap		mRenderers;
+				Container			mConvexObjects;	// CreateConvexObject() indices, by ID
+				udword				mNbHandles;
+				udword				mNbRenderers;
+
+				void				WriteDword(udword value);
+				void				WriteFloat(float value);
+				void				WriteData(const void* data, udword size);
+				void				WriteString(const char* string);
+				void				WriteHandle(PintObjectHandle handle);
+				void				WriteRenderer(const PintShapeRenderer* renderer);
+				void				WriteShape(const PINT_SHAPE_CREATE& shape);
+				void				WriteObject(const PINT_OBJECT_CREATE& desc);
+				void				WriteMotor(const PINT_ARTICULATED_MOTOR_CREATE& motor);
+				void				WriteQueries(udword op, udword nb, const void* queries, udword size);
+				// Gives the next ID to the returned handle, even if it is null, so that IDs stay in sync during replay
+				PintObjectHandle	NewHandle(PintObjectHandle handle);
+	};
+
+	// Replays a capture with each registered plugin, prints the timings & saves them to "<filename>.csv". Returns false
+	// if the file cannot be read or is invalid.
+	bool	ReplayCapture(const char* filename);
+
+#endif
@@ -40,12 +40,28 @@ PintObjectHandle ObjectsManager::GetObject(udword i) const
 	return Entries[i];
 }
 
+const PintObjectHandle* ObjectsManager::GetObjects() const
+{
+	return (const PintObjectHandle*)mObjects.GetEntries();
+}
+
+void ObjectsManager::GetWorldTransforms(PR* poses) const
+{
+	ASSERT(mOwner);
+	mOwner->GetWorldTransforms(GetNbObjects(), GetObjects(), poses);
+}
+
 void ObjectsManager::AddObject(PintObjectHandle object)
 {
 	PintObjectHandle* Memory = (PintObjectHandle*)mObjects.Reserve(gEntrySize);
 	*Memory = object;
 }
 
+PintObjectHandle* ObjectsManager::ReserveObjects(udword nb)
+{
+	return (PintObjectHandle*)mObjects.Reserve(nb*gEntrySize);
+}
+
 void ObjectsManager::Reset()
 {
 	mOwner = null;
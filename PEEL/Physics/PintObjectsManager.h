@@ -23,7 +23,13 @@
 
 				udword				GetNbObjects()		const;
 				PintObjectHandle	GetObject(udword i)	const;
+				// Handles are stored contiguously, in creation order
+				const PintObjectHandle*	GetObjects()	const;
+				// Reads the poses of all objects in one call. "poses" must have room for GetNbObjects() entries.
+				void				GetWorldTransforms(PR* poses)	const;
 				void				AddObject(PintObjectHandle object);
+				// Reserves room for nb new handles at the end of the array, and returns the corresponding memory
+				PintObjectHandle*	ReserveObjects(udword nb);
 				void				Reset();
 		private:
 				Pint*				mOwner;
@@ -37,4 +43,11 @@
 		return handle;
 	}
 
+	// The handles are written directly into the objects manager, so that the call only measures the engine.
+	inline_ udword CreatePintObjects(Pint& pint, udword nb, const PINT_OBJECT_CREATE* descs)
+	{
+		PintObjectHandle* handles = pint.mOMHelper->ReserveObjects(nb);
+		return pint.CreateObjects(nb, descs, handles);
+	}
+
 #endif
\ No newline at end of file
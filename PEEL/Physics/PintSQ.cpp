@@ -23,6 +23,9 @@ PintSQ::PintSQ() :
 	mBoxOverlapData		(null),
 	mCapsuleOverlapData	(null)
 {
+	for(udword i=0;i<MAX_NB_SQ_THREADS-1;i++)
+		mWorkerContexts[i] = null;
+	ResetLastBatch();
 }
 
 PintSQ::~PintSQ()
@@ -49,8 +52,18 @@ void PintSQ::ResetAllDataPointers()
 	mCapsuleOverlapData	= null;
 }
 
+void PintSQ::ResetLastBatch()
+{
+	mLastBatch.mType	= SQ_BATCH_RAYCASTS;
+	mLastBatch.mNb		= 0;
+	mLastBatch.mQueries	= null;
+	mLastBatch.mHits	= null;
+}
+
 void PintSQ::ResetHitData()
 {
+	ResetLastBatch();
+
 	mRaycasts.Reset();
 	mRaycastsAny.Reset();
 	mRaycastsAll.Reset();
@@ -75,6 +88,14 @@ void PintSQ::Reset()
 		mOwner->ReleaseSQThreadContext(mThreadContext);
 		mThreadContext = null;
 	}
+	for(udword i=0;i<MAX_NB_SQ_THREADS-1;i++)
+	{
+		if(mWorkerContexts[i])
+		{
+			mOwner->ReleaseSQThreadContext(mWorkerContexts[i]);
+			mWorkerContexts[i] = null;
+		}
+	}
 	mOwner = null;
 
 	ResetHitData();
@@ -90,6 +111,19 @@ void PintSQ::Init(Pint* owner)
 	owner->mSQHelper = this;
 }
 
+PintSQThreadContext PintSQ::GetThreadContext(udword index)
+{
+	ASSERT(mOwner);
+	ASSERT(index<MAX_NB_SQ_THREADS);
+	if(!index)
+		return mThreadContext;
+
+	PintSQThreadContext& Context = mWorkerContexts[index-1];
+	if(!Context)
+		Context = mOwner->CreateSQThreadContext();
+	return Context;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 PintRaycastHit* PintSQ::PrepareRaycastQuery(udword nb, const PintRaycastData* data)
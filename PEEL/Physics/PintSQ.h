@@ -25,6 +25,34 @@
 	struct PintBooleanHit;
 	struct PintOverlapObjectHit;
 
+	#define MAX_NB_SQ_THREADS	32
+
+	// Batched query types, see SQThreads.h
+	enum SQBatchType
+	{
+		SQ_BATCH_RAYCASTS,
+		SQ_BATCH_RAYCAST_ANY,
+		SQ_BATCH_RAYCAST_ALL,
+		SQ_BATCH_BOX_SWEEPS,
+		SQ_BATCH_SPHERE_SWEEPS,
+		SQ_BATCH_CAPSULE_SWEEPS,
+		SQ_BATCH_CONVEX_SWEEPS,
+		SQ_BATCH_SPHERE_OVERLAP_ANY,
+		SQ_BATCH_SPHERE_OVERLAP_OBJECTS,
+		SQ_BATCH_BOX_OVERLAP_ANY,
+		SQ_BATCH_BOX_OVERLAP_OBJECTS,
+		SQ_BATCH_CAPSULE_OVERLAP_ANY,
+		SQ_BATCH_CAPSULE_OVERLAP_OBJECTS,
+	};
+
+	struct SQBatch
+	{
+		SQBatchType		mType;
+		udword			mNb;
+		const void*		mQueries;	// Test-owned query data, e.g. PintRaycastData array
+		void*			mHits;		// PintSQ-owned hits buffer, e.g. PintRaycastHit array
+	};
+
 	template <typename Type>
 	class Hits
 	{
@@ -94,10 +122,19 @@
 				void							ResetHitData();
 
 		inline_	PintSQThreadContext				GetThreadContext()	const	{ return mThreadContext;		}
+		// Context for SQ thread 'index'. Thread 0 is the main thread and uses the default context. Others are created on
+		// first use, so this must be called from the main thread before the queries are dispatched.
+				PintSQThreadContext				GetThreadContext(udword index);
+
+		// Last batch of queries, kept until the test is closed (e.g. to measure multi-threaded scaling)
+		inline_	const SQBatch&					GetLastBatch()		const	{ return mLastBatch;			}
+		inline_	void							SetLastBatch(const SQBatch& batch)	{ mLastBatch = batch;	}
 
 		private:
 				Pint*							mOwner;
 				PintSQThreadContext				mThreadContext;
+				PintSQThreadContext				mWorkerContexts[MAX_NB_SQ_THREADS-1];
+				SQBatch							mLastBatch;
 				//
 				Hits<PintRaycastHit>			mRaycasts;
 				Hits<PintBooleanHit>			mRaycastsAny;
@@ -128,6 +165,7 @@
 				const PintCapsuleOverlapData*	mCapsuleOverlapData;
 
 				void							ResetAllDataPointers();
+				void							ResetLastBatch();
 	};
 
 #endif
\ No newline at end of file
@@ -9,18 +9,248 @@
 #include "stdafx.h"
 #include "PintTiming.h"
 
+static inline_ udword GetHighestBit(udword value)
+{
+	udword Index = 0;
+	while(value>>=1)
+		Index++;
+	return Index;
+}
+
+static inline_ udword GetBucketIndex(udword value)
+{
+	if(value<PINT_HISTOGRAM_NB_SUB_BUCKETS*2)
+		return value;
+
+	const udword HighestBit = GetHighestBit(value);
+	const udword Shift = HighestBit - PINT_HISTOGRAM_SUB_BUCKET_BITS;
+	const udword SubBucket = (value>>Shift) - PINT_HISTOGRAM_NB_SUB_BUCKETS;
+	return PINT_HISTOGRAM_NB_SUB_BUCKETS*2 + (Shift-1)*PINT_HISTOGRAM_NB_SUB_BUCKETS + SubBucket;
+}
+
+// Returns the range of values stored in a bucket
+static inline_ void GetBucketRange(udword index, udword& lowest, udword& width)
+{
+	if(index<PINT_HISTOGRAM_NB_SUB_BUCKETS*2)
+	{
+		lowest = index;
+		width = 1;
+		return;
+	}
+
+	const udword Offset = index - PINT_HISTOGRAM_NB_SUB_BUCKETS*2;
+	const udword Shift = Offset/PINT_HISTOGRAM_NB_SUB_BUCKETS + 1;
+	const udword SubBucket = Offset%PINT_HISTOGRAM_NB_SUB_BUCKETS;
+	lowest = (PINT_HISTOGRAM_NB_SUB_BUCKETS + SubBucket)<<Shift;
+	width = 1<<Shift;
+}
+
+PintHistogram::PintHistogram()
+{
+	Reset();
+}
+
+PintHistogram::~PintHistogram()
+{
+}
+
+void PintHistogram::Reset()
+{
+	mNbValues	= 0;
+	mMin		= MAX_UDWORD;
+	mMax		= 0;
+	mMean		= 0.0;
+	mM2			= 0.0;
+	ZeroMemory(mCounts, sizeof(udword)*PINT_HISTOGRAM_NB_BUCKETS);
+}
+
+void PintHistogram::Record(udword value)
+{
+	mCounts[GetBucketIndex(value)]++;
+	mNbValues++;
+	if(value<mMin)
+		mMin = value;
+	if(value>mMax)
+		mMax = value;
+
+	const double Delta = double(value) - mMean;
+	mMean += Delta / double(mNbValues);
+	mM2 += Delta * (double(value) - mMean);
+}
+
+void PintHistogram::Add(const PintHistogram& other)
+{
+	if(!other.mNbValues)
+		return;
+
+	for(udword i=0;i<PINT_HISTOGRAM_NB_BUCKETS;i++)
+		mCounts[i] += other.mCounts[i];
+	if(other.mMin<mMin)
+		mMin = other.mMin;
+	if(other.mMax>mMax)
+		mMax = other.mMax;
+
+	// Combined mean & sum of squared deviations of both sets (Chan et al.)
+	const double NbA = double(mNbValues);
+	const double NbB = double(other.mNbValues);
+	const double Nb = NbA + NbB;
+	const double Delta = other.mMean - mMean;
+	mMean += Delta * NbB / Nb;
+	mM2 += other.mM2 + Delta * Delta * NbA * NbB / Nb;
+	mNbValues += other.mNbValues;
+}
+
+float PintHistogram::GetStdDev() const
+{
+	if(mNbValues<2)
+		return 0.0f;
+	return float(sqrt(mM2 / double(mNbValues-1)));
+}
+
+udword PintHistogram::GetPercentile(float percentile) const
+{
+	if(!mNbValues)
+		return 0;
+
+	udword Target = udword(ceil(double(percentile) * double(mNbValues) / 100.0));
+	if(!Target)
+		Target = 1;
+	if(Target>=mNbValues)
+		return mMax;
+
+	udword Total = 0;
+	for(udword i=0;i<PINT_HISTOGRAM_NB_BUCKETS;i++)
+	{
+		Total += mCounts[i];
+		if(Total>=Target)
+		{
+			// Report the middle of the bucket, clamped to the actual range of recorded values
+			udword Lowest, Width;
+			GetBucketRange(i, Lowest, Width);
+			udword Value = Lowest + Width/2;
+			if(Value<mMin)
+				Value = mMin;
+			if(Value>mMax)
+				Value = mMax;
+			return Value;
+		}
+	}
+	return mMax;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 PintTiming::PintTiming() :
-	mNbCalls			(0),
 	mCurrentTestResult	(0),
 	mCurrentMemory		(0),
+	mPeakMemory			(0),
 	mCurrentTime		(0),
-	mAvgTime			(0),
-	mWorstTime			(0)
+	mFrameRecorded		(false),
+	mNbCounterFrames	(0),
+	mRecordedCounters	(null),
+	mNbAllocFrames		(0),
+	mRecordedAllocs		(null)
 {
 	ZeroMemory(mRecorded, sizeof(PintRecord)*MAX_NB_RECORDED_FRAMES);
+	ZeroMemory(&mCurrentCounters, sizeof(HardwareCounterValues));
+	ZeroMemory(&mTotalCounters, sizeof(HardwareCounterValues));
+	ZeroMemory(&mCurrentAllocs, sizeof(PintAllocRecord));
+	ZeroMemory(&mTotalAllocs, sizeof(PintAllocStats));
 }
 
 PintTiming::~PintTiming()
 {
+	ICE_FREE(mRecordedAllocs);
+	ICE_FREE(mRecordedCounters);
+}
+
+void PintTiming::ResetTimings()
+{
+	mCurrentMemory = mPeakMemory = mCurrentTime = 0;
+	ZeroMemory(mRecorded, sizeof(PintRecord)*MAX_NB_RECORDED_FRAMES);
+	mFrameRecorded = false;
+	mHistogram.Reset();
+	for(udword i=0;i<PINT_TIMING_NB_PHASES;i++)
+		mPhaseHistograms[i].Reset();
+
+	mNbCounterFrames = 0;
+	ZeroMemory(&mCurrentCounters, sizeof(HardwareCounterValues));
+	ZeroMemory(&mTotalCounters, sizeof(HardwareCounterValues));
+	if(mRecordedCounters)
+		ZeroMemory(mRecordedCounters, sizeof(PintCounterRecord)*MAX_NB_RECORDED_FRAMES);
+
+	mNbAllocFrames = 0;
+	mAllocsHistogram.Reset();
+	ZeroMemory(&mCurrentAllocs, sizeof(PintAllocRecord));
+	ZeroMemory(&mTotalAllocs, sizeof(PintAllocStats));
+	if(mRecordedAllocs)
+		ZeroMemory(mRecordedAllocs, sizeof(PintAllocRecord)*MAX_NB_RECORDED_FRAMES);
+}
+
+void PintTiming::RecordCounters(const HardwareCounterValues& values, udword frame_nb)
+{
+	mCurrentCounters = values;
+	for(udword i=0;i<HW_COUNTER_COUNT;i++)
+		mTotalCounters.mValues[i] += values.mValues[i];
+	mNbCounterFrames++;
+
+	if(frame_nb<MAX_NB_RECORDED_FRAMES)
+	{
+		if(!mRecordedCounters)
+		{
+			mRecordedCounters = (PintCounterRecord*)ICE_ALLOC(sizeof(PintCounterRecord)*MAX_NB_RECORDED_FRAMES);
+			ZeroMemory(mRecordedCounters, sizeof(PintCounterRecord)*MAX_NB_RECORDED_FRAMES);
+		}
+		mRecordedCounters[frame_nb] = values;
+	}
 }
 
+void PintTiming::RecordAllocations(const PintAllocStats& before, const PintAllocStats& after, udword frame_nb)
+{
+	PintAllocRecord Frame;
+	Frame.mNbAllocs			= udword(after.mNbAllocs - before.mNbAllocs);
+	Frame.mNbFrees			= udword(after.mNbFrees - before.mNbFrees);
+	Frame.mAllocatedBytes	= after.mAllocatedBytes - before.mAllocatedBytes;
+	Frame.mFreedBytes		= after.mFreedBytes - before.mFreedBytes;
+	mCurrentAllocs = Frame;
+
+	mTotalAllocs.mNbAllocs += Frame.mNbAllocs;
+	mTotalAllocs.mNbFrees += Frame.mNbFrees;
+	mTotalAllocs.mAllocatedBytes += Frame.mAllocatedBytes;
+	mTotalAllocs.mFreedBytes += Frame.mFreedBytes;
+	mTotalAllocs.mCurrentBytes = after.mCurrentBytes;
+	if(after.mPeakBytes>mTotalAllocs.mPeakBytes)
+		mTotalAllocs.mPeakBytes = after.mPeakBytes;
+	for(udword i=0;i<PINT_NB_ALLOC_SIZE_CLASSES;i++)
+		mTotalAllocs.mSizeClasses[i] += after.mSizeClasses[i] - before.mSizeClasses[i];
+
+	mAllocsHistogram.Record(Frame.mNbAllocs);
+	mNbAllocFrames++;
+
+	if(frame_nb<MAX_NB_RECORDED_FRAMES)
+	{
+		if(!mRecordedAllocs)
+		{
+			mRecordedAllocs = (PintAllocRecord*)ICE_ALLOC(sizeof(PintAllocRecord)*MAX_NB_RECORDED_FRAMES);
+			ZeroMemory(mRecordedAllocs, sizeof(PintAllocRecord)*MAX_NB_RECORDED_FRAMES);
+		}
+		mRecordedAllocs[frame_nb] = Frame;
+	}
+}
+
+void PintTiming::GetAverageCounters(HardwareCounterValues& values) const
+{
+	for(udword i=0;i<HW_COUNTER_COUNT;i++)
+		values.mValues[i] = mNbCounterFrames ? mTotalCounters.mValues[i]/mNbCounterFrames : 0;
+}
+
+const char* GetTimingPhaseName(PintTimingPhase phase)
+{
+	switch(phase)
+	{
+		case PINT_TIMING_SIMULATE:		return "Simulate";
+		case PINT_TIMING_TEST_UPDATE:	return "Test update";
+		case PINT_TIMING_CRITICAL_PATH:	return "Critical path";
+	};
+	return null;
+}
@@ -9,12 +9,73 @@
 #ifndef PINT_TIMING_H
 #define PINT_TIMING_H
 
+#include "HardwareCounters.h"
+#include "PintAllocTracker.h"
+
+	// Per-frame trace, only used to export frame-by-frame graphs. Statistics are computed from the histograms and cover all frames.
 	#define MAX_NB_RECORDED_FRAMES	1024*8
 
 	struct PintRecord
 	{
 		udword	mTime;
-		udword	mUsedMemory;
+		udword	mTestResult;
+		uqword	mUsedMemory;
+	};
+
+	// Per-frame allocations in Pint::Update, only recorded for plugins that support it (see PintAllocTracker.h)
+	struct PintAllocRecord
+	{
+		udword	mNbAllocs;
+		udword	mNbFrees;
+		uqword	mAllocatedBytes;
+		uqword	mFreedBytes;
+	};
+
+	// Per-frame hardware counters, only recorded when enabled (see HardwareCounters.h)
+	typedef HardwareCounterValues	PintCounterRecord;
+
+	// Log-linear histogram (HDR-style). Values below 2*PINT_HISTOGRAM_NB_SUB_BUCKETS are stored exactly, larger values
+	// are stored with PINT_HISTOGRAM_SUB_BUCKET_BITS bits of precision, i.e. with a relative error below 1/32. Memory
+	// usage is constant regardless of the number of recorded values.
+	#define PINT_HISTOGRAM_SUB_BUCKET_BITS	5
+	#define PINT_HISTOGRAM_NB_SUB_BUCKETS	(1<<PINT_HISTOGRAM_SUB_BUCKET_BITS)
+	#define PINT_HISTOGRAM_NB_BUCKETS		(PINT_HISTOGRAM_NB_SUB_BUCKETS*2 + (32-PINT_HISTOGRAM_SUB_BUCKET_BITS-1)*PINT_HISTOGRAM_NB_SUB_BUCKETS)
+
+	class PintHistogram : public Allocateable
+	{
+		public:
+							PintHistogram();
+							~PintHistogram();
+
+				void		Reset();
+				void		Record(udword value);
+				// Adds the values recorded by another histogram, e.g. to combine several runs of a test
+				void		Add(const PintHistogram& other);
+
+		inline_	udword		GetNbValues()	const	{ return mNbValues;								}
+		inline_	udword		GetMin()		const	{ return mNbValues ? mMin : 0;					}
+		inline_	udword		GetMax()		const	{ return mMax;									}
+		inline_	float		GetMean()		const	{ return float(mMean);							}
+				float		GetStdDev()		const;
+				// Returns the value below which "percentile" percents of the recorded values fall (e.g. 99.9f for p99.9)
+				udword		GetPercentile(float percentile)	const;
+
+		private:
+				udword		mNbValues;
+				udword		mMin;
+				udword		mMax;
+				double		mMean;	// Running mean & sum of squared deviations (Welford)
+				double		mM2;
+				udword		mCounts[PINT_HISTOGRAM_NB_BUCKETS];
+	};
+
+	enum PintTimingPhase
+	{
+		PINT_TIMING_SIMULATE,		// Pint::Update
+		PINT_TIMING_TEST_UPDATE,	// PhysicsTest::Update (SQ tests)
+		PINT_TIMING_CRITICAL_PATH,	// Pint::BeginUpdate to the end of Pint::EndUpdate (async updates), not part of the frame's total
+
+		PINT_TIMING_NB_PHASES
 	};
 
 	class PintTiming : public Allocateable
@@ -23,17 +84,18 @@
 							PintTiming();
 							~PintTiming();
 
-		inline_	void		ResetTimings()			{ mNbCalls = mCurrentMemory = mCurrentTime = mAvgTime = mWorstTime = 0;	}
-		inline_	udword		GetAvgTime()	const	{ return mNbCalls ? udword(mAvgTime/mNbCalls) : 0;						}
+				void		ResetTimings();
+		inline_	udword		GetAvgTime()	const	{ return udword(mHistogram.GetMean());	}
+		inline_	udword		GetWorstTime()	const	{ return mHistogram.GetMax();			}
 
-		inline_	void		RecordTimeAndMemory(udword time, udword memory, udword frame_nb)
+		inline_	void		RecordTimeAndMemory(PintTimingPhase phase, udword time, uqword memory, udword frame_nb)
 							{
-								mNbCalls++;
-								mAvgTime += time;
+								mPhaseHistograms[phase].Record(time);
 								mCurrentTime = time;
 								mCurrentMemory = memory;
-								if(time>mWorstTime)
-									mWorstTime = time;
+								if(memory>mPeakMemory)
+									mPeakMemory = memory;
+								mFrameRecorded = true;
 								if(frame_nb<MAX_NB_RECORDED_FRAMES)
 								{
 									mRecorded[frame_nb].mTime = time;
@@ -41,23 +103,66 @@
 								}
 							}
 
-		inline_	void		UpdateRecordedTime(udword time, udword frame_nb)
+		// Allocations made during Pint::Update, from the engine's stats before & after the call. The per-frame trace is allocated on first use.
+				void		RecordAllocations(const PintAllocStats& before, const PintAllocStats& after, udword frame_nb);
+		inline_	bool		HasAllocations()	const	{ return mNbAllocFrames!=0;	}
+
+		inline_	void		UpdateRecordedTime(PintTimingPhase phase, udword time, udword frame_nb)
 							{
-								mAvgTime += time;
+								mPhaseHistograms[phase].Record(time);
 								mCurrentTime += time;
-								if(mCurrentTime>mWorstTime)
-									mWorstTime = mCurrentTime;
+								mFrameRecorded = true;
 								if(frame_nb<MAX_NB_RECORDED_FRAMES)
 									mRecorded[frame_nb].mTime += time;
 							}
 
-				udword		mNbCalls;
+		// Records a phase that doesn't contribute to the frame's total, e.g. because it overlaps the others
+		inline_	void		RecordPhaseTime(PintTimingPhase phase, udword time)
+							{
+								mPhaseHistograms[phase].Record(time);
+							}
+
+		inline_	void		RecordTestResult(udword result, udword frame_nb)
+							{
+								mCurrentTestResult = result;
+								if(frame_nb<MAX_NB_RECORDED_FRAMES)
+									mRecorded[frame_nb].mTestResult = result;
+							}
+
+		// Hardware counters for Pint::Update. The per-frame trace is allocated on first use.
+				void		RecordCounters(const HardwareCounterValues& values, udword frame_nb);
+		inline_	bool		HasCounters()	const	{ return mNbCounterFrames!=0;	}
+				void		GetAverageCounters(HardwareCounterValues& values)	const;
+
+		// Must be called once all phases of a frame have been recorded. Feeds the frame's total time to the main histogram.
+		inline_	void		EndFrame()
+							{
+								if(mFrameRecorded)
+								{
+									mHistogram.Record(mCurrentTime);
+									mFrameRecorded = false;
+								}
+							}
+
 				udword		mCurrentTestResult;
-				udword		mCurrentMemory;
+				uqword		mCurrentMemory;
+				uqword		mPeakMemory;
 				udword		mCurrentTime;
-				udword		mAvgTime;
-				udword		mWorstTime;
+				bool		mFrameRecorded;
+				PintHistogram	mHistogram;								// Per-frame totals
+				PintHistogram	mPhaseHistograms[PINT_TIMING_NB_PHASES];	// Per-phase timings
 				PintRecord	mRecorded[MAX_NB_RECORDED_FRAMES];
+				HardwareCounterValues	mCurrentCounters;
+				HardwareCounterValues	mTotalCounters;
+				udword		mNbCounterFrames;
+				PintCounterRecord*	mRecordedCounters;	// MAX_NB_RECORDED_FRAMES entries, or null
+				PintAllocRecord	mCurrentAllocs;
+				PintAllocStats	mTotalAllocs;		// Sums over all frames, except mCurrentBytes (last frame) & mPeakBytes (max)
+				PintHistogram	mAllocsHistogram;	// Per-frame number of allocations
+				udword		mNbAllocFrames;
+				PintAllocRecord*	mRecordedAllocs;	// MAX_NB_RECORDED_FRAMES entries, or null
 	};
 
+	const char*	GetTimingPhaseName(PintTimingPhase phase);
+
 #endif
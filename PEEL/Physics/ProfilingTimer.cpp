@@ -0,0 +1,184 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "ProfilingTimer.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+	#define PEEL_HAS_TSC
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#include <emmintrin.h>
+	#else
+		#include <x86intrin.h>
+	#endif
+#endif
+
+#ifdef _WIN32
+	#include <mmsystem.h>
+	#pragma comment(lib, "winmm.lib")
+#else
+	#include <time.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Monotonic clock, used as a reference to calibrate the TSC
+#ifdef _WIN32
+static uqword ReadQPC()
+{
+	LARGE_INTEGER Counter;
+	QueryPerformanceCounter(&Counter);
+	return uqword(Counter.QuadPart);
+}
+
+static uqword GetQPCFrequency()
+{
+	LARGE_INTEGER Frequency;
+	QueryPerformanceFrequency(&Frequency);
+	return uqword(Frequency.QuadPart);
+}
+
+static uqword ReadTimeGetTime()
+{
+	return uqword(timeGetTime());
+}
+
+	#define ReadMonotonic			ReadQPC
+	#define GetMonotonicFrequency	GetQPCFrequency
+#else
+static uqword ReadMonotonicRaw()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	return uqword(ts.tv_sec)*1000000000 + uqword(ts.tv_nsec);
+}
+
+static uqword GetMonotonicRawFrequency()
+{
+	return 1000000000;
+}
+
+	#define ReadMonotonic			ReadMonotonicRaw
+	#define GetMonotonicFrequency	GetMonotonicRawFrequency
+#endif
+
+#ifdef PEEL_HAS_TSC
+// The lfences prevent the CPU from executing the profiled code before the start timestamp is read, or the end
+// timestamp before the profiled code is done. rdtscp waits for previous instructions but not for later ones.
+static uqword ReadTSC_Start()
+{
+	_mm_lfence();
+	const uqword Value = __rdtsc();
+	_mm_lfence();
+	return Value;
+}
+
+static uqword ReadTSC_End()
+{
+	unsigned int Aux;
+	const uqword Value = __rdtscp(&Aux);
+	_mm_lfence();
+	return Value;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+static ProfilingTimer	gProfilingTimers[PROFILING_UNITS_COUNT];
+static bool				gProfilingTimersInitialized = false;
+
+static void SetupTimer(ProfilingTimer& timer, const char* name, const char* units, ProfilingTimer::ReadTimestamp start, ProfilingTimer::ReadTimestamp end, uqword mask, uqword frequency, double units_per_second)
+{
+	timer.mName			= name;
+	timer.mUnits		= units;
+	timer.mStart		= start;
+	timer.mEnd			= end;
+	timer.mMask			= mask;
+	timer.mFrequency	= frequency;
+	timer.mTicksToUnits	= units_per_second/double(frequency);
+	timer.mOverhead		= 0;
+}
+
+#ifdef PEEL_HAS_TSC
+static uqword CalibrateTSC()
+{
+	// Spin for ~100 ms and compare the TSC against the monotonic clock
+	const uqword MonotonicFrequency = GetMonotonicFrequency();
+	const uqword MonotonicStart = ReadMonotonic();
+	const uqword TSCStart = ReadTSC_Start();
+	uqword MonotonicEnd;
+	do
+	{
+		MonotonicEnd = ReadMonotonic();
+	}while(MonotonicEnd - MonotonicStart < MonotonicFrequency/10);
+	const uqword TSCEnd = ReadTSC_End();
+
+	return uqword(double(TSCEnd - TSCStart) * double(MonotonicFrequency) / double(MonotonicEnd - MonotonicStart));
+}
+#endif
+
+static uqword MeasureOverhead(const ProfilingTimer& timer)
+{
+	uqword MinTicks = uqword(-1);
+	for(udword i=0;i<1000;i++)
+	{
+		const uqword Start = timer.Start();
+		const uqword Ticks = timer.GetElapsedTicks(Start);
+		if(Ticks<MinTicks)
+			MinTicks = Ticks;
+	}
+	return MinTicks;
+}
+
+void InitProfilingTimers()
+{
+	if(gProfilingTimersInitialized)
+		return;
+
+	// K-Cycles (cycles/1024) is what PEEL has always reported for RDTSC
+#ifdef PEEL_HAS_TSC
+	const uqword TSCFrequency = CalibrateTSC();
+	SetupTimer(gProfilingTimers[PROFILING_UNITS_RDTSC], "K-Cycles (RDTSC)", "K-Cycles", ReadTSC_Start, ReadTSC_End, uqword(-1), TSCFrequency, double(TSCFrequency)/1024.0);
+#else
+	SetupTimer(gProfilingTimers[PROFILING_UNITS_RDTSC], "us (monotonic clock, no TSC)", "us", ReadMonotonic, ReadMonotonic, uqword(-1), GetMonotonicFrequency(), 1000000.0);
+#endif
+
+#ifdef _WIN32
+	// timeGetTime() is a 32-bit counter, it wraps after ~49 days
+	SetupTimer(gProfilingTimers[PROFILING_UNITS_TIME_GET_TIME], "ms (timeGetTime)", "ms", ReadTimeGetTime, ReadTimeGetTime, 0xffffffff, 1000, 1000.0);
+	SetupTimer(gProfilingTimers[PROFILING_UNITS_QPC], "us (QPC)", "us", ReadQPC, ReadQPC, uqword(-1), GetQPCFrequency(), 1000000.0);
+#else
+	SetupTimer(gProfilingTimers[PROFILING_UNITS_TIME_GET_TIME], "ms (monotonic clock)", "ms", ReadMonotonicRaw, ReadMonotonicRaw, uqword(-1), 1000000000, 1000.0);
+	SetupTimer(gProfilingTimers[PROFILING_UNITS_QPC], "us (monotonic clock)", "us", ReadMonotonicRaw, ReadMonotonicRaw, uqword(-1), 1000000000, 1000000.0);
+#endif
+
+	for(udword i=0;i<PROFILING_UNITS_COUNT;i++)
+		gProfilingTimers[i].mOverhead = MeasureOverhead(gProfilingTimers[i]);
+
+	gProfilingTimersInitialized = true;
+
+	PrintProfilingTimers();
+}
+
+const ProfilingTimer& GetProfilingTimer(ProfilingUnits units)
+{
+	ASSERT(gProfilingTimersInitialized);
+	ASSERT(units<PROFILING_UNITS_COUNT);
+	return gProfilingTimers[units];
+}
+
+void PrintProfilingTimers()
+{
+	printf("Profiling timers:\n");
+	for(udword i=0;i<PROFILING_UNITS_COUNT;i++)
+	{
+		const ProfilingTimer& Timer = gProfilingTimers[i];
+		printf("  %s: %.3f MHz, overhead: %d ticks (%.1f ns)\n", Timer.mName, double(Timer.mFrequency)/1000000.0, udword(Timer.mOverhead), Timer.ToNanoseconds(Timer.mOverhead));
+	}
+}
@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef PROFILING_TIMER_H
+#define PROFILING_TIMER_H
+
+	enum ProfilingUnits
+	{
+		PROFILING_UNITS_RDTSC,
+		PROFILING_UNITS_TIME_GET_TIME,
+		PROFILING_UNITS_QPC,
+
+		PROFILING_UNITS_COUNT
+	};
+
+	// Timestamp source used to profile the engines. All counters are 64-bit. Reported values keep the historical
+	// PEEL units (K-Cycles, ms, us) so that results remain comparable with older CSV files.
+	//
+	// - RDTSC uses serialized reads (lfence/rdtsc/lfence to start, rdtscp/lfence to stop). It falls back to the
+	// monotonic clock on platforms without a TSC.
+	// - "timeGetTime" is the 1 ms Windows timer, or the monotonic clock elsewhere.
+	// - QPC is QueryPerformanceCounter on Windows, clock_gettime(CLOCK_MONOTONIC_RAW) elsewhere.
+	struct ProfilingTimer
+	{
+		typedef	uqword	(*ReadTimestamp)();
+
+		const char*		mName;			// For the UI
+		const char*		mUnits;			// Units of values returned by GetElapsed()
+		ReadTimestamp	mStart;
+		ReadTimestamp	mEnd;
+		uqword			mMask;			// For counters narrower than 64 bits
+		uqword			mFrequency;		// Ticks per second (calibrated for the TSC)
+		double			mTicksToUnits;
+		uqword			mOverhead;		// Smallest measured start/end pair, in ticks
+
+		inline_	uqword	Start()								const	{ return (mStart)();										}
+		// Timestamp for the end of a section timed across threads, use GetTicks(start, end) for the duration
+		inline_	uqword	End()								const	{ return (mEnd)();											}
+		inline_	uqword	GetTicks(uqword start, uqword end)	const	{ return (end - start) & mMask;							}
+		inline_	uqword	GetElapsedTicks(uqword start)		const	{ return ((mEnd)() - start) & mMask;					}
+		inline_	udword	GetElapsed(uqword start)			const	{ return ToUnits(GetElapsedTicks(start));				}
+		inline_	udword	ToUnits(uqword ticks)				const	{ return udword(double(ticks)*mTicksToUnits);			}
+		inline_	double	ToNanoseconds(uqword ticks)			const	{ return double(ticks)*1000000000.0/double(mFrequency);	}
+	};
+
+	// Calibrates the TSC & measures the overhead of each timer. Call once at startup, from the main thread.
+	void					InitProfilingTimers();
+	const ProfilingTimer&	GetProfilingTimer(ProfilingUnits units);
+	void					PrintProfilingTimers();
+
+#endif
@@ -15,6 +15,9 @@ static String*			gProgressBarTitle = null;
 
 void CreateProgressBar(udword nb, const char* label)
 {
+#ifdef PEEL_HEADLESS
+	return;
+#endif
 	ASSERT(!gProgressBarTitle);
 	ASSERT(!gProgressBar);
 
@@ -49,11 +52,15 @@ void CreateProgressBar(udword nb, const char* label)
 
 void SetProgress(udword i)
 {
+	if(!gProgressBar)
+		return;
 	gProgressBar->SetValue(i);
 }
 
 void ReleaseProgressBar()
 {
+	if(!gWindow)
+		return;
 	gWindow->SetVisible(false);
 	DELETESINGLE(gWindow);
 	DELETESINGLE(gProgressBar);
@@ -0,0 +1,606 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "RegressionGate.h"
+#include "Simulation.h"
+#include "TestScenes.h"
+#include "RunConfig.h"
+
+#define MAX_NAME_LENGTH				128
+#define MAX_NB_REPORTED_NON_FAILED	10
+
+namespace
+{
+	struct BaselineEntry : public Allocateable
+	{
+		char	mTest[MAX_NAME_LENGTH];		// "Name" or "Name_SubName"
+		char	mEngine[MAX_NAME_LENGTH];
+		char	mUnits[16];
+		char	mAllocator[16];				// Allocator backend, empty for results older than the setting (system)
+		udword	mMedian;
+		udword	mP99;
+		uqword	mPeakMemory;
+	};
+
+	struct RegressionCheck : public Allocateable
+	{
+		char		mTest[MAX_NAME_LENGTH];
+		char		mEngine[MAX_NAME_LENGTH];
+		const char*	mMetric;
+		uqword		mBaseline;
+		uqword		mCurrent;
+		float		mDelta;		// In percents, positive means slower/bigger
+		bool		mFailed;
+	};
+}
+
+static Container	gBaseline;			// BaselineEntry pointers
+static Container	gChecks;			// RegressionCheck pointers
+static udword		gNbUnmatched = 0;
+static char			gBaselineFilename[1024] = {0};
+static float		gMaxMedianRegression = DEFAULT_MAX_MEDIAN_REGRESSION;
+static float		gMaxP99Regression = DEFAULT_MAX_P99_REGRESSION;
+static float		gMaxMemoryRegression = DEFAULT_MAX_MEMORY_REGRESSION;
+
+// Results of the running test's repetitions, for each engine
+static PintHistogram	gRepetitionHistograms[MAX_NB_ENGINES];
+static uqword			gRepetitionPeakMemory[MAX_NB_ENGINES] = {0};
+static udword			gNbRepetitions = 0;
+
+static void CopyName(char* dst, const char* src, udword size)
+{
+	strncpy(dst, src ? src : "", size-1);
+	dst[size-1] = 0;
+}
+
+static void GetTestKey(char* dst, const char* name, const char* sub_name)
+{
+	if(sub_name && *sub_name)
+		CopyName(dst, _F("%s_%s", name, sub_name), MAX_NAME_LENGTH);
+	else
+		CopyName(dst, name, MAX_NAME_LENGTH);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	// Minimal SAX-style JSON parser. Values are reported with their path, e.g. "engines[].stats.total.p50".
+	class JSONReader
+	{
+		public:
+							JSONReader(const char* text) : mText(text)	{ mPath[0] = 0;	}
+		virtual				~JSONReader()								{}
+
+		// Parses all root values (i.e. all lines of a JSON lines file)
+				bool		ParseAll()
+							{
+								SkipWhitespace();
+								while(*mText)
+								{
+									if(!ParseValue())
+										return false;
+									SkipWhitespace();
+								}
+								return true;
+							}
+
+		protected:
+		virtual	void		OnBeginObject(const char* path)							{}
+		virtual	void		OnEndObject(const char* path)							{}
+		virtual	void		OnValue(const char* path, const char* value)			{}
+
+		private:
+				const char*	mText;
+				char		mPath[256];
+				char		mValue[1024];
+
+				void		SkipWhitespace()
+							{
+								while(*mText==' ' || *mText=='\t' || *mText=='\r' || *mText=='\n')
+									mText++;
+							}
+
+				udword		PushPath(const char* name, bool is_array)
+							{
+								const udword Length = udword(strlen(mPath));
+								const udword NameLength = udword(strlen(name));
+								if(Length + NameLength + 3 < sizeof(mPath))
+								{
+									if(is_array)
+										strcat(mPath, "[]");
+									else
+									{
+										if(Length)
+											strcat(mPath, ".");
+										strcat(mPath, name);
+									}
+								}
+								return Length;
+							}
+
+				bool		ParseString(char* dst, udword size)
+							{
+								if(*mText!='"')
+									return false;
+								mText++;
+								udword Length = 0;
+								while(*mText && *mText!='"')
+								{
+									char c = *mText++;
+									if(c=='\\')
+									{
+										c = *mText++;
+										switch(c)
+										{
+											case 'n':	c = '\n';	break;
+											case 'r':	c = '\r';	break;
+											case 't':	c = '\t';	break;
+											case 'b':	c = '\b';	break;
+											case 'f':	c = '\f';	break;
+											case 'u':
+											{
+												// Only ASCII is needed here
+												udword Code = 0;
+												for(udword i=0;i<4 && *mText;i++)
+												{
+													const char h = *mText++;
+													Code = Code*16 + udword(h>='a' ? h-'a'+10 : h>='A' ? h-'A'+10 : h-'0');
+												}
+												c = Code<128 ? char(Code) : '?';
+											}
+											break;
+											case 0:		return false;
+										};
+									}
+									if(Length+1<size)
+										dst[Length++] = c;
+								}
+								if(*mText!='"')
+									return false;
+								mText++;
+								dst[Length] = 0;
+								return true;
+							}
+
+				bool		ParseObject()
+							{
+								mText++;	// Skip '{'
+								OnBeginObject(mPath);
+								SkipWhitespace();
+								if(*mText=='}')
+								{
+									mText++;
+									OnEndObject(mPath);
+									return true;
+								}
+								while(1)
+								{
+									char Key[128];
+									SkipWhitespace();
+									if(!ParseString(Key, sizeof(Key)))
+										return false;
+									SkipWhitespace();
+									if(*mText++!=':')
+										return false;
+
+									const udword Length = PushPath(Key, false);
+									const bool Status = ParseValue();
+									mPath[Length] = 0;
+									if(!Status)
+										return false;
+
+									SkipWhitespace();
+									const char c = *mText++;
+									if(c=='}')
+										break;
+									if(c!=',')
+										return false;
+								}
+								OnEndObject(mPath);
+								return true;
+							}
+
+				bool		ParseArray()
+							{
+								mText++;	// Skip '['
+								SkipWhitespace();
+								if(*mText==']')
+								{
+									mText++;
+									return true;
+								}
+								const udword Length = PushPath("", true);
+								while(1)
+								{
+									if(!ParseValue())
+										return false;
+									SkipWhitespace();
+									const char c = *mText++;
+									if(c==']')
+										break;
+									if(c!=',')
+										return false;
+								}
+								mPath[Length] = 0;
+								return true;
+							}
+
+				bool		ParseValue()
+							{
+								SkipWhitespace();
+								if(*mText=='{')
+									return ParseObject();
+								if(*mText=='[')
+									return ParseArray();
+								if(*mText=='"')
+								{
+									if(!ParseString(mValue, sizeof(mValue)))
+										return false;
+									OnValue(mPath, mValue);
+									return true;
+								}
+
+								// Numbers, true, false, null
+								udword Length = 0;
+								while(*mText && *mText!=',' && *mText!='}' && *mText!=']' && *mText!=' ' && *mText!='\t' && *mText!='\r' && *mText!='\n')
+								{
+									if(Length+1<sizeof(mValue))
+										mValue[Length++] = *mText;
+									mText++;
+								}
+								if(!Length)
+									return false;
+								mValue[Length] = 0;
+								OnValue(mPath, mValue);
+								return true;
+							}
+	};
+
+	// Relies on the order used by ResultsWriter: "test", "options" & "run_config" are written before "engines".
+	class BaselineReader : public JSONReader
+	{
+		public:
+							BaselineReader(const char* text) : JSONReader(text), mNbEntries(0)
+							{
+								mTestName[0] = mSubName[0] = mUnits[0] = mAllocator[0] = 0;
+								ResetEngine();
+							}
+
+				udword		mNbEntries;
+
+		protected:
+		virtual	void		OnBeginObject(const char* path)
+							{
+								if(!*path)
+									mTestName[0] = mSubName[0] = mUnits[0] = mAllocator[0] = 0;
+								else if(strcmp(path, "engines[]")==0)
+									ResetEngine();
+							}
+
+		virtual	void		OnEndObject(const char* path)
+							{
+								if(strcmp(path, "engines[]")==0 && mEngine.mEngine[0] && mHasStats)
+								{
+									GetTestKey(mEngine.mTest, mTestName, mSubName);
+									CopyName(mEngine.mUnits, mUnits, sizeof(mEngine.mUnits));
+									CopyName(mEngine.mAllocator, mAllocator, sizeof(mEngine.mAllocator));
+									AddEntry();
+								}
+							}
+
+		virtual	void		OnValue(const char* path, const char* value)
+							{
+								if(strcmp(path, "test.name")==0)
+									CopyName(mTestName, value, MAX_NAME_LENGTH);
+								else if(strcmp(path, "test.subname")==0)
+									CopyName(mSubName, strcmp(value, "null")==0 ? "" : value, MAX_NAME_LENGTH);
+								else if(strcmp(path, "options.units")==0)
+									CopyName(mUnits, value, sizeof(mUnits));
+								else if(strcmp(path, "run_config.allocator")==0)
+									CopyName(mAllocator, value, sizeof(mAllocator));
+								else if(strcmp(path, "engines[].name")==0)
+									CopyName(mEngine.mEngine, value, MAX_NAME_LENGTH);
+								else if(strcmp(path, "engines[].stats.total.p50")==0)
+								{
+									mEngine.mMedian = udword(atol(value));
+									mHasStats = true;
+								}
+								else if(strcmp(path, "engines[].stats.total.p99")==0)
+									mEngine.mP99 = udword(atol(value));
+								else if(strcmp(path, "engines[].stats.peak_memory")==0)
+									mEngine.mPeakMemory = uqword(_atoi64(value));
+								// Written after the last repetition's stats, the merged repetitions replace them
+								else if(strcmp(path, "engines[].stats.repetitions.total.p50")==0)
+									mEngine.mMedian = udword(atol(value));
+								else if(strcmp(path, "engines[].stats.repetitions.total.p99")==0)
+									mEngine.mP99 = udword(atol(value));
+								else if(strcmp(path, "engines[].stats.repetitions.peak_memory")==0)
+									mEngine.mPeakMemory = uqword(_atoi64(value));
+							}
+
+		private:
+				char			mTestName[MAX_NAME_LENGTH];
+				char			mSubName[MAX_NAME_LENGTH];
+				char			mUnits[16];
+				char			mAllocator[16];
+				BaselineEntry	mEngine;
+				bool			mHasStats;
+
+				void		ResetEngine()
+							{
+								ZeroMemory(&mEngine, sizeof(BaselineEntry));
+								mHasStats = false;
+							}
+
+				void		AddEntry()
+							{
+								// Last occurrence wins
+								const udword NbEntries = gBaseline.GetNbEntries();
+								for(udword i=0;i<NbEntries;i++)
+								{
+									BaselineEntry* Entry = (BaselineEntry*)gBaseline.GetEntry(i);
+									if(strcmp(Entry->mTest, mEngine.mTest)==0 && strcmp(Entry->mEngine, mEngine.mEngine)==0)
+									{
+										*Entry = mEngine;
+										return;
+									}
+								}
+								BaselineEntry* Entry = ICE_NEW(BaselineEntry);
+								*Entry = mEngine;
+								gBaseline.Add(udword(Entry));
+								mNbEntries++;
+							}
+	};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void ReleaseChecks()
+{
+	const udword NbChecks = gChecks.GetNbEntries();
+	for(udword i=0;i<NbChecks;i++)
+	{
+		RegressionCheck* Check = (RegressionCheck*)gChecks.GetEntry(i);
+		DELETESINGLE(Check);
+	}
+	gChecks.Empty();
+	gNbUnmatched = 0;
+}
+
+void ReleaseBaseline()
+{
+	const udword NbEntries = gBaseline.GetNbEntries();
+	for(udword i=0;i<NbEntries;i++)
+	{
+		BaselineEntry* Entry = (BaselineEntry*)gBaseline.GetEntry(i);
+		DELETESINGLE(Entry);
+	}
+	gBaseline.Empty();
+	ReleaseChecks();
+	gBaselineFilename[0] = 0;
+}
+
+bool IsBaselineLoaded()
+{
+	return gBaseline.GetNbEntries()!=0;
+}
+
+bool LoadBaseline(const char* filename)
+{
+	ReleaseBaseline();
+	if(!filename)
+		return false;
+
+	FILE* fp = fopen(filename, "rb");
+	if(!fp)
+	{
+		printf("WARNING: cannot open baseline file %s.\n", filename);
+		return false;
+	}
+	fseek(fp, 0, SEEK_END);
+	const long Size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	char* Text = (char*)ICE_ALLOC(Size+1);
+	const size_t NbRead = fread(Text, 1, Size, fp);
+	Text[NbRead] = 0;
+	fclose(fp);
+
+	BaselineReader Reader(Text);
+	const bool Status = Reader.ParseAll();
+	ICE_FREE(Text);
+
+	if(!Status)
+		printf("WARNING: baseline file %s is invalid or truncated, only %d entries loaded.\n", filename, gBaseline.GetNbEntries());
+	else
+		printf("Baseline loaded: %d entries from %s.\n", gBaseline.GetNbEntries(), filename);
+
+	CopyName(gBaselineFilename, filename, sizeof(gBaselineFilename));
+	return IsBaselineLoaded();
+}
+
+void SetRegressionThresholds(float max_median, float max_p99, float max_memory)
+{
+	gMaxMedianRegression = max_median;
+	gMaxP99Regression = max_p99;
+	gMaxMemoryRegression = max_memory;
+}
+
+static const BaselineEntry* FindBaselineEntry(const char* test, const char* engine)
+{
+	const udword NbEntries = gBaseline.GetNbEntries();
+	for(udword i=0;i<NbEntries;i++)
+	{
+		const BaselineEntry* Entry = (const BaselineEntry*)gBaseline.GetEntry(i);
+		if(strcmp(Entry->mTest, test)==0 && strcmp(Entry->mEngine, engine)==0)
+			return Entry;
+	}
+	return null;
+}
+
+static void AddCheck(const char* test, const char* engine, const char* metric, uqword baseline, uqword current, float threshold)
+{
+	// Nothing to compare against (e.g. memory isn't recorded for SQ tests)
+	if(!baseline || threshold<0.0f)
+		return;
+
+	RegressionCheck* Check = ICE_NEW(RegressionCheck);
+	CopyName(Check->mTest, test, MAX_NAME_LENGTH);
+	CopyName(Check->mEngine, engine, MAX_NAME_LENGTH);
+	Check->mMetric		= metric;
+	Check->mBaseline	= baseline;
+	Check->mCurrent		= current;
+	Check->mDelta		= (float(current) - float(baseline))*100.0f/float(baseline);
+	Check->mFailed		= Check->mDelta>threshold;
+	gChecks.Add(udword(Check));
+}
+
+void RecordTestRepetition()
+{
+	if(!gRunningTest)
+		return;
+
+	for(udword i=0;i<gNbEngines;i++)
+	{
+		const PintTiming& Timing = gEngines[i].mTiming;
+		gRepetitionHistograms[i].Add(Timing.mHistogram);
+		if(Timing.mPeakMemory>gRepetitionPeakMemory[i])
+			gRepetitionPeakMemory[i] = Timing.mPeakMemory;
+	}
+	gNbRepetitions++;
+}
+
+void ResetTestRepetitions()
+{
+	for(udword i=0;i<MAX_NB_ENGINES;i++)
+	{
+		gRepetitionHistograms[i].Reset();
+		gRepetitionPeakMemory[i] = 0;
+	}
+	gNbRepetitions = 0;
+}
+
+udword GetNbTestRepetitions()
+{
+	return gNbRepetitions;
+}
+
+const PintHistogram& GetRepetitionHistogram(udword engine_index)
+{
+	ASSERT(engine_index<MAX_NB_ENGINES);
+	return gRepetitionHistograms[engine_index];
+}
+
+uqword GetRepetitionPeakMemory(udword engine_index)
+{
+	ASSERT(engine_index<MAX_NB_ENGINES);
+	return gRepetitionPeakMemory[engine_index];
+}
+
+void CheckAgainstBaseline()
+{
+	if(!gRunningTest || !IsBaselineLoaded() || !gNbRepetitions)
+		return;
+
+	char Test[MAX_NAME_LENGTH];
+	GetTestKey(Test, gRunningTest->GetName(), gRunningTest->GetSubName());
+
+	const char* Units = GetProfilingTimer(gProfilingUnits).mUnits;
+	const char* Allocator = GetAllocatorTypeName(gAllocatorType);
+
+	for(udword i=0;i<gNbEngines;i++)
+	{
+		ASSERT(gEngines[i].mEngine);
+		if(!gEngines[i].mEnabled || !gEngines[i].mSupportsCurrentTest || !(gEngines[i].mEngine->GetFlags() & PINT_IS_ACTIVE))
+			continue;
+
+		const char* EngineName = gEngines[i].mEngine->GetName();
+		const BaselineEntry* Entry = FindBaselineEntry(Test, EngineName);
+		if(!Entry)
+		{
+			gNbUnmatched++;
+			continue;
+		}
+
+		// Different allocators change both times & memory, this is a comparison between setups, not a regression
+		const char* BaselineAllocator = Entry->mAllocator[0] ? Entry->mAllocator : GetAllocatorTypeName(PINT_ALLOCATOR_SYSTEM);
+		if(strcmp(BaselineAllocator, Allocator)!=0)
+		{
+			printf("WARNING: %s / %s: baseline recorded with the %s allocator, current run uses %s. Not compared.\n", Test, EngineName, BaselineAllocator, Allocator);
+			gNbUnmatched++;
+			continue;
+		}
+
+		if(strcmp(Entry->mUnits, Units)!=0)
+		{
+			printf("WARNING: %s / %s: baseline recorded in %s, current run in %s. Times not compared.\n", Test, EngineName, Entry->mUnits, Units);
+		}
+		else
+		{
+			const PintHistogram& H = gRepetitionHistograms[i];
+			AddCheck(Test, EngineName, "median", Entry->mMedian, H.GetPercentile(50.0f), gMaxMedianRegression);
+			AddCheck(Test, EngineName, "p99", Entry->mP99, H.GetPercentile(99.0f), gMaxP99Regression);
+		}
+		AddCheck(Test, EngineName, "peak memory", Entry->mPeakMemory, gRepetitionPeakMemory[i], gMaxMemoryRegression);
+	}
+}
+
+// Failed checks first, then by decreasing delta
+static inline_ bool IsWorse(const RegressionCheck* a, const RegressionCheck* b)
+{
+	if(a->mFailed!=b->mFailed)
+		return a->mFailed;
+	return a->mDelta>b->mDelta;
+}
+
+udword ReportRegressions()
+{
+	const udword NbChecks = gChecks.GetNbEntries();
+	RegressionCheck** Checks = (RegressionCheck**)gChecks.GetEntries();
+
+	for(udword i=1;i<NbChecks;i++)
+	{
+		RegressionCheck* Check = Checks[i];
+		udword j = i;
+		while(j && IsWorse(Check, Checks[j-1]))
+		{
+			Checks[j] = Checks[j-1];
+			j--;
+		}
+		Checks[j] = Check;
+	}
+
+	udword NbFailed = 0;
+	udword NbImproved = 0;
+	for(udword i=0;i<NbChecks;i++)
+	{
+		if(Checks[i]->mFailed)
+			NbFailed++;
+		if(Checks[i]->mDelta<0.0f)
+			NbImproved++;
+	}
+
+	printf("\nRegression report (baseline: %s)\n", gBaselineFilename);
+	printf("Thresholds: median %+.1f%%, p99 %+.1f%%, peak memory %+.1f%%\n\n", gMaxMedianRegression, gMaxP99Regression, gMaxMemoryRegression);
+
+	udword NbReported = 0;
+	for(udword i=0;i<NbChecks;i++)
+	{
+		const RegressionCheck* Check = Checks[i];
+		if(!Check->mFailed && (Check->mDelta<=0.0f || NbReported>=NbFailed+MAX_NB_REPORTED_NON_FAILED))
+			break;
+
+		printf("  %+8.2f%%  %s / %s / %s: %llu -> %llu%s\n", Check->mDelta, Check->mTest, Check->mEngine, Check->mMetric, Check->mBaseline, Check->mCurrent, Check->mFailed ? "  ** REGRESSION **" : "");
+		NbReported++;
+	}
+
+	printf("\n%d checks, %d regressions above thresholds, %d improvements, %d engine/test pairs not found in baseline.\n", NbChecks, NbFailed, NbImproved, gNbUnmatched);
+	return NbFailed;
+}
@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef REGRESSION_GATE_H
+#define REGRESSION_GATE_H
+
+	class PintHistogram;
+
+	// Compares the current run against a baseline results file (JSON lines, see ResultsWriter.h). Tests are matched
+	// by name & subname, engines by name. If a test appears several times in the baseline, the last one is used.
+	//
+	// Thresholds are maximum allowed slowdowns/increases in percents, for the median & p99 frame times and for
+	// the peak memory. A negative threshold disables the corresponding check.
+
+	#define DEFAULT_MAX_MEDIAN_REGRESSION	5.0f
+	#define DEFAULT_MAX_P99_REGRESSION		10.0f
+	#define DEFAULT_MAX_MEMORY_REGRESSION	10.0f
+
+	bool	LoadBaseline(const char* filename);
+	void	ReleaseBaseline();
+	bool	IsBaselineLoaded();
+
+	void	SetRegressionThresholds(float max_median, float max_p99, float max_memory);
+
+	// Accumulates the running test's frame times & peak memory, with or without a baseline. Call it after each repetition
+	// of a test, the last one included, before the engines are closed and before the results are exported: the JSON
+	// results store the merged repetitions, so that a baseline & the checks against it use the same statistics.
+	void				RecordTestRepetition();
+	void				ResetTestRepetitions();
+	udword				GetNbTestRepetitions();
+	// Frame times of all recorded repetitions of the running test for an engine, and their maximum peak memory
+	const PintHistogram&	GetRepetitionHistogram(udword engine_index);
+	uqword				GetRepetitionPeakMemory(udword engine_index);
+
+	// Compares the running test's recorded repetitions with the baseline, after the last one. Must be called before the
+	// engines are closed, and before ResetTestRepetitions().
+	void	CheckAgainstBaseline();
+
+	// Prints a ranked report of the worst regressions. Returns the number of checks that exceeded their threshold.
+	udword	ReportRegressions();
+
+#endif
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+// Replaces Render.cpp in the headless build. Same interface, but nothing is drawn and no GL resources are created.
+
+#include "stdafx.h"
+#include "Render.h"
+#include "Pint.h"
+
+void SetupGLMatrix(const PR& pose)																			{}
+void DrawLine(const Point& p0, const Point& p1, const Point& color)											{}
+void DrawCircle(udword nb_segments, const Matrix4x4& matrix, const Point& color, float radius, bool semi_circle)	{}
+void DrawTriangle(const Point& p0, const Point& p1, const Point& p2, const Point& color)						{}
+void DrawSphere(float radius, const PR& pose)																{}
+void DrawSphereWireframe(float radius, const PR& pose, const Point& color)									{}
+void DrawBox(const Point& extents, const PR& pose)															{}
+void DrawCapsule(float r, float h, const PR& pose)															{}
+void DrawCapsuleWireframe(float r, float h, const PR& pose, const Point& color)								{}
+void DrawCylinder(float r, float h, const PR& pose)															{}
+
+	// Some plugins use the renderer pointer as a key to share cooked data (e.g. convex meshes), so each call must
+	// still return a unique object.
+	class PintNullShapeRenderer : public PintShapeRenderer
+	{
+		public:
+							PintNullShapeRenderer()		{}
+		virtual				~PintNullShapeRenderer()	{}
+
+		virtual	void		Render(const PR& pose)						{}
+		virtual	void		SetColor(const Point& color, bool isStatic)	{}
+		virtual	void		SetShadows(bool flag)						{}
+	};
+
+static Container* gShapeRenderers = null;
+
+static PintShapeRenderer* RegisterShapeRenderer(PintShapeRenderer* renderer)
+{
+	ASSERT(renderer);
+
+	if(!gShapeRenderers)
+		gShapeRenderers = ICE_NEW(Container);
+	ASSERT(gShapeRenderers);
+
+	gShapeRenderers->Add(udword(renderer));
+	return renderer;
+}
+
+PintShapeRenderer* CreateSphereRenderer(float radius)
+{
+	return RegisterShapeRenderer(ICE_NEW(PintNullShapeRenderer));
+}
+
+PintShapeRenderer* CreateCapsuleRenderer(float radius, float height)
+{
+	return RegisterShapeRenderer(ICE_NEW(PintNullShapeRenderer));
+}
+
+PintShapeRenderer* CreateCylinderRenderer(float radius, float height)
+{
+	return RegisterShapeRenderer(ICE_NEW(PintNullShapeRenderer));
+}
+
+PintShapeRenderer* CreateBoxRenderer(const Point& extents)
+{
+	return RegisterShapeRenderer(ICE_NEW(PintNullShapeRenderer));
+}
+
+PintShapeRenderer* CreateConvexRenderer(udword nb_verts, const Point* verts)
+{
+	return RegisterShapeRenderer(ICE_NEW(PintNullShapeRenderer));
+}
+
+PintShapeRenderer* CreateMeshRenderer(const SurfaceInterface& surface)
+{
+	return RegisterShapeRenderer(ICE_NEW(PintNullShapeRenderer));
+}
+
+PintShapeRenderer* CreateCustomRenderer(PintShapeRenderer* renderer)
+{
+	return RegisterShapeRenderer(ICE_NEW(PintNullShapeRenderer));
+}
+
+void ReleaseAllShapeRenderers()
+{
+	if(gShapeRenderers)
+	{
+		const udword Size = gShapeRenderers->GetNbEntries();
+		for(udword i=0;i<Size;i++)
+		{
+			PintShapeRenderer* renderer = (PintShapeRenderer*)gShapeRenderers->GetEntry(i);
+			DELETESINGLE(renderer);
+		}
+		DELETESINGLE(gShapeRenderers);
+	}
+}
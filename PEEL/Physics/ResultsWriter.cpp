@@ -0,0 +1,547 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "ResultsWriter.h"
+#include "Simulation.h"
+#include "TestScenes.h"
+#include "RunConfig.h"
+#include "SQThreads.h"
+#include "RegressionGate.h"
+#include <time.h>
+
+#if defined(_M_IX86) || defined(_M_X64)
+	#include <intrin.h>
+	#define PEEL_HAS_CPUID
+#elif defined(__i386__) || defined(__x86_64__)
+	#include <cpuid.h>
+	#define PEEL_HAS_CPUID
+#endif
+
+#ifndef _WIN32
+	#include <unistd.h>
+#endif
+
+#ifndef PEEL_GIT_HASH
+	#define PEEL_GIT_HASH	"unknown"
+#endif
+
+#define RESULTS_FORMAT_VERSION	1
+
+// Not a String, since this is initialized before the ICE allocator is setup
+static char		gResultsFilename[1024] = DEFAULT_RESULTS_FILENAME;
+// Off until a filename is set (headless runs & scripts), so that exports from the GUI don't write results files
+static bool		gResultsEnabled = false;
+
+void SetResultsFilename(const char* filename)
+{
+	gResultsEnabled = filename!=null;
+	if(filename)
+	{
+		strncpy(gResultsFilename, filename, sizeof(gResultsFilename)-1);
+		gResultsFilename[sizeof(gResultsFilename)-1] = 0;
+	}
+}
+
+const char* GetResultsFilename()
+{
+	return gResultsEnabled ? gResultsFilename : null;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	// Minimal streaming JSON writer. Everything is written on a single line.
+	class JSONWriter
+	{
+		public:
+							JSONWriter(FILE* fp) : mFile(fp), mDepth(0)	{ mFirst[0] = true;	}
+
+				void		BeginObject(const char* name=null)	{ Begin(name, '{');	}
+				void		EndObject()							{ End('}');			}
+				void		BeginArray(const char* name=null)	{ Begin(name, '[');	}
+				void		EndArray()							{ End(']');			}
+
+				void		WriteString(const char* name, const char* value)
+							{
+								WriteName(name);
+								if(value)
+									WriteEscaped(value);
+								else
+									fprintf(mFile, "null");
+							}
+
+				void		WriteInt(const char* name, udword value)
+							{
+								WriteName(name);
+								fprintf(mFile, "%u", value);
+							}
+
+				void		WriteUQword(const char* name, uqword value)
+							{
+								WriteName(name);
+								fprintf(mFile, "%llu", value);
+							}
+
+				void		WriteFloat(const char* name, double value)
+							{
+								WriteName(name);
+								// JSON has no NaN or infinity. Both fail this test, since inf-inf is NaN.
+								if(value-value==0.0)
+									fprintf(mFile, "%.9g", value);
+								else
+									fprintf(mFile, "null");
+							}
+
+				void		WriteBool(const char* name, bool value)
+							{
+								WriteName(name);
+								fprintf(mFile, value ? "true" : "false");
+							}
+
+				void		WritePoint(const char* name, const Point& p)
+							{
+								BeginArray(name);
+								WriteFloat(null, p.x);
+								WriteFloat(null, p.y);
+								WriteFloat(null, p.z);
+								EndArray();
+							}
+
+		private:
+				FILE*		mFile;
+				udword		mDepth;
+				bool		mFirst[16];
+
+				void		WriteName(const char* name)
+							{
+								if(!mFirst[mDepth])
+									fputc(',', mFile);
+								mFirst[mDepth] = false;
+								if(name)
+								{
+									WriteEscaped(name);
+									fputc(':', mFile);
+								}
+							}
+
+				void		Begin(const char* name, char c)
+							{
+								WriteName(name);
+								fputc(c, mFile);
+								ASSERT(mDepth<15);
+								mFirst[++mDepth] = true;
+							}
+
+				void		End(char c)
+							{
+								ASSERT(mDepth);
+								mDepth--;
+								fputc(c, mFile);
+							}
+
+				void		WriteEscaped(const char* text)
+							{
+								fputc('"', mFile);
+								while(*text)
+								{
+									const unsigned char c = *text++;
+									if(c=='"' || c=='\\')
+									{
+										fputc('\\', mFile);
+										fputc(c, mFile);
+									}
+									else if(c<0x20)
+										fprintf(mFile, "\\u%04x", c);
+									else
+										fputc(c, mFile);
+								}
+								fputc('"', mFile);
+							}
+	};
+
+	class JSONSettingsCallback : public PintSettingsCallback
+	{
+		public:
+							JSONSettingsCallback(JSONWriter& writer) : mWriter(writer)	{}
+
+		virtual	void		ReportSetting(const char* name, const char* value)	{ mWriter.WriteString(name, value);	}
+
+				JSONWriter&	mWriter;
+	};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void GetCPUName(char* buffer, udword size)
+{
+	ASSERT(buffer && size>=49);
+	strcpy(buffer, "Unknown");
+#ifdef PEEL_HAS_CPUID
+	unsigned int Regs[12];
+	#ifdef _MSC_VER
+	int Info[4];
+	__cpuid(Info, 0x80000000);
+	if(unsigned(Info[0])<0x80000004)
+		return;
+	for(udword i=0;i<3;i++)
+	{
+		__cpuid(Info, 0x80000002+i);
+		CopyMemory(Regs+i*4, Info, sizeof(Info));
+	}
+	#else
+	if(__get_cpuid_max(0x80000000, null)<0x80000004)
+		return;
+	for(udword i=0;i<3;i++)
+		__get_cpuid(0x80000002+i, Regs+i*4, Regs+i*4+1, Regs+i*4+2, Regs+i*4+3);
+	#endif
+	CopyMemory(buffer, Regs, 48);
+	buffer[48] = 0;
+
+	// Brand strings are often padded with leading spaces
+	const char* Start = buffer;
+	while(*Start==' ')
+		Start++;
+	if(Start!=buffer)
+		memmove(buffer, Start, strlen(Start)+1);
+#endif
+}
+
+static udword GetNbHardwareThreads()
+{
+#ifdef _WIN32
+	SYSTEM_INFO Info;
+	GetSystemInfo(&Info);
+	return Info.dwNumberOfProcessors;
+#else
+	const long Nb = sysconf(_SC_NPROCESSORS_ONLN);
+	return Nb>0 ? udword(Nb) : 0;
+#endif
+}
+
+static const char* GetGitHash()
+{
+	const char* Hash = getenv("PEEL_GIT_HASH");
+	return Hash && *Hash ? Hash : PEEL_GIT_HASH;
+}
+
+static void WriteHistogram(JSONWriter& writer, const char* name, const PintHistogram& h)
+{
+	writer.BeginObject(name);
+	writer.WriteInt("frames", h.GetNbValues());
+	writer.WriteFloat("avg", h.GetMean());
+	writer.WriteFloat("stddev", h.GetStdDev());
+	writer.WriteInt("min", h.GetMin());
+	writer.WriteInt("p50", h.GetPercentile(50.0f));
+	writer.WriteInt("p90", h.GetPercentile(90.0f));
+	writer.WriteInt("p99", h.GetPercentile(99.0f));
+	writer.WriteInt("p99.9", h.GetPercentile(99.9f));
+	writer.WriteInt("max", h.GetMax());
+	writer.EndObject();
+}
+
+static void WriteAllocations(JSONWriter& writer, const PintTiming& timing, udword nb_frames)
+{
+	const PintAllocStats& Totals = timing.mTotalAllocs;
+	writer.BeginObject("allocations");
+	writer.WriteUQword("nb_allocs", Totals.mNbAllocs);
+	writer.WriteUQword("nb_frees", Totals.mNbFrees);
+	writer.WriteUQword("allocated_bytes", Totals.mAllocatedBytes);
+	writer.WriteUQword("freed_bytes", Totals.mFreedBytes);
+	writer.WriteUQword("peak_bytes", Totals.mPeakBytes);
+	WriteHistogram(writer, "allocs_per_frame", timing.mAllocsHistogram);
+
+	// Upper bounds in bytes, 0 for the last class (all larger allocations)
+	writer.BeginArray("size_class_limits");
+	for(udword j=0;j<PINT_NB_ALLOC_SIZE_CLASSES;j++)
+		writer.WriteInt(null, GetPintAllocSizeClassLimit(j));
+	writer.EndArray();
+	writer.BeginArray("size_classes");
+	for(udword j=0;j<PINT_NB_ALLOC_SIZE_CLASSES;j++)
+		writer.WriteUQword(null, Totals.mSizeClasses[j]);
+	writer.EndArray();
+
+	if(timing.mRecordedAllocs)
+	{
+		writer.BeginObject("frames");
+		writer.BeginArray("nb_allocs");
+		for(udword i=0;i<nb_frames;i++)
+			writer.WriteInt(null, timing.mRecordedAllocs[i].mNbAllocs);
+		writer.EndArray();
+		writer.BeginArray("nb_frees");
+		for(udword i=0;i<nb_frames;i++)
+			writer.WriteInt(null, timing.mRecordedAllocs[i].mNbFrees);
+		writer.EndArray();
+		writer.BeginArray("allocated_bytes");
+		for(udword i=0;i<nb_frames;i++)
+			writer.WriteUQword(null, timing.mRecordedAllocs[i].mAllocatedBytes);
+		writer.EndArray();
+		writer.BeginArray("freed_bytes");
+		for(udword i=0;i<nb_frames;i++)
+			writer.WriteUQword(null, timing.mRecordedAllocs[i].mFreedBytes);
+		writer.EndArray();
+		writer.EndObject();
+	}
+	writer.EndObject();
+}
+
+static void WriteEngine(JSONWriter& writer, udword index, udword nb_frames)
+{
+	const EngineData& Data = gEngines[index];
+	const PintTiming& Timing = Data.mTiming;
+
+	writer.BeginObject();
+	writer.WriteString("name", Data.mEngine->GetName());
+	writer.WriteBool("supported", Data.mSupportsCurrentTest);
+
+	writer.BeginObject("settings");
+	if(Data.mPlugIn)
+	{
+		JSONSettingsCallback Callback(writer);
+		Data.mPlugIn->GetSettings(Callback);
+	}
+	writer.EndObject();
+
+	if(Data.mSupportsCurrentTest)
+	{
+		writer.BeginObject("stats");
+		WriteHistogram(writer, "total", Timing.mHistogram);
+		for(udword j=0;j<PINT_TIMING_NB_PHASES;j++)
+		{
+			if(Timing.mPhaseHistograms[j].GetNbValues())
+				WriteHistogram(writer, GetTimingPhaseName(PintTimingPhase(j)), Timing.mPhaseHistograms[j]);
+		}
+		writer.WriteUQword("peak_memory", Timing.mPeakMemory);
+		// The stats above are the last repetition's, the regression gate compares all of them
+		const udword NbRepetitions = GetNbTestRepetitions();
+		if(NbRepetitions>1)
+		{
+			writer.BeginObject("repetitions");
+			writer.WriteInt("count", NbRepetitions);
+			WriteHistogram(writer, "total", GetRepetitionHistogram(index));
+			writer.WriteUQword("peak_memory", GetRepetitionPeakMemory(index));
+			writer.EndObject();
+		}
+		writer.EndObject();
+
+		writer.BeginObject("frames");
+		writer.BeginArray("time");
+		for(udword i=0;i<nb_frames;i++)
+			writer.WriteInt(null, Timing.mRecorded[i].mTime);
+		writer.EndArray();
+		writer.BeginArray("memory");
+		for(udword i=0;i<nb_frames;i++)
+			writer.WriteUQword(null, Timing.mRecorded[i].mUsedMemory);
+		writer.EndArray();
+		writer.BeginArray("test_result");
+		for(udword i=0;i<nb_frames;i++)
+			writer.WriteInt(null, Timing.mRecorded[i].mTestResult);
+		writer.EndArray();
+		writer.EndObject();
+
+		if(Timing.HasAllocations())
+			WriteAllocations(writer, Timing, nb_frames);
+
+		if(Timing.HasCounters())
+		{
+			writer.BeginObject("counters");
+			writer.WriteString("scope", GetHardwareCountersScope());
+
+			HardwareCounterValues Avg;
+			Timing.GetAverageCounters(Avg);
+			writer.BeginObject("avg");
+			if(IsHardwareCounterAvailable(HW_COUNTER_INSTRUCTIONS))
+				writer.WriteFloat("IPC", Avg.GetIPC());
+			for(udword j=0;j<HW_COUNTER_COUNT;j++)
+			{
+				if(IsHardwareCounterAvailable(HardwareCounter(j)))
+					writer.WriteUQword(GetHardwareCounterName(HardwareCounter(j)), Avg.mValues[j]);
+			}
+			writer.EndObject();
+
+			if(Timing.mRecordedCounters)
+			{
+				writer.BeginObject("frames");
+				for(udword j=0;j<HW_COUNTER_COUNT;j++)
+				{
+					if(!IsHardwareCounterAvailable(HardwareCounter(j)))
+						continue;
+					writer.BeginArray(GetHardwareCounterName(HardwareCounter(j)));
+					for(udword i=0;i<nb_frames;i++)
+						writer.WriteUQword(null, Timing.mRecordedCounters[i].mValues[j]);
+					writer.EndArray();
+				}
+				writer.EndObject();
+			}
+			writer.EndObject();
+		}
+	}
+	writer.EndObject();
+}
+
+// Common part of all records: format, build & host info
+static void WriteRecordHeader(JSONWriter& writer)
+{
+	writer.WriteString("format", "peel-results");
+	writer.WriteInt("version", RESULTS_FORMAT_VERSION);
+
+	{
+		char Timestamp[32];
+		const time_t Now = time(null);
+		strftime(Timestamp, sizeof(Timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&Now));
+		writer.WriteString("timestamp", Timestamp);
+	}
+
+	writer.BeginObject("build");
+	writer.WriteString("git", GetGitHash());
+	writer.WriteString("date", __DATE__ " " __TIME__);
+#ifdef _DEBUG
+	writer.WriteString("config", "Debug");
+#else
+	writer.WriteString("config", "Release");
+#endif
+	writer.WriteInt("pointer_size", sizeof(void*));
+	writer.EndObject();
+
+	writer.BeginObject("host");
+	{
+		char CPUName[64];
+		GetCPUName(CPUName, sizeof(CPUName));
+		writer.WriteString("cpu", CPUName);
+	}
+	writer.WriteInt("nb_threads", GetNbHardwareThreads());
+#ifdef _WIN32
+	writer.WriteString("os", "Windows");
+#else
+	writer.WriteString("os", "Linux");
+#endif
+	writer.EndObject();
+}
+
+bool TestJSONExport()
+{
+	if(!gRunningTest || !gResultsEnabled)
+		return false;
+
+	FILE* fp = fopen(gResultsFilename, "a");
+	if(!fp)
+		return false;
+
+	JSONWriter Writer(fp);
+	Writer.BeginObject();
+	WriteRecordHeader(Writer);
+
+	Writer.BeginObject("test");
+	Writer.WriteString("name", gRunningTest->GetName());
+	Writer.WriteString("subname", gRunningTest->GetSubName());
+	Writer.WriteBool("profile_update", gRunningTest->ProfileUpdate());
+	Writer.EndObject();
+
+	const PINT_WORLD_CREATE& Desc = GetWorldDesc();
+	Writer.BeginObject("world");
+	Writer.WritePoint("gravity", Desc.mGravity);
+	Writer.WriteFloat("timestep", Desc.mTimestep);
+	Writer.WriteInt("nb_simulate_calls_per_frame", Desc.mNbSimulateCallsPerFrame);
+	if(Desc.mGlobalBounds.GetMin(0)<=Desc.mGlobalBounds.GetMax(0))
+	{
+		Writer.BeginObject("global_bounds");
+		Writer.WritePoint("min", Desc.mGlobalBounds.GetMin());
+		Writer.WritePoint("max", Desc.mGlobalBounds.GetMax());
+		Writer.EndObject();
+	}
+	Writer.EndObject();
+
+	const ProfilingTimer& Timer = GetProfilingTimer(gProfilingUnits);
+	Writer.BeginObject("options");
+	Writer.WriteString("units", Timer.mUnits);
+	Writer.WriteString("timer", Timer.mName);
+	Writer.WriteUQword("timer_frequency", Timer.mFrequency);
+	Writer.WriteFloat("timer_overhead_ns", Timer.ToNanoseconds(Timer.mOverhead));
+	Writer.WriteString("sq_profiling_mode", GetSQProfilingModeName(gSQProfilingMode));
+	Writer.WriteBool("randomize_order", gRandomizeOrder);
+	Writer.WriteBool("trash_cache", gTrashCache);
+	Writer.WriteInt("warmup_frames", gWarmupFrames);
+	Writer.WriteBool("hardware_counters", gHardwareCounters && !gParallelEngines);
+	Writer.WriteBool("parallel_engines", gParallelEngines);
+	Writer.WriteInt("sq_threads", gNbSQThreads);
+	Writer.WriteBool("async_updates", gAsyncUpdates && !gParallelEngines);
+	Writer.WriteInt("async_update_work_us", gAsyncUpdateWork);
+	Writer.EndObject();
+
+	const RunConfigStatus& RunConfig = GetRunConfigStatus();
+	char Cores[256];
+	Writer.BeginObject("run_config");
+	GetCoreSetString(gSimulationCores, Cores, sizeof(Cores));
+	Writer.WriteString("simulation_cores", gSimulationCores ? Cores : null);
+	GetCoreSetString(gWorkerCores, Cores, sizeof(Cores));
+	Writer.WriteString("worker_cores", gWorkerCores ? Cores : null);
+	Writer.WriteString("priority", GetRunPriorityName(RunConfig.mPriority));
+	Writer.WriteString("allocator", GetAllocatorTypeName(gAllocatorType));
+	Writer.WriteString("governor", RunConfig.mGovernor);
+	Writer.WriteBool("governor_locked", RunConfig.mGovernorLocked);
+	Writer.WriteInt("cpu_mhz", RunConfig.mCurrentMHz);
+	Writer.WriteInt("cpu_max_mhz", RunConfig.mMaxMHz);
+	if(RunConfig.mTurbo<0)
+		Writer.WriteString("turbo", null);
+	else
+		Writer.WriteBool("turbo", RunConfig.mTurbo!=0);
+	Writer.WriteBool("frequency_warning", RunConfig.mFrequencyWarning);
+	Writer.EndObject();
+
+	const udword NbFrames = gFrameNb<=MAX_NB_RECORDED_FRAMES ? gFrameNb : MAX_NB_RECORDED_FRAMES;
+	Writer.WriteInt("nb_frames", gFrameNb);
+	Writer.WriteInt("nb_recorded_frames", NbFrames);
+
+	Writer.BeginArray("engines");
+	for(udword i=0;i<gNbEngines;i++)
+	{
+		ASSERT(gEngines[i].mEngine);
+		if(!gEngines[i].mEnabled || !(gEngines[i].mEngine->GetFlags() & PINT_IS_ACTIVE))
+			continue;
+		WriteEngine(Writer, i, NbFrames);
+	}
+	Writer.EndArray();
+
+	Writer.EndObject();
+	fputc('\n', fp);
+	fclose(fp);
+	return true;
+}
+
+bool AppendFailedRunRecord(const char* test_name, const char* plugin, const char* status, udword exit_code)
+{
+	if(!gResultsEnabled)
+		return false;
+
+	FILE* fp = fopen(gResultsFilename, "a");
+	if(!fp)
+		return false;
+
+	JSONWriter Writer(fp);
+	Writer.BeginObject();
+	WriteRecordHeader(Writer);
+
+	Writer.BeginObject("test");
+	Writer.WriteString("name", test_name);
+	Writer.EndObject();
+
+	Writer.BeginObject("failure");
+	Writer.WriteString("plugin", plugin);
+	Writer.WriteString("status", status);
+	Writer.WriteInt("exit_code", exit_code);
+	Writer.EndObject();
+
+	Writer.BeginArray("engines");
+	Writer.EndArray();
+
+	Writer.EndObject();
+	fputc('\n', fp);
+	fclose(fp);
+	return true;
+}
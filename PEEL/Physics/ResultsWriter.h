@@ -0,0 +1,31 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef RESULTS_WRITER_H
+#define RESULTS_WRITER_H
+
+	// Machine-readable results, in JSON lines format: each test run appends one self-contained JSON object (one line)
+	// to the results file, so that a whole script run ends up in a single file. Each record contains the run metadata
+	// (build, host, test & world params, plugin settings), the per-frame data and the statistics of each engine.
+	//
+	// The git hash comes from the PEEL_GIT_HASH environment variable, or from the PEEL_GIT_HASH define at compile time.
+
+	#define DEFAULT_RESULTS_FILENAME	"PEEL_Results.jsonl"
+
+	// Null disables the JSON output, which is also the default. The headless app enables it with DEFAULT_RESULTS_FILENAME.
+	void		SetResultsFilename(const char* filename);
+	const char*	GetResultsFilename();
+
+	// Appends the results of the running test to the results file. Must be called before the engines are closed.
+	bool		TestJSONExport();
+
+	// Appends a record for a run that produced no results (e.g. the engine's process crashed or timed out). The record
+	// has a "failure" object and an empty "engines" array.
+	bool		AppendFailedRunRecord(const char* test_name, const char* plugin, const char* status, udword exit_code);
+
+#endif
@@ -0,0 +1,521 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "RunConfig.h"
+
+#ifdef _WIN32
+	#include <powrprof.h>
+	#pragma comment(lib, "powrprof.lib")
+#elif defined(__linux__)
+	#include <sched.h>
+	#include <pthread.h>
+	#include <unistd.h>
+	#include <sys/resource.h>
+#endif
+
+uqword		gSimulationCores = 0;
+uqword		gWorkerCores = 0;
+RunPriority	gRunPriority = RUN_PRIORITY_NORMAL;
+bool		gLockGovernor = false;
+PintAllocatorType	gAllocatorType = PINT_ALLOCATOR_SYSTEM;
+
+static RunConfigStatus	gStatus;
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool ParseCoreSet(const char* text, uqword& cores, udword max_nb_cores)
+{
+	ASSERT(max_nb_cores<=MAX_NB_CORES);
+	cores = 0;
+	if(!text)
+		return false;
+
+	const char* c = text;
+	while(*c)
+	{
+		if(*c<'0' || *c>'9')
+			return false;
+		udword First = 0;
+		while(*c>='0' && *c<='9')
+			First = First*10 + udword(*c++ - '0');
+
+		udword Last = First;
+		if(*c=='-')
+		{
+			c++;
+			if(*c<'0' || *c>'9')
+				return false;
+			Last = 0;
+			while(*c>='0' && *c<='9')
+				Last = Last*10 + udword(*c++ - '0');
+		}
+
+		if(First>Last || Last>=max_nb_cores)
+			return false;
+		for(udword i=First;i<=Last;i++)
+			cores |= uqword(1)<<i;
+
+		if(*c==',' && c[1])
+			c++;
+		else if(*c)
+			return false;
+	}
+	return cores!=0;
+}
+
+void GetCoreSetString(uqword cores, char* buffer, udword size)
+{
+	ASSERT(buffer && size);
+	buffer[0] = 0;
+	udword Length = 0;
+	udword i = 0;
+	while(i<MAX_NB_CORES)
+	{
+		if(!(cores & (uqword(1)<<i)))
+		{
+			i++;
+			continue;
+		}
+		udword Last = i;
+		while(Last+1<MAX_NB_CORES && (cores & (uqword(1)<<(Last+1))))
+			Last++;
+
+		const char* Range = Last==i ? _F("%s%d", Length ? "," : "", i) : _F("%s%d-%d", Length ? "," : "", i, Last);
+		const udword RangeLength = udword(strlen(Range));
+		if(Length+RangeLength+1>size)
+			break;
+		strcpy(buffer+Length, Range);
+		Length += RangeLength;
+		i = Last+1;
+	}
+}
+
+bool ParseRunPriority(const char* text, RunPriority& priority)
+{
+	if(!text)
+		return false;
+	for(udword i=RUN_PRIORITY_NORMAL;i<=RUN_PRIORITY_REALTIME;i++)
+	{
+		if(_stricmp(text, GetRunPriorityName(RunPriority(i)))==0)
+		{
+			priority = RunPriority(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* GetRunPriorityName(RunPriority priority)
+{
+	switch(priority)
+	{
+		case RUN_PRIORITY_NORMAL:	return "normal";
+		case RUN_PRIORITY_HIGH:		return "high";
+		case RUN_PRIORITY_REALTIME:	return "realtime";
+	};
+	return null;
+}
+
+bool ParseAllocatorType(const char* text, PintAllocatorType& type)
+{
+	if(!text)
+		return false;
+	for(udword i=PINT_ALLOCATOR_SYSTEM;i<=PINT_ALLOCATOR_POOL;i++)
+	{
+		if(_stricmp(text, GetAllocatorTypeName(PintAllocatorType(i)))==0)
+		{
+			type = PintAllocatorType(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* GetAllocatorTypeName(PintAllocatorType type)
+{
+	switch(type)
+	{
+		case PINT_ALLOCATOR_SYSTEM:	return "system";
+		case PINT_ALLOCATOR_ARENA:	return "arena";
+		case PINT_ALLOCATOR_POOL:	return "pool";
+	};
+	return null;
+}
+
+const RunConfigStatus& GetRunConfigStatus()
+{
+	return gStatus;
+}
+
+static udword GetNbCoresInSet(uqword cores)
+{
+	udword Nb = 0;
+	for(udword i=0;i<MAX_NB_CORES;i++)
+	{
+		if(cores & (uqword(1)<<i))
+			Nb++;
+	}
+	return Nb;
+}
+
+// Returns the index-th core of the set
+static udword GetCoreFromSet(uqword cores, udword index)
+{
+	ASSERT(cores);
+	for(udword i=0;i<MAX_NB_CORES;i++)
+	{
+		if(cores & (uqword(1)<<i))
+		{
+			if(!index)
+				return i;
+			index--;
+		}
+	}
+	return 0;
+}
+
+bool GetEngineThreadCore(udword index, udword& core)
+{
+	if(!gSimulationCores)
+		return false;
+
+	// The first core is used by the main thread, engine threads use the others unless there is only one
+	const udword NbCores = GetNbCoresInSet(gSimulationCores);
+	if(NbCores>1)
+		core = GetCoreFromSet(gSimulationCores, 1 + (index % (NbCores-1)));
+	else
+		core = GetCoreFromSet(gSimulationCores, 0);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+
+// Not in the SDK headers
+struct PEEL_PROCESSOR_POWER_INFORMATION
+{
+	ULONG	Number;
+	ULONG	MaxMhz;
+	ULONG	CurrentMhz;
+	ULONG	MhzLimit;
+	ULONG	MaxIdleState;
+	ULONG	CurrentIdleState;
+};
+
+static const GUID gHighPerformanceScheme	= { 0x8c5e7fda, 0xe8bf, 0x4a96, { 0x9a, 0x85, 0xa6, 0xe2, 0x3a, 0x8c, 0x63, 0x5c } };
+static const GUID gBalancedScheme			= { 0x381b4222, 0xf694, 0x41f0, { 0x96, 0x85, 0xff, 0x5b, 0xb2, 0x60, 0xdf, 0x2e } };
+static const GUID gPowerSaverScheme			= { 0xa1841308, 0x3541, 0x4fab, { 0xbc, 0x81, 0xf7, 0x15, 0x56, 0xf2, 0x0b, 0x4a } };
+
+static GUID	gPreviousScheme;
+static bool	gMustRestoreScheme = false;
+
+static bool GetActiveScheme(GUID& scheme)
+{
+	GUID* Active = null;
+	if(PowerGetActiveScheme(null, &Active)!=ERROR_SUCCESS || !Active)
+		return false;
+	scheme = *Active;
+	LocalFree(Active);
+	return true;
+}
+
+static const char* GetSchemeName(const GUID& scheme)
+{
+	if(IsEqualGUID(scheme, gHighPerformanceScheme))
+		return "High performance";
+	if(IsEqualGUID(scheme, gBalancedScheme))
+		return "Balanced";
+	if(IsEqualGUID(scheme, gPowerSaverScheme))
+		return "Power saver";
+	return "Custom";
+}
+
+static void PinCurrentThread(udword core)
+{
+	if(core<sizeof(DWORD_PTR)*8)
+		SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1)<<core);
+	else
+		printf("WARNING: core %d can't be used by this build, main thread not pinned.\n", core);
+}
+
+static void UnpinCurrentThread()
+{
+	DWORD_PTR ProcessMask, SystemMask;
+	if(GetProcessAffinityMask(GetCurrentProcess(), &ProcessMask, &SystemMask))
+		SetThreadAffinityMask(GetCurrentThread(), ProcessMask);
+}
+
+static RunPriority SetPriority(RunPriority priority)
+{
+	if(priority==RUN_PRIORITY_NORMAL)
+	{
+		SetPriorityClass(GetCurrentProcess(), NORMAL_PRIORITY_CLASS);
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_NORMAL);
+		return RUN_PRIORITY_NORMAL;
+	}
+
+	// Windows silently gives HIGH_PRIORITY_CLASS when REALTIME_PRIORITY_CLASS isn't allowed
+	SetPriorityClass(GetCurrentProcess(), priority==RUN_PRIORITY_REALTIME ? REALTIME_PRIORITY_CLASS : HIGH_PRIORITY_CLASS);
+	SetThreadPriority(GetCurrentThread(), priority==RUN_PRIORITY_REALTIME ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST);
+	const DWORD Class = GetPriorityClass(GetCurrentProcess());
+	if(Class==REALTIME_PRIORITY_CLASS)
+		return RUN_PRIORITY_REALTIME;
+	if(Class==HIGH_PRIORITY_CLASS)
+		return RUN_PRIORITY_HIGH;
+	return RUN_PRIORITY_NORMAL;
+}
+
+static void UpdateFrequencyStatus(udword core)
+{
+	GUID Scheme;
+	if(GetActiveScheme(Scheme))
+		strcpy(gStatus.mGovernor, GetSchemeName(Scheme));
+	else
+		strcpy(gStatus.mGovernor, "unknown");
+
+	SYSTEM_INFO Info;
+	GetSystemInfo(&Info);
+	const udword NbProcessors = Info.dwNumberOfProcessors;
+
+	PEEL_PROCESSOR_POWER_INFORMATION* PPI = (PEEL_PROCESSOR_POWER_INFORMATION*)ICE_ALLOC(sizeof(PEEL_PROCESSOR_POWER_INFORMATION)*NbProcessors);
+	if(CallNtPowerInformation(ProcessorInformation, null, 0, PPI, sizeof(PEEL_PROCESSOR_POWER_INFORMATION)*NbProcessors)==0)
+	{
+		const PEEL_PROCESSOR_POWER_INFORMATION& P = PPI[core<NbProcessors ? core : 0];
+		gStatus.mCurrentMHz = P.CurrentMhz;
+		gStatus.mMaxMHz = P.MaxMhz;
+		// Frequency capped below nominal: power saving or thermal throttling
+		if(P.MhzLimit<P.MaxMhz)
+			gStatus.mFrequencyWarning = true;
+	}
+	ICE_FREE(PPI);
+
+	// Turbo state isn't exposed, only the scheme tells us whether frequency scaling is aggressive
+	gStatus.mTurbo = -1;
+	if(strcmp(gStatus.mGovernor, "unknown")!=0 && strcmp(gStatus.mGovernor, "High performance")!=0)
+		gStatus.mFrequencyWarning = true;
+}
+
+static void LockGovernor()
+{
+	if(gMustRestoreScheme)
+		return;
+	if(!GetActiveScheme(gPreviousScheme))
+		return;
+	if(IsEqualGUID(gPreviousScheme, gHighPerformanceScheme))
+	{
+		gStatus.mGovernorLocked = true;
+		return;
+	}
+	if(PowerSetActiveScheme(null, &gHighPerformanceScheme)==ERROR_SUCCESS)
+	{
+		gMustRestoreScheme = true;
+		gStatus.mGovernorLocked = true;
+	}
+	else
+		printf("WARNING: could not switch to the High performance power scheme.\n");
+}
+
+void RestoreRunConfig()
+{
+	if(gMustRestoreScheme)
+	{
+		PowerSetActiveScheme(null, &gPreviousScheme);
+		gMustRestoreScheme = false;
+	}
+	gStatus.mGovernorLocked = false;
+}
+
+#elif defined(__linux__)
+
+static char		gPreviousGovernors[MAX_NB_CORES][32];
+static bool		gMustRestoreGovernors = false;
+
+static bool ReadSysFile(const char* filename, char* buffer, udword size)
+{
+	FILE* fp = fopen(filename, "r");
+	if(!fp)
+		return false;
+	const bool Status = fgets(buffer, size, fp)!=null;
+	fclose(fp);
+	if(Status)
+	{
+		char* EndOfLine = strchr(buffer, '\n');
+		if(EndOfLine)
+			*EndOfLine = 0;
+	}
+	return Status;
+}
+
+static bool WriteSysFile(const char* filename, const char* text)
+{
+	FILE* fp = fopen(filename, "w");
+	if(!fp)
+		return false;
+	const bool Status = fputs(text, fp)>=0;
+	return fclose(fp)==0 && Status;
+}
+
+static void PinCurrentThread(udword core)
+{
+	cpu_set_t Set;
+	CPU_ZERO(&Set);
+	CPU_SET(core, &Set);
+	pthread_setaffinity_np(pthread_self(), sizeof(Set), &Set);
+}
+
+static void UnpinCurrentThread()
+{
+	cpu_set_t Set;
+	CPU_ZERO(&Set);
+	const long NbCores = sysconf(_SC_NPROCESSORS_CONF);
+	for(long i=0;i<NbCores && i<CPU_SETSIZE;i++)
+		CPU_SET(i, &Set);
+	pthread_setaffinity_np(pthread_self(), sizeof(Set), &Set);
+}
+
+static RunPriority SetPriority(RunPriority priority)
+{
+	if(priority==RUN_PRIORITY_REALTIME)
+	{
+		sched_param Param;
+		Param.sched_priority = sched_get_priority_max(SCHED_FIFO)/2;
+		if(pthread_setschedparam(pthread_self(), SCHED_FIFO, &Param)==0)
+			return RUN_PRIORITY_REALTIME;
+	}
+	if(priority!=RUN_PRIORITY_NORMAL)
+	{
+		if(setpriority(PRIO_PROCESS, 0, -10)==0)
+			return RUN_PRIORITY_HIGH;
+	}
+	return RUN_PRIORITY_NORMAL;
+}
+
+static void UpdateFrequencyStatus(udword core)
+{
+	char Buffer[64];
+	if(ReadSysFile(_F("/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor", core), Buffer, sizeof(Buffer)))
+		strcpy(gStatus.mGovernor, Buffer);
+	else
+		strcpy(gStatus.mGovernor, "unknown");
+
+	if(ReadSysFile(_F("/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq", core), Buffer, sizeof(Buffer)))
+		gStatus.mCurrentMHz = udword(atol(Buffer)/1000);
+	if(ReadSysFile(_F("/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", core), Buffer, sizeof(Buffer)))
+		gStatus.mMaxMHz = udword(atol(Buffer)/1000);
+
+	gStatus.mTurbo = -1;
+	if(ReadSysFile("/sys/devices/system/cpu/intel_pstate/no_turbo", Buffer, sizeof(Buffer)))
+		gStatus.mTurbo = atoi(Buffer) ? 0 : 1;
+	else if(ReadSysFile("/sys/devices/system/cpu/cpufreq/boost", Buffer, sizeof(Buffer)))
+		gStatus.mTurbo = atoi(Buffer) ? 1 : 0;
+
+	if((strcmp(gStatus.mGovernor, "unknown")!=0 && strcmp(gStatus.mGovernor, "performance")!=0) || gStatus.mTurbo==1)
+		gStatus.mFrequencyWarning = true;
+}
+
+static void LockGovernor()
+{
+	if(gMustRestoreGovernors)
+		return;
+
+	const long NbCores = sysconf(_SC_NPROCESSORS_ONLN);
+	bool Status = true;
+	for(long i=0;i<NbCores && i<MAX_NB_CORES;i++)
+	{
+		const char* Filename = _F("/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor", int(i));
+		if(!ReadSysFile(Filename, gPreviousGovernors[i], sizeof(gPreviousGovernors[i])))
+		{
+			gPreviousGovernors[i][0] = 0;
+			continue;
+		}
+		Status &= WriteSysFile(_F("/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor", int(i)), "performance");
+	}
+	gMustRestoreGovernors = true;
+	gStatus.mGovernorLocked = Status;
+	if(!Status)
+		printf("WARNING: could not set the performance governor on all cores (root rights needed).\n");
+}
+
+void RestoreRunConfig()
+{
+	if(gMustRestoreGovernors)
+	{
+		for(udword i=0;i<MAX_NB_CORES;i++)
+		{
+			if(gPreviousGovernors[i][0])
+				WriteSysFile(_F("/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor", i), gPreviousGovernors[i]);
+		}
+		gMustRestoreGovernors = false;
+	}
+	gStatus.mGovernorLocked = false;
+}
+
+#else
+
+static void			PinCurrentThread(udword)				{}
+static void			UnpinCurrentThread()					{}
+static RunPriority	SetPriority(RunPriority)				{ return RUN_PRIORITY_NORMAL;		}
+static void			UpdateFrequencyStatus(udword)			{ strcpy(gStatus.mGovernor, "unknown");	gStatus.mTurbo = -1;	}
+static void			LockGovernor()							{}
+void				RestoreRunConfig()						{}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ApplyRunConfig()
+{
+	const bool GovernorLocked = gStatus.mGovernorLocked;
+	ZeroMemory(&gStatus, sizeof(gStatus));
+	gStatus.mGovernorLocked = GovernorLocked;
+
+	udword MainCore = 0;
+	if(gSimulationCores)
+	{
+		MainCore = GetCoreFromSet(gSimulationCores, 0);
+		PinCurrentThread(MainCore);
+	}
+	else
+	{
+		// The main thread may have been pinned by a previous run
+		UnpinCurrentThread();
+	}
+
+	// Core sets can also come from scripts, check them here rather than at parse time
+	if(gWorkerCores>>MAX_NB_WORKER_CORES)
+	{
+		printf("WARNING: worker cores must be below %d, higher cores are ignored.\n", MAX_NB_WORKER_CORES);
+		gWorkerCores &= (uqword(1)<<MAX_NB_WORKER_CORES)-1;
+	}
+	if(gSimulationCores & gWorkerCores)
+		printf("WARNING: simulation and worker cores overlap, engine worker threads will compete with the simulation threads.\n");
+
+	gStatus.mPriority = SetPriority(gRunPriority);
+	if(gStatus.mPriority!=gRunPriority)
+		printf("WARNING: %s priority requested, running at %s priority.\n", GetRunPriorityName(gRunPriority), GetRunPriorityName(gStatus.mPriority));
+
+	if(gLockGovernor)
+		LockGovernor();
+	else
+		RestoreRunConfig();
+
+	UpdateFrequencyStatus(MainCore);
+
+	char SimulationCores[256];
+	char WorkerCores[256];
+	GetCoreSetString(gSimulationCores, SimulationCores, sizeof(SimulationCores));
+	GetCoreSetString(gWorkerCores, WorkerCores, sizeof(WorkerCores));
+	printf("Run config: simulation cores: %s, worker cores: %s, priority: %s, allocator: %s, governor: %s%s, %d/%d MHz\n",
+		gSimulationCores ? SimulationCores : "any", gWorkerCores ? WorkerCores : "any", GetRunPriorityName(gStatus.mPriority), GetAllocatorTypeName(gAllocatorType),
+		gStatus.mGovernor, gStatus.mGovernorLocked ? " (locked)" : "", gStatus.mCurrentMHz, gStatus.mMaxMHz);
+
+	if(gStatus.mFrequencyWarning)
+		printf("WARNING: CPU frequency scaling%s is active, timings may vary. Use the performance governor/power scheme for stable results.\n", gStatus.mTurbo==1 ? " (turbo)" : "");
+}
@@ -0,0 +1,68 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef RUN_CONFIG_H
+#define RUN_CONFIG_H
+
+#include "PintAllocTracker.h"
+
+	// Machine setup for benchmark runs: thread placement, priority and CPU frequency. Core sets are masks (bit i = core i)
+	// written as lists of cores and ranges, e.g. "2-5,8". An empty set (0) leaves the placement to the OS.
+	//
+	// - Simulation cores: the main thread is pinned to the first one. With parallel engines, the engine threads use
+	//   the others (or share the only one).
+	// - Worker cores: passed to engines for their own worker threads, see PINT_WORLD_CREATE::GetWorkerThreadAffinity().
+	//
+	// The allocator backend is passed to engines the same way, see PINT_WORLD_CREATE::GetAllocatorType().
+
+	enum RunPriority
+	{
+		RUN_PRIORITY_NORMAL,
+		RUN_PRIORITY_HIGH,
+		RUN_PRIORITY_REALTIME,	// Needs admin/root rights, falls back to high priority otherwise
+	};
+
+	struct RunConfigStatus
+	{
+		char		mGovernor[64];		// Power scheme (Windows) or cpufreq governor (Linux)
+		udword		mCurrentMHz;		// 0 if unknown
+		udword		mMaxMHz;			// 0 if unknown
+		sdword		mTurbo;				// 1 if enabled, 0 if disabled, -1 if unknown
+		RunPriority	mPriority;			// Priority actually obtained
+		bool		mGovernorLocked;	// Switched to the performance governor/scheme for the run
+		bool		mFrequencyWarning;	// Frequency scaling is active, timings may drift
+	};
+
+	// Core sets are 64 bits, but the engines' thread pool APIs take 32-bit masks so worker cores are limited to 0-31
+	#define MAX_NB_CORES		64
+	#define MAX_NB_WORKER_CORES	32
+
+	extern	uqword		gSimulationCores;
+	extern	uqword		gWorkerCores;
+	extern	RunPriority	gRunPriority;
+	extern	bool		gLockGovernor;
+	extern	PintAllocatorType	gAllocatorType;
+
+	bool		ParseCoreSet(const char* text, uqword& cores, udword max_nb_cores=MAX_NB_CORES);
+	void		GetCoreSetString(uqword cores, char* buffer, udword size);
+	bool		ParseRunPriority(const char* text, RunPriority& priority);
+	const char*	GetRunPriorityName(RunPriority priority);
+	bool		ParseAllocatorType(const char* text, PintAllocatorType& type);
+	const char*	GetAllocatorTypeName(PintAllocatorType type);
+
+	// Applies the settings above. Must be called from the main thread. Prints the resulting status and warnings. The main
+	// thread is unpinned when there are no simulation cores.
+	void		ApplyRunConfig();
+	// Restores the initial governor/power scheme, if it was changed.
+	void		RestoreRunConfig();
+	const RunConfigStatus&	GetRunConfigStatus();
+
+	// Returns the core for engine thread 'index' (parallel engines), or false to let the caller decide.
+	bool		GetEngineThreadCore(udword index, udword& core);
+
+#endif
@@ -0,0 +1,498 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "SQThreads.h"
+#include "Simulation.h"
+#include "RunConfig.h"
+#include "TestScenes.h"
+
+udword	gNbSQThreads = 1;
+
+namespace
+{
+	// One slice of a batch, i.e. the job of one SQ thread
+	struct SQSlice
+	{
+		Pint*				mPint;
+		PintSQThreadContext	mContext;
+		SQBatch				mBatch;
+		udword				mNbHits;
+		uqword				mEndTime;	// Timestamp taken by workers when the slice is done
+	};
+
+	struct SQWorker
+	{
+		IceThread*	mThread;
+		IceSem*		mStart;
+		udword		mIndex;		// Slice index, starts at 1 (slice 0 is run by the main thread, if any)
+	};
+}
+
+static SQWorker	gSQWorkers[MAX_NB_SQ_THREADS];
+static udword	gNbSQWorkers = 0;
+static IceSem*	gSQWorkersDone = null;
+static bool		gSQWorkersExit = false;
+static udword	gNbPendingSlices = 0;	// Slices started by StartSQBatch(), not waited for yet
+
+// Current batch. Written by the main thread before the workers are woken up, the semaphores take care of visibility.
+static SQSlice	gSQSlices[MAX_NB_SQ_THREADS];
+
+static udword GetQuerySize(SQBatchType type)
+{
+	switch(type)
+	{
+		case SQ_BATCH_RAYCASTS:
+		case SQ_BATCH_RAYCAST_ANY:
+		case SQ_BATCH_RAYCAST_ALL:				return sizeof(PintRaycastData);
+		case SQ_BATCH_BOX_SWEEPS:				return sizeof(PintBoxSweepData);
+		case SQ_BATCH_SPHERE_SWEEPS:			return sizeof(PintSphereSweepData);
+		case SQ_BATCH_CAPSULE_SWEEPS:			return sizeof(PintCapsuleSweepData);
+		case SQ_BATCH_CONVEX_SWEEPS:			return sizeof(PintConvexSweepData);
+		case SQ_BATCH_SPHERE_OVERLAP_ANY:
+		case SQ_BATCH_SPHERE_OVERLAP_OBJECTS:	return sizeof(PintSphereOverlapData);
+		case SQ_BATCH_BOX_OVERLAP_ANY:
+		case SQ_BATCH_BOX_OVERLAP_OBJECTS:		return sizeof(PintBoxOverlapData);
+		case SQ_BATCH_CAPSULE_OVERLAP_ANY:
+		case SQ_BATCH_CAPSULE_OVERLAP_OBJECTS:	return sizeof(PintCapsuleOverlapData);
+	};
+	ASSERT(0);
+	return 0;
+}
+
+static udword GetHitSize(SQBatchType type)
+{
+	switch(type)
+	{
+		case SQ_BATCH_RAYCASTS:
+		case SQ_BATCH_BOX_SWEEPS:
+		case SQ_BATCH_SPHERE_SWEEPS:
+		case SQ_BATCH_CAPSULE_SWEEPS:
+		case SQ_BATCH_CONVEX_SWEEPS:			return sizeof(PintRaycastHit);
+		case SQ_BATCH_RAYCAST_ANY:
+		case SQ_BATCH_SPHERE_OVERLAP_ANY:
+		case SQ_BATCH_BOX_OVERLAP_ANY:
+		case SQ_BATCH_CAPSULE_OVERLAP_ANY:		return sizeof(PintBooleanHit);
+		case SQ_BATCH_RAYCAST_ALL:
+		case SQ_BATCH_SPHERE_OVERLAP_OBJECTS:
+		case SQ_BATCH_BOX_OVERLAP_OBJECTS:
+		case SQ_BATCH_CAPSULE_OVERLAP_OBJECTS:	return sizeof(PintOverlapObjectHit);
+	};
+	ASSERT(0);
+	return 0;
+}
+
+static udword ExecuteSQBatch(Pint& pint, PintSQThreadContext context, const SQBatch& batch)
+{
+	const udword Nb = batch.mNb;
+	if(!Nb)
+		return 0;
+
+	switch(batch.mType)
+	{
+		case SQ_BATCH_RAYCASTS:					return pint.BatchRaycasts(context, Nb, (PintRaycastHit*)batch.mHits, (const PintRaycastData*)batch.mQueries);
+		case SQ_BATCH_RAYCAST_ANY:				return pint.BatchRaycastAny(context, Nb, (PintBooleanHit*)batch.mHits, (const PintRaycastData*)batch.mQueries);
+		case SQ_BATCH_RAYCAST_ALL:				return pint.BatchRaycastAll(context, Nb, (PintOverlapObjectHit*)batch.mHits, (const PintRaycastData*)batch.mQueries);
+		case SQ_BATCH_BOX_SWEEPS:				return pint.BatchBoxSweeps(context, Nb, (PintRaycastHit*)batch.mHits, (const PintBoxSweepData*)batch.mQueries);
+		case SQ_BATCH_SPHERE_SWEEPS:			return pint.BatchSphereSweeps(context, Nb, (PintRaycastHit*)batch.mHits, (const PintSphereSweepData*)batch.mQueries);
+		case SQ_BATCH_CAPSULE_SWEEPS:			return pint.BatchCapsuleSweeps(context, Nb, (PintRaycastHit*)batch.mHits, (const PintCapsuleSweepData*)batch.mQueries);
+		case SQ_BATCH_CONVEX_SWEEPS:			return pint.BatchConvexSweeps(context, Nb, (PintRaycastHit*)batch.mHits, (const PintConvexSweepData*)batch.mQueries);
+		case SQ_BATCH_SPHERE_OVERLAP_ANY:		return pint.BatchSphereOverlapAny(context, Nb, (PintBooleanHit*)batch.mHits, (const PintSphereOverlapData*)batch.mQueries);
+		case SQ_BATCH_SPHERE_OVERLAP_OBJECTS:	return pint.BatchSphereOverlapObjects(context, Nb, (PintOverlapObjectHit*)batch.mHits, (const PintSphereOverlapData*)batch.mQueries);
+		case SQ_BATCH_BOX_OVERLAP_ANY:			return pint.BatchBoxOverlapAny(context, Nb, (PintBooleanHit*)batch.mHits, (const PintBoxOverlapData*)batch.mQueries);
+		case SQ_BATCH_BOX_OVERLAP_OBJECTS:		return pint.BatchBoxOverlapObjects(context, Nb, (PintOverlapObjectHit*)batch.mHits, (const PintBoxOverlapData*)batch.mQueries);
+		case SQ_BATCH_CAPSULE_OVERLAP_ANY:		return pint.BatchCapsuleOverlapAny(context, Nb, (PintBooleanHit*)batch.mHits, (const PintCapsuleOverlapData*)batch.mQueries);
+		case SQ_BATCH_CAPSULE_OVERLAP_OBJECTS:	return pint.BatchCapsuleOverlapObjects(context, Nb, (PintOverlapObjectHit*)batch.mHits, (const PintCapsuleOverlapData*)batch.mQueries);
+	};
+	ASSERT(0);
+	return 0;
+}
+
+static inline_ void RunSlice(SQSlice& slice)
+{
+	slice.mNbHits = ExecuteSQBatch(*slice.mPint, slice.mContext, slice.mBatch);
+}
+
+void ThreadSetup();
+
+static int gSQWorkerThread(void* user_data)
+{
+	ThreadSetup();
+
+	const SQWorker* Worker = (const SQWorker*)user_data;
+	while(1)
+	{
+		SemWait(Worker->mStart);
+
+		if(gSQWorkersExit)
+			break;
+
+		SQSlice& Slice = gSQSlices[Worker->mIndex];
+		RunSlice(Slice);
+		Slice.mEndTime = GetProfilingTimer(gProfilingUnits).End();
+
+		SemPost(gSQWorkersDone);
+	}
+	return 0;
+}
+
+static udword GetNbCores()
+{
+	SYSTEM_INFO Info;
+	GetSystemInfo(&Info);
+	return Info.dwNumberOfProcessors;
+}
+
+// Creates workers for slices 1 to nb-1
+static void CreateSQThreads(udword nb)
+{
+	ASSERT(!gNbSQWorkers);
+	ASSERT(nb<=MAX_NB_SQ_THREADS);
+
+	gSQWorkersDone = CreateSemaphore(0);
+	gSQWorkersExit = false;
+
+	const udword NbCores = GetNbCores();
+	const udword MaxNbCores = sizeof(DWORD_PTR)*8;
+
+	for(udword i=1;i<nb;i++)
+	{
+		SQWorker& Worker = gSQWorkers[i];
+		Worker.mIndex	= i;
+		Worker.mStart	= CreateSemaphore(0);
+		Worker.mThread	= CreateThread(gSQWorkerThread, &Worker);
+
+		// Same placement as the engine threads: the main thread keeps its core
+		udword Core;
+		if(!GetEngineThreadCore(i-1, Core))
+			Core = NbCores>1 ? 1 + ((i-1) % (NbCores-1)) : 0;
+		if(Core>=MaxNbCores)
+			Core %= MaxNbCores;
+		if(Worker.mThread)
+			SetThreadAffinityMask(Worker.mThread->handle, DWORD_PTR(1)<<Core);
+	}
+	gNbSQWorkers = nb;
+
+	if(nb>NbCores)
+		printf("WARNING: %d SQ threads for %d cores, some threads share a core.\n", nb, NbCores);
+}
+
+void ReleaseSQThreads()
+{
+	if(!gNbSQWorkers)
+		return;
+
+	gSQWorkersExit = true;
+	for(udword i=1;i<gNbSQWorkers;i++)
+		SemPost(gSQWorkers[i].mStart);
+
+	for(udword i=1;i<gNbSQWorkers;i++)
+	{
+		WaitThread(gSQWorkers[i].mThread, null);
+		DestroySemaphore(gSQWorkers[i].mStart);
+		gSQWorkers[i].mThread = null;
+		gSQWorkers[i].mStart = null;
+	}
+	DestroySemaphore(gSQWorkersDone);
+	gSQWorkersDone = null;
+	gSQWorkersExit = false;
+	gNbSQWorkers = 0;
+}
+
+static inline_ bool SupportsConcurrentSQ(const Pint& pint)
+{
+	return (pint.GetFlags() & PINT_CONCURRENT_SQ)!=0;
+}
+
+static void SetupSQThreads(udword nb)
+{
+	ASSERT(!gNbPendingSlices);
+	if(gNbSQWorkers<nb)
+	{
+		ReleaseSQThreads();
+		CreateSQThreads(nb);
+	}
+}
+
+// Splits the batch in contiguous slices 'first' to 'first+nb-1', the first ones get the remainder. Each slice writes
+// its own range of the hits buffer.
+static void SetupSlices(Pint& pint, const SQBatch& batch, udword first, udword nb)
+{
+	PintSQ& Helper = *pint.mSQHelper;
+
+	const udword QuerySize = GetQuerySize(batch.mType);
+	const udword HitSize = GetHitSize(batch.mType);
+	const udword SliceSize = batch.mNb / nb;
+	const udword Remainder = batch.mNb % nb;
+	udword Offset = 0;
+	for(udword i=0;i<nb;i++)
+	{
+		const udword Nb = SliceSize + (i<Remainder ? 1 : 0);
+
+		SQSlice& Slice = gSQSlices[first+i];
+		Slice.mPint				= &pint;
+		Slice.mContext			= Helper.GetThreadContext(first+i);
+		Slice.mBatch.mType		= batch.mType;
+		Slice.mBatch.mNb		= Nb;
+		Slice.mBatch.mQueries	= (const ubyte*)batch.mQueries + Offset*QuerySize;
+		Slice.mBatch.mHits		= (ubyte*)batch.mHits + Offset*HitSize;
+		Slice.mNbHits			= 0;
+		Slice.mEndTime			= 0;
+		Offset += Nb;
+	}
+	ASSERT(Offset==batch.mNb);
+}
+
+udword DispatchSQBatch(Pint& pint, const SQBatch& batch, udword nb_threads)
+{
+	ASSERT(pint.mSQHelper);
+	PintSQ& Helper = *pint.mSQHelper;
+
+	if(nb_threads>MAX_NB_SQ_THREADS)
+		nb_threads = MAX_NB_SQ_THREADS;
+	// No empty slices
+	if(nb_threads>batch.mNb)
+		nb_threads = batch.mNb;
+	if(nb_threads<=1 || !SupportsConcurrentSQ(pint))
+		return ExecuteSQBatch(pint, Helper.GetThreadContext(), batch);
+
+	SetupSQThreads(nb_threads);
+	SetupSlices(pint, batch, 0, nb_threads);
+
+	for(udword i=1;i<nb_threads;i++)
+		SemPost(gSQWorkers[i].mStart);
+
+	RunSlice(gSQSlices[0]);
+
+	for(udword i=1;i<nb_threads;i++)
+		SemWait(gSQWorkersDone);
+
+	udword NbHits = 0;
+	for(udword i=0;i<nb_threads;i++)
+		NbHits += gSQSlices[i].mNbHits;
+	return NbHits;
+}
+
+udword RunSQBatch(Pint& pint, SQBatchType type, udword nb, const void* queries, void* hits)
+{
+	SQBatch Batch;
+	Batch.mType		= type;
+	Batch.mNb		= nb;
+	Batch.mQueries	= queries;
+	Batch.mHits		= hits;
+
+	ASSERT(pint.mSQHelper);
+	pint.mSQHelper->SetLastBatch(Batch);
+
+	return DispatchSQBatch(pint, Batch, gNbSQThreads);
+}
+
+void StartSQBatch(Pint& pint, const SQBatch& batch, udword nb_threads)
+{
+	ASSERT(pint.mSQHelper);
+	ASSERT(batch.mNb);
+
+	// All slices run on workers, the main thread is busy with something else
+	if(nb_threads>MAX_NB_SQ_THREADS-1)
+		nb_threads = MAX_NB_SQ_THREADS-1;
+	if(nb_threads>batch.mNb)
+		nb_threads = batch.mNb;
+	if(!nb_threads || !SupportsConcurrentSQ(pint))
+		nb_threads = 1;
+
+	SetupSQThreads(nb_threads+1);
+	SetupSlices(pint, batch, 1, nb_threads);
+
+	gNbPendingSlices = nb_threads;
+	for(udword i=1;i<=nb_threads;i++)
+		SemPost(gSQWorkers[i].mStart);
+}
+
+udword WaitSQBatch(uqword& end_time)
+{
+	ASSERT(gNbPendingSlices);
+
+	for(udword i=0;i<gNbPendingSlices;i++)
+		SemWait(gSQWorkersDone);
+
+	udword NbHits = 0;
+	end_time = gSQSlices[1].mEndTime;
+	for(udword i=1;i<=gNbPendingSlices;i++)
+	{
+		NbHits += gSQSlices[i].mNbHits;
+		if(gSQSlices[i].mEndTime>end_time)
+			end_time = gSQSlices[i].mEndTime;
+	}
+	gNbPendingSlices = 0;
+	return NbHits;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Each thread count is timed several times & the best time is kept, to filter out interference from the rest of the system
+#define NB_SCALING_RUNS	8
+
+// Returns the best time for the batch, in timer ticks
+static uqword MeasureSQBatch(Pint& pint, const SQBatch& batch, udword nb_threads)
+{
+	const ProfilingTimer& Timer = GetProfilingTimer(gProfilingUnits);
+
+	// Warmup run, also creates the workers & contexts
+	DispatchSQBatch(pint, batch, nb_threads);
+
+	uqword BestTime = uqword(-1);
+	for(udword i=0;i<NB_SCALING_RUNS;i++)
+	{
+		const uqword Start = Timer.Start();
+		DispatchSQBatch(pint, batch, nb_threads);
+		const uqword Time = Timer.GetElapsedTicks(Start);
+		if(Time<BestTime)
+			BestTime = Time;
+	}
+	return BestTime;
+}
+
+void ReportSQScaling()
+{
+	if(!gRunningTest || gNbSQThreads<=1)
+		return;
+
+	const udword NbThreads = gNbSQThreads<MAX_NB_SQ_THREADS ? gNbSQThreads : MAX_NB_SQ_THREADS;
+	const ProfilingTimer& Timer = GetProfilingTimer(gProfilingUnits);
+
+	double QueriesPerSecond[MAX_NB_ENGINES][MAX_NB_SQ_THREADS];
+	bool Measured[MAX_NB_ENGINES];
+	bool HasResults = false;
+	for(udword b=0;b<gNbEngines;b++)
+	{
+		Measured[b] = false;
+		if(!gEngines[b].mEnabled || !gEngines[b].mSupportsCurrentTest || !gEngines[b].mEngine)
+			continue;
+
+		Pint& Engine = *gEngines[b].mEngine;
+		const SQBatch& Batch = gEngines[b].mSQHelper.GetLastBatch();
+		if(!Batch.mNb || !SupportsConcurrentSQ(Engine))
+			continue;
+
+		for(udword t=0;t<NbThreads;t++)
+		{
+			const uqword Ticks = MeasureSQBatch(Engine, Batch, t+1);
+			QueriesPerSecond[b][t] = Ticks ? double(Batch.mNb)*double(Timer.mFrequency)/double(Ticks) : 0.0;
+		}
+		Measured[b] = HasResults = true;
+	}
+	if(!HasResults)
+		return;
+
+	FILE* fp = fopen(GetTestCSVFilename("_SQScaling"), "w");
+	const char* Sep = gCommaSeparator ? ", " : "; ";
+
+	printf("SQ scaling for %s (queries/second, speedup vs 1 thread):\n", gRunningTest->GetName());
+	if(fp)
+	{
+		fprintf_s(fp, "%s - SQ scaling (queries/second)\n\n", gRunningTest->GetName());
+		fprintf_s(fp, "Threads");
+		for(udword t=0;t<NbThreads;t++)
+			fprintf_s(fp, "%s%d", Sep, t+1);
+		fprintf_s(fp, "\n");
+	}
+
+	for(udword b=0;b<gNbEngines;b++)
+	{
+		if(!Measured[b])
+			continue;
+
+		const char* EngineName = gEngines[b].mEngine->GetName();
+		const double Reference = QueriesPerSecond[b][0];
+		for(udword t=0;t<NbThreads;t++)
+			printf("  %s: %d thread(s): %.0f (x%.2f)\n", EngineName, t+1, QueriesPerSecond[b][t], Reference!=0.0 ? QueriesPerSecond[b][t]/Reference : 0.0);
+
+		if(fp)
+		{
+			fprintf_s(fp, "%s", EngineName);
+			for(udword t=0;t<NbThreads;t++)
+				fprintf_s(fp, "%s%.0f", Sep, QueriesPerSecond[b][t]);
+			fprintf_s(fp, "\n");
+		}
+	}
+
+	if(fp)
+		fclose(fp);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ReportSQOverlap()
+{
+	if(!gRunningTest || gSQProfilingMode!=SQ_PROFILING_OVERLAP)
+		return;
+
+	bool HasResults = false;
+	for(udword b=0;b<gNbEngines;b++)
+	{
+		if(gEngines[b].mEnabled && gEngines[b].mSupportsCurrentTest && gEngines[b].mSQOverlap.mSerialSQ.GetNbValues())
+			HasResults = true;
+	}
+	if(!HasResults)
+		return;
+
+	FILE* fp = fopen(GetTestCSVFilename("_SQOverlap"), "w");
+	const char* Sep = gCommaSeparator ? ", " : "; ";
+	const char* Units = GetProfilingTimer(gProfilingUnits).mUnits;
+
+	printf("SQ overlap for %s (%s, average per frame):\n", gRunningTest->GetName(), Units);
+	if(fp)
+	{
+		fprintf_s(fp, "%s - SQ overlap (%s, average per frame)\n\n", gRunningTest->GetName(), Units);
+		fprintf_s(fp, "Engine%sSerialized sim%sSerialized SQ%sSerialized total%sOverlapped sim%sOverlapped SQ%sOverlapped total%sGain (%%)%sEfficiency (%%)\n", Sep, Sep, Sep, Sep, Sep, Sep, Sep, Sep);
+	}
+
+	for(udword b=0;b<gNbEngines;b++)
+	{
+		const EngineData& Data = gEngines[b];
+		const SQOverlapStats& Stats = Data.mSQOverlap;
+		if(!Data.mEnabled || !Data.mSupportsCurrentTest || !Stats.mSerialSQ.GetNbValues())
+			continue;
+
+		const char* EngineName = Data.mEngine->GetName();
+		const float SerialSim = Stats.mSerialSim.GetMean();
+		const float SerialSQ = Stats.mSerialSQ.GetMean();
+		const float Serialized = SerialSim + SerialSQ;
+
+		if(!Stats.mOverlapWall.GetNbValues())
+		{
+			printf("  %s: queries not supported during Update, serialized: %.0f (sim %.0f + SQ %.0f)\n", EngineName, Serialized, SerialSim, SerialSQ);
+			if(fp)
+				fprintf_s(fp, "%s%s%.0f%s%.0f%s%.0f%s-%s-%s-%s-%s-\n", EngineName, Sep, SerialSim, Sep, SerialSQ, Sep, Serialized, Sep, Sep, Sep, Sep, Sep);
+			continue;
+		}
+
+		const float OverlapSim = Stats.mOverlapSim.GetMean();
+		const float OverlapSQ = Stats.mOverlapSQ.GetMean();
+		const float Overlapped = Stats.mOverlapWall.GetMean();
+
+		// Efficiency is the part of the hideable time (the shortest of sim & SQ) that was actually hidden. Contention shows
+		// up as slowdowns: queries blocked by locks take as long as the simulation, shared resources slow both down.
+		const float Gain = Serialized!=0.0f ? (Serialized - Overlapped)*100.0f/Serialized : 0.0f;
+		const float Hideable = TMin(SerialSim, SerialSQ);
+		const float Efficiency = Hideable!=0.0f ? (Serialized - Overlapped)*100.0f/Hideable : 0.0f;
+		const float SimSlowdown = SerialSim!=0.0f ? OverlapSim/SerialSim : 0.0f;
+		const float SQSlowdown = SerialSQ!=0.0f ? OverlapSQ/SerialSQ : 0.0f;
+
+		printf("  %s: serialized %.0f (sim %.0f + SQ %.0f), overlapped %.0f (sim %.0f, SQ %.0f)\n", EngineName, Serialized, SerialSim, SerialSQ, Overlapped, OverlapSim, OverlapSQ);
+		printf("  %s: gain %.1f%%, efficiency %.1f%%, sim slowdown x%.2f, SQ slowdown x%.2f\n", EngineName, Gain, Efficiency, SimSlowdown, SQSlowdown);
+		if(Efficiency<10.0f)
+			printf("  %s: WARNING: no real overlap, queries are probably blocked by the simulation.\n", EngineName);
+
+		if(fp)
+			fprintf_s(fp, "%s%s%.0f%s%.0f%s%.0f%s%.0f%s%.0f%s%.0f%s%.1f%s%.1f\n", EngineName, Sep, SerialSim, Sep, SerialSQ, Sep, Serialized, Sep, OverlapSim, Sep, OverlapSQ, Sep, Overlapped, Sep, Gain, Sep, Efficiency);
+	}
+
+	if(fp)
+		fclose(fp);
+}
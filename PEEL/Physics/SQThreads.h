@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SQ_THREADS_H
+#define SQ_THREADS_H
+
+#include "PintSQ.h"
+
+	// Multi-threaded scene queries. With gNbSQThreads>1, batches of queries from the SQ tests (DoBatchRaycasts() & co)
+	// are split in gNbSQThreads contiguous slices for engines flagged PINT_CONCURRENT_SQ. The main thread runs the first
+	// slice, pinned worker threads the others (same cores as the parallel engines threads), and each thread passes its own
+	// PintSQThreadContext to the engine. Other engines run the whole batch on the main thread, as before.
+	//
+	// Profiled test updates then measure the wall-clock time of the whole batch. When the test is closed, the last batch
+	// of each engine is replayed with 1 to gNbSQThreads threads and the resulting queries/second are printed & saved to
+	// Test_SQScaling.csv, see ReportSQScaling().
+	//
+	// In SQ_PROFILING_OVERLAP mode the last batch of each engine is also replayed on the workers, alternately during and
+	// after Pint::Update, to measure how much of the queries' cost the engine can hide behind its simulation.
+
+	extern	udword	gNbSQThreads;	// 1 = single-threaded queries (default), clamped to MAX_NB_SQ_THREADS
+
+	// Runs a batch of queries for this engine with gNbSQThreads threads & records it as the engine's last batch.
+	// Returns the total number of hits, as returned by the Pint::Batch* functions.
+	udword	RunSQBatch(Pint& pint, SQBatchType type, udword nb, const void* queries, void* hits);
+
+	// Runs a batch with up to nb_threads threads, without recording it.
+	udword	DispatchSQBatch(Pint& pint, const SQBatch& batch, udword nb_threads);
+
+	// Runs a batch on the SQ worker threads only (up to nb_threads of them, 1 for engines not flagged PINT_CONCURRENT_SQ)
+	// and returns immediately, so that the main thread can do something else in the meantime. WaitSQBatch() must be
+	// called before the next batch is started. It returns the total number of hits, and the timestamp at which the last
+	// worker was done (see ProfilingTimer::End()).
+	void	StartSQBatch(Pint& pint, const SQBatch& batch, udword nb_threads);
+	udword	WaitSQBatch(uqword& end_time);
+
+	// Replays the last batch of each engine with 1 to gNbSQThreads threads and reports the queries/second. Called when the
+	// running test is closed, does nothing if gNbSQThreads is 1 or no batch has been recorded.
+	void	ReportSQScaling();
+
+	// Compares the serialized & overlapped timings recorded in SQ_PROFILING_OVERLAP mode and reports them. Called when the
+	// running test is closed, does nothing in other modes.
+	void	ReportSQOverlap();
+
+	// Stops and releases all workers.
+	void	ReleaseSQThreads();
+
+#endif
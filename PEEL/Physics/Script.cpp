@@ -9,6 +9,9 @@
 #include "stdafx.h"
 #include "Script.h"
 #include "TestScenes.h"
+#include "BenchmarkStats.h"
+#include "RegressionGate.h"
+#include "PintSQ.h"
 
 static AutomatedTests* gAutomatedTests = null;
 
@@ -26,26 +29,79 @@ struct ParseContext
 {
 	ParseContext() :
 		mNbFrames		(0),
+		mWarmupFrames	(0),
+		mNbRepetitions	(1),
+		mConfidence		(DEFAULT_BENCHMARK_CONFIDENCE),
+		mMaxMedianRegression	(DEFAULT_MAX_MEDIAN_REGRESSION),
+		mMaxP99Regression		(DEFAULT_MAX_P99_REGRESSION),
+		mMaxMemoryRegression	(DEFAULT_MAX_MEMORY_REGRESSION),
 		mRendering		(false),
 		mRandomizeOrder	(false),
-		mTrashCache		(false)
+		mTrashCache		(false),
+		mParallelEngines(false),
+		mSimulationCores(0),
+		mWorkerCores	(0),
+		mRunPriority	(RUN_PRIORITY_NORMAL),
+		mLockGovernor	(false),
+		mAllocatorType	(PINT_ALLOCATOR_SYSTEM),
+		mAllocTracking	(false),
+		mNbSQThreads	(1),
+		mAsyncUpdates	(false),
+		mAsyncUpdateWork(0)
 	{
 	}
 
 	Container	mTests;
 	udword		mNbFrames;
+	udword		mWarmupFrames;
+	udword		mNbRepetitions;
+	float		mConfidence;
+	String		mResultsFilename;
+	String		mBaselineFilename;
+	float		mMaxMedianRegression;
+	float		mMaxP99Regression;
+	float		mMaxMemoryRegression;
 	bool		mRendering;
 	bool		mRandomizeOrder;
 	bool		mTrashCache;
+	bool		mParallelEngines;
+	uqword		mSimulationCores;
+	uqword		mWorkerCores;
+	RunPriority	mRunPriority;
+	bool		mLockGovernor;
+	PintAllocatorType	mAllocatorType;
+	bool		mAllocTracking;
+	udword		mNbSQThreads;
+	bool		mAsyncUpdates;
+	udword		mAsyncUpdateWork;
 };
 
 AutomatedTests::AutomatedTests(const ParseContext& ctx) :
 	mTests			(ctx.mTests),
 	mDefaultNbFrames(ctx.mNbFrames),
 	mIndex			(0),
+	mWarmupFrames	(ctx.mWarmupFrames),
+	mNbRepetitions	(ctx.mNbRepetitions),
+	mRepetition		(0),
+	mConfidence		(ctx.mConfidence),
+	mResultsFilename(ctx.mResultsFilename),
+	mBaselineFilename(ctx.mBaselineFilename),
+	mMaxMedianRegression(ctx.mMaxMedianRegression),
+	mMaxP99Regression(ctx.mMaxP99Regression),
+	mMaxMemoryRegression(ctx.mMaxMemoryRegression),
 	mRendering		(ctx.mRendering),
 	mRandomizeOrder	(ctx.mRandomizeOrder),
-	mTrashCache		(ctx.mTrashCache)
+	mTrashCache		(ctx.mTrashCache),
+	mParallelEngines(ctx.mParallelEngines),
+	mSimulationCores(ctx.mSimulationCores),
+	mWorkerCores	(ctx.mWorkerCores),
+	mRunPriority	(ctx.mRunPriority),
+	mLockGovernor	(ctx.mLockGovernor),
+	mAllocatorType	(ctx.mAllocatorType),
+	mAllocTracking	(ctx.mAllocTracking),
+	mNbSQThreads	(ctx.mNbSQThreads),
+	mAsyncUpdates	(ctx.mAsyncUpdates),
+	mAsyncUpdateWork(ctx.mAsyncUpdateWork)
 {
 }
 
@@ -80,9 +136,18 @@ AutomatedTest* AutomatedTests::GetCurrentTest() const
 AutomatedTest* AutomatedTests::SelectNextTest()
 {
 	mIndex++;
+	mRepetition = 0;
 	return GetCurrentTest();
 }
 
+bool AutomatedTests::SelectNextRepetition()
+{
+	if(mRepetition+1>=mNbRepetitions)
+		return false;
+	mRepetition++;
+	return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static PhysicsTest* FindTest(const char* name)
@@ -97,6 +162,26 @@ static PhysicsTest* FindTest(const char* name)
 	return null;
 }
 
+// The parser may split "2-5,8" at commas, so the parameters are joined back
+static bool ParseScriptCoreSet(const ParameterBlock& pb, uqword& cores, udword max_nb_cores)
+{
+	char Buffer[256];
+	Buffer[0] = 0;
+	udword Length = 0;
+	for(udword i=1;i<pb.GetNbParams();i++)
+	{
+		const char* Param = pb[i];
+		const udword ParamLength = udword(strlen(Param));
+		if(Length+ParamLength+2>sizeof(Buffer))
+			return false;
+		if(Length)
+			Buffer[Length++] = ',';
+		strcpy(Buffer+Length, Param);
+		Length += ParamLength;
+	}
+	return ParseCoreSet(Buffer, cores, max_nb_cores);
+}
+
 static bool gParseCallback(const char* command, const ParameterBlock& pb, udword context, void* user_data, const ParameterBlock* cmd)
 {
 	ParseContext* Context = (ParseContext*)user_data;
@@ -121,6 +206,48 @@ static bool gParseCallback(const char* command, const ParameterBlock& pb, udword
 	{
 		Context->mNbFrames = (sdword)pb[1];
 	}
+	else if(pb.GetNbParams()==2 && pb[0]=="Warmup")
+	{
+		const sdword NbFrames = (sdword)pb[1];
+		Context->mWarmupFrames = NbFrames>0 ? NbFrames : 0;
+	}
+	else if(pb.GetNbParams()==2 && pb[0]=="Repetitions")
+	{
+		const sdword NbRepetitions = (sdword)pb[1];
+		Context->mNbRepetitions = NbRepetitions>1 ? NbRepetitions : 1;
+	}
+	else if(pb.GetNbParams()==2 && pb[0]=="Confidence")
+	{
+		// Percentage, e.g. "Confidence 95". Fractions like 0.95 are accepted as well.
+		float Confidence = (float)pb[1];
+		if(Confidence>0.0f && Confidence<1.0f)
+			Confidence *= 100.0f;
+		if(Confidence>0.0f && Confidence<100.0f)
+			Context->mConfidence = Confidence;
+		else
+			printf(_F("Invalid confidence level in script:\n%s\n", command));
+	}
+	else if(pb.GetNbParams()==2 && pb[0]=="ResultsFile")
+	{
+		Context->mResultsFilename = pb[1];
+	}
+	else if(pb.GetNbParams()==2 && pb[0]=="Baseline")
+	{
+		Context->mBaselineFilename = pb[1];
+	}
+	// Maximum regressions in percents, a negative value disables the check
+	else if(pb.GetNbParams()==2 && pb[0]=="MaxMedianRegression")
+	{
+		Context->mMaxMedianRegression = (float)pb[1];
+	}
+	else if(pb.GetNbParams()==2 && pb[0]=="MaxP99Regression")
+	{
+		Context->mMaxP99Regression = (float)pb[1];
+	}
+	else if(pb.GetNbParams()==2 && pb[0]=="MaxMemoryRegression")
+	{
+		Context->mMaxMemoryRegression = (float)pb[1];
+	}
 	else if(pb.GetNbParams()==2 && pb[0]=="Rendering")
 	{
 		if(pb[1]=="true")
@@ -142,6 +269,64 @@ static bool gParseCallback(const char* command, const ParameterBlock& pb, udword
 		else if(pb[1]=="false")
 			Context->mTrashCache = false;
 	}
+	else if(pb.GetNbParams()==2 && pb[0]=="ParallelEngines")
+	{
+		if(pb[1]=="true")
+			Context->mParallelEngines = true;
+		else if(pb[1]=="false")
+			Context->mParallelEngines = false;
+	}
+	else if(pb.GetNbParams()==2 && pb[0]=="AllocTracking")
+	{
+		if(pb[1]=="true")
+			Context->mAllocTracking = true;
+		else if(pb[1]=="false")
+			Context->mAllocTracking = false;
+	}
+	// Core sets are lists of cores & ranges, e.g. "2-5,8"
+	else if(pb.GetNbParams()>=2 && (pb[0]=="SimulationCores" || pb[0]=="WorkerCores"))
+	{
+		const bool Simulation = pb[0]=="SimulationCores";
+		if(!ParseScriptCoreSet(pb, Simulation ? Context->mSimulationCores : Context->mWorkerCores, Simulation ? MAX_NB_CORES : MAX_NB_WORKER_CORES))
+			printf(_F("Invalid core set in script:\n%s\n", command));
+	}
+	else if(pb.GetNbParams()==2 && pb[0]=="Priority")
+	{
+		if(!ParseRunPriority(pb[1], Context->mRunPriority))
+			printf(_F("Invalid priority in script:\n%s\n", command));
+	}
+	else if(pb.GetNbParams()==2 && pb[0]=="LockGovernor")
+	{
+		if(pb[1]=="true")
+			Context->mLockGovernor = true;
+		else if(pb[1]=="false")
+			Context->mLockGovernor = false;
+	}
+	else if(pb.GetNbParams()==2 && pb[0]=="Allocator")
+	{
+		if(!ParseAllocatorType(pb[1], Context->mAllocatorType))
+			printf(_F("Invalid allocator in script:\n%s\n", command));
+	}
+	else if(pb.GetNbParams()==2 && pb[0]=="SQThreads")
+	{
+		const sdword NbThreads = (sdword)pb[1];
+		if(NbThreads>=1 && NbThreads<=MAX_NB_SQ_THREADS)
+			Context->mNbSQThreads = NbThreads;
+		else
+			printf(_F("Invalid number of SQ threads in script:\n%s\n", command));
+	}
+	// Main thread work in microseconds, e.g. "AsyncUpdates 2000"
+	else if(pb.GetNbParams()==2 && pb[0]=="AsyncUpdates")
+	{
+		const sdword Work = (sdword)pb[1];
+		if(Work>=0)
+		{
+			Context->mAsyncUpdates = true;
+			Context->mAsyncUpdateWork = Work;
+		}
+		else
+			printf(_F("Invalid async updates work in script:\n%s\n", command));
+	}
 	else
 	{
 		printf(_F("Unknown command in script:\n%s\n", command));
@@ -9,6 +9,8 @@
 #ifndef SCRIPT_H
 #define SCRIPT_H
 
+#include "RunConfig.h"
+
 	class PhysicsTest;
 	struct ParseContext;
 
@@ -27,13 +29,34 @@
 			bool			IsValid()			const;
 			AutomatedTest*	GetCurrentTest()	const;
 			AutomatedTest*	SelectNextTest();
+			// Returns true if the current test must be run again
+			bool			SelectNextRepetition();
 
 			Container		mTests;
 			udword			mDefaultNbFrames;
 			udword			mIndex;
+			udword			mWarmupFrames;
+			udword			mNbRepetitions;
+			udword			mRepetition;
+			float			mConfidence;
+			String			mResultsFilename;
+			String			mBaselineFilename;
+			float			mMaxMedianRegression;
+			float			mMaxP99Regression;
+			float			mMaxMemoryRegression;
 			bool			mRendering;
 			bool			mRandomizeOrder;
 			bool			mTrashCache;
+			bool			mParallelEngines;
+			uqword			mSimulationCores;
+			uqword			mWorkerCores;
+			RunPriority		mRunPriority;
+			bool			mLockGovernor;
+			PintAllocatorType	mAllocatorType;
+			bool			mAllocTracking;
+			udword			mNbSQThreads;
+			bool			mAsyncUpdates;
+			udword			mAsyncUpdateWork;
 	};
 
 	AutomatedTests* GetAutomatedTests();
@@ -0,0 +1,984 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdafx.h"
+#include "Simulation.h"
+#include "Render.h"
+#include "TestScenes.h"
+#include "TrashCache.h"
+#include "EngineThreads.h"
+#include "SQThreads.h"
+#include "RunConfig.h"
+#include "PintCapture.h"
+#include "Determinism.h"
+
+EngineData			gEngines[MAX_NB_ENGINES];
+udword				gNbEngines = 0;
+PintPlugin*			gPlugIns[MAX_NB_ENGINES];
+udword				gNbPlugIns = 0;
+udword				gFrameNb = 0;
+udword				gNbSimulateCallsPerFrame = 1;
+float				gTimestep = 1.0f/60.0f;
+PhysicsTest*		gRunningTest = null;
+ProfilingUnits		gProfilingUnits = PROFILING_UNITS_RDTSC;
+SQProfilingMode		gSQProfilingMode = SQ_PROFILING_UPDATE;
+bool				gPaused = false;
+bool				gRandomizeOrder = false;
+bool				gTrashCache = false;
+bool				gCommaSeparator = false;
+bool				gHardwareCounters = false;
+bool				gAllocTracking = false;
+udword				gWarmupFrames = 0;
+bool				gWarmingUp = false;
+bool				gParallelEngines = false;
+bool				gAsyncUpdates = false;
+udword				gAsyncUpdateWork = 0;
+const char*			gResultsSuffix = null;
+const char*			gCaptureFilename = null;
+udword				gNbWorkerThreads = INVALID_ID;
+
+const char* GetSQProfilingModeName(SQProfilingMode mode)
+{
+	switch(mode)
+	{
+		case SQ_PROFILING_SIM:		return "Sim";
+		case SQ_PROFILING_UPDATE:	return "Update";
+		case SQ_PROFILING_COMBINED:	return "Combined";
+		case SQ_PROFILING_OVERLAP:	return "Overlap";
+	};
+	return null;
+}
+
+bool ParseSQProfilingMode(const char* text, SQProfilingMode& mode)
+{
+	if(!text)
+		return false;
+	for(udword i=SQ_PROFILING_SIM;i<=SQ_PROFILING_OVERLAP;i++)
+	{
+		if(_stricmp(text, GetSQProfilingModeName(SQProfilingMode(i)))==0)
+		{
+			mode = SQProfilingMode(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+typedef PintPlugin* (*GetPintPlugin)	();
+
+static PintPlugin* LoadPlugIn(const char* filename)
+{
+/*	LIBRARY LibHandle;
+	if(!IceCore::LoadLibrary(filename, LibHandle, true))
+		return null;
+
+	GetPintPlugin func = (GetPintPlugin)BindSymbol(LibHandle, "GetPintPlugin");
+	if(!func)
+	{
+		UnloadLibrary(LibHandle);
+		return null;
+	}
+	return (func)();*/
+
+	udword FPUEnv[256];
+	FillMemory(FPUEnv, 256*4, 0xff);
+	__asm fstenv FPUEnv
+		HMODULE handle = ::LoadLibraryA(filename);
+	__asm fldenv FPUEnv
+	if(!handle)
+	{
+		printf("WARNING: plugin %s failed to load.\n", filename);
+		return null;
+	}
+	GetPintPlugin func = (GetPintPlugin)GetProcAddress(handle, "GetPintPlugin");
+	if(!func)
+	{
+		printf("WARNING: plugin %s is invalid.\n", filename);
+		FreeLibrary(handle);
+		return null;
+	}
+	return (func)();
+}
+
+void RegisterPlugIn(const char* filename)
+{
+	if(gNbPlugIns==MAX_NB_ENGINES)
+	{
+		printf("WARNING: too many plugins, %s ignored.\n", filename);
+		return;
+	}
+
+	PintPlugin* pp = LoadPlugIn(filename);
+	if(pp)
+	{
+		printf(_F("Plugin found: %s\n", filename));
+		gPlugIns[gNbPlugIns++] = pp;
+	}
+}
+
+void SetupWorldDesc(PINT_WORLD_CREATE& desc, const char* test_name)
+{
+	class Access : public PINT_WORLD_CREATE
+	{
+		public:
+		void SetName(const char* name)					{ mTestName = name;					}
+		void SetWorkerThreadAffinity(udword affinity)	{ mWorkerThreadAffinity = affinity;	}
+		void SetAllocatorType(PintAllocatorType type)	{ mAllocatorType = type;			}
+		void SetNbWorkerThreads(udword nb)				{ mNbWorkerThreads = nb;			}
+		void SetAllocTracking(bool enabled)				{ mAllocTracking = enabled;			}
+	};
+	static_cast<Access&>(desc).SetName(test_name);
+	// Pint-side masks are 32 bits, like the engines' thread pool APIs. Higher cores are rejected when parsing core sets.
+	ASSERT(!(gWorkerCores>>MAX_NB_WORKER_CORES));
+	static_cast<Access&>(desc).SetWorkerThreadAffinity(udword(gWorkerCores));
+	static_cast<Access&>(desc).SetAllocatorType(gAllocatorType);
+	static_cast<Access&>(desc).SetNbWorkerThreads(gNbWorkerThreads);
+	static_cast<Access&>(desc).SetAllocTracking(gAllocTracking);
+}
+
+void GetTestSceneParams(PhysicsTest* test, PINT_WORLD_CREATE& desc)
+{
+	ASSERT(test);
+	test->GetSceneParams(desc);
+	SetupWorldDesc(desc, test->GetName());
+}
+
+static PINT_WORLD_CREATE	gWorldDesc;
+static PintRecorder*		gRecorder = null;
+
+const PINT_WORLD_CREATE& GetWorldDesc()
+{
+	return gWorldDesc;
+}
+
+void InitEngines(const PINT_WORLD_CREATE& desc)
+{
+	gWorldDesc = desc;
+
+	for(udword i=0;i<gNbPlugIns;i++)
+		gPlugIns[i]->Init(desc);
+
+	gNbSimulateCallsPerFrame = desc.mNbSimulateCallsPerFrame;
+	gTimestep = desc.mTimestep;
+
+	gNbEngines = 0;
+	for(udword i=0;i<gNbPlugIns;i++)
+	{
+		ASSERT(gNbEngines!=MAX_NB_ENGINES);
+		Pint* Engine = gPlugIns[i]->GetPint();
+		ASSERT(Engine);
+		// The recorder replaces the first engine before the helpers are bound, so that it sees all the calls
+		if(!i && gCaptureFilename)
+		{
+			ASSERT(!gRecorder);
+			gRecorder = ICE_NEW(PintRecorder)(*Engine);
+			if(gRecorder->Open(gCaptureFilename, desc))
+			{
+				printf("Capturing %s calls to %s\n", Engine->GetName(), gCaptureFilename);
+				Engine = gRecorder;
+			}
+			else
+			{
+				printf("WARNING: cannot create capture file %s\n", gCaptureFilename);
+				DELETESINGLE(gRecorder);
+			}
+		}
+		gEngines[gNbEngines].mOMHelper.Init(Engine);
+		gEngines[gNbEngines].mSQHelper.Init(Engine);
+		gEngines[gNbEngines].mPlugIn = gPlugIns[i];
+		gEngines[gNbEngines++].mEngine = Engine;
+	}
+}
+
+void CloseRunningTest()
+{
+	if(gRunningTest)
+	{
+		// Before Close(), while the test's queries & objects are still around
+		ReportSQScaling();
+		ReportSQOverlap();
+		ReportDeterminism();
+
+		for(udword i=0;i<gNbEngines;i++)
+		{
+			ASSERT(gEngines[i].mEngine);
+			gRunningTest->Close(*gEngines[i].mEngine);
+		}
+		gRunningTest->CommonRelease();
+	}
+}
+
+void ResetSQHelpersHitData()
+{
+	for(udword i=0;i<gNbEngines;i++)
+		gEngines[i].mSQHelper.ResetHitData();
+}
+
+void CloseEngines()
+{
+	CloseRunningTest();
+
+	for(udword i=0;i<gNbEngines;i++)
+	{
+		gEngines[i].mOMHelper.Reset();
+		gEngines[i].mSQHelper.Reset();
+	}
+
+	ReleaseEngineThreads();
+	ReleaseSQThreads();
+
+	// Before the plugins release the recorded engine
+	DELETESINGLE(gRecorder);
+
+	for(udword i=0;i<gNbPlugIns;i++)
+		gPlugIns[i]->Close();
+
+	ReleaseAllShapeRenderers();
+}
+
+void ResetTimers()
+{
+	gFrameNb = 0;
+	for(udword i=0;i<gNbEngines;i++)
+	{
+		gEngines[i].mTiming.ResetTimings();
+		gEngines[i].mSQOverlap.Reset();
+	}
+}
+
+bool EnableHardwareCounters(bool enabled)
+{
+	if(enabled)
+		gHardwareCounters = InitHardwareCounters();
+	else
+		gHardwareCounters = false;
+	return gHardwareCounters;
+}
+
+void StartTest(PhysicsTest* test)
+{
+	gRunningTest = test;
+	ResetTimers();
+	gWarmingUp = gWarmupFrames!=0;
+	if(!gRunningTest)
+		return;
+
+	gRunningTest->CommonSetup();
+	for(udword i=0;i<gNbEngines;i++)
+	{
+		ASSERT(gEngines[i].mEngine);
+		gEngines[i].mSupportsCurrentTest = gRunningTest->Init(*gEngines[i].mEngine);
+	}
+	StartDeterminismRun();
+}
+
+// Null when allocation tracking is disabled: the engines' trackers then stay at 0, and the memory comes from
+// Pint::Update()'s return value instead.
+static inline_ const PintAllocStats* GetTrackedAllocStats(Pint& engine)
+{
+	return gAllocTracking ? engine.GetAllocStats() : null;
+}
+
+static udword ProfileUpdate(EngineData& engine, float dt, bool record_counters)
+{
+	const ProfilingTimer& Timer = GetProfilingTimer(gProfilingUnits);
+
+	// Counters are read outside of the timed section, to keep the syscalls out of the recorded time
+	HardwareCounterValues CountersStart;
+	if(record_counters)
+		ReadHardwareCounters(CountersStart);
+
+	// Same for the allocation stats, which are only copied here
+	const PintAllocStats* AllocStats = GetTrackedAllocStats(*engine.mEngine);
+	PintAllocStats AllocStatsStart;
+	if(AllocStats)
+		AllocStatsStart = *AllocStats;
+
+	const uqword Start = Timer.Start();
+		const udword CurrentMemory = engine.mEngine->Update(dt);
+	const udword Time = Timer.GetElapsed(Start);
+
+	if(record_counters)
+	{
+		HardwareCounterValues CountersEnd, Delta;
+		ReadHardwareCounters(CountersEnd);
+		GetHardwareCountersDelta(Delta, CountersStart, CountersEnd);
+		engine.mTiming.RecordCounters(Delta, gFrameNb);
+	}
+
+	// The 32-bit value returned by Update() wraps past 4 GB, the tracked value doesn't
+	uqword UsedMemory = CurrentMemory;
+	if(AllocStats)
+	{
+		const PintAllocStats AllocStatsEnd = *AllocStats;
+		engine.mTiming.RecordAllocations(AllocStatsStart, AllocStatsEnd, gFrameNb);
+		UsedMemory = AllocStatsEnd.mCurrentBytes;
+	}
+
+	engine.mTiming.RecordTimeAndMemory(PINT_TIMING_SIMULATE, Time, UsedMemory, gFrameNb);
+	return Time;
+}
+
+static void NoProfileUpdate(EngineData& engine, float dt)
+{
+	engine.mEngine->Update(dt);
+}
+
+// In "combined" mode the test update time is added to the simulation time recorded by ProfileUpdate().
+static udword ProfileTestUpdate(PhysicsTest* test, EngineData& engine, float dt, bool combined)
+{
+	const ProfilingTimer& Timer = GetProfilingTimer(gProfilingUnits);
+
+	const uqword Start = Timer.Start();
+		const udword TestResult = test->Update(*engine.mEngine, dt);
+	const udword Time = Timer.GetElapsed(Start);
+
+	if(combined)
+		engine.mTiming.UpdateRecordedTime(PINT_TIMING_TEST_UPDATE, Time, gFrameNb);
+	else
+		engine.mTiming.RecordTimeAndMemory(PINT_TIMING_TEST_UPDATE, Time, 0, gFrameNb);
+	engine.mTiming.RecordTestResult(TestResult, gFrameNb);
+	return Time;
+}
+
+static inline_ bool IsOverlapProfiled(bool must_profile_test_update)
+{
+	return must_profile_test_update && gSQProfilingMode==SQ_PROFILING_OVERLAP && !gParallelEngines;
+}
+
+// Runs the engine's last batch of queries (from the previous frame) during or after Pint::Update, see Simulate().
+static void OverlapUpdate(EngineData& engine, float dt, bool record_counters)
+{
+	const SQBatch& Batch = engine.mSQHelper.GetLastBatch();
+	if(!Batch.mNb)
+	{
+		ProfileUpdate(engine, dt, record_counters);
+		return;
+	}
+
+	const ProfilingTimer& Timer = GetProfilingTimer(gProfilingUnits);
+	Pint& Engine = *engine.mEngine;
+	SQOverlapStats& Stats = engine.mSQOverlap;
+
+	if(!(Engine.GetFlags() & PINT_SQ_DURING_UPDATE))
+	{
+		// Queries must not run during the update: serialized frames only, and the queries run like the test's
+		const udword SimTime = ProfileUpdate(engine, dt, record_counters);
+
+		const uqword Start = Timer.Start();
+			DispatchSQBatch(Engine, Batch, gNbSQThreads);
+		const udword SQTime = Timer.GetElapsed(Start);
+
+		Stats.mSerialSim.Record(SimTime);
+		Stats.mSerialSQ.Record(SQTime);
+		engine.mTiming.UpdateRecordedTime(PINT_TIMING_TEST_UPDATE, SQTime, gFrameNb);
+		return;
+	}
+
+	// Both kinds of frames use the same worker threads, so that only the overlap differs
+	if(gFrameNb&1)
+	{
+		const PintAllocStats* AllocStats = GetTrackedAllocStats(Engine);
+
+		// Counters are recorded on both kinds of frames. They are per-thread here: the SQ workers are persistent
+		// threads, whose inherited counts only reach the main thread when they exit, so only the batch dispatch
+		// is added to the update on this side.
+		HardwareCounterValues CountersStart;
+		if(record_counters)
+			ReadHardwareCounters(CountersStart);
+
+		const uqword Start = Timer.Start();
+		StartSQBatch(Engine, Batch, gNbSQThreads);
+			const udword CurrentMemory = Engine.Update(dt);
+		const uqword SimEnd = Timer.End();
+
+		if(record_counters)
+		{
+			HardwareCounterValues CountersEnd, Delta;
+			ReadHardwareCounters(CountersEnd);
+			GetHardwareCountersDelta(Delta, CountersStart, CountersEnd);
+			engine.mTiming.RecordCounters(Delta, gFrameNb);
+		}
+
+		uqword SQEnd;
+		WaitSQBatch(SQEnd);
+
+		const udword SimTime = Timer.ToUnits(Timer.GetTicks(Start, SimEnd));
+		const udword SQTime = Timer.ToUnits(Timer.GetTicks(Start, SQEnd));
+		const udword WallTime = TMax(SimTime, SQTime);
+
+		Stats.mOverlapSim.Record(SimTime);
+		Stats.mOverlapSQ.Record(SQTime);
+		Stats.mOverlapWall.Record(WallTime);
+
+		engine.mTiming.RecordTimeAndMemory(PINT_TIMING_SIMULATE, SimTime, AllocStats ? AllocStats->mCurrentBytes : CurrentMemory, gFrameNb);
+		engine.mTiming.UpdateRecordedTime(PINT_TIMING_TEST_UPDATE, WallTime - SimTime, gFrameNb);
+	}
+	else
+	{
+		const udword SimTime = ProfileUpdate(engine, dt, record_counters);
+
+		const uqword Start = Timer.Start();
+		StartSQBatch(Engine, Batch, gNbSQThreads);
+		uqword SQEnd;
+		WaitSQBatch(SQEnd);
+		const udword SQTime = Timer.ToUnits(Timer.GetTicks(Start, SQEnd));
+
+		Stats.mSerialSim.Record(SimTime);
+		Stats.mSerialSQ.Record(SQTime);
+		engine.mTiming.UpdateRecordedTime(PINT_TIMING_TEST_UPDATE, SQTime, gFrameNb);
+	}
+}
+
+static void SimulateEngine(EngineData& engine, float dt, bool must_profile_test_update, bool record_counters)
+{
+	ASSERT(engine.mEngine);
+	if(IsOverlapProfiled(must_profile_test_update))
+	{
+		OverlapUpdate(engine, dt, record_counters);
+	}
+	else if(	must_profile_test_update
+			&&	gSQProfilingMode==SQ_PROFILING_UPDATE)
+	{
+		NoProfileUpdate(engine, dt);
+	}
+	else
+	{
+		ProfileUpdate(engine, dt, record_counters);
+	}
+//	printf(_F("%s: %d (Avg: %d)(Worst: %d)\n", engine.mEngine->GetName(), CurrentTime, engine.mTiming.GetAvgTime(), engine.mTiming.GetWorstTime()));
+
+	engine.mEngine->UpdateNonProfiled(dt);
+}
+
+static inline_ bool IsEngineSimulated(udword i)
+{
+	return gEngines[i].mEnabled && gEngines[i].mSupportsCurrentTest;
+}
+
+static inline_ bool IsMainThreadOnly(udword i)
+{
+	return (gEngines[i].mEngine->GetFlags() & PINT_MAIN_THREAD_ONLY)!=0;
+}
+
+static inline_ bool IsAsyncUpdate(bool must_profile_test_update)
+{
+	if(!gAsyncUpdates || gParallelEngines)
+		return false;
+	// These modes don't profile the simulation of SQ tests the usual way
+	return !must_profile_test_update || gSQProfilingMode==SQ_PROFILING_SIM || gSQProfilingMode==SQ_PROFILING_COMBINED;
+}
+
+static void BusyWait(udword microseconds)
+{
+	if(!microseconds)
+		return;
+
+	const ProfilingTimer& Timer = GetProfilingTimer(gProfilingUnits);
+	const uqword Ticks = uqword(double(microseconds)*double(Timer.mFrequency)/1000000.0);
+	const uqword Start = Timer.Start();
+	while(Timer.GetElapsedTicks(Start)<Ticks);
+}
+
+namespace
+{
+	struct AsyncStep
+	{
+		uqword					mStart;
+		uqword					mBlockingTicks;
+		udword					mMemory;
+		PintAllocStats			mAllocStatsStart;
+		HardwareCounterValues	mCounters;		// Sum over the blocking calls, like mBlockingTicks
+	};
+}
+
+// Starts the steps of all engines, runs the test's common update & the main thread work, then collects the results.
+// Hardware counters cover the blocking calls only (BeginUpdate & EndUpdate, or Update), as the recorded times do.
+static void AsyncUpdate(const Permutation& P, float dt)
+{
+	const ProfilingTimer& Timer = GetProfilingTimer(gProfilingUnits);
+	const bool RecordCounters = gHardwareCounters;
+
+	AsyncStep Steps[MAX_NB_ENGINES];
+	for(udword ii=0;ii<gNbEngines;ii++)
+	{
+		const udword i = P[ii];
+		if(!IsEngineSimulated(i))
+			continue;
+
+		Pint& Engine = *gEngines[i].mEngine;
+		AsyncStep& Step = Steps[i];
+
+		// Before each engine's step like in serial mode, although the engines started before are still running
+		if(gTrashCache)
+			trashCache();
+
+		HardwareCounterValues CountersStart;
+		if(RecordCounters)
+			ReadHardwareCounters(CountersStart);
+
+		const PintAllocStats* AllocStats = GetTrackedAllocStats(Engine);
+		if(AllocStats)
+			Step.mAllocStatsStart = *AllocStats;
+
+		Step.mStart = Timer.Start();
+		if(Engine.GetFlags() & PINT_ASYNC_UPDATE)
+		{
+			Engine.BeginUpdate(dt);
+			Step.mMemory = 0;
+		}
+		else
+		{
+			Step.mMemory = Engine.Update(dt);
+		}
+		Step.mBlockingTicks = Timer.GetElapsedTicks(Step.mStart);
+
+		if(RecordCounters)
+		{
+			HardwareCounterValues CountersEnd;
+			ReadHardwareCounters(CountersEnd);
+			GetHardwareCountersDelta(Step.mCounters, CountersStart, CountersEnd);
+		}
+	}
+
+	if(gRunningTest)
+		gRunningTest->CommonUpdate(dt);
+	BusyWait(gAsyncUpdateWork);
+
+	for(udword ii=0;ii<gNbEngines;ii++)
+	{
+		const udword i = P[ii];
+		if(!IsEngineSimulated(i))
+			continue;
+
+		EngineData& Data = gEngines[i];
+		Pint& Engine = *Data.mEngine;
+		AsyncStep& Step = Steps[i];
+
+		uqword CriticalPathTicks = Step.mBlockingTicks;
+		if(Engine.GetFlags() & PINT_ASYNC_UPDATE)
+		{
+			HardwareCounterValues CountersStart;
+			if(RecordCounters)
+				ReadHardwareCounters(CountersStart);
+
+			const uqword Start = Timer.Start();
+				Step.mMemory = Engine.EndUpdate();
+			const uqword End = Timer.End();
+			Step.mBlockingTicks += Timer.GetTicks(Start, End);
+			CriticalPathTicks = Timer.GetTicks(Step.mStart, End);
+
+			if(RecordCounters)
+			{
+				HardwareCounterValues CountersEnd, Delta;
+				ReadHardwareCounters(CountersEnd);
+				GetHardwareCountersDelta(Delta, CountersStart, CountersEnd);
+				for(udword j=0;j<HW_COUNTER_COUNT;j++)
+					Step.mCounters.mValues[j] += Delta.mValues[j];
+			}
+		}
+		if(RecordCounters)
+			Data.mTiming.RecordCounters(Step.mCounters, gFrameNb);
+
+		uqword UsedMemory = Step.mMemory;
+		const PintAllocStats* AllocStats = GetTrackedAllocStats(Engine);
+		if(AllocStats)
+		{
+			const PintAllocStats AllocStatsEnd = *AllocStats;
+			Data.mTiming.RecordAllocations(Step.mAllocStatsStart, AllocStatsEnd, gFrameNb);
+			UsedMemory = AllocStatsEnd.mCurrentBytes;
+		}
+
+		Data.mTiming.RecordTimeAndMemory(PINT_TIMING_SIMULATE, Timer.ToUnits(Step.mBlockingTicks), UsedMemory, gFrameNb);
+		Data.mTiming.RecordPhaseTime(PINT_TIMING_CRITICAL_PATH, Timer.ToUnits(CriticalPathTicks));
+
+		Engine.UpdateNonProfiled(dt);
+	}
+}
+
+namespace
+{
+	struct ParallelFrame
+	{
+		float	mDt;
+		bool	mMustProfileTestUpdate;
+	};
+}
+
+// Runs on engine threads
+static void gSimulateEngineTask(udword i, void* user_data)
+{
+	const ParallelFrame* Frame = (const ParallelFrame*)user_data;
+	if(IsEngineSimulated(i) && !IsMainThreadOnly(i))
+		SimulateEngine(gEngines[i], Frame->mDt, Frame->mMustProfileTestUpdate, false);
+}
+
+const char* GetHardwareCountersScope()
+{
+	const bool MustProfileTestUpdate = gRunningTest ? gRunningTest->ProfileUpdate() : false;
+	if(IsAsyncUpdate(MustProfileTestUpdate))
+		return "Pint::BeginUpdate & EndUpdate";
+	if(IsOverlapProfiled(MustProfileTestUpdate))
+		return "Pint::Update, serialized & overlapped frames, the latter with the SQ batch dispatch";
+	return "Pint::Update";
+}
+
+void Simulate()
+{
+	if(gPaused)
+		return;
+
+	const float dt = gTimestep;
+
+	Permutation P;
+	P.Init(gNbEngines);
+	if(gRandomizeOrder)
+		P.Random(gNbEngines*2);
+	else
+		P.Identity();
+
+	const bool MustProfileTestUpdate = gRunningTest ? gRunningTest->ProfileUpdate() : false;
+	const bool AsyncUpdates = IsAsyncUpdate(MustProfileTestUpdate);
+
+	if(gParallelEngines)
+	{
+		ParallelFrame Frame;
+		Frame.mDt					= dt;
+		Frame.mMustProfileTestUpdate	= MustProfileTestUpdate;
+		RunEngineTasks(gNbEngines, gSimulateEngineTask, &Frame);
+
+		// Engines that aren't thread-safe are isolated: they run alone, once the others are done
+		for(udword ii=0;ii<gNbEngines;ii++)
+		{
+			const udword i = P[ii];
+			if(IsEngineSimulated(i) && IsMainThreadOnly(i))
+				SimulateEngine(gEngines[i], dt, MustProfileTestUpdate, false);
+		}
+	}
+	else if(AsyncUpdates)
+	{
+		AsyncUpdate(P, dt);
+	}
+	else
+	{
+		for(udword ii=0;ii<gNbEngines;ii++)
+		{
+			const udword i = P[ii];
+			if(!IsEngineSimulated(i))
+				continue;
+
+			SimulateEngine(gEngines[i], dt, MustProfileTestUpdate, gHardwareCounters);
+
+			if(gTrashCache)
+				trashCache();
+//				trashIcacheAndBranchPredictors();
+		}
+	}
+
+	udword CurrentTime;
+	if(gRunningTest)
+	{
+		// Already done during the steps in async mode
+		if(!AsyncUpdates)
+			gRunningTest->CommonUpdate(dt);
+		for(udword ii=0;ii<gNbEngines;ii++)
+		{
+			const udword i = P[ii];
+			if(!gEngines[i].mEnabled || !gEngines[i].mSupportsCurrentTest)
+				continue;
+
+			ASSERT(gEngines[i].mEngine);
+			if(MustProfileTestUpdate)
+			{
+				if(gSQProfilingMode==SQ_PROFILING_SIM || gSQProfilingMode==SQ_PROFILING_OVERLAP)
+				{
+					gEngines[i].mTiming.RecordTestResult(gRunningTest->Update(*gEngines[i].mEngine, dt), gFrameNb);
+				}
+				else
+				{
+					CurrentTime = ProfileTestUpdate(gRunningTest, gEngines[i], dt, gSQProfilingMode==SQ_PROFILING_COMBINED);
+				}
+			}
+			else
+			{
+				// Normal update without profiling
+				gRunningTest->Update(*gEngines[i].mEngine, dt);
+			}
+		}
+	}
+
+	// Outside of the timed sections, once the test's update has run for all engines
+	RecordDeterminismFrame();
+
+	for(udword i=0;i<gNbEngines;i++)
+		gEngines[i].mTiming.EndFrame();
+
+	gFrameNb++;
+
+	if(gWarmingUp && gFrameNb>=gWarmupFrames)
+	{
+		gWarmingUp = false;
+		ResetTimers();
+	}
+}
+
+const char* GetTestCSVFilename(const char* postfix)
+{
+	ASSERT(gRunningTest);
+
+	static char Filename[1024];
+	_snprintf(Filename, sizeof(Filename)-1, ".\\%s%s%s%s%s%s.csv",
+		gRunningTest->GetName(),
+		gRunningTest->GetSubName() ? "_" : "", gRunningTest->GetSubName() ? gRunningTest->GetSubName() : "",
+		gResultsSuffix ? "_" : "", gResultsSuffix ? gResultsSuffix : "",
+		postfix ? postfix : "");
+	Filename[sizeof(Filename)-1] = 0;
+	return Filename;
+}
+
+bool TestCSVExport()
+{
+	if(!gRunningTest)
+		return false;
+
+	FILE* globalFile = fopen(GetTestCSVFilename(null), "w");
+	if(!globalFile)
+		return false;
+
+	const ProfilingTimer& Timer = GetProfilingTimer(gProfilingUnits);
+	fprintf_s(globalFile, "%s (%s)\n", gRunningTest->GetName(), Timer.mUnits);
+	fprintf_s(globalFile, "(Timer: %s, %.3f MHz, overhead: %.1f ns)\n\n", Timer.mName, double(Timer.mFrequency)/1000000.0, Timer.ToNanoseconds(Timer.mOverhead));
+	if(gParallelEngines)
+		fprintf_s(globalFile, "(Parallel engines: each engine simulated on its own thread, timings include interference between engines)\n\n");
+	{
+		const RunConfigStatus& RunConfig = GetRunConfigStatus();
+		char SimulationCores[256];
+		char WorkerCores[256];
+		GetCoreSetString(gSimulationCores, SimulationCores, sizeof(SimulationCores));
+		GetCoreSetString(gWorkerCores, WorkerCores, sizeof(WorkerCores));
+		fprintf_s(globalFile, "(Simulation cores: %s, worker cores: %s, priority: %s, allocator: %s, governor: %s%s, %d/%d MHz%s)\n\n",
+			gSimulationCores ? SimulationCores : "any", gWorkerCores ? WorkerCores : "any", GetRunPriorityName(RunConfig.mPriority), GetAllocatorTypeName(gAllocatorType),
+			RunConfig.mGovernor, RunConfig.mGovernorLocked ? " (locked)" : "", RunConfig.mCurrentMHz, RunConfig.mMaxMHz,
+			RunConfig.mFrequencyWarning ? ", WARNING: frequency scaling active" : "");
+	}
+
+	const udword NbFrames = gFrameNb<=MAX_NB_RECORDED_FRAMES ? gFrameNb : MAX_NB_RECORDED_FRAMES;
+	if(NbFrames!=gFrameNb)
+		fprintf_s(globalFile, "(Per-frame data limited to the first %d frames. Statistics below cover all %d frames.)\n\n", NbFrames, gFrameNb);
+
+	for(udword b=0;b<gNbEngines;b++)
+	{
+		if(!gEngines[b].mEnabled || !gEngines[b].mSupportsCurrentTest || !(gEngines[b].mEngine->GetFlags() & PINT_IS_ACTIVE))
+			continue;
+
+		if(gCommaSeparator)
+			fprintf_s(globalFile, "%s, ", gEngines[b].mEngine->GetName());
+		else
+			fprintf_s(globalFile, "%s; ", gEngines[b].mEngine->GetName());
+
+		for(udword i=0;i<NbFrames;i++)
+		{
+			if(gCommaSeparator)
+				fprintf_s(globalFile, "%d, ", gEngines[b].mTiming.mRecorded[i].mTime);
+			else
+				fprintf_s(globalFile, "%d; ", gEngines[b].mTiming.mRecorded[i].mTime);
+		}
+		fprintf_s(globalFile, "\n");
+	}
+
+	fprintf_s(globalFile, "\n\n");
+
+	fprintf_s(globalFile, "Memory usage (Kb):\n\n");
+
+	for(udword b=0;b<gNbEngines;b++)
+	{
+		if(!gEngines[b].mEnabled || !gEngines[b].mSupportsCurrentTest || !(gEngines[b].mEngine->GetFlags() & PINT_IS_ACTIVE))
+			continue;
+
+		if(gCommaSeparator)
+			fprintf_s(globalFile, "%s, ", gEngines[b].mEngine->GetName());
+		else
+			fprintf_s(globalFile, "%s; ", gEngines[b].mEngine->GetName());
+
+		for(udword i=0;i<NbFrames;i++)
+		{
+			if(gCommaSeparator)
+				fprintf_s(globalFile, "%d, ", udword(gEngines[b].mTiming.mRecorded[i].mUsedMemory/1024));
+			else
+				fprintf_s(globalFile, "%d; ", udword(gEngines[b].mTiming.mRecorded[i].mUsedMemory/1024));
+		}
+		fprintf_s(globalFile, "\n");
+	}
+
+	fprintf_s(globalFile, "\n\n");
+
+	const char* Sep = gCommaSeparator ? ", " : "; ";
+
+	bool HasAllocations = false;
+	for(udword b=0;b<gNbEngines;b++)
+	{
+		if(gEngines[b].mTiming.HasAllocations() && gEngines[b].mTiming.mRecordedAllocs)
+			HasAllocations = true;
+	}
+
+	if(HasAllocations)
+	{
+		fprintf_s(globalFile, "Allocations (Pint::Update, per frame):\n\n");
+
+		for(udword b=0;b<gNbEngines;b++)
+		{
+			const PintTiming& Timing = gEngines[b].mTiming;
+			if(!gEngines[b].mEnabled || !gEngines[b].mSupportsCurrentTest || !(gEngines[b].mEngine->GetFlags() & PINT_IS_ACTIVE) || !Timing.mRecordedAllocs)
+				continue;
+
+			const char* EngineName = gEngines[b].mEngine->GetName();
+			fprintf_s(globalFile, "%s - Nb allocs%s", EngineName, Sep);
+			for(udword i=0;i<NbFrames;i++)
+				fprintf_s(globalFile, "%d%s", Timing.mRecordedAllocs[i].mNbAllocs, Sep);
+			fprintf_s(globalFile, "\n%s - Nb frees%s", EngineName, Sep);
+			for(udword i=0;i<NbFrames;i++)
+				fprintf_s(globalFile, "%d%s", Timing.mRecordedAllocs[i].mNbFrees, Sep);
+			fprintf_s(globalFile, "\n%s - Allocated bytes%s", EngineName, Sep);
+			for(udword i=0;i<NbFrames;i++)
+				fprintf_s(globalFile, "%llu%s", Timing.mRecordedAllocs[i].mAllocatedBytes, Sep);
+			fprintf_s(globalFile, "\n%s - Freed bytes%s", EngineName, Sep);
+			for(udword i=0;i<NbFrames;i++)
+				fprintf_s(globalFile, "%llu%s", Timing.mRecordedAllocs[i].mFreedBytes, Sep);
+			fprintf_s(globalFile, "\n");
+		}
+
+		fprintf_s(globalFile, "\nAllocation totals:\n\n");
+		fprintf_s(globalFile, "Engine%sNb allocs%sNb frees%sAllocated bytes%sFreed bytes%sPeak bytes%sAllocs/frame p50%sAllocs/frame p99%sAllocs/frame max", Sep, Sep, Sep, Sep, Sep, Sep, Sep, Sep);
+		for(udword j=0;j<PINT_NB_ALLOC_SIZE_CLASSES;j++)
+		{
+			const udword Limit = GetPintAllocSizeClassLimit(j);
+			if(Limit)
+				fprintf_s(globalFile, "%s<=%d", Sep, Limit);
+			else
+				fprintf_s(globalFile, "%s>%d", Sep, GetPintAllocSizeClassLimit(j-1));
+		}
+		fprintf_s(globalFile, "\n");
+
+		for(udword b=0;b<gNbEngines;b++)
+		{
+			const PintTiming& Timing = gEngines[b].mTiming;
+			if(!gEngines[b].mEnabled || !gEngines[b].mSupportsCurrentTest || !(gEngines[b].mEngine->GetFlags() & PINT_IS_ACTIVE) || !Timing.HasAllocations())
+				continue;
+
+			const PintAllocStats& Totals = Timing.mTotalAllocs;
+			const PintHistogram& H = Timing.mAllocsHistogram;
+			fprintf_s(globalFile, "%s%s%llu%s%llu%s%llu%s%llu%s%llu%s%d%s%d%s%d", gEngines[b].mEngine->GetName(), Sep,
+				Totals.mNbAllocs, Sep, Totals.mNbFrees, Sep, Totals.mAllocatedBytes, Sep, Totals.mFreedBytes, Sep, Totals.mPeakBytes, Sep,
+				H.GetPercentile(50.0f), Sep, H.GetPercentile(99.0f), Sep, H.GetMax());
+			for(udword j=0;j<PINT_NB_ALLOC_SIZE_CLASSES;j++)
+				fprintf_s(globalFile, "%s%llu", Sep, Totals.mSizeClasses[j]);
+			fprintf_s(globalFile, "\n");
+		}
+
+		fprintf_s(globalFile, "\n\n");
+	}
+
+	bool HasCounters = false;
+	for(udword b=0;b<gNbEngines;b++)
+	{
+		if(gEngines[b].mTiming.HasCounters() && gEngines[b].mTiming.mRecordedCounters)
+			HasCounters = true;
+	}
+
+	if(HasCounters)
+	{
+		fprintf_s(globalFile, "Hardware counters (%s, per frame):\n\n", GetHardwareCountersScope());
+
+		for(udword b=0;b<gNbEngines;b++)
+		{
+			const PintTiming& Timing = gEngines[b].mTiming;
+			if(!gEngines[b].mEnabled || !gEngines[b].mSupportsCurrentTest || !(gEngines[b].mEngine->GetFlags() & PINT_IS_ACTIVE) || !Timing.mRecordedCounters)
+				continue;
+
+			for(udword j=0;j<HW_COUNTER_COUNT;j++)
+			{
+				if(!IsHardwareCounterAvailable(HardwareCounter(j)))
+					continue;
+
+				fprintf_s(globalFile, "%s - %s%s", gEngines[b].mEngine->GetName(), GetHardwareCounterName(HardwareCounter(j)), Sep);
+				for(udword i=0;i<NbFrames;i++)
+					fprintf_s(globalFile, "%llu%s", Timing.mRecordedCounters[i].mValues[j], Sep);
+				fprintf_s(globalFile, "\n");
+			}
+		}
+
+		fprintf_s(globalFile, "\n\n");
+	}
+
+	fprintf_s(globalFile, "Statistics:\n\n");
+
+	fprintf_s(globalFile, "Engine%sPhase%sFrames%sAvg%sStdDev%sp50%sp90%sp99%sp99.9%sMax\n", Sep, Sep, Sep, Sep, Sep, Sep, Sep, Sep, Sep);
+
+	for(udword b=0;b<gNbEngines;b++)
+	{
+		if(!gEngines[b].mEnabled || !gEngines[b].mSupportsCurrentTest || !(gEngines[b].mEngine->GetFlags() & PINT_IS_ACTIVE))
+			continue;
+
+		for(udword j=0;j<PINT_TIMING_NB_PHASES+1;j++)
+		{
+			// First row is the per-frame total, then one row per recorded phase
+			const PintHistogram& H = j ? gEngines[b].mTiming.mPhaseHistograms[j-1] : gEngines[b].mTiming.mHistogram;
+			if(j && !H.GetNbValues())
+				continue;
+
+			fprintf_s(globalFile, "%s%s%s%s%d%s%.2f%s%.2f%s%d%s%d%s%d%s%d%s%d\n",
+				gEngines[b].mEngine->GetName(), Sep,
+				j ? GetTimingPhaseName(PintTimingPhase(j-1)) : "Total", Sep,
+				H.GetNbValues(), Sep,
+				H.GetMean(), Sep,
+				H.GetStdDev(), Sep,
+				H.GetPercentile(50.0f), Sep,
+				H.GetPercentile(90.0f), Sep,
+				H.GetPercentile(99.0f), Sep,
+				H.GetPercentile(99.9f), Sep,
+				H.GetMax());
+		}
+	}
+
+	if(HasCounters)
+	{
+		fprintf_s(globalFile, "\n\nHardware counters (%s, average per frame):\n\n", GetHardwareCountersScope());
+
+		// Unavailable counters are left out, IPC needs the instructions counter (e.g. Windows only has cycles)
+		const bool HasIPC = IsHardwareCounterAvailable(HW_COUNTER_INSTRUCTIONS);
+		fprintf_s(globalFile, HasIPC ? "Engine%sIPC" : "Engine", Sep);
+		for(udword j=0;j<HW_COUNTER_COUNT;j++)
+		{
+			if(IsHardwareCounterAvailable(HardwareCounter(j)))
+				fprintf_s(globalFile, "%s%s", Sep, GetHardwareCounterName(HardwareCounter(j)));
+		}
+		fprintf_s(globalFile, "\n");
+
+		for(udword b=0;b<gNbEngines;b++)
+		{
+			const PintTiming& Timing = gEngines[b].mTiming;
+			if(!gEngines[b].mEnabled || !gEngines[b].mSupportsCurrentTest || !(gEngines[b].mEngine->GetFlags() & PINT_IS_ACTIVE) || !Timing.HasCounters())
+				continue;
+
+			HardwareCounterValues Avg;
+			Timing.GetAverageCounters(Avg);
+			fprintf_s(globalFile, "%s", gEngines[b].mEngine->GetName());
+			if(HasIPC)
+				fprintf_s(globalFile, "%s%.3f", Sep, Avg.GetIPC());
+			for(udword j=0;j<HW_COUNTER_COUNT;j++)
+			{
+				if(IsHardwareCounterAvailable(HardwareCounter(j)))
+					fprintf_s(globalFile, "%s%llu", Sep, Avg.mValues[j]);
+			}
+			fprintf_s(globalFile, "\n");
+		}
+	}
+
+	fclose(globalFile);
+	return true;
+}
@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *	PEEL - Physics Engine Evaluation Lab
+ *	Copyright (C) 2012 Pierre Terdiman
+ *	Homepage: http://www.codercorner.com/blog.htm
+ */
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "Pint.h"
+#include "PintSQ.h"
+#include "PintTiming.h"
+#include "PintObjectsManager.h"
+#include "ProfilingTimer.h"
+
+	// Engine-side part of PEEL, shared by the GUI app and the headless runner. Nothing in here touches GL, GLUT or IceGUI.
+
+	class PhysicsTest;
+
+	#define MAX_NB_ENGINES			32
+
+	enum SQProfilingMode
+	{
+		SQ_PROFILING_SIM,
+		SQ_PROFILING_UPDATE,
+		SQ_PROFILING_COMBINED,
+		SQ_PROFILING_OVERLAP,	// Queries run on SQ threads during Pint::Update, see Simulate()
+	};
+
+	// Returns "Sim", "Update", "Combined" or "Overlap"
+	const char*	GetSQProfilingModeName(SQProfilingMode mode);
+	// Case-insensitive, returns false for unknown names
+	bool		ParseSQProfilingMode(const char* text, SQProfilingMode& mode);
+
+	// Timings recorded in SQ_PROFILING_OVERLAP mode, in profiling units. Serialized frames run the queries after
+	// Pint::Update, overlapped frames run them at the same time. Times of overlapped frames are measured from the
+	// same start, the frame's wall-clock time is the largest of them.
+	struct SQOverlapStats
+	{
+		void	Reset()
+				{
+					mSerialSim.Reset();
+					mSerialSQ.Reset();
+					mOverlapSim.Reset();
+					mOverlapSQ.Reset();
+					mOverlapWall.Reset();
+				}
+
+		PintHistogram	mSerialSim;
+		PintHistogram	mSerialSQ;
+		PintHistogram	mOverlapSim;
+		PintHistogram	mOverlapSQ;
+		PintHistogram	mOverlapWall;
+	};
+
+	struct EngineData
+	{
+		EngineData() :
+			mEngine					(null),
+			mPlugIn					(null),
+			mEnabled				(true),
+			mSupportsCurrentTest	(true)
+		{
+			mDragPoint.Zero();
+			mLocalPoint.Zero();
+		}
+
+		Pint*					mEngine;
+		PintPlugin*				mPlugIn;			// Plugin the engine comes from
+		PintSQ					mSQHelper;
+		ObjectsManager			mOMHelper;
+		PintTiming				mTiming;
+		SQOverlapStats			mSQOverlap;
+		PintRaycastHit			mPickingData;
+		Point					mDragPoint;
+		Point					mLocalPoint;
+		bool					mEnabled;
+		bool					mSupportsCurrentTest;
+	};
+
+	extern	EngineData			gEngines[MAX_NB_ENGINES];
+	extern	udword				gNbEngines;
+	extern	PintPlugin*			gPlugIns[MAX_NB_ENGINES];
+	extern	udword				gNbPlugIns;
+	extern	udword				gFrameNb;
+	extern	udword				gNbSimulateCallsPerFrame;
+	extern	float				gTimestep;
+	extern	PhysicsTest*		gRunningTest;
+	extern	ProfilingUnits		gProfilingUnits;
+	extern	SQProfilingMode		gSQProfilingMode;
+	extern	bool				gPaused;
+	extern	bool				gRandomizeOrder;
+	extern	bool				gTrashCache;
+	extern	bool				gCommaSeparator;
+	extern	bool				gHardwareCounters;
+	extern	bool				gAllocTracking;		// Allocation stats, see PINT_WORLD_CREATE::GetAllocTracking()
+	extern	udword				gWarmupFrames;		// Frames simulated before timings are recorded
+	extern	bool				gWarmingUp;
+	extern	bool				gParallelEngines;	// Engines simulated concurrently, see Simulate()
+	extern	bool				gAsyncUpdates;		// Pint::BeginUpdate/EndUpdate for engines flagged PINT_ASYNC_UPDATE, see Simulate()
+	extern	udword				gAsyncUpdateWork;	// Main thread work between BeginUpdate & EndUpdate, in microseconds
+	extern	const char*			gResultsSuffix;		// Added to CSV filenames, e.g. when each engine runs in its own process
+	extern	const char*			gCaptureFilename;	// If set, the first engine's calls are captured to this file, see PintCapture.h
+	extern	udword				gNbWorkerThreads;	// Engines' worker threads, overrides the plugins' settings unless INVALID_ID
+
+	void	RegisterPlugIn(const char* filename);
+
+	// Sets the params normally setup by the system: test name, worker threads affinity & number, allocator.
+	void	SetupWorldDesc(PINT_WORLD_CREATE& desc, const char* test_name);
+	// Fetches the test's scene params and sets the test name. For configurable tests this must be called after the test's UI has been created.
+	void	GetTestSceneParams(PhysicsTest* test, PINT_WORLD_CREATE& desc);
+
+	// Calls PintPlugin::Init for all registered plugins and rebuilds the engines array. With gCaptureFilename, the first
+	// engine is replaced with a PintRecorder until CloseEngines().
+	void	InitEngines(const PINT_WORLD_CREATE& desc);
+	// Returns the params used by the last InitEngines() call.
+	const PINT_WORLD_CREATE&	GetWorldDesc();
+	// Closes the running test (if any) and all plugins.
+	void	CloseEngines();
+	void	CloseRunningTest();
+
+	// Sets up the test and calls PhysicsTest::Init for each engine. Engines must have been initialized first.
+	// If gWarmupFrames is not zero, timers are reset (and gFrameNb restarts from 0) once the warmup frames have been simulated.
+	void	StartTest(PhysicsTest* test);
+
+	void	ResetTimers();
+	// Enables/disables hardware counters around Pint::Update. Returns the new state, i.e. false if counters are unavailable.
+	bool	EnableHardwareCounters(bool enabled);
+	void	ResetSQHelpersHitData();
+
+	// Runs one simulation step for all enabled engines, followed by the running test's update.
+	//
+	// With gParallelEngines, Pint::Update runs on one pinned worker thread per engine and the frame ends when all of
+	// them are done. Engines flagged PINT_MAIN_THREAD_ONLY are then updated alone, on the main thread. The test's
+	// CommonUpdate & Update calls still run on the main thread afterwards, in the usual order: they share state between
+	// engines, and can create objects (and thus GL render data). Hardware counters and cache trashing are disabled in
+	// this mode, and each engine's timings include the interference of the others (shared caches, memory bandwidth).
+	//
+	// In SQ_PROFILING_OVERLAP mode (not available with gParallelEngines, which then uses SQ_PROFILING_SIM) the queries
+	// of each engine's last batch, i.e. from the previous frame, run on the SQ threads while the main thread updates
+	// engines flagged PINT_SQ_DURING_UPDATE. This alternates with serialized frames (queries after Pint::Update), which
+	// give the reference. The recorded frame time is the wall-clock time of both, the time added by the queries is
+	// recorded as the test update. Tests' own updates are not profiled in this mode. Hardware counters are recorded on
+	// both kinds of frames, and on overlapped frames include the main thread's SQ batch dispatch.
+	//
+	// With gAsyncUpdates (not with gParallelEngines, nor when SQ tests profile the queries only) the steps of all engines
+	// are started with Pint::BeginUpdate, then the main thread runs the test's CommonUpdate and gAsyncUpdateWork us of busy
+	// work (standing for the rest of a game frame), then results are collected in order with Pint::EndUpdate. The frame
+	// time is the "blocking" time, i.e. the time the main thread spent in these calls. The time from BeginUpdate to the
+	// end of EndUpdate is recorded as the "critical path". Engines without PINT_ASYNC_UPDATE block in Pint::Update.
+	void	Simulate();
+
+	// Describes what the recorded hardware counters cover for the running test, e.g. for the exported results.
+	const char*	GetHardwareCountersScope();
+
+	// Returns ".\\Test[_SubName][_Suffix][postfix].csv" for the running test, in a static buffer.
+	const char*	GetTestCSVFilename(const char* postfix);
+
+	// Saves the recorded timings & memory usage of the running test to a CSV file. Returns false if no file was written.
+	bool	TestCSVExport();
+
+#endif
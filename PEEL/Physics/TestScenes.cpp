@@ -12,6 +12,7 @@
 #include "TestScenes.h"
 #include "TestScenesHelpers.h"
 #include "PintSQ.h"
+#include "SQThreads.h"
 #include "SourceRay.h"
 #include "MyConvex.h"
 #include "Loader_Bin.h"
@@ -792,7 +793,7 @@ udword DoBatchRaycasts(TestBase& test, Pint& pint, bool use_phantoms)
 		}
 		else
 		{
-			NbHits = pint.BatchRaycasts(pint.mSQHelper->GetThreadContext(), Nb, Dest, Data);
+			NbHits = RunSQBatch(pint, SQ_BATCH_RAYCASTS, Nb, Data, Dest);
 		}
 
 		if(0)	// Save results
@@ -816,7 +817,7 @@ udword DoBatchRaycasts(TestBase& test, Pint& pint, bool use_phantoms)
 		PintBooleanHit* Dest = pint.mSQHelper->PrepareRaycastAnyQuery(Nb, Data);
 
 		ASSERT(!use_phantoms);
-		NbHits = pint.BatchRaycastAny(pint.mSQHelper->GetThreadContext(), Nb, Dest, Data);
+		NbHits = RunSQBatch(pint, SQ_BATCH_RAYCAST_ANY, Nb, Data, Dest);
 	}
 	else if(gRaycastMode==2)
 	{
@@ -824,7 +825,7 @@ udword DoBatchRaycasts(TestBase& test, Pint& pint, bool use_phantoms)
 		PintOverlapObjectHit* Dest = pint.mSQHelper->PrepareRaycastAllQuery(Nb, Data);
 
 		ASSERT(!use_phantoms);
-		NbHits = pint.BatchRaycastAll(pint.mSQHelper->GetThreadContext(), Nb, Dest, Data);
+		NbHits = RunSQBatch(pint, SQ_BATCH_RAYCAST_ALL, Nb, Data, Dest);
 	}
 	return NbHits;
 }
@@ -836,7 +837,7 @@ udword DoBatchBoxSweeps(TestBase& test, Pint& pint)
 
 	PintRaycastHit* Dest = pint.mSQHelper->PrepareBoxSweepQuery(Nb, Data);
 
-	return pint.BatchBoxSweeps(pint.mSQHelper->GetThreadContext(), Nb, Dest, Data);
+	return RunSQBatch(pint, SQ_BATCH_BOX_SWEEPS, Nb, Data, Dest);
 }
 
 udword DoBatchSphereSweeps(TestBase& test, Pint& pint)
@@ -846,7 +847,7 @@ udword DoBatchSphereSweeps(TestBase& test, Pint& pint)
 
 	PintRaycastHit* Dest = pint.mSQHelper->PrepareSphereSweepQuery(Nb, Data);
 
-	return pint.BatchSphereSweeps(pint.mSQHelper->GetThreadContext(), Nb, Dest, Data);
+	return RunSQBatch(pint, SQ_BATCH_SPHERE_SWEEPS, Nb, Data, Dest);
 }
 
 udword DoBatchCapsuleSweeps(TestBase& test, Pint& pint)
@@ -856,7 +857,7 @@ udword DoBatchCapsuleSweeps(TestBase& test, Pint& pint)
 
 	PintRaycastHit* Dest = pint.mSQHelper->PrepareCapsuleSweepQuery(Nb, Data);
 
-	return pint.BatchCapsuleSweeps(pint.mSQHelper->GetThreadContext(), Nb, Dest, Data);
+	return RunSQBatch(pint, SQ_BATCH_CAPSULE_SWEEPS, Nb, Data, Dest);
 }
 
 udword DoBatchConvexSweeps(TestBase& test, Pint& pint)
@@ -866,7 +867,7 @@ udword DoBatchConvexSweeps(TestBase& test, Pint& pint)
 
 	PintRaycastHit* Dest = pint.mSQHelper->PrepareConvexSweepQuery(Nb, Data);
 
-	return pint.BatchConvexSweeps(pint.mSQHelper->GetThreadContext(), Nb, Dest, Data);
+	return RunSQBatch(pint, SQ_BATCH_CONVEX_SWEEPS, Nb, Data, Dest);
 }
 
 udword DoBatchSphereOverlaps(TestBase& test, Pint& pint, BatchOverlapMode mode)
@@ -877,12 +878,12 @@ udword DoBatchSphereOverlaps(TestBase& test, Pint& pint, BatchOverlapMode mode)
 	if(mode==OVERLAP_ANY)
 	{
 		PintBooleanHit* Dest = pint.mSQHelper->PrepareSphereOverlapAnyQuery(Nb, Data);
-		return pint.BatchSphereOverlapAny(pint.mSQHelper->GetThreadContext(), Nb, Dest, Data);
+		return RunSQBatch(pint, SQ_BATCH_SPHERE_OVERLAP_ANY, Nb, Data, Dest);
 	}
 	else if(mode==OVERLAP_OBJECTS)
 	{
 		PintOverlapObjectHit* Dest = pint.mSQHelper->PrepareSphereOverlapObjectsQuery(Nb, Data);
-		return pint.BatchSphereOverlapObjects(pint.mSQHelper->GetThreadContext(), Nb, Dest, Data);
+		return RunSQBatch(pint, SQ_BATCH_SPHERE_OVERLAP_OBJECTS, Nb, Data, Dest);
 	}
 	return 0;
 }
@@ -895,12 +896,12 @@ udword DoBatchBoxOverlaps(TestBase& test, Pint& pint, BatchOverlapMode mode)
 	if(mode==OVERLAP_ANY)
 	{
 		PintBooleanHit* Dest = pint.mSQHelper->PrepareBoxOverlapAnyQuery(Nb, Data);
-		return pint.BatchBoxOverlapAny(pint.mSQHelper->GetThreadContext(), Nb, Dest, Data);
+		return RunSQBatch(pint, SQ_BATCH_BOX_OVERLAP_ANY, Nb, Data, Dest);
 	}
 	else if(mode==OVERLAP_OBJECTS)
 	{
 		PintOverlapObjectHit* Dest = pint.mSQHelper->PrepareBoxOverlapObjectsQuery(Nb, Data);
-		return pint.BatchBoxOverlapObjects(pint.mSQHelper->GetThreadContext(), Nb, Dest, Data);
+		return RunSQBatch(pint, SQ_BATCH_BOX_OVERLAP_OBJECTS, Nb, Data, Dest);
 	}
 	return 0;
 }
@@ -913,12 +914,12 @@ udword DoBatchCapsuleOverlaps(TestBase& test, Pint& pint, BatchOverlapMode mode)
 	if(mode==OVERLAP_ANY)
 	{
 		PintBooleanHit* Dest = pint.mSQHelper->PrepareCapsuleOverlapAnyQuery(Nb, Data);
-		return pint.BatchCapsuleOverlapAny(pint.mSQHelper->GetThreadContext(), Nb, Dest, Data);
+		return RunSQBatch(pint, SQ_BATCH_CAPSULE_OVERLAP_ANY, Nb, Data, Dest);
 	}
 	else if(mode==OVERLAP_OBJECTS)
 	{
 		PintOverlapObjectHit* Dest = pint.mSQHelper->PrepareCapsuleOverlapObjectsQuery(Nb, Data);
-		return pint.BatchCapsuleOverlapObjects(pint.mSQHelper->GetThreadContext(), Nb, Dest, Data);
+		return RunSQBatch(pint, SQ_BATCH_CAPSULE_OVERLAP_OBJECTS, Nb, Data, Dest);
 	}
 	return 0;
 }
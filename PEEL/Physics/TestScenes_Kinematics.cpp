@@ -100,7 +100,8 @@ void KinematicTestScene::CommonRelease()
 
 bool KinematicTestScene::Setup(Pint& pint, const PintCaps& caps)
 {
-	if(!caps.mSupportRigidBodySimulation || !caps.mSupportKinematics)
+	// Engines without simulation can still run the test, e.g. to measure how their scene structures deal with moving objects
+	if(!caps.mSupportKinematics)
 		return false;
 
 	PINT_BOX_CREATE BoxDesc(mBoxExtents);
@@ -168,7 +169,7 @@ bool KinematicTestScene::Setup(Pint& pint, const PintCaps& caps)
 			}
 		}
 	}
-	if(mAddDynamicObjects)
+	if(mAddDynamicObjects && caps.mSupportRigidBodySimulation)
 		return GenerateArrayOfBoxes(pint, Point(1.0f, 1.0f, 1.0f), 32, 32, 10.0f, 60.0f, 60.0f);
 	return true;
 }
@@ -15,6 +15,7 @@
 #include "Loader_Bin.h"
 #include "Random.h"
 #include "GUI_Helpers.h"
+#include "Simulation.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -1209,6 +1210,42 @@ END_TEST(TenThousandsSpheres)
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static void CreateTenThousandsBoxes(Pint& pint)
+{
+	const float Amplitude = 1.5f;
+	const udword NbLayers = 40;
+	const udword NbX = 16;
+	const udword NbY = 16;
+	BasicRandom Rnd(42);
+	for(udword j=0;j<NbLayers;j++)
+	{
+		const float Scale = 4.0f;
+		for(udword y=0;y<NbY;y++)
+		{
+			for(udword x=0;x<NbX;x++)
+			{
+				const float xf = (float(x)-float(NbX)*0.5f)*Scale;
+				const float yf = (float(y)-float(NbY)*0.5f)*Scale;
+
+				const Point pos = Point(xf, Rnd.RandomFloat()*2.0f + Amplitude + (Amplitude * 2.0f * float(j)), yf);
+
+				{
+					PINT_BOX_CREATE BoxDesc;
+					UnitRandomPt(BoxDesc.mExtents, Rnd);
+					BoxDesc.mExtents.x = fabsf(BoxDesc.mExtents.x);
+					BoxDesc.mExtents.y = fabsf(BoxDesc.mExtents.y);
+					BoxDesc.mExtents.z = fabsf(BoxDesc.mExtents.z);
+					BoxDesc.mExtents += Point(0.2f, 0.2f, 0.2f);
+					BoxDesc.mRenderer	= CreateBoxRenderer(BoxDesc.mExtents);
+
+					PintObjectHandle Handle = CreateDynamicObject(pint, &BoxDesc, pos);
+					ASSERT(Handle);
+				}
+			}
+		}
+	}
+}
+
 static const char* gDesc_10000_Boxes = "10000+ dynamic boxes.";
 
 START_TEST(TenThousandsBoxes, CATEGORY_PERFORMANCE, gDesc_10000_Boxes)
@@ -1224,42 +1261,86 @@ START_TEST(TenThousandsBoxes, CATEGORY_PERFORMANCE, gDesc_10000_Boxes)
 		if(!caps.mSupportRigidBodySimulation)
 			return false;
 
-		const float Amplitude = 1.5f;
-		const udword NbLayers = 40;
-		const udword NbX = 16;
-		const udword NbY = 16;
-		BasicRandom Rnd(42);
-		for(udword j=0;j<NbLayers;j++)
-		{
-			const float Scale = 4.0f;
-			for(udword y=0;y<NbY;y++)
-			{
-				for(udword x=0;x<NbX;x++)
-				{
-					const float xf = (float(x)-float(NbX)*0.5f)*Scale;
-					const float yf = (float(y)-float(NbY)*0.5f)*Scale;
+		CreateTenThousandsBoxes(pint);
+		return true;
+	}
 
-					const Point pos = Point(xf, Rnd.RandomFloat()*2.0f + Amplitude + (Amplitude * 2.0f * float(j)), yf);
+END_TEST(TenThousandsBoxes)
 
-					{
-						PINT_BOX_CREATE BoxDesc;
-						UnitRandomPt(BoxDesc.mExtents, Rnd);
-						BoxDesc.mExtents.x = fabsf(BoxDesc.mExtents.x);
-						BoxDesc.mExtents.y = fabsf(BoxDesc.mExtents.y);
-						BoxDesc.mExtents.z = fabsf(BoxDesc.mExtents.z);
-						BoxDesc.mExtents += Point(0.2f, 0.2f, 0.2f);
-						BoxDesc.mRenderer	= CreateBoxRenderer(BoxDesc.mExtents);
+///////////////////////////////////////////////////////////////////////////////
 
-						PintObjectHandle Handle = CreateDynamicObject(pint, &BoxDesc, pos);
-						ASSERT(Handle);
+	class PoseReadbackData : public Allocateable
+	{
+		public:
+					PoseReadbackData(udword nb) : mNbObjects(nb)
+					{
+						mPoses		= ICE_NEW(PR)[nb];
+						mPositions	= ICE_NEW(Point)[nb];
+						mRotations	= ICE_NEW(Quat)[nb];
 					}
-				}
-			}
-		}
+					~PoseReadbackData()
+					{
+						DELETEARRAY(mRotations);
+						DELETEARRAY(mPositions);
+						DELETEARRAY(mPoses);
+					}
+
+		udword		mNbObjects;
+		PR*			mPoses;
+		Point*		mPositions;
+		Quat*		mRotations;
+	};
+
+static const char* gDesc_10000_Boxes_PoseReadback = "Same as TenThousandsBoxes, but the test also reads back the poses of all objects each frame, \
+using the bulk pose readback API (active transforms when available). The profiled time includes the readback.";
+
+START_TEST(TenThousandsBoxes_PoseReadback, CATEGORY_PERFORMANCE, gDesc_10000_Boxes_PoseReadback)
+
+	virtual	void	GetSceneParams(PINT_WORLD_CREATE& desc)
+	{
+		TestBase::GetSceneParams(desc);
+		desc.mCamera[0] = CameraPose(Point(37.22f, 13.73f, 33.16f), Point(-0.76f, -0.15f, -0.63f));
+	}
+
+	virtual	bool	ProfileUpdate()	{ return true;	}
+
+	virtual bool	Setup(Pint& pint, const PintCaps& caps)
+	{
+		if(!caps.mSupportRigidBodySimulation)
+			return false;
+
+		CreateTenThousandsBoxes(pint);
+
+		pint.mUserData = ICE_NEW(PoseReadbackData)(pint.mOMHelper->GetNbObjects());
 		return true;
 	}
 
-END_TEST(TenThousandsBoxes)
+	virtual void	Close(Pint& pint)
+	{
+		PoseReadbackData* UserData = (PoseReadbackData*)pint.mUserData;
+		DELETESINGLE(UserData);
+		pint.mUserData = null;
+
+		TestBase::Close(pint);
+	}
+
+	virtual	udword	Update(Pint& pint, float dt)
+	{
+		PoseReadbackData* UserData = (PoseReadbackData*)pint.mUserData;
+		if(!UserData)
+			return 0;
+
+		// Only the objects that moved, if the engine can tell...
+		const udword NbActive = pint.GetActiveTransforms(UserData->mNbObjects, null, UserData->mPositions, UserData->mRotations);
+		if(NbActive!=INVALID_ID)
+			return NbActive;
+
+		// ...otherwise all of them, in one call.
+		pint.mOMHelper->GetWorldTransforms(UserData->mPoses);
+		return UserData->mNbObjects;
+	}
+
+END_TEST(TenThousandsBoxes_PoseReadback)
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -1792,7 +1873,64 @@ class DynamicsOnMeshLevel : public TestBase
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static const char* gDesc_AddStaticObjects = "FLAWED TEST - TO REVISIT. Add static objects at runtime. This is a test where the 'SQ Profiling Mode' makes a big difference. Use the 'Combined' mode in the PEEL generic UI to see the true cost of insertions. Please refer to the user manual for details.";
+// The "add objects" tests below prepare all object descriptors (and their renderers) outside of the profiled update,
+// which only contains the batched CreateObjects() call. That way they measure the engine's insertion cost, not PEEL's.
+
+static void PrepareSeaOfStaticBoxes(PINT_BOX_CREATE* boxes, PINT_OBJECT_CREATE* objects, float amplitude, udword nb_x, udword nb_y, float altitude)
+{
+	// Same objects as CreateSeaOfStaticBoxes()
+	BasicRandom Rnd(42);
+	udword Index = 0;
+	for(udword y=0;y<nb_y;y++)
+	{
+		const float CoeffY = 2.0f * ((float(y)/float(nb_y-1)) - 0.5f);
+		for(udword x=0;x<nb_x;x++)
+		{
+			const float CoeffX = 2.0f * ((float(x)/float(nb_x-1)) - 0.5f);
+
+			Point Random;
+			UnitRandomPt(Random, Rnd);
+			const Point Extents = Random + Point(1.0f, 1.0f, 1.0f);
+
+			boxes[Index].mExtents	= Extents;
+			boxes[Index].mRenderer	= CreateBoxRenderer(Extents);
+
+			UnitRandomPt(Random, Rnd);
+			const Point Center = Random + Point(CoeffX * amplitude, altitude, CoeffY * amplitude);
+
+			objects[Index].mShapes		= boxes + Index;
+			objects[Index].mMass		= 0.0f;
+			objects[Index].mPosition	= Center;
+			Index++;
+		}
+	}
+}
+
+static udword PrepareArrayOfObjects(PINT_OBJECT_CREATE* objects, const PINT_SHAPE_CREATE* shape, udword nb_x, udword nb_y, float altitude, float scale_x, float scale_z, float mass)
+{
+	// Same objects as GenerateArrayOfBoxes() & co
+	const float OneOverNbX = OneOverNb(nb_x);
+	const float OneOverNbY = OneOverNb(nb_y);
+	udword Index = 0;
+	for(udword y=0;y<nb_y;y++)
+	{
+		const float CoeffY = 2.0f * ((float(y)*OneOverNbY) - 0.5f);
+		for(udword x=0;x<nb_x;x++)
+		{
+			const float CoeffX = 2.0f * ((float(x)*OneOverNbX) - 0.5f);
+
+			objects[Index].mShapes		= shape;
+			objects[Index].mMass		= mass;
+			objects[Index].mPosition	= Point(CoeffX * scale_x, altitude, CoeffY * scale_z);
+			Index++;
+		}
+	}
+	return Index;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static const char* gDesc_AddStaticObjects = "Add static objects at runtime. This is a test where the 'SQ Profiling Mode' makes a big difference. Use the 'Combined' mode in the PEEL generic UI to see the true cost of insertions. Please refer to the user manual for details.";
 
 START_TEST(AddStaticObjects, CATEGORY_PERFORMANCE, gDesc_AddStaticObjects)
 
@@ -1800,8 +1938,9 @@ START_TEST(AddStaticObjects, CATEGORY_PERFORMANCE, gDesc_AddStaticObjects)
 	float				mAmplitude;
 	float				mBoxSize;
 	PINT_BOX_CREATE*	mBoxCreate;
+	PINT_OBJECT_CREATE*	mObjectCreate;
 	bool*				mFlags;
-	Container			mCreated;
+	udword				mNbCreated;
 
 	virtual	bool	ProfileUpdate()
 	{
@@ -1811,8 +1950,9 @@ START_TEST(AddStaticObjects, CATEGORY_PERFORMANCE, gDesc_AddStaticObjects)
 	virtual	void	CommonRelease()
 	{
 		ICE_FREE(mFlags);
+		DELETEARRAY(mObjectCreate);
 		DELETEARRAY(mBoxCreate);
-		mCreated.Empty();
+		mNbCreated = 0;
 
 		TestBase::CommonRelease();
 	}
@@ -1838,7 +1978,9 @@ START_TEST(AddStaticObjects, CATEGORY_PERFORMANCE, gDesc_AddStaticObjects)
 		BasicRandom Rnd(42);
 
 		mBoxCreate = ICE_NEW(PINT_BOX_CREATE)[NbX*NbY];
+		mObjectCreate = ICE_NEW(PINT_OBJECT_CREATE)[NbX*NbY];
 		mFlags = (bool*)ICE_ALLOC(sizeof(bool)*NbX*NbY);
+		mNbCreated = 0;
 
 		udword Index = 0;
 		for(udword y=0;y<NbY;y++)
@@ -1891,7 +2033,8 @@ START_TEST(AddStaticObjects, CATEGORY_PERFORMANCE, gDesc_AddStaticObjects)
 
 		mMoving.SetCenterExtents(Point(x, 0.0f, y), Point(mBoxSize, 10.0f, mBoxSize));
 
-		mCreated.Reset();
+		// Prepare the descriptors for this frame, outside of the profiled update
+		mNbCreated = 0;
 		udword NbBoxes = GetNbAABBs();
 		const AABB* Boxes = (const AABB*)GetAABBs();
 		for(udword i=0;i<NbBoxes;i++)
@@ -1899,7 +2042,11 @@ START_TEST(AddStaticObjects, CATEGORY_PERFORMANCE, gDesc_AddStaticObjects)
 			if(!mFlags[i] && mMoving.Intersect(Boxes[i]))
 			{
 				mFlags[i] = true;
-				mCreated.Add(i);
+
+				PINT_OBJECT_CREATE& ObjectDesc = mObjectCreate[mNbCreated++];
+				ObjectDesc.mShapes		= mBoxCreate + i;
+				ObjectDesc.mMass		= 0.0f;
+				Boxes[i].GetCenter(ObjectDesc.mPosition);
 			}
 		}
 	}
@@ -1912,47 +2059,47 @@ START_TEST(AddStaticObjects, CATEGORY_PERFORMANCE, gDesc_AddStaticObjects)
 
 	virtual udword	Update(Pint& pint, float dt)
 	{
-		const AABB* Boxes = (const AABB*)GetAABBs();
-		udword NbCreated = mCreated.GetNbEntries();
-		const udword* Indices = mCreated.GetEntries();
-		while(NbCreated--)
-		{
-			const udword i = *Indices++;
-
-			Point Center;
-			Boxes[i].GetCenter(Center);
-
-			PINT_OBJECT_CREATE ObjectDesc;
-			ObjectDesc.mShapes		= mBoxCreate + i;
-			ObjectDesc.mMass		= 0.0f;
-			ObjectDesc.mPosition	= Center;
-			CreatePintObject(pint, ObjectDesc);
-		}
-		return mCreated.GetNbEntries();
+		if(mNbCreated)
+			CreatePintObjects(pint, mNbCreated, mObjectCreate);
+		return mNbCreated;
 	}
 
 END_TEST(AddStaticObjects)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static const char* gDesc_AddStaticObjects2 = "FLAWED TEST - TO REVISIT. 64*64 static boxes... added at runtime to 128*128 other static boxes.... This is a test where the 'SQ Profiling Mode' makes a big difference. Use the 'Combined' mode in the PEEL generic UI to see the true cost of insertions. Please refer to the user manual for details.";
+static const char* gDesc_AddStaticObjects2 = "64*64 static boxes... added at runtime to 128*128 other static boxes.... This is a test where the 'SQ Profiling Mode' makes a big difference. Use the 'Combined' mode in the PEEL generic UI to see the true cost of insertions. Please refer to the user manual for details.";
 
 START_TEST(AddStaticObjects2, CATEGORY_PERFORMANCE, gDesc_AddStaticObjects2)
 
-	bool	mStopTest;
-	bool	mAddObjects;
+	PINT_BOX_CREATE*	mBoxCreate;
+	PINT_OBJECT_CREATE*	mObjectCreate;
+	bool				mStopTest;
+	bool				mAddObjects;
 
 	virtual	bool	ProfileUpdate()
 	{
 		return true;
 	}
 
+	virtual	void	CommonRelease()
+	{
+		DELETEARRAY(mObjectCreate);
+		DELETEARRAY(mBoxCreate);
+
+		TestBase::CommonRelease();
+	}
+
 	virtual bool	CommonSetup()
 	{
 		TestBase::CommonSetup();
 		mCreateDefaultEnvironment = false;
 		mAddObjects = false;
 		mStopTest = false;
+
+		mBoxCreate = ICE_NEW(PINT_BOX_CREATE)[64*64];
+		mObjectCreate = ICE_NEW(PINT_OBJECT_CREATE)[64*64];
+		PrepareSeaOfStaticBoxes(mBoxCreate, mObjectCreate, 50.0f, 64, 64, 1.0f);
 		return true;
 	}
 
@@ -1981,9 +2128,8 @@ START_TEST(AddStaticObjects2, CATEGORY_PERFORMANCE, gDesc_AddStaticObjects2)
 
 	virtual udword	Update(Pint& pint, float dt)
 	{
-		// PT: TODO: revisit this test. Creating renderers here pollutes the timings. Not good.
 		if(mAddObjects)
-			return CreateSeaOfStaticBoxes(pint, 50.0f, 64, 64, 1.0f);
+			return CreatePintObjects(pint, 64*64, mObjectCreate);
 
 		return 0;
 	}
@@ -1992,13 +2138,15 @@ END_TEST(AddStaticObjects2)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static const char* gDesc_AddDynamicObjects = "FLAWED TEST - TO REVISIT. Add dynamic objects at runtime. This is a test where the 'SQ Profiling Mode' makes a big difference. Use the 'Combined' mode in the PEEL generic UI to see the true cost of insertions. Please refer to the user manual for details.";
+static const char* gDesc_AddDynamicObjects = "Add dynamic objects at runtime. This is a test where the 'SQ Profiling Mode' makes a big difference. Use the 'Combined' mode in the PEEL generic UI to see the true cost of insertions. Please refer to the user manual for details.";
 
 START_TEST(AddDynamicObjects, CATEGORY_PERFORMANCE, gDesc_AddDynamicObjects)
 
 	AABB				mMoving;
 	float				mAmplitude;
 	float				mBoxSize;
+	PINT_BOX_CREATE		mBoxCreate;
+	PINT_OBJECT_CREATE	mObjectCreate;
 
 	virtual	bool	ProfileUpdate()
 	{
@@ -2019,6 +2167,11 @@ START_TEST(AddDynamicObjects, CATEGORY_PERFORMANCE, gDesc_AddDynamicObjects)
 		mBoxSize = 1.0f;
 		mAmplitude = 80.0f;
 
+		mBoxCreate.mExtents		= Point(1.0f, 1.0f, 1.0f);
+		mBoxCreate.mRenderer	= CreateBoxRenderer(mBoxCreate.mExtents);
+
+		mObjectCreate.mShapes	= &mBoxCreate;
+		mObjectCreate.mMass		= 1.0f;
 		return true;
 	}
 
@@ -2039,6 +2192,9 @@ START_TEST(AddDynamicObjects, CATEGORY_PERFORMANCE, gDesc_AddDynamicObjects)
 		const float y = sinf(t*2.07f) * cosf(t*0.13f) * PosScale;
 
 		mMoving.SetCenterExtents(Point(x, 0.0f, y), Point(mBoxSize, 10.0f, mBoxSize));
+
+		mMoving.GetCenter(mObjectCreate.mPosition);
+		mObjectCreate.mPosition.y += 50.0f;
 	}
 
 	virtual void	CommonRender(PintRender& renderer)
@@ -2048,16 +2204,7 @@ START_TEST(AddDynamicObjects, CATEGORY_PERFORMANCE, gDesc_AddDynamicObjects)
 
 	virtual udword	Update(Pint& pint, float dt)
 	{
-		// PT: TODO: revisit this test. Creating renderers here pollutes the timings. Not good.
-		PINT_BOX_CREATE BoxCreate(1.0f, 1.0f, 1.0f);
-		BoxCreate.mRenderer	= CreateBoxRenderer(BoxCreate.mExtents);
-
-		PINT_OBJECT_CREATE ObjectDesc;
-		ObjectDesc.mShapes		= &BoxCreate;
-		ObjectDesc.mMass		= 1.0f;
-		mMoving.GetCenter(ObjectDesc.mPosition);
-		ObjectDesc.mPosition.y += 50.0f;
-		CreatePintObject(pint, ObjectDesc);
+		CreatePintObjects(pint, 1, &mObjectCreate);
 		return 0;
 	}
 
@@ -2065,10 +2212,14 @@ END_TEST(AddDynamicObjects)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static const char* gDesc_AddDynamicObjects2 = "FLAWED TEST - TO REVISIT. Add dynamic objects at runtime. This is a test where the 'SQ Profiling Mode' makes a big difference. Use the 'Combined' mode in the PEEL generic UI to see the true cost of insertions. Please refer to the user manual for details.";
+static const char* gDesc_AddDynamicObjects2 = "Add dynamic objects at runtime. This is a test where the 'SQ Profiling Mode' makes a big difference. Use the 'Combined' mode in the PEEL generic UI to see the true cost of insertions. Please refer to the user manual for details.";
 
 START_TEST(AddDynamicObjects2, CATEGORY_PERFORMANCE, gDesc_AddDynamicObjects2)
 
+	PINT_BOX_CREATE		mBoxCreate;
+	PINT_OBJECT_CREATE	mObjectCreate[4*4*2];
+	udword				mNbObjects;
+
 	virtual	bool	ProfileUpdate()
 	{
 	//	return false;
@@ -2083,6 +2234,12 @@ START_TEST(AddDynamicObjects2, CATEGORY_PERFORMANCE, gDesc_AddDynamicObjects2)
 	virtual bool	CommonSetup()
 	{
 		TestBase::CommonSetup();
+
+		mBoxCreate.mExtents		= Point(0.5f, 0.5f, 0.5f);
+		mBoxCreate.mRenderer	= CreateBoxRenderer(mBoxCreate.mExtents);
+
+		mNbObjects = PrepareArrayOfObjects(mObjectCreate, &mBoxCreate, 4, 4, 50.0f, 2.0f, 2.0f, 1.0f);
+		mNbObjects += PrepareArrayOfObjects(mObjectCreate + mNbObjects, &mBoxCreate, 4, 4, 48.0f, 2.0f, 2.0f, 1.0f);
 		return true;
 	}
 
@@ -2111,13 +2268,8 @@ START_TEST(AddDynamicObjects2, CATEGORY_PERFORMANCE, gDesc_AddDynamicObjects2)
 
 	virtual udword	Update(Pint& pint, float dt)
 	{
-		// PT: TODO: revisit this test. Creating renderers here pollutes the timings. Not good.
 		if(mCurrentTime==0.0f)
-		{
-			GenerateArrayOfBoxes(pint, Point(0.5f, 0.5f, 0.5f), 4, 4, 50.0f, 2.0f, 2.0f, 1.0f);
-			GenerateArrayOfBoxes(pint, Point(0.5f, 0.5f, 0.5f), 4, 4, 48.0f, 2.0f, 2.0f, 1.0f);
-	//		GenerateArrayOfSpheres(pint, 0.5f, 4, 4, 48.0f, 2.0f, 1.0f);
-		}
+			CreatePintObjects(pint, mNbObjects, mObjectCreate);
 		return 0;
 	}
 
@@ -2125,13 +2277,15 @@ END_TEST(AddDynamicObjects2)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-static const char* gDesc_AddDynamicObjectsAndDoRaycasts = "FLAWED TEST - TO REVISIT. Add dynamic objects at runtime, and do raycasts. This is a test where the 'SQ Profiling Mode' makes a big difference. Use the 'Combined' mode in the PEEL generic UI to see the true cost of insertions. Please refer to the user manual for details.";
+static const char* gDesc_AddDynamicObjectsAndDoRaycasts = "Add dynamic objects at runtime, and do raycasts. This is a test where the 'SQ Profiling Mode' makes a big difference. Use the 'Combined' mode in the PEEL generic UI to see the true cost of insertions. Please refer to the user manual for details.";
 
 START_SQ_TEST(AddDynamicObjectsAndDoRaycasts, CATEGORY_PERFORMANCE, gDesc_AddDynamicObjectsAndDoRaycasts)
 
 	AABB				mMoving;
 	float				mAmplitude;
 	float				mBoxSize;
+	PINT_BOX_CREATE		mBoxCreate;
+	PINT_OBJECT_CREATE	mObjectCreate[11];
 
 	virtual	void	CommonRelease()
 	{
@@ -2147,6 +2301,14 @@ START_SQ_TEST(AddDynamicObjectsAndDoRaycasts, CATEGORY_PERFORMANCE, gDesc_AddDyn
 		mBoxSize = 1.0f;
 		mAmplitude = 80.0f;
 
+		mBoxCreate.mExtents		= Point(1.0f, 1.0f, 1.0f);
+		mBoxCreate.mRenderer	= CreateBoxRenderer(mBoxCreate.mExtents);
+		for(udword i=0;i<11;i++)
+		{
+			mObjectCreate[i].mShapes	= &mBoxCreate;
+			mObjectCreate[i].mMass		= 1.0f;
+		}
+
 		bool Status = Setup_PotPourri_Raycasts(*this, 4096, 100.0f);
 		mCreateDefaultEnvironment = true;
 		return Status;
@@ -2169,6 +2331,15 @@ START_SQ_TEST(AddDynamicObjectsAndDoRaycasts, CATEGORY_PERFORMANCE, gDesc_AddDyn
 		const float y = sinf(t*2.07f) * cosf(t*0.13f) * PosScale;
 
 		mMoving.SetCenterExtents(Point(x, 0.0f, y), Point(mBoxSize, 10.0f, mBoxSize));
+
+		Point Pos;
+		mMoving.GetCenter(Pos);
+		Pos.y += 50.0f;
+		for(udword i=0;i<11;i++)
+		{
+			mObjectCreate[i].mPosition = Pos;
+			Pos.y += 1.0f;
+		}
 	}
 
 	virtual void	CommonRender(PintRender& renderer)
@@ -2178,26 +2349,367 @@ START_SQ_TEST(AddDynamicObjectsAndDoRaycasts, CATEGORY_PERFORMANCE, gDesc_AddDyn
 
 	virtual udword	Update(Pint& pint, float dt)
 	{
-		// PT: TODO: revisit this test. Creating renderers here pollutes the timings. Not good.
-		PINT_BOX_CREATE BoxCreate(1.0f, 1.0f, 1.0f);
-		BoxCreate.mRenderer	= CreateBoxRenderer(BoxCreate.mExtents);
+		CreatePintObjects(pint, 11, mObjectCreate);
 
-		PINT_OBJECT_CREATE ObjectDesc;
-		ObjectDesc.mShapes		= &BoxCreate;
-		ObjectDesc.mMass		= 1.0f;
-		mMoving.GetCenter(ObjectDesc.mPosition);
-		ObjectDesc.mPosition.y += 50.0f;
-		CreatePintObject(pint, ObjectDesc);
-		for(udword i=0;i<10;i++)
+		return DoBatchRaycasts(*this, pint);
+	}
+
+END_TEST(AddDynamicObjectsAndDoRaycasts)
+
+///////////////////////////////////////////////////////////////////////////////
+
+	// Per-engine data for the streaming test
+	class StreamingData : public Allocateable
+	{
+		public:
+							StreamingData(udword nb_objects)
+							{
+								mHandles = (PintObjectHandle*)ICE_ALLOC(sizeof(PintObjectHandle)*nb_objects);
+								ZeroMemory(mHandles, sizeof(PintObjectHandle)*nb_objects);
+							}
+							~StreamingData()
+							{
+								ICE_FREE(mHandles);
+							}
+
+		PintObjectHandle*	mHandles;		// Same layout as the test's object descriptors
+		PintHistogram		mLoadTimes;		// Per-frame cost of CreateObjects() calls, for frames loading tiles
+		PintHistogram		mUnloadTimes;	// Per-frame cost of ReleaseObjects() calls, for frames unloading tiles
+	};
+
+	struct StreamingTile
+	{
+		AABB	mBounds;
+		udword	mFirstObject;
+		udword	mNbObjects;
+		bool	mLoaded;
+	};
+
+static const char* gDesc_StreamingWorldChunks = "Streams world chunks around a moving viewer. The Archipelago level is split in 8*8 tiles, each tile has its own static mesh and 4*4 dynamic props. \
+Tiles are loaded (CreateObjects) when they get close to the viewer and unloaded (ReleaseObjects) when they get far. The profiled update contains the streaming calls followed by a grid of raycasts, \
+so it also captures the scene-query structure updates that follow insertions & removals. Look at the worst times and per-frame graphs for spikes. Per-engine load & unload costs are printed when the test is closed. \
+Note that the first load of a tile includes mesh cooking, which engines sharing mesh data skip afterwards.";
+
+START_TEST(StreamingWorldChunks, CATEGORY_PERFORMANCE, gDesc_StreamingWorldChunks)
+
+	enum
+	{
+		NB_TILES_PER_SIDE	= 8,
+		NB_TILES			= NB_TILES_PER_SIDE*NB_TILES_PER_SIDE,
+		NB_PROPS_PER_SIDE	= 4,
+		NB_OBJECTS_PER_TILE	= 1 + NB_PROPS_PER_SIDE*NB_PROPS_PER_SIDE,
+	};
+
+	StreamingTile*		mTiles;
+	IndexedSurface*		mTileSurfaces;
+	PINT_MESH_CREATE*	mTileMeshes;
+	PINT_BOX_CREATE		mPropCreate;
+	PINT_OBJECT_CREATE*	mObjectCreate;
+	Container			mToLoad;
+	Container			mToUnload;
+	Point				mMin;
+	Point				mMax;
+	Point				mViewer;
+	float				mLoadRadius;
+
+	virtual	void	GetSceneParams(PINT_WORLD_CREATE& desc)
+	{
+		TestBase::GetSceneParams(desc);
+		desc.mCamera[0] = CameraPose(Point(42.22f, 50.00f, 42.77f), Point(0.66f, -0.50f, 0.55f));
+	}
+
+	virtual	bool	ProfileUpdate()
+	{
+		return true;
+	}
+
+	virtual	void	CommonRelease()
+	{
+		DELETEARRAY(mObjectCreate);
+		DELETEARRAY(mTileMeshes);
+		DELETEARRAY(mTileSurfaces);
+		DELETEARRAY(mTiles);
+		mToLoad.Empty();
+		mToUnload.Empty();
+
+		TestBase::CommonRelease();
+	}
+
+	udword	GetTileIndex(const Point& p)	const
+	{
+		const float fx = (p.x - mMin.x) * float(NB_TILES_PER_SIDE) / (mMax.x - mMin.x);
+		const float fz = (p.z - mMin.z) * float(NB_TILES_PER_SIDE) / (mMax.z - mMin.z);
+		const udword x = fx<=0.0f ? 0 : MIN(udword(fx), udword(NB_TILES_PER_SIDE-1));
+		const udword z = fz<=0.0f ? 0 : MIN(udword(fz), udword(NB_TILES_PER_SIDE-1));
+		return x + z*NB_TILES_PER_SIDE;
+	}
+
+	// Splits the level's triangles in tiles, according to their centers
+	void	CreateTileSurfaces()
+	{
+		const udword NbSurfaces = GetNbSurfaces();
+
+		udword MaxNbVerts = 0;
+		for(udword s=0;s<NbSurfaces;s++)
+			MaxNbVerts = MAX(MaxNbVerts, GetSurface(s)->GetNbVerts());
+		udword* Remap = (udword*)ICE_ALLOC(sizeof(udword)*MaxNbVerts);
+
+		Container Verts;
+		Container Faces;
+		for(udword t=0;t<NB_TILES;t++)
+		{
+			Verts.Reset();
+			Faces.Reset();
+			udword NbVerts = 0;
+			for(udword s=0;s<NbSurfaces;s++)
+			{
+				const IndexedSurface* IS = GetSurface(s);
+				const Point* V = IS->GetVerts();
+				FillMemory(Remap, IS->GetNbVerts()*sizeof(udword), 0xff);
+
+				const udword NbFaces = IS->GetNbFaces();
+				for(udword f=0;f<NbFaces;f++)
+				{
+					const IndexedTriangle* T = IS->GetFace(f);
+					const Point TriCenter = (V[T->mRef[0]] + V[T->mRef[1]] + V[T->mRef[2]])/3.0f;
+					if(GetTileIndex(TriCenter)!=t)
+						continue;
+
+					for(udword j=0;j<3;j++)
+					{
+						const udword Ref = T->mRef[j];
+						if(Remap[Ref]==INVALID_ID)
+						{
+							Remap[Ref] = NbVerts++;
+							Verts.Add(&V[Ref].x, 3);
+						}
+						Faces.Add(Remap[Ref]);
+					}
+				}
+			}
+
+			if(NbVerts)
+			{
+				bool Status = mTileSurfaces[t].Init(Faces.GetNbEntries()/3, NbVerts, (const Point*)Verts.GetEntries(), (const IndexedTriangle*)Faces.GetEntries());
+				ASSERT(Status);
+			}
+		}
+		ICE_FREE(Remap);
+	}
+
+	void	UpdateViewer()
+	{
+		// The viewer goes around the level in 30 seconds
+		const Point Center = (mMin + mMax)*0.5f;
+		const Point Extents = (mMax - mMin)*0.5f;
+		const float Radius = MIN(Extents.x, Extents.z) * 0.6f;
+		const float Angle = mCurrentTime * TWOPI / 30.0f;
+		mViewer = Point(Center.x + cosf(Angle)*Radius, mMax.y, Center.z + sinf(Angle)*Radius);
+	}
+
+	bool	IsTileWanted(const StreamingTile& tile)	const
+	{
+		Point TileCenter;
+		tile.mBounds.GetCenter(TileCenter);
+		const float dx = TileCenter.x - mViewer.x;
+		const float dz = TileCenter.z - mViewer.z;
+		return dx*dx + dz*dz < mLoadRadius*mLoadRadius;
+	}
+
+	virtual bool	CommonSetup()
+	{
+		TestBase::CommonSetup();
+
+		LoadMeshesFromFile_(*this, "Archipelago.bin");
+		mCreateDefaultEnvironment = false;
+
+		Point Center, Extents;
+		GetGlobalBounds(Center, Extents);
+		mMin = Center - Extents;
+		mMax = Center + Extents;
+		mLoadRadius = MIN(Extents.x, Extents.z) * 0.35f;
+
+		mTiles = ICE_NEW(StreamingTile)[NB_TILES];
+		mTileSurfaces = ICE_NEW(IndexedSurface)[NB_TILES];
+		mTileMeshes = ICE_NEW(PINT_MESH_CREATE)[NB_TILES];
+		mObjectCreate = ICE_NEW(PINT_OBJECT_CREATE)[NB_TILES*NB_OBJECTS_PER_TILE];
+
+		CreateTileSurfaces();
+
+		mPropCreate.mExtents	= Point(0.5f, 0.5f, 0.5f);
+		mPropCreate.mRenderer	= CreateBoxRenderer(mPropCreate.mExtents);
+
+		// All descriptors are prepared here, the profiled update only contains the engine calls
+		const float TileSizeX = (mMax.x - mMin.x) / float(NB_TILES_PER_SIDE);
+		const float TileSizeZ = (mMax.z - mMin.z) / float(NB_TILES_PER_SIDE);
+		for(udword z=0;z<NB_TILES_PER_SIDE;z++)
+		{
+			for(udword x=0;x<NB_TILES_PER_SIDE;x++)
+			{
+				const udword t = x + z*NB_TILES_PER_SIDE;
+				StreamingTile& Tile = mTiles[t];
+
+				const Point TileMin(mMin.x + float(x)*TileSizeX, mMin.y, mMin.z + float(z)*TileSizeZ);
+				const Point TileMax(TileMin.x + TileSizeX, mMax.y, TileMin.z + TileSizeZ);
+				Tile.mBounds.SetMinMax(TileMin, TileMax);
+				Tile.mFirstObject	= t*NB_OBJECTS_PER_TILE;
+				Tile.mNbObjects		= 0;
+				Tile.mLoaded		= false;
+
+				// Tiles without triangles (e.g. over the sea) stay empty
+				const IndexedSurface& TileSurface = mTileSurfaces[t];
+				if(!TileSurface.GetNbFaces())
+					continue;
+
+				PINT_MESH_CREATE& MeshCreate = mTileMeshes[t];
+				MeshCreate.mSurface		= TileSurface.GetSurfaceInterface();
+				MeshCreate.mRenderer	= CreateMeshRenderer(MeshCreate.mSurface);
+
+				PINT_OBJECT_CREATE* ObjectCreate = mObjectCreate + Tile.mFirstObject;
+				ObjectCreate->mShapes	= &MeshCreate;
+				ObjectCreate->mMass		= 0.0f;
+				ObjectCreate++;
+
+				for(udword pz=0;pz<NB_PROPS_PER_SIDE;pz++)
+				{
+					for(udword px=0;px<NB_PROPS_PER_SIDE;px++)
+					{
+						const float CoeffX = (float(px)+0.5f)/float(NB_PROPS_PER_SIDE);
+						const float CoeffZ = (float(pz)+0.5f)/float(NB_PROPS_PER_SIDE);
+
+						ObjectCreate->mShapes	= &mPropCreate;
+						ObjectCreate->mMass		= 1.0f;
+						ObjectCreate->mPosition	= Point(TileMin.x + CoeffX*TileSizeX, mMax.y + 2.0f, TileMin.z + CoeffZ*TileSizeZ);
+						ObjectCreate++;
+					}
+				}
+				Tile.mNbObjects = NB_OBJECTS_PER_TILE;
+			}
+		}
+
+		// Initial tiles are loaded in Setup(), out of the profiled frames
+		UpdateViewer();
+		for(udword t=0;t<NB_TILES;t++)
+			mTiles[t].mLoaded = IsTileWanted(mTiles[t]);
+
+		RegisterArrayOfRaycasts(*this, 32, 32, mMax.y + 10.0f, Extents.x, Extents.z, Point(0.0f, -1.0f, 0.0f), Extents.y*2.0f + 20.0f, Point(Center.x, 0.0f, Center.z));
+		return true;
+	}
+
+	virtual bool	Setup(Pint& pint, const PintCaps& caps)
+	{
+		if(!caps.mSupportMeshes || !caps.mSupportRaycasts)
+			return false;
+
+		StreamingData* Data = ICE_NEW(StreamingData)(NB_TILES*NB_OBJECTS_PER_TILE);
+		pint.mUserData = Data;
+
+		for(udword t=0;t<NB_TILES;t++)
+		{
+			const StreamingTile& Tile = mTiles[t];
+			if(Tile.mLoaded)
+				pint.CreateObjects(Tile.mNbObjects, mObjectCreate + Tile.mFirstObject, Data->mHandles + Tile.mFirstObject);
+		}
+		return true;
+	}
+
+	virtual void	Close(Pint& pint)
+	{
+		StreamingData* Data = (StreamingData*)pint.mUserData;
+		if(Data)
+		{
+			const char* Units = GetProfilingTimer(gProfilingUnits).mUnits;
+			printf("%s: tile loads: %d frames, avg %d, worst %d (%s)\n", pint.GetName(), Data->mLoadTimes.GetNbValues(), udword(Data->mLoadTimes.GetMean()), Data->mLoadTimes.GetMax(), Units);
+			printf("%s: tile unloads: %d frames, avg %d, worst %d (%s)\n", pint.GetName(), Data->mUnloadTimes.GetNbValues(), udword(Data->mUnloadTimes.GetMean()), Data->mUnloadTimes.GetMax(), Units);
+			DELETESINGLE(Data);
+		}
+		pint.mUserData = null;
+
+		TestBase::Close(pint);
+	}
+
+	virtual void	CommonUpdate(float dt)
+	{
+		TestBase::CommonUpdate(dt);
+
+		UpdateViewer();
+
+		// All engines load & unload the same tiles in the same frame
+		mToLoad.Reset();
+		mToUnload.Reset();
+		for(udword t=0;t<NB_TILES;t++)
+		{
+			StreamingTile& Tile = mTiles[t];
+			const bool Wanted = IsTileWanted(Tile);
+			if(Wanted==Tile.mLoaded)
+				continue;
+
+			Tile.mLoaded = Wanted;
+			if(!Tile.mNbObjects)
+				continue;
+
+			if(Wanted)
+				mToLoad.Add(t);
+			else
+				mToUnload.Add(t);
+		}
+	}
+
+	virtual void	CommonRender(PintRender& renderer)
+	{
+		for(udword t=0;t<NB_TILES;t++)
+		{
+			if(mTiles[t].mLoaded && mTiles[t].mNbObjects)
+				renderer.DrawWirefameAABB(mTiles[t].mBounds, Point(0.0f, 1.0f, 0.0f));
+		}
+
+		AABB Viewer;
+		Viewer.SetCenterExtents(mViewer, Point(1.0f, 1.0f, 1.0f));
+		renderer.DrawWirefameAABB(Viewer, Point(1.0f, 0.0f, 0.0f));
+	}
+
+	virtual udword	Update(Pint& pint, float dt)
+	{
+		StreamingData* Data = (StreamingData*)pint.mUserData;
+		if(!Data)
+			return 0;
+
+		const ProfilingTimer& Timer = GetProfilingTimer(gProfilingUnits);
+
+		const udword NbToUnload = mToUnload.GetNbEntries();
+		if(NbToUnload)
+		{
+			const uqword Start = Timer.Start();
+			for(udword i=0;i<NbToUnload;i++)
+			{
+				const StreamingTile& Tile = mTiles[mToUnload[i]];
+				pint.ReleaseObjects(Tile.mNbObjects, Data->mHandles + Tile.mFirstObject);
+			}
+			Data->mUnloadTimes.Record(Timer.GetElapsed(Start));
+
+			for(udword i=0;i<NbToUnload;i++)
+			{
+				const StreamingTile& Tile = mTiles[mToUnload[i]];
+				ZeroMemory(Data->mHandles + Tile.mFirstObject, Tile.mNbObjects*sizeof(PintObjectHandle));
+			}
+		}
+
+		const udword NbToLoad = mToLoad.GetNbEntries();
+		if(NbToLoad)
 		{
-			ObjectDesc.mPosition.y += 1.0f;
-			CreatePintObject(pint, ObjectDesc);
+			const uqword Start = Timer.Start();
+			for(udword i=0;i<NbToLoad;i++)
+			{
+				const StreamingTile& Tile = mTiles[mToLoad[i]];
+				pint.CreateObjects(Tile.mNbObjects, mObjectCreate + Tile.mFirstObject, Data->mHandles + Tile.mFirstObject);
+			}
+			Data->mLoadTimes.Record(Timer.GetElapsed(Start));
 		}
 
 		return DoBatchRaycasts(*this, pint);
 	}
 
-END_TEST(AddDynamicObjectsAndDoRaycasts)
+END_TEST(StreamingWorldChunks)
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -474,7 +474,7 @@ class VehicleSDK : public TestBase
 	{
 		TestBase::CommonSetup();
 
-		const udword Index = mComboBox_Level->GetSelectedIndex();
+		const udword Index = mComboBox_Level ? mComboBox_Level->GetSelectedIndex() : 0;
 		if(Index==0)
 		{
 			mCreateDefaultEnvironment = false;
@@ -539,7 +539,7 @@ class VehicleSDK : public TestBase
 
 		PINT_VEHICLE_CREATE VehicleDesc;
 		VehicleDesc.mStartPose.mPos				= Point(0.0f, 3.0f, 0.0f);
-		VehicleDesc.mDifferential				= PintVehicleDifferential(mComboBox_Differential->GetSelectedIndex());
+		VehicleDesc.mDifferential				= PintVehicleDifferential(mComboBox_Differential ? mComboBox_Differential->GetSelectedIndex() : 0);
 		VehicleDesc.mChassisMass				= GetFromEditBox(1500.0f,	mEditBox_ChassisMass,				0.0f, MAX_FLOAT);
 		VehicleDesc.mChassisMOICoeffY			= GetFromEditBox(0.8f,		mEditBox_ChassisMOICoeffY,			0.0f, MAX_FLOAT);
 		VehicleDesc.mChassisCMOffsetY			= GetFromEditBox(0.65f,		mEditBox_ChassisCMOffsetY,			MIN_FLOAT, MAX_FLOAT);
@@ -605,7 +605,7 @@ class VehicleSDK : public TestBase
 		VehicleData->mChassis = VD.mChassis;
 		VehicleData->mVehicle = VehicleHandle;
 
-		const udword Index = mComboBox_Level->GetSelectedIndex();
+		const udword Index = mComboBox_Level ? mComboBox_Level->GetSelectedIndex() : 0;
 		if(Index==0)
 		{
 			//#####
@@ -687,7 +687,7 @@ class VehicleSDK : public TestBase
 		if(!VehicleHandle)
 			return 0;
 
-		if(mCheckBox_DriveVehicle->IsChecked())
+		if(mCheckBox_DriveVehicle && mCheckBox_DriveVehicle->IsChecked())
 		{
 			pint.SetVehicleInput(VehicleHandle, mInput);
 
@@ -739,12 +739,12 @@ class VehicleSDK : public TestBase
 
 	virtual udword	GetFlags() const
 	{
-		return mCheckBox_DriveVehicle->IsChecked() ? TEST_FLAGS_USE_CURSOR_KEYS : TEST_FLAGS_DEFAULT;
+		return mCheckBox_DriveVehicle && mCheckBox_DriveVehicle->IsChecked() ? TEST_FLAGS_USE_CURSOR_KEYS : TEST_FLAGS_DEFAULT;
 	}
 
 	virtual bool	SpecialKeyCallback(int key, int x, int y, bool down)
 	{
-		if(mCheckBox_DriveVehicle->IsChecked())
+		if(mCheckBox_DriveVehicle && mCheckBox_DriveVehicle->IsChecked())
 		{
 			switch(key)
 			{
@@ -46,5 +46,11 @@ using namespace Meshmerizer;
 using namespace IceImageWork;
 using namespace IceGUI;
 
-#include "GL/glut.h"
+#ifdef PEEL_HEADLESS
+	// The headless runner never opens a window: use the plain GL headers so that we don't link against GLUT.
+	#include <GL/gl.h>
+	#include <GL/glu.h>
+#else
+	#include "GL/glut.h"
+#endif
 #include <vector>